@@ -45,6 +45,7 @@ apt-get install -y \
 	libsystemd-dev \
 	libudev-dev \
 	libunwind-dev \
+	liburing-dev \
 	libx11-dev \
 	libx11-xcb-dev \
 	libxau-dev \
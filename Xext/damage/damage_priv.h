@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+#ifndef _XORG_DAMAGE_PRIV_H
+#define _XORG_DAMAGE_PRIV_H
+
+#include <X11/Xmd.h>
+
+/*
+ * Server specific DAMAGE requests.  They're numbered well above the
+ * standard ones, so they won't clash with future protocol versions.
+ */
+
+#define X_DamageSetRegionChannel        64
+
+/*
+ * Instead of a DamageNotify event per box, publish the damage of a
+ * RawRectangles or DeltaRectangles damage object into shared memory the
+ * client passes along with the request, the file descriptor of something
+ * it can mmap.  The damage accumulates there until the client has read
+ * it, and the client gets one DamageChannelNotify whenever new damage
+ * shows up after it read the previous one.
+ *
+ * A region with more than maxBoxes boxes (0 for as many as fit into the
+ * buffer) is published as maxBoxes bounding boxes of runs of its boxes
+ * instead.  Sending the request again replaces the channel; damage the
+ * client didn't read from the old one isn't carried over.
+ */
+typedef struct {
+    CARD8   reqType;
+    CARD8   damageReqType;
+    CARD16  length;
+    CARD32  damage;
+    CARD32  maxBoxes;
+} xDamageSetRegionChannelReq;
+#define sz_xDamageSetRegionChannelReq 12
+
+/*
+ * At the start of the shared memory, in the byte order of the server
+ * (the fd only works for local clients anyway), followed by the boxes,
+ * in drawable coordinates.
+ *
+ * The server writes everything but ack.  serial is odd while it does,
+ * so the client has to read serial, then the region, then serial once
+ * more, and retry unless both were the same even number.  Once it has
+ * the region, it stores that serial in ack; the next update starts
+ * from scratch rather than adding to the region.
+ */
+#define DAMAGE_CHANNEL_MAGIC    0x58444d47      /* "XDMG" */
+
+typedef struct {
+    CARD32  magic;
+    CARD32  serial;
+    CARD32  ack;                /* written by the client */
+    CARD32  maxBoxes;           /* boxes the buffer takes, after capping */
+    CARD32  nBoxes;
+    CARD32  capped;             /* boxes cover the region, not equal it */
+    INT16   x1, y1, x2, y2;     /* extents of the region */
+} xDamageChannelHeader;
+#define sz_xDamageChannelHeader 32
+
+typedef struct {
+    INT16   x1, y1, x2, y2;
+} xDamageChannelBox;
+#define sz_xDamageChannelBox 8
+
+/* GenericEvent, extension is the major opcode of DAMAGE */
+#define DamageChannelNotify     0
+
+typedef struct {
+    CARD8   type;
+    CARD8   extension;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD16  evtype;
+    CARD16  pad0;
+    CARD32  damage;
+    CARD32  serial;             /* of the update that notified */
+    CARD32  pad1;
+    CARD32  pad2;
+    CARD32  pad3;
+} xDamageChannelNotifyEvent;
+#define sz_xDamageChannelNotifyEvent 32
+
+#endif /* _XORG_DAMAGE_PRIV_H */
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Shared memory channel for DAMAGE regions
+ *
+ * With RawRectangles and DeltaRectangles damage objects, every box of
+ * every bit of damage is an event of its own, and a scrolling terminal or
+ * a video in a browser easily makes for thousands of them per frame, to
+ * every compositor and VNC server around.  A channel collects the damage
+ * instead, and publishes it into memory the client has mapped once per
+ * dispatch cycle, notifying the client only if it has read the previous
+ * update already.  Whatever it hasn't read yet is merged into the next
+ * update, so the client never misses any damage, and the region is
+ * coarsened into bounding boxes rather than ever running out of room.
+ */
+
+#include <dix-config.h>
+
+#include <string.h>
+
+#include "misc.h"
+#include "damage_priv.h"
+#include "damagechannel.h"
+
+struct _DamageChannel {
+    xDamageChannelHeader *header;
+    xDamageChannelBox *boxes;
+    CARD32 maxBoxes;
+    CARD32 serial;              /* of the last update */
+    RegionRec pending;          /* damage since the last update */
+    RegionRec published;        /* damage the client hasn't read */
+};
+
+DamageChannelPtr
+DamageChannelCreate(void *addr, size_t size, CARD32 maxBoxes)
+{
+    DamageChannelPtr channel;
+    size_t room;
+
+    if (size < sz_xDamageChannelHeader + sz_xDamageChannelBox)
+        return NULL;
+    room = (size - sz_xDamageChannelHeader) / sz_xDamageChannelBox;
+    if (!maxBoxes || maxBoxes > room)
+        maxBoxes = min(room, INT32_MAX);
+
+    channel = calloc(1, sizeof(*channel));
+    if (!channel)
+        return NULL;
+    channel->header = addr;
+    channel->boxes = (xDamageChannelBox *) ((char *) addr +
+                                            sz_xDamageChannelHeader);
+    channel->maxBoxes = maxBoxes;
+    RegionNull(&channel->pending);
+    RegionNull(&channel->published);
+
+    memset(channel->header, 0, sz_xDamageChannelHeader);
+    channel->header->magic = DAMAGE_CHANNEL_MAGIC;
+    channel->header->maxBoxes = maxBoxes;
+    return channel;
+}
+
+void
+DamageChannelDestroy(DamageChannelPtr channel)
+{
+    if (!channel)
+        return;
+    RegionUninit(&channel->pending);
+    RegionUninit(&channel->published);
+    free(channel);
+}
+
+void
+DamageChannelAdd(DamageChannelPtr channel, RegionPtr pRegion)
+{
+    RegionUnion(&channel->pending, &channel->pending, pRegion);
+}
+
+static void
+DamageChannelBox(xDamageChannelBox *out, const BoxRec *box)
+{
+    out->x1 = box->x1;
+    out->y1 = box->y1;
+    out->x2 = box->x2;
+    out->y2 = box->y2;
+}
+
+/*
+ * Boxes of a region come in bands from top to bottom, so runs of them
+ * are close together; each run of n / maxBoxes boxes (rounded up) makes
+ * a bounding box.
+ */
+static CARD32
+DamageChannelWriteBoxes(DamageChannelPtr channel, RegionPtr pRegion)
+{
+    int nbox = RegionNumRects(pRegion);
+    BoxPtr pbox = RegionRects(pRegion);
+    int run = (nbox + channel->maxBoxes - 1) / channel->maxBoxes;
+    CARD32 n = 0;
+
+    if (run <= 1) {
+        for (; n < nbox; n++)
+            DamageChannelBox(&channel->boxes[n], &pbox[n]);
+        return n;
+    }
+
+    for (int i = 0; i < nbox; i += run, n++) {
+        BoxRec extents = pbox[i];
+
+        for (int j = i + 1; j < min(i + run, nbox); j++) {
+            extents.x1 = min(extents.x1, pbox[j].x1);
+            extents.x2 = max(extents.x2, pbox[j].x2);
+            extents.y2 = max(extents.y2, pbox[j].y2);
+        }
+        DamageChannelBox(&channel->boxes[n], &extents);
+    }
+    return n;
+}
+
+Bool
+DamageChannelPublish(DamageChannelPtr channel, CARD32 *serial)
+{
+    xDamageChannelHeader *header = channel->header;
+    RegionPtr pRegion = &channel->published;
+    BoxPtr extents;
+    Bool caughtUp;
+
+    if (!RegionNotEmpty(&channel->pending))
+        return FALSE;
+
+    /* the client has read up to the last update, or is still behind */
+    caughtUp = __atomic_load_n(&header->ack, __ATOMIC_ACQUIRE) ==
+        channel->serial;
+    if (caughtUp)
+        RegionEmpty(pRegion);
+    RegionUnion(pRegion, pRegion, &channel->pending);
+    RegionEmpty(&channel->pending);
+
+    __atomic_store_n(&header->serial, channel->serial + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    extents = RegionExtents(pRegion);
+    header->x1 = extents->x1;
+    header->y1 = extents->y1;
+    header->x2 = extents->x2;
+    header->y2 = extents->y2;
+    header->nBoxes = DamageChannelWriteBoxes(channel, pRegion);
+    header->capped = header->nBoxes < RegionNumRects(pRegion);
+
+    channel->serial += 2;
+    __atomic_store_n(&header->serial, channel->serial, __ATOMIC_RELEASE);
+
+    *serial = channel->serial;
+    return caughtUp;
+}
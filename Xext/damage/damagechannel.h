@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+#ifndef XSERVER_DAMAGE_CHANNEL_H
+#define XSERVER_DAMAGE_CHANNEL_H
+
+#include <X11/Xdefs.h>
+#include <X11/Xmd.h>
+
+#include "regionstr.h"
+
+/*
+ * Shared memory a damage object publishes its region into, see
+ * damage_priv.h for the layout the client sees.
+ */
+
+/* needs fds from clients, and catching them truncating the memory */
+#if defined(XTRANS_SEND_FDS) && defined(HAVE_SIGACTION)
+#define DAMAGE_CHANNEL  1
+#endif
+
+typedef struct _DamageChannel *DamageChannelPtr;
+
+/*
+ * @brief set up a channel in the size bytes mapped at addr
+ *
+ * @param maxBoxes boxes to publish at most, 0 for as many as fit
+ * @return the channel, or NULL if there's no room for a box or no memory
+ */
+DamageChannelPtr DamageChannelCreate(void *addr, size_t size,
+                                     CARD32 maxBoxes);
+
+/* doesn't unmap the memory */
+void DamageChannelDestroy(DamageChannelPtr channel);
+
+/* add damage to publish with the next update */
+void DamageChannelAdd(DamageChannelPtr channel, RegionPtr pRegion);
+
+/*
+ * @brief publish the damage added since the last update
+ *
+ * @param serial set to the serial of the update
+ * @return TRUE if the client has read all earlier updates and should be
+ *         told about this one
+ */
+Bool DamageChannelPublish(DamageChannelPtr channel, CARD32 *serial);
+
+#endif /* XSERVER_DAMAGE_CHANNEL_H */
@@ -23,6 +23,9 @@
 
 #include <dix-config.h>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <X11/Xproto.h>
 #include <X11/extensions/damageproto.h>
 
@@ -31,11 +34,15 @@
 #include "dix/screenint_priv.h"
 #include "include/pixmapstr.h"
 #include "miext/extinit_priv.h"
+#include "os/busfault.h"
 #include "os/client_priv.h"
 #include "Xext/panoramiX.h"
 #include "Xext/panoramiXsrv.h"
+#include "Xext/geext_priv.h"
 #include "xfixes/xfixes.h"
 
+#include "damage_priv.h"
+#include "damagechannel.h"
 #include "damageextint.h"
 #include "damagestr.h"
 #include "protocol-versions.h"
@@ -54,6 +61,13 @@ typedef struct _DamageExt {
     ClientPtr pClient;
     XID id;
     XID drawable;
+#ifdef DAMAGE_CHANNEL
+    DamageChannelPtr channel;
+    void *channelAddr;
+    size_t channelSize;
+    struct busfault *busfault;
+    struct xorg_list dirty;     /* in damageDirtyChannels if damaged */
+#endif
 } DamageExtRec, *DamageExtPtr;
 
 #define VERIFY_DAMAGEEXT(pDamageExt, rid, client, mode) { \
@@ -89,6 +103,11 @@ static DevPrivateKeyRec DamageClientPrivateKeyRec;
 
 Bool noDamageExtension = FALSE;
 
+#ifdef DAMAGE_CHANNEL
+static struct xorg_list damageDirtyChannels;
+static Bool damagePublishQueued;
+#endif
+
 static void
 DamageNoteCritical(ClientPtr pClient)
 {
@@ -168,11 +187,110 @@ DamageExtNotify(DamageExtPtr pDamageExt, BoxPtr pBoxes, int nBoxes)
     DamageNoteCritical(pClient);
 }
 
+#ifdef DAMAGE_CHANNEL
+
+static void
+DamageExtChannelNotify(DamageExtPtr pDamageExt, CARD32 serial)
+{
+    xDamageChannelNotifyEvent ev = {
+        .type = GenericEvent,
+        .extension = DamageReqCode,
+        .sequenceNumber = pDamageExt->pClient->sequence,
+        .length = 0,
+        .evtype = DamageChannelNotify,
+        .damage = pDamageExt->id,
+        .serial = serial,
+    };
+
+    WriteEventsToClient(pDamageExt->pClient, 1, (xEvent *) &ev);
+    DamageNoteCritical(pDamageExt->pClient);
+}
+
+static void _X_COLD
+SDamageChannelNotifyEvent(xGenericEvent * from, xGenericEvent * to)
+{
+    xDamageChannelNotifyEvent *ev = (xDamageChannelNotifyEvent *) to;
+
+    *to = *from;
+    swaps(&ev->sequenceNumber);
+    swapl(&ev->length);
+    swaps(&ev->evtype);
+    swapl(&ev->damage);
+    swapl(&ev->serial);
+}
+
+/* once per dispatch cycle, all the damage since the last one */
+static Bool
+DamageExtPublish(ClientPtr pClient, void *closure)
+{
+    DamageExtPtr pDamageExt, tmp;
+
+    xorg_list_for_each_entry_safe(pDamageExt, tmp, &damageDirtyChannels,
+                                  dirty) {
+        CARD32 serial;
+
+        xorg_list_del(&pDamageExt->dirty);
+        xorg_list_init(&pDamageExt->dirty);
+        if (DamageChannelPublish(pDamageExt->channel, &serial))
+            DamageExtChannelNotify(pDamageExt, serial);
+    }
+    damagePublishQueued = FALSE;
+    return TRUE;
+}
+
+static void
+DamageExtChannelReport(DamageExtPtr pDamageExt, RegionPtr pRegion)
+{
+    DamageChannelAdd(pDamageExt->channel, pRegion);
+    if (xorg_list_is_empty(&pDamageExt->dirty))
+        xorg_list_add(&pDamageExt->dirty, &damageDirtyChannels);
+    if (!damagePublishQueued) {
+        QueueWorkProc(DamageExtPublish, serverClient, NULL);
+        damagePublishQueued = TRUE;
+    }
+}
+
+static void
+DamageExtFreeChannel(DamageExtPtr pDamageExt)
+{
+    if (!pDamageExt->channel)
+        return;
+    xorg_list_del(&pDamageExt->dirty);
+    xorg_list_init(&pDamageExt->dirty);
+    DamageChannelDestroy(pDamageExt->channel);
+    pDamageExt->channel = NULL;
+    if (pDamageExt->busfault)
+        busfault_unregister(pDamageExt->busfault);
+    pDamageExt->busfault = NULL;
+    munmap(pDamageExt->channelAddr, pDamageExt->channelSize);
+}
+
+static void
+DamageExtBusfaultNotify(void *context)
+{
+    DamageExtPtr pDamageExt = context;
+
+    ErrorF("damage channel of 0x%x truncated by client\n",
+           (unsigned int) pDamageExt->id);
+    busfault_unregister(pDamageExt->busfault);
+    pDamageExt->busfault = NULL;
+    FreeResource(pDamageExt->id, X11_RESTYPE_NONE);
+}
+
+#endif /* DAMAGE_CHANNEL */
+
 static void
 DamageExtReport(DamagePtr pDamage, RegionPtr pRegion, void *closure)
 {
     DamageExtPtr pDamageExt = closure;
 
+#ifdef DAMAGE_CHANNEL
+    if (pDamageExt->channel) {
+        DamageExtChannelReport(pDamageExt, pRegion);
+        return;
+    }
+#endif
+
     switch (pDamageExt->level) {
     case DamageReportRawRegion:
     case DamageReportDeltaRegion:
@@ -272,6 +390,9 @@ DamageExtCreate(DrawablePtr pDrawable, DamageReportLevel level,
     pDamageExt->pDrawable = pDrawable;
     pDamageExt->level = level;
     pDamageExt->pClient = client;
+#ifdef DAMAGE_CHANNEL
+    xorg_list_init(&pDamageExt->dirty);
+#endif
     pDamageExt->pDamage = DamageCreate(DamageExtReport, DamageExtDestroy, level,
                                        FALSE, pDrawable->pScreen, pDamageExt);
     if (!pDamageExt->pDamage) {
@@ -517,6 +638,69 @@ ProcDamageAdd(ClientPtr client)
     return Success;
 }
 
+#ifdef DAMAGE_CHANNEL
+static int
+ProcDamageSetRegionChannel(ClientPtr client)
+{
+    REQUEST(xDamageSetRegionChannelReq);
+    REQUEST_SIZE_MATCH(xDamageSetRegionChannelReq);
+
+    if (client->swapped) {
+        swapl(&stuff->damage);
+        swapl(&stuff->maxBoxes);
+    }
+
+    DamageExtPtr pDamageExt;
+    DamageChannelPtr channel;
+    struct busfault *busfault;
+    struct stat statb;
+    void *addr;
+    int fd;
+
+    SetReqFds(client, 1);
+    VERIFY_DAMAGEEXT(pDamageExt, stuff->damage, client, DixWriteAccess);
+    if (!client->local)
+        return BadAccess;
+    if (pDamageExt->level != DamageReportRawRegion &&
+        pDamageExt->level != DamageReportDeltaRegion)
+        return BadMatch;
+
+    fd = ReadFdFromClient(client);
+    if (fd < 0)
+        return BadMatch;
+    if (fstat(fd, &statb) < 0 || statb.st_size <= 0) {
+        close(fd);
+        return BadMatch;
+    }
+    addr = mmap(NULL, statb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return BadAccess;
+
+    /* before the header is written, the client may have truncated it */
+    busfault = busfault_register_mmap(addr, statb.st_size,
+                                      DamageExtBusfaultNotify, pDamageExt);
+    if (!busfault) {
+        munmap(addr, statb.st_size);
+        return BadAlloc;
+    }
+    channel = DamageChannelCreate(addr, statb.st_size, stuff->maxBoxes);
+    if (!channel) {
+        busfault_unregister(busfault);
+        munmap(addr, statb.st_size);
+        return BadLength;
+    }
+
+    DamageExtFreeChannel(pDamageExt);
+    pDamageExt->busfault = busfault;
+    pDamageExt->channel = channel;
+    pDamageExt->channelAddr = addr;
+    pDamageExt->channelSize = statb.st_size;
+    return Success;
+}
+#endif /* DAMAGE_CHANNEL */
+
 static int
 ProcDamageDispatch(ClientPtr client)
 {
@@ -534,6 +718,11 @@ ProcDamageDispatch(ClientPtr client)
         /* version 1.1 */
         case X_DamageAdd:
             return ProcDamageAdd(client);
+#ifdef DAMAGE_CHANNEL
+        /* server specific */
+        case X_DamageSetRegionChannel:
+            return ProcDamageSetRegionChannel(client);
+#endif
         default:
             return BadRequest;
     }
@@ -551,6 +740,9 @@ FreeDamageExt(void *value, XID did)
     if (pDamageExt->pDamage) {
         DamageDestroy(pDamageExt->pDamage);
     }
+#ifdef DAMAGE_CHANNEL
+    DamageExtFreeChannel(pDamageExt);
+#endif
     free(pDamageExt);
     return Success;
 }
@@ -713,6 +905,11 @@ DamageExtensionInit(void)
         DamageEventBase = extEntry->eventBase;
         EventSwapVector[DamageEventBase + XDamageNotify] =
             (EventSwapPtr) SDamageNotifyEvent;
+#ifdef DAMAGE_CHANNEL
+        xorg_list_init(&damageDirtyChannels);
+        damagePublishQueued = FALSE;
+        GERegisterExtension(DamageReqCode, SDamageChannelNotifyEvent);
+#endif
         SetResourceTypeErrorValue(DamageExtType,
                                   extEntry->errorBase + BadDamage);
 #ifdef XINERAMA
@@ -136,10 +136,226 @@ SyncCheckWarnIsCounter(const SyncObject * pSync, const char *warning)
     return TRUE;
 }
 
-/*  Each counter maintains a simple linked list of triggers that are
- *  interested in the counter.  The two functions below are used to
- *  delete and add triggers on this list.
+/*  Each fence maintains a simple linked list of triggers that are
+ *  interested in the fence.  Counters have lots more of them at times
+ *  (alarms and awaits of compositors and GL clients, IDLETIME), so they
+ *  keep their triggers in an index instead: one array per test type,
+ *  sorted by test value.  A counter change then only needs to look at
+ *  the triggers whose thresholds lie between the old and the new value,
+ *  and the bracket values of system counters are found by bisection.
+ *
+ *  A trigger is filed under its indexed_value and indexed_type, which
+ *  are its test_value and test_type as of the last SyncTriggerReindex().
+ *  Whoever changes those of a trigger on a counter has to call that.
+ *
+ *  The two functions below are used to delete and add triggers on these
+ *  lists and indices.
+ */
+
+#define SYNC_TEST_TYPES 4       /* XSyncPositiveTransition ... */
+
+typedef struct _SyncTriggerArray {
+    SyncTrigger **triggers;     /* by indexed_value, then address */
+    int num;
+    int size;
+} SyncTriggerArray;
+
+/* triggers SyncChangeCounter() is about to check, see SyncIndexRemove() */
+typedef struct _SyncTriggerFiring {
+    SyncTrigger **triggers;
+    int num;
+    struct _SyncTriggerFiring *next;
+} SyncTriggerFiring;
+
+typedef struct _SyncTriggerIndex {
+    SyncTriggerArray types[SYNC_TEST_TYPES];
+    SyncTriggerFiring *firing;
+} SyncTriggerIndex;
+
+/* the first trigger with a value >= value, or > value if after */
+static int
+SyncIndexBound(const SyncTriggerArray *array, int64_t value, Bool after)
+{
+    int lo = 0, hi = array->num;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        int64_t v = array->triggers[mid]->indexed_value;
+
+        if (v < value || (after && v == value))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* position of pTrigger, or where it would go */
+static int
+SyncIndexPosition(const SyncTriggerArray *array, SyncTrigger *pTrigger,
+                  Bool *found)
+{
+    int64_t value = pTrigger->indexed_value;
+    int lo = 0, hi = array->num;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        SyncTrigger *p = array->triggers[mid];
+
+        if (p->indexed_value < value ||
+            (p->indexed_value == value &&
+             (uintptr_t) p < (uintptr_t) pTrigger))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = lo < array->num && array->triggers[lo] == pTrigger;
+    return lo;
+}
+
+static Bool
+SyncIndexContains(const SyncTriggerIndex *idx, SyncTrigger *pTrigger)
+{
+    Bool found;
+
+    if (!idx || pTrigger->indexed_type >= SYNC_TEST_TYPES)
+        return FALSE;
+    SyncIndexPosition(&idx->types[pTrigger->indexed_type], pTrigger, &found);
+    return found;
+}
+
+static void
+SyncIndexInsert(SyncTriggerIndex *idx, SyncTrigger *pTrigger)
+{
+    SyncTriggerArray *array;
+    Bool found;
+    int i;
+
+    /* SyncInitTrigger() has vetted the test type */
+    pTrigger->indexed_value = pTrigger->test_value;
+    pTrigger->indexed_type = pTrigger->test_type;
+    array = &idx->types[pTrigger->indexed_type];
+
+    if (array->num == array->size) {
+        array->size = array->size ? array->size * 2 : 8;
+        /* Failure is not an option, it's succeed or burst! */
+        array->triggers = XNFreallocarray(array->triggers, array->size,
+                                          sizeof(SyncTrigger *));
+    }
+    i = SyncIndexPosition(array, pTrigger, &found);
+    memmove(&array->triggers[i + 1], &array->triggers[i],
+            (array->num - i) * sizeof(SyncTrigger *));
+    array->triggers[i] = pTrigger;
+    array->num++;
+}
+
+static void
+SyncIndexRemove(SyncTriggerIndex *idx, SyncTrigger *pTrigger)
+{
+    SyncTriggerArray *array = &idx->types[pTrigger->indexed_type];
+    Bool found;
+    int i = SyncIndexPosition(array, pTrigger, &found);
+
+    if (!found)
+        return;
+    array->num--;
+    memmove(&array->triggers[i], &array->triggers[i + 1],
+            (array->num - i) * sizeof(SyncTrigger *));
+
+    /* may be freed right after this, so don't fire it anymore */
+    for (SyncTriggerFiring *f = idx->firing; f; f = f->next) {
+        for (i = 0; i < f->num; i++) {
+            if (f->triggers[i] == pTrigger)
+                f->triggers[i] = NULL;
+        }
+    }
+}
+
+/*
+ * The triggers of each type which may become true when the counter
+ * changes from oldval to its current value, first[type] <= i < last[type].
  */
+static int
+SyncIndexRanges(const SyncTriggerIndex *idx, int64_t oldval, int64_t newval,
+                int *first, int *last)
+{
+    const SyncTriggerArray *types = idx->types;
+    int num = 0;
+
+    /* value >= test_value */
+    first[XSyncPositiveComparison] = 0;
+    last[XSyncPositiveComparison] =
+        SyncIndexBound(&types[XSyncPositiveComparison], newval, TRUE);
+
+    /* value <= test_value */
+    first[XSyncNegativeComparison] =
+        SyncIndexBound(&types[XSyncNegativeComparison], newval, FALSE);
+    last[XSyncNegativeComparison] = types[XSyncNegativeComparison].num;
+
+    /* oldval < test_value <= value */
+    first[XSyncPositiveTransition] = last[XSyncPositiveTransition] = 0;
+    if (newval > oldval) {
+        first[XSyncPositiveTransition] =
+            SyncIndexBound(&types[XSyncPositiveTransition], oldval, TRUE);
+        last[XSyncPositiveTransition] =
+            SyncIndexBound(&types[XSyncPositiveTransition], newval, TRUE);
+    }
+
+    /* value <= test_value < oldval */
+    first[XSyncNegativeTransition] = last[XSyncNegativeTransition] = 0;
+    if (newval < oldval) {
+        first[XSyncNegativeTransition] =
+            SyncIndexBound(&types[XSyncNegativeTransition], newval, FALSE);
+        last[XSyncNegativeTransition] =
+            SyncIndexBound(&types[XSyncNegativeTransition], oldval, FALSE);
+    }
+
+    for (int type = 0; type < SYNC_TEST_TYPES; type++)
+        num += last[type] - first[type];
+    return num;
+}
+
+/* the test value or type of a trigger changed */
+static void
+SyncTriggerReindex(SyncTrigger * pTrigger)
+{
+    SyncCounter *pCounter = (SyncCounter *) pTrigger->pSync;
+
+    if (!pCounter || pCounter->sync.type != SYNC_COUNTER ||
+        pTrigger->test_type >= SYNC_TEST_TYPES)
+        return;
+    if (pTrigger->indexed_value == pTrigger->test_value &&
+        pTrigger->indexed_type == pTrigger->test_type)
+        return;
+    if (!SyncIndexContains(pCounter->pTrigindex, pTrigger))
+        return;
+    SyncIndexRemove(pCounter->pTrigindex, pTrigger);
+    SyncIndexInsert(pCounter->pTrigindex, pTrigger);
+}
+
+/* no triggers left, and nobody iterating over them */
+static Bool
+SyncIndexEmpty(const SyncTriggerIndex *idx)
+{
+    if (!idx || idx->firing)
+        return FALSE;
+    for (int type = 0; type < SYNC_TEST_TYPES; type++) {
+        if (idx->types[type].num)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+SyncIndexFree(SyncTriggerIndex *idx)
+{
+    if (!idx)
+        return;
+    for (int type = 0; type < SYNC_TEST_TYPES; type++)
+        free(idx->types[type].triggers);
+    free(idx);
+}
+
 void
 SyncDeleteTriggerFromSyncObject(SyncTrigger * pTrigger)
 {
@@ -152,6 +368,21 @@ SyncDeleteTriggerFromSyncObject(SyncTrigger * pTrigger)
     if (!pTrigger->pSync)
         return;
 
+    if (SYNC_COUNTER == pTrigger->pSync->type) {
+        pCounter = (SyncCounter *) pTrigger->pSync;
+
+        if (SyncIndexContains(pCounter->pTrigindex, pTrigger))
+            SyncIndexRemove(pCounter->pTrigindex, pTrigger);
+        if (SyncIndexEmpty(pCounter->pTrigindex)) {
+            SyncIndexFree(pCounter->pTrigindex);
+            pCounter->pTrigindex = NULL;
+        }
+
+        if (IsSystemCounter(pCounter))
+            SyncComputeBracketValues(pCounter);
+        return;
+    }
+
     pPrev = NULL;
     pCur = pTrigger->pSync->pTriglist;
 
@@ -170,13 +401,7 @@ SyncDeleteTriggerFromSyncObject(SyncTrigger * pTrigger)
         pCur = pCur->next;
     }
 
-    if (SYNC_COUNTER == pTrigger->pSync->type) {
-        pCounter = (SyncCounter *) pTrigger->pSync;
-
-        if (IsSystemCounter(pCounter))
-            SyncComputeBracketValues(pCounter);
-    }
-    else if (SYNC_FENCE == pTrigger->pSync->type) {
+    if (SYNC_FENCE == pTrigger->pSync->type) {
         SyncFence *pFence = (SyncFence *) pTrigger->pSync;
 
         pFence->funcs.DeleteTrigger(pTrigger);
@@ -192,6 +417,22 @@ SyncAddTriggerToSyncObject(SyncTrigger * pTrigger)
     if (!pTrigger->pSync)
         return Success;
 
+    if (SYNC_COUNTER == pTrigger->pSync->type) {
+        pCounter = (SyncCounter *) pTrigger->pSync;
+
+        /* don't do anything if it's already there */
+        if (SyncIndexContains(pCounter->pTrigindex, pTrigger))
+            return Success;
+
+        if (!pCounter->pTrigindex)
+            pCounter->pTrigindex = XNFcallocarray(1, sizeof(SyncTriggerIndex));
+        SyncIndexInsert(pCounter->pTrigindex, pTrigger);
+
+        if (IsSystemCounter(pCounter))
+            SyncComputeBracketValues(pCounter);
+        return Success;
+    }
+
     /* don't do anything if it's already there */
     for (pCur = pTrigger->pSync->pTriglist; pCur; pCur = pCur->next) {
         if (pCur->pTrigger == pTrigger)
@@ -205,13 +446,7 @@ SyncAddTriggerToSyncObject(SyncTrigger * pTrigger)
     pCur->next = pTrigger->pSync->pTriglist;
     pTrigger->pSync->pTriglist = pCur;
 
-    if (SYNC_COUNTER == pTrigger->pSync->type) {
-        pCounter = (SyncCounter *) pTrigger->pSync;
-
-        if (IsSystemCounter(pCounter))
-            SyncComputeBracketValues(pCounter);
-    }
-    else if (SYNC_FENCE == pTrigger->pSync->type) {
+    if (SYNC_FENCE == pTrigger->pSync->type) {
         SyncFence *pFence = (SyncFence *) pTrigger->pSync;
 
         pFence->funcs.AddTrigger(pTrigger);
@@ -438,8 +673,10 @@ SyncInitTrigger(ClientPtr client, SyncTrigger * pTrigger, XID syncObject,
     if (newSyncObject) {
         SyncAddTriggerToSyncObject(pTrigger);
     }
-    else if (pCounter && IsSystemCounter(pCounter)) {
-        SyncComputeBracketValues(pCounter);
+    else {
+        SyncTriggerReindex(pTrigger);
+        if (pCounter && IsSystemCounter(pCounter))
+            SyncComputeBracketValues(pCounter);
     }
 
     return Success;
@@ -629,6 +866,7 @@ SyncAlarmTriggerFired(SyncTrigger * pTrigger)
      */
     SyncSendAlarmNotifyEvents(pAlarm);
     pTrigger->test_value = new_test_value;
+    SyncTriggerReindex(pTrigger);
 }
 
 /*  This function is called when an Await unblocks, either as a result
@@ -740,23 +978,69 @@ SyncUpdateCounter(SyncCounter *pCounter, int64_t newval)
 void
 SyncChangeCounter(SyncCounter * pCounter, int64_t newval)
 {
-    SyncTriggerList *ptl, *pnext;
+    SyncTriggerIndex *idx = pCounter->pTrigindex;
+    SyncTrigger *local[16];
+    SyncTriggerFiring firing = { .triggers = local };
+    int first[SYNC_TEST_TYPES], last[SYNC_TEST_TYPES];
     int64_t oldval;
+    int num;
 
     oldval = SyncUpdateCounter(pCounter, newval);
+    if (!idx)
+        goto brackets;
+
+    /*  Collect the triggers which may have become true first: firing them
+     *  can add, move and delete triggers.  SyncIndexRemove() drops the
+     *  deleted ones from the collection.
+     */
+    num = SyncIndexRanges(idx, oldval, newval, first, last);
+    if (num > (int) ARRAY_SIZE(local))
+        firing.triggers = XNFcallocarray(num, sizeof(SyncTrigger *));
+    for (int type = 0; type < SYNC_TEST_TYPES; type++) {
+        for (int i = first[type]; i < last[type]; i++)
+            firing.triggers[firing.num++] = idx->types[type].triggers[i];
+    }
+    firing.next = idx->firing;
+    idx->firing = &firing;
 
     /* run through triggers to see if any become true */
-    for (ptl = pCounter->sync.pTriglist; ptl; ptl = pnext) {
-        pnext = ptl->next;
-        if ((*ptl->pTrigger->CheckTrigger) (ptl->pTrigger, oldval))
-            (*ptl->pTrigger->TriggerFired) (ptl->pTrigger);
+    for (int i = 0; i < firing.num; i++) {
+        SyncTrigger *pTrigger = firing.triggers[i];
+
+        if (pTrigger && (*pTrigger->CheckTrigger) (pTrigger, oldval))
+            (*pTrigger->TriggerFired) (pTrigger);
     }
 
+    idx->firing = firing.next;
+    if (firing.triggers != local)
+        free(firing.triggers);
+
+ brackets:
     if (IsSystemCounter(pCounter)) {
         SyncComputeBracketValues(pCounter);
     }
 }
 
+/* whether SyncChangeCounter() from oldval would fire any trigger */
+static Bool
+SyncCounterWouldTrigger(SyncCounter * pCounter, int64_t oldval)
+{
+    SyncTriggerIndex *idx = pCounter->pTrigindex;
+    int first[SYNC_TEST_TYPES], last[SYNC_TEST_TYPES];
+
+    if (!idx || !SyncIndexRanges(idx, oldval, pCounter->value, first, last))
+        return FALSE;
+    for (int type = 0; type < SYNC_TEST_TYPES; type++) {
+        for (int i = first[type]; i < last[type]; i++) {
+            SyncTrigger *pTrigger = idx->types[type].triggers[i];
+
+            if ((*pTrigger->CheckTrigger) (pTrigger, oldval))
+                return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 /* loosely based on dix/events.c/EventSelectForWindow */
 static Bool
 SyncEventSelectForAlarm(SyncAlarm * pAlarm, ClientPtr client, Bool wantevents)
@@ -914,8 +1198,11 @@ SyncChangeAlarmAttributes(ClientPtr client, SyncAlarm * pAlarm, Mask mask,
     pAlarm->delta = delta;
     pAlarm->trigger = trigger;
     if ((status = SyncInitTrigger(client, &pAlarm->trigger, counter, RTCounter,
-                                  origmask & XSyncCAAllTrigger)) != Success)
+                                  origmask & XSyncCAAllTrigger)) != Success) {
+        /* the test type may have changed anyway */
+        SyncTriggerReindex(&pAlarm->trigger);
         return status;
+    }
 
     /* XXX spec does not really say to do this - needs clarification */
     pAlarm->state = XSyncAlarmActive;
@@ -1057,8 +1344,7 @@ SyncDestroySystemCounter(void *pSysCounter)
 static void
 SyncComputeBracketValues(SyncCounter * pCounter)
 {
-    SyncTriggerList *pCur;
-    SyncTrigger *pTrigger;
+    SyncTriggerIndex *idx;
     SysCounterInfo *psci;
     int64_t *pnewgtval = NULL;
     int64_t *pnewltval = NULL;
@@ -1075,73 +1361,41 @@ SyncComputeBracketValues(SyncCounter * pCounter)
     psci->bracket_greater = LLONG_MAX;
     psci->bracket_less = LLONG_MIN;
 
-    for (pCur = pCounter->sync.pTriglist; pCur; pCur = pCur->next) {
-        pTrigger = pCur->pTrigger;
+    /*  For each test type, the nearest test values above and below the
+     *  counter value.  A trigger with a test value equal to the counter
+     *  value doesn't bracket it, except for transitions: we want one more
+     *  change in their direction to see the value go past the threshold.
+     */
+    idx = pCounter->pTrigindex;
+    for (int type = 0; idx && type < SYNC_TEST_TYPES; type++) {
+        const SyncTriggerArray *array = &idx->types[type];
+        int greater, less;
+
+        if ((type == XSyncPositiveComparison ||
+             type == XSyncNegativeTransition) &&
+            ct == XSyncCounterNeverIncreases)
+            continue;
+        if ((type == XSyncNegativeComparison ||
+             type == XSyncPositiveTransition) &&
+            ct == XSyncCounterNeverDecreases)
+            continue;
 
-        if (pTrigger->test_type == XSyncPositiveComparison &&
-            ct != XSyncCounterNeverIncreases) {
-            if (pCounter->value < pTrigger->test_value &&
-                pTrigger->test_value < psci->bracket_greater) {
-                psci->bracket_greater = pTrigger->test_value;
-                pnewgtval = &psci->bracket_greater;
-            }
-            else if (pCounter->value > pTrigger->test_value &&
-                     pTrigger->test_value > psci->bracket_less) {
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
-        }
-        else if (pTrigger->test_type == XSyncNegativeComparison &&
-                 ct != XSyncCounterNeverDecreases) {
-            if (pCounter->value > pTrigger->test_value &&
-                pTrigger->test_value > psci->bracket_less) {
-                psci->bracket_less = pTrigger->test_value;
-                pnewltval = &psci->bracket_less;
-            }
-            else if (pCounter->value < pTrigger->test_value &&
-                     pTrigger->test_value < psci->bracket_greater) {
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
-        }
-        else if (pTrigger->test_type == XSyncNegativeTransition &&
-                 ct != XSyncCounterNeverIncreases) {
-            if (pCounter->value >= pTrigger->test_value &&
-                pTrigger->test_value > psci->bracket_less) {
-                    /*
-                     * If the value is exactly equal to our threshold, we want one
-                     * more event in the negative direction to ensure we pick up
-                     * when the value is less than this threshold.
-                     */
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
-            else if (pCounter->value < pTrigger->test_value &&
-                     pTrigger->test_value < psci->bracket_greater) {
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
+        greater = SyncIndexBound(array, pCounter->value,
+                                 type != XSyncPositiveTransition);
+        less = SyncIndexBound(array, pCounter->value,
+                              type == XSyncNegativeTransition) - 1;
+
+        if (greater < array->num &&
+            array->triggers[greater]->indexed_value < psci->bracket_greater) {
+            psci->bracket_greater = array->triggers[greater]->indexed_value;
+            pnewgtval = &psci->bracket_greater;
         }
-        else if (pTrigger->test_type == XSyncPositiveTransition &&
-                 ct != XSyncCounterNeverDecreases) {
-            if (pCounter->value <= pTrigger->test_value &&
-                pTrigger->test_value < psci->bracket_greater) {
-                    /*
-                     * If the value is exactly equal to our threshold, we
-                     * want one more event in the positive direction to
-                     * ensure we pick up when the value *exceeds* this
-                     * threshold.
-                     */
-                    psci->bracket_greater = pTrigger->test_value;
-                    pnewgtval = &psci->bracket_greater;
-            }
-            else if (pCounter->value > pTrigger->test_value &&
-                     pTrigger->test_value > psci->bracket_less) {
-                    psci->bracket_less = pTrigger->test_value;
-                    pnewltval = &psci->bracket_less;
-            }
+        if (less >= 0 &&
+            array->triggers[less]->indexed_value > psci->bracket_less) {
+            psci->bracket_less = array->triggers[less]->indexed_value;
+            pnewltval = &psci->bracket_less;
         }
-    }                           /* end for each trigger */
+    }
 
     (*psci->BracketValues) ((void *) pCounter, pnewltval, pnewgtval);
 
@@ -1184,13 +1438,14 @@ FreeCounter(void *env, XID id)
     pCounter->sync.beingDestroyed = TRUE;
 
     if (pCounter->sync.initialized) {
-        SyncTriggerList *ptl, *pnext;
+        SyncTriggerIndex *idx = pCounter->pTrigindex;
 
         /* tell all the counter's triggers that counter has been destroyed */
-        for (ptl = pCounter->sync.pTriglist; ptl; ptl = pnext) {
-            (*ptl->pTrigger->CounterDestroyed) (ptl->pTrigger);
-            pnext = ptl->next;
-            free(ptl); /* destroy the trigger list as we go */
+        for (int type = 0; idx && type < SYNC_TEST_TYPES; type++) {
+            SyncTriggerArray *array = &idx->types[type];
+
+            for (int i = 0; i < array->num; i++)
+                (*array->triggers[i]->CounterDestroyed) (array->triggers[i]);
         }
         if (IsSystemCounter(pCounter)) {
             xorg_list_del(&pCounter->pSysCounterInfo->entry);
@@ -1200,6 +1455,7 @@ FreeCounter(void *env, XID id)
         }
     }
 
+    SyncIndexFree(pCounter->pTrigindex);
     free(pCounter);
     return Success;
 }
@@ -2428,8 +2684,6 @@ IdleTimeBlockHandler(void *pCounter, void *wt)
     int64_t *less = priv->value_less;
     int64_t *greater = priv->value_greater;
     int64_t idle, old_idle;
-    SyncTriggerList *list = counter->sync.pTriglist;
-    SyncTrigger *trig;
 
     if (!less && !greater)
         return;
@@ -2451,18 +2705,13 @@ IdleTimeBlockHandler(void *pCounter, void *wt)
         /*
          * We've been idle for less than the threshold value, and someone
          * wants to know about that, but now we need to know whether they
-         * want level or edge trigger.  Check the trigger list against the
+         * want level or edge trigger.  Check the triggers against the
          * current idle time, and if any succeed, bomb out of select()
          * immediately so we can reschedule.
          */
 
-        for (list = counter->sync.pTriglist; list; list = list->next) {
-            trig = list->pTrigger;
-            if (trig->CheckTrigger(trig, old_idle)) {
-                AdjustWaitForDelay(wt, 0);
-                break;
-            }
-        }
+        if (SyncCounterWouldTrigger(counter, old_idle))
+            AdjustWaitForDelay(wt, 0);
         /*
          * We've been called exactly on the idle time, but we have a
          * NegativeTransition trigger which requires a transition from an
@@ -2483,15 +2732,8 @@ IdleTimeBlockHandler(void *pCounter, void *wt)
         if (idle < *greater) {
             AdjustWaitForDelay(wt, *greater - idle);
         }
-        else {
-            for (list = counter->sync.pTriglist; list;
-                 list = list->next) {
-                trig = list->pTrigger;
-                if (trig->CheckTrigger(trig, old_idle)) {
-                    AdjustWaitForDelay(wt, 0);
-                    break;
-                }
-            }
+        else if (SyncCounterWouldTrigger(counter, old_idle)) {
+            AdjustWaitForDelay(wt, 0);
         }
     }
 
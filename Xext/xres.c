@@ -14,11 +14,13 @@
 #include "dix/client_priv.h"
 #include "dix/dix_priv.h"
 #include "dix/registry_priv.h"
+#include "dix/reqprof_priv.h"
 #include "dix/request_priv.h"
 #include "dix/resource_priv.h"
 #include "os/client_priv.h"
 #include "miext/extinit_priv.h"
 #include "Xext/xace.h"
+#include "Xext/xres_priv.h"
 
 #include "misc.h"
 #include "os.h"
@@ -932,6 +934,74 @@ ProcXResQueryResourceBytes (ClientPtr client)
     return rc;
 }
 
+static void
+WriteRequestStats(const ReqProfStatsRec *stats, void *data)
+{
+    x_rpcbuf_t *rpcbuf = data;
+
+    /* write xXResRequestStats */
+    x_rpcbuf_write_CARD8(rpcbuf, stats->major);
+    x_rpcbuf_write_CARD8(rpcbuf, 0);
+    x_rpcbuf_write_CARD16(rpcbuf, stats->minor);
+    x_rpcbuf_write_CARD32(rpcbuf, stats->count);
+    x_rpcbuf_write_CARD32(rpcbuf, stats->totalUs >> 32);
+    x_rpcbuf_write_CARD32(rpcbuf, stats->totalUs & 0xffffffff);
+    x_rpcbuf_write_CARD32(rpcbuf, stats->maxUs);
+    x_rpcbuf_write_CARD32s(rpcbuf, stats->buckets, REQPROF_BUCKETS);
+}
+
+static void
+CountRequestStats(const ReqProfStatsRec *stats, void *data)
+{
+    (*(CARD32 *) data)++;
+}
+
+static int
+ProcXResQueryClientRequestStats(ClientPtr client)
+{
+    REQUEST(xXResQueryClientRequestStatsReq);
+    REQUEST_SIZE_MATCH(xXResQueryClientRequestStatsReq);
+
+    if (client->swapped)
+        swapl(&stuff->client);
+
+    ClientPtr statsClient = dixClientForXID(stuff->client);
+
+    if ((!statsClient) ||
+        (dixCallClientAccessCallback(client, statsClient, DixReadAccess)
+                              != Success)) {
+        client->errorValue = stuff->client;
+        return BadValue;
+    }
+
+    x_rpcbuf_t rpcbuf = { .swapped = client->swapped, .err_clear = TRUE };
+
+    CARD32 num_stats = 0;
+    ReqProfForEach(statsClient, CountRequestStats, &num_stats);
+    ReqProfForEach(statsClient, WriteRequestStats, &rpcbuf);
+
+    if (rpcbuf.error)
+        return BadAlloc;
+
+    const FairSchedClientRec *cpu = ReqProfSchedClient(statsClient->index);
+
+    xXResQueryClientRequestStatsReply reply = {
+        .num_stats = num_stats,
+        .num_buckets = REQPROF_BUCKETS,
+        .turns = cpu->turns,
+        .cpu_us = cpu->cpuNs / 1000
+    };
+
+    if (client->swapped) {
+        swapl(&reply.num_stats);
+        swapl(&reply.num_buckets);
+        swapl(&reply.turns);
+        swapll(&reply.cpu_us);
+    }
+
+    return X_SEND_REPLY_WITH_RPCBUF(client, reply, rpcbuf);
+}
+
 static int
 ProcResDispatch(ClientPtr client)
 {
@@ -949,6 +1019,8 @@ ProcResDispatch(ClientPtr client)
         return ProcXResQueryClientIds(client);
     case X_XResQueryResourceBytes:
         return ProcXResQueryResourceBytes(client);
+    case X_XResQueryClientRequestStats:
+        return ProcXResQueryClientRequestStats(client);
     default: break;
     }
 
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+#ifndef _XORG_XRES_PRIV_H
+#define _XORG_XRES_PRIV_H
+
+#include <X11/Xmd.h>
+
+/*
+ * Server specific X-Resource requests.  They're numbered well above the
+ * standard ones, so they won't clash with future protocol versions.
+ */
+
+#define X_XResQueryClientRequestStats   64
+
+typedef struct {
+    CARD8   reqType;
+    CARD8   XResReqType;
+    CARD16  length;
+    CARD32  client;             /* any XID owned by the client */
+} xXResQueryClientRequestStatsReq;
+#define sz_xXResQueryClientRequestStatsReq 8
+
+typedef struct {
+    CARD8   type;
+    CARD8   pad1;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD32  num_stats;
+    CARD32  num_buckets;
+    CARD32  turns;              /* times the client was scheduled */
+    CARD32  pad2;
+    CARD64  cpu_us;             /* server CPU time spent on its turns */
+} xXResQueryClientRequestStatsReply;
+#define sz_xXResQueryClientRequestStatsReply 32
+
+/*
+ * The reply is followed by num_stats of these, each followed by
+ * num_buckets CARD32 histogram buckets: requests which took less than
+ * 1us, then [2^(i-1), 2^i) us, the last bucket counting everything
+ * slower.  The total is split in halves, so the entries stay 4 byte
+ * aligned.
+ */
+typedef struct {
+    CARD8   major;
+    CARD8   pad;
+    CARD16  minor;
+    CARD32  count;
+    CARD32  total_us_hi;
+    CARD32  total_us_lo;
+    CARD32  max_us;
+} xXResRequestStats;
+#define sz_xXResRequestStats 20
+
+#endif /* _XORG_XRES_PRIV_H */
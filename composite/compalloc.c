@@ -55,7 +55,9 @@ compScreenUpdate(ClientPtr pClient, void *closure)
     CompScreenPtr cs = GetCompScreen(pScreen);
 
     compCheckTree(pScreen);
+    compPaintBegin(pScreen);
     compPaintChildrenToWindow(pScreen->root);
+    compPaintEnd(pScreen);
 
     /* Next damage will restore the worker */
     cs->pendingScreenUpdate = FALSE;
@@ -313,7 +315,7 @@ compFreeClientWindow(WindowPtr pWin, XID id)
 
     if (pPixmap) {
         compRestoreWindow(pWin, pPixmap);
-        dixDestroyPixmap(pPixmap, 0);
+        compPixmapPoolPut(&GetCompScreen(pScreen)->pixmapPool, pPixmap);
     }
 }
 
@@ -531,8 +533,8 @@ compNewPixmap(WindowPtr pWin, int x, int y, int w, int h)
     WindowPtr pParent = pWin->parent;
     PixmapPtr pPixmap;
 
-    pPixmap = (*pScreen->CreatePixmap) (pScreen, w, h, pWin->drawable.depth,
-                                        CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+    pPixmap = compPixmapPoolGet(&GetCompScreen(pScreen)->pixmapPool, pScreen,
+                                w, h, pWin->drawable.depth);
 
     if (!pPixmap)
         return 0;
@@ -254,6 +254,7 @@ SingleCompositeNameWindowPixmap(ClientPtr client, xCompositeNameWindowPixmapReq
         return rc;
 
     ++pPixmap->refcnt;
+    compPixmapPoolForget(&GetCompScreen(pScreen)->pixmapPool, pPixmap);
 
     if (!AddResource(stuff->pixmap, X11_RESTYPE_PIXMAP, (void *) pPixmap))
         return BadAlloc;
@@ -666,6 +667,7 @@ ProcCompositeNameWindowPixmap(ClientPtr client)
             return BadAlloc;
 
         ++pPixmap->refcnt;
+        compPixmapPoolForget(&GetCompScreen(walkScreen)->pixmapPool, pPixmap);
     });
 
     if (!AddResource(stuff->pixmap, XRT_PIXMAP, (void *) newPix))
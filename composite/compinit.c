@@ -64,6 +64,8 @@ static void compCloseScreen(CallbackListPtr *pcbl, ScreenPtr pScreen, void *unus
 
     free(cs->alternateVisuals);
     free(cs->implicitRedirectExceptions);
+    compPaintFini(pScreen);
+    compPixmapPoolFini(&cs->pixmapPool, pScreen);
 
     pScreen->InstallColormap = cs->InstallColormap;
     pScreen->ChangeWindowAttributes = cs->ChangeWindowAttributes;
@@ -332,6 +334,8 @@ compScreenInit(ScreenPtr pScreen)
     cs->numImplicitRedirectExceptions = 0;
     cs->implicitRedirectExceptions = NULL;
 
+    compPixmapPoolInit(&cs->pixmapPool);
+
     if (!compAddAlternateVisuals(pScreen, cs)) {
         free(cs);
         return FALSE;
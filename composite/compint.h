@@ -72,6 +72,7 @@
 #include "xfixes.h"
 #include <X11/extensions/compositeproto.h>
 #include "compositeext.h"
+#include "os/threadpool_priv.h"
 #include <assert.h>
 
 /*
@@ -124,6 +125,19 @@ typedef struct _CompImplicitRedirectException {
     XID winVisual;
 } CompImplicitRedirectException;
 
+/*
+ * Released backing pixmaps kept for reuse, see comppool.c
+ */
+#define COMP_PIXMAP_POOL_SIZE   16
+
+typedef struct _CompPixmapPool {
+    size_t maxBytes;            /* CompositeSetPixmapPool(), 0 if off */
+    size_t bytes;
+    int num;
+    PixmapPtr pixmaps[COMP_PIXMAP_POOL_SIZE];   /* oldest first */
+    unsigned long hits, misses, evictions;
+} CompPixmapPoolRec, *CompPixmapPoolPtr;
+
 typedef struct _CompScreen {
     CopyWindowProcPtr CopyWindow;
     CreateWindowProcPtr CreateWindow;
@@ -166,8 +180,34 @@ typedef struct _CompScreen {
     CompOverlayClientPtr pOverlayClients;
 
     SourceValidateProcPtr SourceValidate;
+
+    /*
+     * Automatic redirection updates collected by compScreenUpdate,
+     * see comptile.c
+     */
+    Bool paintThreaded;         /* CompositeSetThreaded() */
+    Bool paintCollecting;
+    struct _CompPaintJob *paintJobs;
+    int numPaintJobs;
+    int sizePaintJobs;
+
+    CompPixmapPoolRec pixmapPool;
 } CompScreenRec, *CompScreenPtr;
 
+/*
+ * Copy of the damage of a redirected window into its parent: pSrc shows
+ * the window's pixmap, pDst the parent, clipped to region (in screen
+ * coordinates) and validated.  Jobs of a level only depend on jobs of
+ * lower levels.
+ */
+typedef struct _CompPaintJob {
+    RegionRec region;
+    PicturePtr pSrc, pDst;
+    PixmapPtr pSrcPixmap, pDstPixmap;
+    int xDst, yDst;             /* where the window's pixmap goes */
+    int level;
+} CompPaintJobRec, *CompPaintJobPtr;
+
 extern DevPrivateKeyRec CompScreenPrivateKeyRec;
 
 #define CompScreenPrivateKey (&CompScreenPrivateKeyRec)
@@ -321,6 +361,40 @@ void
 void
  compPaintChildrenToWindow(WindowPtr pWin);
 
+void
+ compPaintRun(ThreadPoolPtr pool, CompPaintJobPtr jobs, int njobs);
+
+void
+ compPaintBegin(ScreenPtr pScreen);
+
+Bool
+ compPaintQueueWindow(WindowPtr pWin);
+
+void
+ compPaintFlush(ScreenPtr pScreen);
+
+void
+ compPaintEnd(ScreenPtr pScreen);
+
+void
+ compPaintFini(ScreenPtr pScreen);
+
+void
+ compPixmapPoolInit(CompPixmapPoolPtr pool);
+
+PixmapPtr
+ compPixmapPoolGet(CompPixmapPoolPtr pool, ScreenPtr pScreen,
+                   int w, int h, int depth);
+
+void
+ compPixmapPoolPut(CompPixmapPoolPtr pool, PixmapPtr pPixmap);
+
+void
+ compPixmapPoolForget(CompPixmapPoolPtr pool, PixmapPtr pPixmap);
+
+void
+ compPixmapPoolFini(CompPixmapPoolPtr pool, ScreenPtr pScreen);
+
 WindowPtr
  CompositeRealChildHead(WindowPtr pWin);
 
@@ -39,4 +39,22 @@ extern _X_EXPORT Bool compIsAlternateVisual(ScreenPtr pScreen, XID visual);
 
 extern _X_EXPORT RESTYPE CompositeClientWindowType;
 
+/*
+ * Let automatic redirection updates run on worker threads, for screens
+ * whose pixmaps are all in system memory and drawn by fb.  Call after
+ * CompositeExtensionInit, e.g. from a post-CreateScreenResources hook,
+ * and before the screen has windows redirected.
+ */
+extern _X_EXPORT void CompositeSetThreaded(ScreenPtr pScreen, Bool threaded);
+
+/*
+ * Keep up to maxBytes of released backing pixmaps for reuse, for screens
+ * whose ModifyPixmapHeader can shrink a pixmap without reallocating it,
+ * like fb's.  Call after CompositeExtensionInit, e.g. from a
+ * post-CreateScreenResources hook, and before the screen has windows
+ * redirected.
+ */
+extern _X_EXPORT void CompositeSetPixmapPool(ScreenPtr pScreen,
+                                             size_t maxBytes);
+
 #endif                          /* _COMPOSITEEXT_H_ */
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Pool of backing pixmaps for redirected windows
+ *
+ * Every time a redirected window is mapped or resized it gets a new
+ * pixmap, and the old one is destroyed once its contents are copied over.
+ * Interactive resizes thus allocate and free a window sized pixmap per
+ * step.  On screens with pixmaps in plain memory (DDXes opt in with
+ * CompositeSetPixmapPool()), backing pixmaps are allocated in size
+ * classes instead: rounded up to a quarter of the next smaller power of
+ * two, their drawables then shrunk to the size asked for.  Released ones
+ * are kept around for the next window of the same depth and class, up to
+ * a byte limit, dropping the least recently released ones first.
+ *
+ * Only pixmaps nobody else holds can be pooled; once a client named one
+ * with NameWindowPixmap, it may hang on to it in ways without a
+ * reference, like DAMAGE objects, so it's destroyed as usual.
+ */
+
+#include <dix-config.h>
+
+#include "compint.h"
+
+#define COMP_PIXMAP_CLASS_MIN   64
+
+void
+CompositeSetPixmapPool(ScreenPtr pScreen, size_t maxBytes)
+{
+    CompScreenPtr cs;
+
+    if (!dixPrivateKeyRegistered(CompScreenPrivateKey))
+        return;
+    cs = GetCompScreen(pScreen);
+    if (cs)
+        cs->pixmapPool.maxBytes = maxBytes;
+}
+
+void
+compPixmapPoolInit(CompPixmapPoolPtr pool)
+{
+    memset(pool, 0, sizeof(*pool));
+}
+
+/* the size a pixmap dimension is allocated with */
+static int
+compPixmapClass(int size)
+{
+    int step = COMP_PIXMAP_CLASS_MIN;
+
+    while (step * 8 <= size)
+        step <<= 1;
+    size = (size + step - 1) & ~(step - 1);
+    return min(size, MAXSHORT);
+}
+
+static size_t
+compPixmapBytes(PixmapPtr pPixmap)
+{
+    return (size_t) pPixmap->devKind *
+        compPixmapClass(pPixmap->drawable.height);
+}
+
+static void
+compPixmapPoolRemove(CompPixmapPoolPtr pool, int i)
+{
+    pool->bytes -= compPixmapBytes(pool->pixmaps[i]);
+    pool->num--;
+    memmove(&pool->pixmaps[i], &pool->pixmaps[i + 1],
+            (pool->num - i) * sizeof(pool->pixmaps[0]));
+}
+
+PixmapPtr
+compPixmapPoolGet(CompPixmapPoolPtr pool, ScreenPtr pScreen,
+                  int w, int h, int depth)
+{
+    int cw = compPixmapClass(w), ch = compPixmapClass(h);
+    PixmapPtr pPixmap = NULL;
+
+    if (!pool->maxBytes)
+        return (*pScreen->CreatePixmap) (pScreen, w, h, depth,
+                                         CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+
+    /* the most recently released one is the most likely to be cached */
+    for (int i = pool->num - 1; i >= 0; i--) {
+        PixmapPtr p = pool->pixmaps[i];
+
+        if (p->drawable.depth == depth &&
+            compPixmapClass(p->drawable.width) == cw &&
+            compPixmapClass(p->drawable.height) == ch) {
+            compPixmapPoolRemove(pool, i);
+            pPixmap = p;
+            break;
+        }
+    }
+
+    if (pPixmap) {
+        pool->hits++;
+    }
+    else {
+        pool->misses++;
+        pPixmap = (*pScreen->CreatePixmap) (pScreen, cw, ch, depth,
+                                            CREATE_PIXMAP_USAGE_BACKING_PIXMAP);
+        if (!pPixmap)
+            return NULL;
+    }
+
+    /* keeps devKind, the rest of the rows stays unused */
+    (*pScreen->ModifyPixmapHeader) (pPixmap, w, h, 0, 0, 0, NULL);
+    return pPixmap;
+}
+
+void
+compPixmapPoolPut(CompPixmapPoolPtr pool, PixmapPtr pPixmap)
+{
+    size_t bytes;
+
+    if (!pool->maxBytes || pPixmap->refcnt != 1 ||
+        pPixmap->usage_hint != CREATE_PIXMAP_USAGE_BACKING_PIXMAP) {
+        dixDestroyPixmap(pPixmap, 0);
+        return;
+    }
+
+    bytes = compPixmapBytes(pPixmap);
+    if (bytes > pool->maxBytes) {
+        dixDestroyPixmap(pPixmap, 0);
+        return;
+    }
+    while (pool->num == COMP_PIXMAP_POOL_SIZE ||
+           pool->bytes + bytes > pool->maxBytes) {
+        PixmapPtr pOldest = pool->pixmaps[0];
+
+        compPixmapPoolRemove(pool, 0);
+        dixDestroyPixmap(pOldest, 0);
+        pool->evictions++;
+    }
+    pool->pixmaps[pool->num++] = pPixmap;
+    pool->bytes += bytes;
+}
+
+void
+compPixmapPoolForget(CompPixmapPoolPtr pool, PixmapPtr pPixmap)
+{
+    if (pool->maxBytes)
+        pPixmap->usage_hint = 0;
+}
+
+void
+compPixmapPoolFini(CompPixmapPoolPtr pool, ScreenPtr pScreen)
+{
+    unsigned long gets = pool->hits + pool->misses;
+
+    if (gets)
+        LogMessageVerb(X_INFO, 3,
+                       "composite: screen %d backing pixmaps: %lu of %lu "
+                       "from the pool (%lu%%), %lu evicted\n",
+                       pScreen->myNum, pool->hits, gets,
+                       pool->hits * 100 / gets, pool->evictions);
+    while (pool->num) {
+        PixmapPtr pPixmap = pool->pixmaps[pool->num - 1];
+
+        compPixmapPoolRemove(pool, pool->num - 1);
+        dixDestroyPixmap(pPixmap, 0);
+    }
+}
@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Threaded updates of automatically redirected windows
+ *
+ * With lots of redirected windows on a software rendered screen, copying
+ * their pixmaps into the parents is most of the work of a frame, and all
+ * of it happens in compScreenUpdate() on the main thread.  Screens drawn
+ * by fb with their pixmaps in plain memory (DDXes opt in with
+ * CompositeSetThreaded()) collect those updates instead, and then do them
+ * at once with fbCompositeValidated() on the server's worker threads, a
+ * window per task.  Big windows are done one at a time, fb splits those
+ * up into bands itself.
+ *
+ * An update reads the window's pixmap and writes the parent's.  Updates
+ * into pixmaps other updates read from are done first, so each update
+ * gets a level, and those of a level don't depend on each other: siblings
+ * write disjoint parts of their parent, as their border clips don't
+ * overlap.  That doesn't hold for pixels smaller than a byte, so those
+ * aren't queued.  The queue is emptied before compScreenUpdate() returns,
+ * since any request after that may read or draw the parents.
+ */
+
+#include <dix-config.h>
+
+#include "fb/fbpict_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "compint.h"
+#include "mipict.h"
+
+void
+CompositeSetThreaded(ScreenPtr pScreen, Bool threaded)
+{
+    CompScreenPtr cs;
+
+    if (!dixPrivateKeyRegistered(CompScreenPrivateKey))
+        return;
+    cs = GetCompScreen(pScreen);
+    if (cs)
+        cs->paintThreaded = threaded && ThreadPoolDefaultThreads() > 1;
+}
+
+/* whether workers can write a pixmap without touching their neighbours' */
+static Bool
+compPaintPixmap(PixmapPtr pPixmap)
+{
+    return pPixmap->drawable.bitsPerPixel >= 8 && pPixmap->devPrivate.ptr;
+}
+
+static unsigned long
+compPaintArea(CompPaintJobPtr job)
+{
+    BoxPtr extents = RegionExtents(&job->region);
+
+    return (unsigned long) (extents->x2 - extents->x1) *
+        (extents->y2 - extents->y1);
+}
+
+static void
+compPaintJob(CompPaintJobPtr job)
+{
+    fbCompositeValidated(PictOpSrc, job->pSrc, NULL, job->pDst,
+                         0, 0, 0, 0, job->xDst, job->yDst,
+                         job->pSrcPixmap->drawable.width,
+                         job->pSrcPixmap->drawable.height);
+}
+
+static void
+compPaintTask(void *data, int i)
+{
+    compPaintJob(((CompPaintJobPtr *) data)[i]);
+}
+
+void
+compPaintRun(ThreadPoolPtr pool, CompPaintJobPtr jobs, int njobs)
+{
+    CompPaintJobPtr *tasks;
+    int maxLevel = 0;
+    unsigned long area = 0;
+
+    for (int i = 0; i < njobs; i++) {
+        maxLevel = max(maxLevel, jobs[i].level);
+        area += compPaintArea(&jobs[i]);
+    }
+    if (area < THREADPOOL_MIN_AREA)
+        pool = NULL;
+
+    tasks = calloc(max(njobs, 1), sizeof(CompPaintJobPtr));
+    for (int level = 0; level <= maxLevel; level++) {
+        int n = 0;
+
+        for (int i = 0; i < njobs; i++) {
+            if (jobs[i].level != level)
+                continue;
+            /* big ones get bands of their own, no memory for tasks either */
+            if (!pool || !tasks ||
+                compPaintArea(&jobs[i]) >= THREADPOOL_MIN_AREA)
+                compPaintJob(&jobs[i]);
+            else
+                tasks[n++] = &jobs[i];
+        }
+        if (n)
+            ThreadPoolRun(pool, compPaintTask, tasks, n);
+    }
+    free(tasks);
+}
+
+void
+compPaintBegin(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+
+    cs->paintCollecting = cs->paintThreaded;
+}
+
+Bool
+compPaintQueueWindow(WindowPtr pWin)
+{
+    ScreenPtr pScreen = pWin->drawable.pScreen;
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    CompWindowPtr cw = GetCompWindow(pWin);
+    WindowPtr pParent = pWin->parent;
+    PictFormatPtr pSrcFormat = PictureWindowFormat(pWin);
+    PictFormatPtr pDstFormat = PictureWindowFormat(pParent);
+    PixmapPtr pSrcPixmap, pDstPixmap;
+    PicturePtr pSrcPicture, pDstPicture;
+    XID subwindowMode = IncludeInferiors;
+    RegionPtr pDamage;
+    RegionRec clip;
+    CompPaintJobPtr job;
+    int error;
+
+    if (!cs->paintCollecting || !pSrcFormat || !pDstFormat)
+        return FALSE;
+    pSrcPixmap = (*pScreen->GetWindowPixmap) (pWin);
+    pDstPixmap = (*pScreen->GetWindowPixmap) (pParent);
+    if (!compPaintPixmap(pSrcPixmap) || !compPaintPixmap(pDstPixmap))
+        return FALSE;
+
+    if (cs->numPaintJobs == cs->sizePaintJobs) {
+        int size = cs->sizePaintJobs ? cs->sizePaintJobs * 2 : 16;
+        CompPaintJobPtr jobs = reallocarray(cs->paintJobs, size,
+                                            sizeof(CompPaintJobRec));
+
+        if (!jobs)
+            return FALSE;
+        cs->paintJobs = jobs;
+        cs->sizePaintJobs = size;
+    }
+    job = &cs->paintJobs[cs->numPaintJobs];
+
+    pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable, pSrcFormat,
+                                0, 0, serverClient, &error);
+    pDstPicture = CreatePicture(0, &pParent->drawable, pDstFormat,
+                                CPSubwindowMode, &subwindowMode,
+                                serverClient, &error);
+    if (!pSrcPicture || !pDstPicture) {
+        if (pSrcPicture)
+            FreePicture(pSrcPicture, 0);
+        if (pDstPicture)
+            FreePicture(pDstPicture, 0);
+        return FALSE;
+    }
+
+    /*
+     * What compWindowUpdateAutomatic() clips the composite to, in screen
+     * coordinates: the damage inside the real border clip, and the parent
+     * as drawn with IncludeInferiors.
+     */
+    pDamage = DamageRegion(cw->damage);
+    RegionTranslate(pDamage, pWin->drawable.x, pWin->drawable.y);
+    RegionNull(&job->region);
+    RegionIntersect(&job->region, pDamage, &cw->borderClip);
+    RegionIntersect(&job->region, &job->region, &pParent->borderClip);
+    RegionIntersect(&job->region, &job->region, &pParent->winSize);
+
+    RegionNull(&clip);
+    RegionCopy(&clip, &job->region);
+    RegionTranslate(&clip, -pParent->drawable.x, -pParent->drawable.y);
+    error = SetPictureClipRegion(pDstPicture, 0, 0, &clip);
+    RegionUninit(&clip);
+
+    if (error == Success)
+        DamageEmpty(cw->damage);
+    else    /* compWindowUpdateAutomatic() gets the damage as it was */
+        RegionTranslate(pDamage, -pWin->drawable.x, -pWin->drawable.y);
+    if (error != Success || !RegionNotEmpty(&job->region)) {
+        RegionUninit(&job->region);
+        FreePicture(pSrcPicture, 0);
+        FreePicture(pDstPicture, 0);
+        return error == Success;
+    }
+
+    /* everything that isn't safe on the workers */
+    ValidatePicture(pSrcPicture);
+    ValidatePicture(pDstPicture);
+    miCompositeSourceValidate(pSrcPicture);
+
+    job->pSrc = pSrcPicture;
+    job->pDst = pDstPicture;
+    job->pSrcPixmap = pSrcPixmap;
+    job->pDstPixmap = pDstPixmap;
+    job->xDst = pSrcPixmap->screen_x - pParent->drawable.x;
+    job->yDst = pSrcPixmap->screen_y - pParent->drawable.y;
+    /* after the updates drawing into our pixmap */
+    job->level = 0;
+    for (int i = 0; i < cs->numPaintJobs; i++) {
+        if (cs->paintJobs[i].pDstPixmap == pSrcPixmap)
+            job->level = max(job->level, cs->paintJobs[i].level + 1);
+    }
+    cs->numPaintJobs++;
+
+    /*
+     * Like CompositePicture() would, before the pixels are there; that's
+     * only after the queue is flushed, before anybody can look.  If the
+     * parent is redirected too, this queues it up as well.
+     */
+    DamageDamageRegion(&pParent->drawable, &job->region);
+    return TRUE;
+}
+
+void
+compPaintFlush(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+    ThreadPoolPtr pool;
+
+    if (!cs->numPaintJobs)
+        return;
+
+    pool = ThreadPoolServer();
+    /* no workers, these are done inline and the next ones unqueued */
+    if (!pool)
+        cs->paintThreaded = FALSE;
+    compPaintRun(pool, cs->paintJobs, cs->numPaintJobs);
+
+    for (int i = 0; i < cs->numPaintJobs; i++) {
+        RegionUninit(&cs->paintJobs[i].region);
+        FreePicture(cs->paintJobs[i].pSrc, 0);
+        FreePicture(cs->paintJobs[i].pDst, 0);
+    }
+    cs->numPaintJobs = 0;
+}
+
+void
+compPaintEnd(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+
+    compPaintFlush(pScreen);
+    cs->paintCollecting = FALSE;
+}
+
+void
+compPaintFini(ScreenPtr pScreen)
+{
+    CompScreenPtr cs = GetCompScreen(pScreen);
+
+    free(cs->paintJobs);
+}
@@ -179,7 +179,7 @@ compCheckRedirect(WindowPtr pWin)
 
             compSetParentPixmap(pWin);
             compRestoreWindow(pWin, pPixmap);
-            dixDestroyPixmap(pPixmap, 0);
+            compPixmapPoolPut(&cs->pixmapPool, pPixmap);
         }
     }
     else if (should) {
@@ -368,7 +368,9 @@ compFreeOldPixmap(WindowPtr pWin)
         CompWindowPtr cw = GetCompWindow(pWin);
 
         if (cw->pOldPixmap) {
-            dixDestroyPixmap(cw->pOldPixmap, 0);
+            CompScreenPtr cs = GetCompScreen(pWin->drawable.pScreen);
+
+            compPixmapPoolPut(&cs->pixmapPool, cw->pOldPixmap);
             cw->pOldPixmap = NullPixmap;
         }
     }
@@ -596,7 +598,7 @@ void compWindowDestroy(CallbackListPtr *pcbl, ScreenPtr pScreen, WindowPtr pWin)
         PixmapPtr pPixmap = (*pScreen->GetWindowPixmap) (pWin);
 
         compSetParentPixmap(pWin);
-        dixDestroyPixmap(pPixmap, 0);
+        compPixmapPoolPut(&cs->pixmapPool, pPixmap);
     }
 
     /* Did we just destroy the overlay window? */
@@ -655,18 +657,25 @@ compWindowUpdateAutomatic(WindowPtr pWin)
     PictFormatPtr pDstFormat = PictureWindowFormat(pWin->parent);
     int error;
     RegionPtr pRegion = DamageRegion(cw->damage);
-    PicturePtr pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
-                                           pSrcFormat,
-                                           0, 0,
-                                           serverClient,
-                                           &error);
+    PicturePtr pSrcPicture, pDstPicture;
     XID subwindowMode = IncludeInferiors;
-    PicturePtr pDstPicture = CreatePicture(0, &pParent->drawable,
-                                           pDstFormat,
-                                           CPSubwindowMode,
-                                           &subwindowMode,
-                                           serverClient,
-                                           &error);
+
+    if (compPaintQueueWindow(pWin))
+        return;
+    /* the updates this one depends on have to be done first */
+    compPaintFlush(pScreen);
+
+    pSrcPicture = CreatePicture(0, &pSrcPixmap->drawable,
+                                pSrcFormat,
+                                0, 0,
+                                serverClient,
+                                &error);
+    pDstPicture = CreatePicture(0, &pParent->drawable,
+                                pDstFormat,
+                                CPSubwindowMode,
+                                &subwindowMode,
+                                serverClient,
+                                &error);
 
     /*
      * First move the region from window to screen coordinates
@@ -46,6 +46,7 @@ SOFTWARE.
 
 #include <dix-config.h>
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <X11/X.h>
@@ -59,84 +60,205 @@ SOFTWARE.
 #include "dix.h"
 
 #define InitialTableSize 256
+#define InitialHashSize 512
+#define AtomArenaChunkSize 16384
 
-typedef struct _Node {
-    struct _Node *left, *right;
-    Atom a;
-    unsigned int fingerPrint;
-    const char *string;
-} NodeRec, *NodePtr;
+/*
+ * Atoms are never freed individually, so the name lookup is an open
+ * addressing table with linear probing and no tombstones.  Each slot keeps
+ * the full hash of its name, so growing the table never has to touch the
+ * strings again and most probe mismatches are rejected without a memcmp.
+ */
+typedef struct _AtomSlot {
+    uint32_t hash;
+    Atom a;                     /* None marks an empty slot */
+} AtomSlotRec, *AtomSlotPtr;
+
+/*
+ * Names of non-predefined atoms are packed into a chain of bump-allocated
+ * chunks instead of getting one heap block each.
+ */
+typedef struct _AtomChunk {
+    struct _AtomChunk *next;
+    size_t used;
+    size_t size;
+    char data[];
+} AtomChunkRec, *AtomChunkPtr;
 
 static Atom lastAtom = None;
-static NodePtr atomRoot = NULL;
+
+/* indexed by Atom */
 static unsigned long tableLength;
-static NodePtr *nodeTable;
+static const char **atomNames;
+static uint32_t *atomLengths;
 
-Atom
-MakeAtom(const char *string, unsigned len, Bool makeit)
+static unsigned long hashSize;  /* always a power of two */
+static AtomSlotPtr hashTable;
+
+static AtomChunkPtr atomArena;
+
+static uint64_t
+AtomMix(uint64_t h)
 {
-    NodePtr *np;
-    int comp;
-    unsigned int fp = 0;
-
-    np = &atomRoot;
-    for (unsigned int i = 0; i < (len + 1) / 2; i++) {
-        fp = fp * 27 + (unsigned int)string[i];
-        fp = fp * 27 + (unsigned int)string[len - 1 - i];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint32_t
+AtomHash(const char *string, unsigned len)
+{
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ len;
+    uint64_t w;
+
+    while (len >= sizeof(w)) {
+        memcpy(&w, string, sizeof(w));
+        h = (h ^ AtomMix(w)) * 0x87c37b91114253d5ULL;
+        string += sizeof(w);
+        len -= sizeof(w);
     }
-    while (*np != NULL) {
-        if (fp < (*np)->fingerPrint)
-            np = &((*np)->left);
-        else if (fp > (*np)->fingerPrint)
-            np = &((*np)->right);
-        else {                  /* now start testing the strings */
-            comp = strncmp(string, (*np)->string, len);
-            if ((comp < 0) || ((comp == 0) && (len < strlen((*np)->string))))
-                np = &((*np)->left);
-            else if (comp > 0)
-                np = &((*np)->right);
-            else
-                return (*np)->a;
-        }
+    if (len) {
+        w = 0;
+        memcpy(&w, string, len);
+        h = (h ^ AtomMix(w)) * 0x87c37b91114253d5ULL;
     }
-    if (makeit) {
-        NodePtr nd = calloc(1, sizeof(NodeRec));
-        if (!nd)
-            return BAD_RESOURCE;
-        if (lastAtom < XA_LAST_PREDEFINED) {
-            nd->string = string;
-        }
-        else {
-            nd->string = strndup(string, len);
-            if (!nd->string) {
-                free(nd);
-                return BAD_RESOURCE;
-            }
-        }
-        if ((lastAtom + 1) >= tableLength) {
-            NodePtr *table;
-
-            table = reallocarray(nodeTable, tableLength, 2 * sizeof(NodePtr));
-            if (!table) {
-                if (nd->string != string) {
-                    /* nd->string has been strdup'ed */
-                    free((char *) nd->string);
-                }
-                free(nd);
-                return BAD_RESOURCE;
-            }
-            tableLength <<= 1;
-            nodeTable = table;
-        }
-        *np = nd;
-        nd->left = nd->right = NULL;
-        nd->fingerPrint = fp;
-        nd->a = ++lastAtom;
-        nodeTable[lastAtom] = nd;
-        return nd->a;
+    return (uint32_t) AtomMix(h);
+}
+
+static char *
+AtomArenaStrndup(const char *string, unsigned len)
+{
+    AtomChunkPtr chunk = atomArena;
+    char *dst;
+
+    if (!chunk || chunk->size - chunk->used < (size_t) len + 1) {
+        size_t size = AtomArenaChunkSize;
+
+        if (size < (size_t) len + 1)
+            size = (size_t) len + 1;
+        chunk = malloc(sizeof(AtomChunkRec) + size);
+        if (!chunk)
+            return NULL;
+        chunk->used = 0;
+        chunk->size = size;
+        chunk->next = atomArena;
+        atomArena = chunk;
+    }
+
+    dst = chunk->data + chunk->used;
+    memcpy(dst, string, len);
+    dst[len] = '\0';
+    chunk->used += (size_t) len + 1;
+    return dst;
+}
+
+static AtomSlotPtr
+AtomFindSlot(const char *string, unsigned len, uint32_t hash)
+{
+    unsigned long mask = hashSize - 1;
+    unsigned long i = hash & mask;
+
+    for (;;) {
+        AtomSlotPtr slot = &hashTable[i];
+
+        if (slot->a == None)
+            return slot;
+        if (slot->hash == hash && atomLengths[slot->a] == len &&
+            memcmp(atomNames[slot->a], string, len) == 0)
+            return slot;
+        i = (i + 1) & mask;
+    }
+}
+
+static Bool
+AtomGrowHash(void)
+{
+    unsigned long newSize = hashSize << 1;
+    unsigned long mask = newSize - 1;
+    AtomSlotPtr newTable;
+
+    newTable = calloc(newSize, sizeof(AtomSlotRec));
+    if (!newTable)
+        return FALSE;
+
+    for (unsigned long i = 0; i < hashSize; i++) {
+        unsigned long j;
+
+        if (hashTable[i].a == None)
+            continue;
+        for (j = hashTable[i].hash & mask; newTable[j].a != None;
+             j = (j + 1) & mask)
+            ;
+        newTable[j] = hashTable[i];
     }
-    else
+
+    free(hashTable);
+    hashTable = newTable;
+    hashSize = newSize;
+    return TRUE;
+}
+
+static Bool
+AtomGrowTable(void)
+{
+    const char **names;
+    uint32_t *lengths;
+
+    names = reallocarray(atomNames, tableLength, 2 * sizeof(*atomNames));
+    if (!names)
+        return FALSE;
+    atomNames = names;
+
+    lengths = reallocarray(atomLengths, tableLength, 2 * sizeof(*atomLengths));
+    if (!lengths)
+        return FALSE;
+    atomLengths = lengths;
+
+    tableLength <<= 1;
+    return TRUE;
+}
+
+Atom
+MakeAtom(const char *string, unsigned len, Bool makeit)
+{
+    uint32_t hash;
+    AtomSlotPtr slot;
+    const char *name;
+
+    /* before InitAtoms(), or after FreeAllAtoms() during a reset */
+    if (hashSize == 0)
         return None;
+
+    hash = AtomHash(string, len);
+    slot = AtomFindSlot(string, len, hash);
+    if (slot->a != None)
+        return slot->a;
+    if (!makeit)
+        return None;
+
+    /* keep the load factor below 3/4 so probe sequences stay short */
+    if ((lastAtom + 1) * 4 >= hashSize * 3) {
+        if (!AtomGrowHash())
+            return BAD_RESOURCE;
+        slot = AtomFindSlot(string, len, hash);
+    }
+    if ((lastAtom + 1) >= tableLength && !AtomGrowTable())
+        return BAD_RESOURCE;
+
+    if (lastAtom < XA_LAST_PREDEFINED)
+        name = string;
+    else if (!(name = AtomArenaStrndup(string, len)))
+        return BAD_RESOURCE;
+
+    lastAtom++;
+    atomNames[lastAtom] = name;
+    atomLengths[lastAtom] = len;
+    slot->hash = hash;
+    slot->a = lastAtom;
+    return lastAtom;
 }
 
 Bool
@@ -148,41 +270,28 @@ ValidAtom(Atom atom)
 const char *
 NameForAtom(Atom atom)
 {
-    NodePtr node;
-
-    if (atom > lastAtom)
+    if (atom > lastAtom || !atomNames)
         return 0;
-    if ((node = nodeTable[atom]) == NULL)
-        return 0;
-    return node->string;
-}
-
-static void
-FreeAtom(NodePtr patom)
-{
-    if (patom->left)
-        FreeAtom(patom->left);
-    if (patom->right)
-        FreeAtom(patom->right);
-    if (patom->a > XA_LAST_PREDEFINED) {
-        /*
-         * All strings above XA_LAST_PREDEFINED are strdup'ed, so it's safe to
-         * cast here
-         */
-        free((char *) patom->string);
-    }
-    free(patom);
+    return atomNames[atom];
 }
 
 void
 FreeAllAtoms(void)
 {
-    if (atomRoot == NULL)
-        return;
-    FreeAtom(atomRoot);
-    atomRoot = NULL;
-    free(nodeTable);
-    nodeTable = NULL;
+    while (atomArena) {
+        AtomChunkPtr next = atomArena->next;
+
+        free(atomArena);
+        atomArena = next;
+    }
+    free(hashTable);
+    hashTable = NULL;
+    hashSize = 0;
+    free(atomNames);
+    atomNames = NULL;
+    free(atomLengths);
+    atomLengths = NULL;
+    tableLength = 0;
     lastAtom = None;
 }
 
@@ -191,10 +300,13 @@ InitAtoms(void)
 {
     FreeAllAtoms();
     tableLength = InitialTableSize;
-    nodeTable = calloc(InitialTableSize, sizeof(NodePtr));
-    if (!nodeTable)
+    atomNames = calloc(InitialTableSize, sizeof(*atomNames));
+    atomLengths = calloc(InitialTableSize, sizeof(*atomLengths));
+    hashSize = InitialHashSize;
+    hashTable = calloc(InitialHashSize, sizeof(AtomSlotRec));
+    if (!atomNames || !atomLengths || !hashTable)
         FatalError("creating atom table");
-    nodeTable[None] = NULL;
+    atomNames[None] = NULL;
     MakePredeclaredAtoms();
     if (lastAtom != XA_LAST_PREDEFINED)
         FatalError("builtin atom number mismatch");
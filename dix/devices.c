@@ -99,6 +99,33 @@ CallbackListPtr DeviceAccessCallback = NULL;
 
 static void RecalculateMasterButtons(DeviceIntPtr slave);
 
+static Bool
+IsIdentityTransform(const struct pixman_f_transform *m)
+{
+    for (int y = 0; y < 3; y++)
+        for (int x = 0; x < 3; x++)
+            if (m->m[y][x] != (x == y ? 1.0 : 0.0))
+                return FALSE;
+    return TRUE;
+}
+
+/**
+ * Precompute what transformAbsolute() and transformRelative() need for
+ * each event: the inverse of the absolute matrix, and whether the
+ * matrices do anything at all.
+ */
+static void
+DeviceUpdateTransforms(DeviceIntPtr dev)
+{
+    dev->relative_transform_identity =
+        IsIdentityTransform(&dev->relative_transform);
+    dev->scale_and_transform_identity =
+        IsIdentityTransform(&dev->scale_and_transform);
+    if (!pixman_f_transform_invert(&dev->scale_and_transform_inverse,
+                                   &dev->scale_and_transform))
+        pixman_f_transform_init_identity(&dev->scale_and_transform_inverse);
+}
+
 static void
 DeviceSetTransform(DeviceIntPtr dev, float *transform_data)
 {
@@ -144,6 +171,8 @@ DeviceSetTransform(DeviceIntPtr dev, float *transform_data)
     dev->relative_transform = transform;
     dev->relative_transform.m[0][2] = 0;
     dev->relative_transform.m[1][2] = 0;
+
+    DeviceUpdateTransforms(dev);
 }
 
 /**
@@ -325,6 +354,7 @@ AddInputDevice(ClientPtr client, DeviceProc deviceProc, Bool autoStart)
     dev->relative_transform.m[1][1] = 1.0;
     dev->relative_transform.m[2][2] = 1.0;
     dev->scale_and_transform = dev->relative_transform;
+    DeviceUpdateTransforms(dev);
 
     XIChangeDeviceProperty(dev, XIGetKnownProperty(XI_PROP_TRANSFORM),
                            XIGetKnownProperty(XATOM_FLOAT), 32,
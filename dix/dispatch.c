@@ -108,9 +108,11 @@ Equipment Corporation.
 #include "dix/cursor_priv.h"
 #include "dix/dix_priv.h"
 #include "dix/extension_priv.h"
+#include "dix/fairsched_priv.h"
 #include "dix/input_priv.h"
 #include "dix/gc_priv.h"
 #include "dix/registry_priv.h"
+#include "dix/reqprof_priv.h"
 #include "dix/request_priv.h"
 #include "dix/resource_priv.h"
 #include "dix/screenint_priv.h"
@@ -286,8 +288,10 @@ clients_are_ready(void)
 void
 mark_client_ready(ClientPtr client)
 {
-    if (xorg_list_is_empty(&client->ready))
+    if (xorg_list_is_empty(&client->ready)) {
+        FairSchedWake(client);
         xorg_list_append(&client->ready, &ready_clients);
+    }
 }
 
 /*
@@ -346,6 +350,13 @@ SmartScheduleClient(void)
     xorg_list_for_each_entry(pClient, &ready_clients, ready) {
         nready++;
 
+        /* the one which got the least weighted CPU time so far */
+        if (FairScheduling) {
+            if (!best || FairSchedBefore(pClient, best))
+                best = pClient;
+            continue;
+        }
+
         /* Praise clients which haven't run in a while */
         if ((now - pClient->smart_stop_tick) >= idle) {
             if (pClient->smart_priority < 0)
@@ -380,6 +391,7 @@ SmartScheduleClient(void)
     }
 #endif
     SmartLastIndex[best->smart_priority - SMART_MIN_PRIORITY] = best->index;
+    FairSchedPicked(best);
     /*
      * Set current client pointer
      */
@@ -480,6 +492,8 @@ Dispatch(void)
     int result;
     ClientPtr client;
     long start_tick;
+    CARD64 req_start, cpu_start;
+    int index;
 
     nextFreeClientID = 1;
     nClients = 0;
@@ -507,6 +521,8 @@ Dispatch(void)
             isItTimeToYield = FALSE;
 
             start_tick = SmartScheduleTime;
+            cpu_start = FairSchedCpuTime();
+            index = client->index;
             while (!isItTimeToYield) {
                 if (InputCheckPending())
                     ProcessInputEvents();
@@ -546,6 +562,7 @@ Dispatch(void)
                                           client->index,
                                           client->requestBuffer);
 #endif
+                req_start = ReqProfStart();
                 if (result < 0 || result > (maxBigRequestSize << 2))
                     result = BadLength;
                 else {
@@ -568,6 +585,7 @@ Dispatch(void)
                 }
                 if (!SmartScheduleSignalEnable)
                     SmartScheduleTime = GetTimeInMillis();
+                ReqProfDone(client, req_start);
 
 #ifdef XSERVER_DTRACE
                 if (XSERVER_REQUEST_DONE_ENABLED())
@@ -587,6 +605,7 @@ Dispatch(void)
                     break;
                 }
             }
+            FairSchedCharge(index, FairSchedCpuTime() - cpu_start);
             FlushAllOutput();
             if (client == SmartLastClient)
                 client->smart_stop_tick = SmartScheduleTime;
@@ -3630,6 +3649,7 @@ CloseDownClient(ClientPtr client)
         if (ClientIsAsleep(client))
             dixClientSignal(client);
         ProcessWorkQueueZombies();
+        ReqProfClientGone(client);
         CloseDownConnection(client);
         output_pending_clear(client);
         mark_client_not_ready(client);
@@ -3706,6 +3726,7 @@ InitClient(ClientPtr client, int i, void *ospriv)
     client->smart_start_tick = SmartScheduleTime;
     client->smart_stop_tick = SmartScheduleTime;
     client->clientIds = NULL;
+    FairSchedInitClient(client);
 }
 
 /************************
@@ -283,6 +283,8 @@ static struct DeviceEventTime {
 static xEvent *swapEvent = NULL;
 static int swapEventLen = 0;
 
+Bool CoalesceMotionEvents = FALSE;
+
 void
 NotImplemented(xEvent *from, xEvent *to)
 {
@@ -6029,6 +6031,35 @@ ProcRecolorCursor(ClientPtr client)
  * @param count Number of events.
  * @param events The event list.
  */
+/*
+ * With -coalescemotion, a core motion event replaces the previous one
+ * still waiting in the client's output buffer, if that was written in
+ * the same output batch (see mieqProcessInputEvents()) and only differs
+ * in time and position.  ev may be byte swapped already; the fields are
+ * only compared for equality, so that doesn't matter.
+ */
+static Bool
+CoalesceMotionEvent(ClientPtr pClient, const xEvent *ev)
+{
+    xEvent *last;
+
+    if (!CoalesceMotionEvents || ev->u.u.type != MotionNotify ||
+        EventCallback)
+        return FALSE;
+    last = OutputBatchLastEvent(pClient);
+    if (!last || last->u.u.type != MotionNotify ||
+        last->u.u.detail != ev->u.u.detail ||
+        last->u.keyButtonPointer.root != ev->u.keyButtonPointer.root ||
+        last->u.keyButtonPointer.event != ev->u.keyButtonPointer.event ||
+        last->u.keyButtonPointer.child != ev->u.keyButtonPointer.child ||
+        last->u.keyButtonPointer.state != ev->u.keyButtonPointer.state ||
+        last->u.keyButtonPointer.sameScreen !=
+        ev->u.keyButtonPointer.sameScreen)
+        return FALSE;
+    memcpy(last, ev, sizeof(xEvent));
+    return TRUE;
+}
+
 void
 WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
 {
@@ -6128,15 +6159,22 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
             (*EventSwapVector[eventFrom->u.u.type & 0177])
                 (eventFrom, eventTo);
 
+            if (count == 1 && CoalesceMotionEvent(pClient, eventTo))
+                return;
             WriteToClient(pClient, eventlength, eventTo);
         }
     }
     else {
+        if (count == 1 && CoalesceMotionEvent(pClient, events))
+            return;
         /* only one GenericEvent, remember? that means either count is 1 and
          * eventlength is arbitrary or eventlength is 32 and count doesn't
          * matter. And we're all set. Woohoo. */
         WriteToClient(pClient, count * eventlength, events);
     }
+
+    if (count == 1 && events->u.u.type == MotionNotify)
+        OutputBatchMarkEvent(pClient);
 }
 
 /*
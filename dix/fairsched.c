@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Per client CPU accounting and fair share scheduling
+ *
+ * The smart scheduler hands out time slices by wall clock time and
+ * priority, without knowing what a client's requests actually cost.  A
+ * client flooding expensive requests gets demoted a bit, but keeps taking
+ * a slice whenever it comes up, however long its requests take.
+ *
+ * So Dispatch() reads the CPU clock around every turn it gives a client,
+ * and charges the difference to that client here.  That's the dispatch
+ * thread's CPU time, plus what the worker threads spent on the tasks it
+ * handed them meanwhile.  It goes into the client's request profile,
+ * which is where the numbers can be queried from; that's all that
+ * happens by default.
+ *
+ * With -fairsched, ready clients are scheduled by weighted fair queueing
+ * instead: each client's CPU time is scaled by its priority, every step up
+ * halving it, and the ready client with the least of that virtual time
+ * runs next.  Clients competing for the server thus get shares of its CPU
+ * time in proportion to their weights, however expensive their requests.
+ * Virtual time doesn't accumulate while a client is idle: when it gets
+ * ready again, it is caught up to the clients which kept running, less
+ * one maximal time slice as a bonus for having waited.
+ */
+
+#include <dix-config.h>
+
+#include <string.h>
+#include <time.h>
+
+#include "dix/dixstruct_priv.h"
+#include "dix/fairsched_priv.h"
+#include "dix/reqprof_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "misc.h"
+#include "os.h"
+
+/* clients' weights range from 1/256 to 256 */
+#define FAIRSCHED_MAX_SHIFT 8
+
+Bool FairScheduling = FALSE;
+
+static uint64_t fairVirtualTime;        /* of the clients which keep running */
+static uint64_t totalNs;
+
+CARD64
+FairSchedCpuTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return (CARD64) ts.tv_sec * 1000000000 + ts.tv_nsec +
+            ThreadPoolCpuTime();
+#endif
+    /* wall clock time, which includes waiting for the workers */
+    return GetTimeInMicros() * 1000;
+}
+
+CARD64
+FairSchedTotalCpuTime(void)
+{
+    return totalNs;
+}
+
+void
+FairSchedInitClient(ClientPtr client)
+{
+    FairSchedClientRec *c = ReqProfSchedClient(client->index);
+
+    memset(c, 0, sizeof(*c));
+    c->vtime = fairVirtualTime;
+}
+
+void
+FairSchedWake(ClientPtr client)
+{
+    FairSchedClientRec *c = ReqProfSchedClient(client->index);
+    uint64_t credit = (uint64_t) SmartScheduleMaxSlice * 1000000;
+
+    if (fairVirtualTime > credit && c->vtime < fairVirtualTime - credit)
+        c->vtime = fairVirtualTime - credit;
+}
+
+static uint64_t
+FairSchedWeigh(ClientPtr client, uint64_t ns)
+{
+    int shift = client->priority;
+
+    if (shift > FAIRSCHED_MAX_SHIFT)
+        shift = FAIRSCHED_MAX_SHIFT;
+    if (shift < -FAIRSCHED_MAX_SHIFT)
+        shift = -FAIRSCHED_MAX_SHIFT;
+    return shift >= 0 ? ns >> shift : ns << -shift;
+}
+
+/* the client at index may have gone during its turn */
+void
+FairSchedCharge(int index, CARD64 ns)
+{
+    ClientPtr client = clients[index];
+    FairSchedClientRec *c = ReqProfSchedClient(index);
+
+    totalNs += ns;
+    if (!client || client->clientGone)
+        return;
+    c->cpuNs += ns;
+    c->vtime += FairSchedWeigh(client, ns);
+}
+
+void
+FairSchedPicked(ClientPtr client)
+{
+    FairSchedClientRec *c = ReqProfSchedClient(client->index);
+
+    c->turns++;
+    if (c->vtime > fairVirtualTime)
+        fairVirtualTime = c->vtime;
+}
+
+Bool
+FairSchedBefore(ClientPtr a, ClientPtr b)
+{
+    return ReqProfSchedClient(a->index)->vtime <
+        ReqProfSchedClient(b->index)->vtime;
+}
+
+const FairSchedClientRec *
+FairSchedGetClient(ClientPtr client)
+{
+    return ReqProfSchedClient(client->index);
+}
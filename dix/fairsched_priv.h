@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+#ifndef _XSERVER_DIX_FAIRSCHED_PRIV_H
+#define _XSERVER_DIX_FAIRSCHED_PRIV_H
+
+#include <stdint.h>
+#include <X11/Xdefs.h>
+#include <X11/Xmd.h>
+
+#include "include/dix.h"
+#include "include/dixstruct.h"
+
+/*
+ * Per client CPU accounting and fair share scheduling.
+ *
+ * Dispatch() charges the CPU time each client's turn takes, on the
+ * dispatch thread and on the worker threads it hands tasks to, to that
+ * client.  With FairScheduling, SmartScheduleClient() picks the ready
+ * client which got the least CPU time, weighted by its priority, instead
+ * of going by priority first.
+ *
+ * The clients' records are kept with their request profiles.
+ */
+
+typedef struct _FairSchedClient {
+    uint64_t cpuNs;             /* spent on the client's requests */
+    uint64_t vtime;             /* cpuNs weighted by priority, and caught up */
+    CARD32 turns;               /* times it was scheduled */
+} FairSchedClientRec;
+
+extern Bool FairScheduling;             /* -fairsched turns it on */
+
+CARD64 FairSchedCpuTime(void);
+CARD64 FairSchedTotalCpuTime(void);
+void FairSchedInitClient(ClientPtr client);
+void FairSchedWake(ClientPtr client);
+void FairSchedCharge(int index, CARD64 ns);
+void FairSchedPicked(ClientPtr client);
+Bool FairSchedBefore(ClientPtr a, ClientPtr b);
+const FairSchedClientRec *FairSchedGetClient(ClientPtr client);
+
+#endif /* _XSERVER_DIX_FAIRSCHED_PRIV_H */
@@ -1166,7 +1166,8 @@ transformRelative(DeviceIntPtr dev, ValuatorMask *mask)
     valuator_mask_fetch_double(mask, 0, &x);
     valuator_mask_fetch_double(mask, 1, &y);
 
-    transform(&dev->relative_transform, &x, &y);
+    if (!dev->relative_transform_identity)
+        transform(&dev->relative_transform, &x, &y);
 
     if (x)
         valuator_mask_set_double(mask, 0, x);
@@ -1193,6 +1194,9 @@ transformAbsolute(DeviceIntPtr dev, ValuatorMask *mask)
     double x, y, ox = 0.0, oy = 0.0;
     int has_x, has_y;
 
+    if (dev->scale_and_transform_identity)
+        return;
+
     has_x = valuator_mask_isset(mask, 0);
     has_y = valuator_mask_isset(mask, 1);
 
@@ -1200,14 +1204,11 @@ transformAbsolute(DeviceIntPtr dev, ValuatorMask *mask)
         return;
 
     if (!has_x || !has_y) {
-        struct pixman_f_transform invert;
-
         /* undo transformation from last event */
         ox = dev->last.valuators[0];
         oy = dev->last.valuators[1];
 
-        pixman_f_transform_invert(&invert, &dev->scale_and_transform);
-        transform(&invert, &ox, &oy);
+        transform(&dev->scale_and_transform_inverse, &ox, &oy);
     }
 
     if (has_x)
@@ -1622,34 +1623,34 @@ emulate_scroll_button_events(InternalEvent *events,
 }
 
 
-/**
- * Generate a complete series of InternalEvents (filled into the EventList)
- * representing pointer motion, or button presses.  If the device is a slave
- * device, also potentially generate a DeviceClassesChangedEvent to update
- * the master device.
- *
- * events is not NULL-terminated; the return value is the number of events.
- * The DDX is responsible for allocating the event structure in the first
- * place via InitEventList() and GetMaximumEventsNum(), and for freeing it.
- *
- * In the generated events rootX/Y will be in absolute screen coords and
- * the valuator information in the absolute or relative device coords.
- *
- * last.valuators[x] of the device is always in absolute device coords.
- * last.valuators[x] of the master device is in absolute screen coords.
- *
- * master->last.valuators[x] for x > 2 is undefined.
- */
-int
-GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
-                 int buttons, int flags, const ValuatorMask *mask_in)
+/* only events moving a scroll axis may have to emulate scroll buttons */
+static Bool
+moves_scroll_axes(DeviceIntPtr pDev, const ValuatorMask *mask)
+{
+    if (!pDev->valuator || !mask)
+        return FALSE;
+
+    for (int i = 0; i < min(valuator_mask_size(mask), pDev->valuator->numAxes);
+         i++)
+        if (pDev->valuator->axes[i].scroll.type != SCROLL_TYPE_NONE &&
+            valuator_mask_isset(mask, i))
+            return TRUE;
+    return FALSE;
+}
+
+/* GetPointerEvents(), once the device turned out to be able to send any */
+static int
+get_pointer_events(InternalEvent *events, DeviceIntPtr pDev, int type,
+                   int buttons, int flags, const ValuatorMask *mask_in,
+                   CARD32 ms)
 {
-    CARD32 ms = GetTimeInMillis();
     int num_events = 0, nev_tmp;
     ValuatorMask last_valuators;
     ValuatorMask mask;
     ValuatorMask scroll;
     int realtype = type;
+    /* scroll button presses turn into scroll axis motion below */
+    Bool scrolling = type == ButtonPress || moves_scroll_axes(pDev, mask_in);
 
 #ifdef XSERVER_DTRACE
     if (XSERVER_INPUT_EVENT_ENABLED()) {
@@ -1660,15 +1661,6 @@ GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
     }
 #endif
 
-    BUG_RETURN_VAL(buttons >= MAX_BUTTONS, 0);
-
-    /* refuse events from disabled devices */
-    if (!pDev->enabled)
-        return 0;
-
-    if (!miPointerGetScreen(pDev))
-        return 0;
-
     events = UpdateFromMaster(events, pDev, DEVCHANGE_POINTER_EVENT,
                               &num_events);
 
@@ -1676,9 +1668,12 @@ GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
 
     /* Back up the current value of last.valuators. fill_pointer_events()
      * overwrites those but we need them for scroll button emulation */
-    valuator_mask_zero(&last_valuators);
-    for (size_t idx = 0; idx < pDev->last.numValuators; idx++)
-        valuator_mask_set_double(&last_valuators, idx, pDev->last.valuators[idx]);
+    if (scrolling) {
+        valuator_mask_zero(&last_valuators);
+        for (size_t idx = 0; idx < pDev->last.numValuators; idx++)
+            valuator_mask_set_double(&last_valuators, idx,
+                                     pDev->last.valuators[idx]);
+    }
 
     /* Turn a scroll button press into a smooth-scrolling event if
      * necessary. This only needs to cater for the XIScrollFlagPreferred
@@ -1735,6 +1730,9 @@ GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
     events += nev_tmp;
     num_events += nev_tmp;
 
+    if (!scrolling)
+        return num_events;
+
     valuator_mask_zero(&scroll);
 
     /* Now turn the smooth-scrolling axes back into emulated button presses
@@ -1759,6 +1757,70 @@ GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
     return num_events;
 }
 
+/**
+ * Generate a complete series of InternalEvents (filled into the EventList)
+ * representing pointer motion, or button presses.  If the device is a slave
+ * device, also potentially generate a DeviceClassesChangedEvent to update
+ * the master device.
+ *
+ * events is not NULL-terminated; the return value is the number of events.
+ * The DDX is responsible for allocating the event structure in the first
+ * place via InitEventList() and GetMaximumEventsNum(), and for freeing it.
+ *
+ * In the generated events rootX/Y will be in absolute screen coords and
+ * the valuator information in the absolute or relative device coords.
+ *
+ * last.valuators[x] of the device is always in absolute device coords.
+ * last.valuators[x] of the master device is in absolute screen coords.
+ *
+ * master->last.valuators[x] for x > 2 is undefined.
+ */
+int
+GetPointerEvents(InternalEvent *events, DeviceIntPtr pDev, int type,
+                 int buttons, int flags, const ValuatorMask *mask_in)
+{
+    BUG_RETURN_VAL(buttons >= MAX_BUTTONS, 0);
+
+    /* refuse events from disabled devices */
+    if (!pDev->enabled)
+        return 0;
+
+    if (!miPointerGetScreen(pDev))
+        return 0;
+
+    return get_pointer_events(events, pDev, type, buttons, flags, mask_in,
+                              GetTimeInMillis());
+}
+
+/**
+ * Generate and enqueue motion events for a burst of valuator masks, as an
+ * input driver reads them from the kernel in one go.  The result is the
+ * same as calling QueuePointerEvents() with MotionNotify for each mask in
+ * turn, except that all of them get the same timestamp, and the checks
+ * that apply to all of them are done only once.  Masks without any
+ * valuators get no flags, like in xf86PostMotionEventM().
+ *
+ * This function is not reentrant. Disable signals before calling.
+ */
+void
+QueuePointerMotionEvents(DeviceIntPtr device, int flags,
+                         const ValuatorMask *masks, int nmasks)
+{
+    CARD32 ms;
+
+    if (nmasks <= 0 || !device->enabled || !miPointerGetScreen(device))
+        return;
+
+    ms = GetTimeInMillis();
+    for (int i = 0; i < nmasks; i++) {
+        int mask_flags = valuator_mask_num_valuators(&masks[i]) ? flags : 0;
+        int nevents = get_pointer_events(InputEventList, device, MotionNotify,
+                                         0, mask_flags, &masks[i], ms);
+
+        queueEventList(device, InputEventList, nevents);
+    }
+}
+
 /**
  * Generate internal events representing this proximity event and enqueue
  * them on the event queue.
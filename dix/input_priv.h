@@ -347,6 +347,10 @@ extern Bool EnableCursor;
  */
 extern Bool CursorVisible;
 
+/* -coalescemotion: merge core motion events queued for a client while
+   input events are processed */
+extern Bool CoalesceMotionEvents;
+
 void valuator_mask_drop_unaccelerated(ValuatorMask *mask);
 
 Bool point_on_screen(ScreenPtr pScreen, int x, int y);
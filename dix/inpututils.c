@@ -621,6 +621,10 @@ valuator_mask_has_unaccelerated(const ValuatorMask *mask)
 void
 valuator_mask_drop_unaccelerated(ValuatorMask *mask)
 {
+    /* unaccelerated values are only ever set along with the flag */
+    if (!mask->has_unaccelerated)
+        return;
+
     memset(mask->unaccelerated, 0, sizeof(mask->unaccelerated));
     mask->has_unaccelerated = FALSE;
 }
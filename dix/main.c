@@ -92,10 +92,12 @@ Equipment Corporation.
 #include "dix/input_priv.h"
 #include "dix/gc_priv.h"
 #include "dix/registry_priv.h"
+#include "dix/reqprof_priv.h"
 #include "dix/screensaver_priv.h"
 #include "dix/selection_priv.h"
 #include "dix/server_priv.h"
 #include "include/extinit.h"
+#include "mi/mi_priv.h"
 #include "os/audit_priv.h"
 #include "os/auth.h"
 #include "os/client_priv.h"
@@ -195,6 +197,8 @@ dix_main(int argc, char *argv[], char *envp[])
         dixResetRegistry();
         InitFonts();
         InitCallbackManager();
+        /* before the DDX, which might want SIGUSR2 for itself */
+        ReqProfInit();
         InitOutput(argc, argv);
 
         if (screenInfo.numScreens < 1)
@@ -346,6 +350,8 @@ dix_main(int argc, char *argv[], char *envp[])
 
         FreeAllAtoms();
 
+        miSpanCacheFlush();
+
         FreeAuditTimer();
 
         DeleteCallbackManager();
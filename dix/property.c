@@ -93,6 +93,222 @@ PrintPropertys(WindowPtr pWin)
 }
 #endif
 
+/*
+ * Windows with only a few properties just walk the list.  Once a window
+ * collects PROPERTY_INDEX_MIN of them (root windows easily carry hundreds),
+ * an open addressing table keyed by the property name is built next to the
+ * list, so lookups, inserts and deletes stay constant time.  The list itself
+ * is kept, doubly linked, since it defines the ListProperties order and
+ * security modules walk it.
+ *
+ * With polyinstantiated properties (XSELinux) several PropertyRecs may share
+ * a name.  The index always points to the instance nearest to the list head,
+ * which is where the lookup walk would have stopped, and counts the others
+ * in dups so the common case never has to look for them.
+ */
+
+#define PROPERTY_INDEX_MIN      8
+#define PROPERTY_INDEX_MIN_SIZE 16
+
+typedef struct _PropertyIndex {
+    unsigned int count;         /* properties on the window */
+    unsigned int dups;          /* instances not referenced by a slot */
+    unsigned int size;          /* number of slots, power of two */
+    PropertyPtr slots[];
+} PropertyIndexRec, *PropertyIndexPtr;
+
+/* a window private, so WindowRec stays the way drivers know it */
+static DevPrivateKeyRec propertyIndexKeyRec;
+
+#define propertyIndexKey (&propertyIndexKeyRec)
+
+Bool
+PropertyIndexInit(void)
+{
+    return dixRegisterPrivateKey(propertyIndexKey, PRIVATE_WINDOW, 0);
+}
+
+static inline PropertyIndexPtr
+PropertyIndexGet(WindowPtr pWin)
+{
+    return dixLookupPrivate(&pWin->devPrivates, propertyIndexKey);
+}
+
+static inline void
+PropertyIndexSet(WindowPtr pWin, PropertyIndexPtr index)
+{
+    dixSetPrivate(&pWin->devPrivates, propertyIndexKey, index);
+}
+
+static inline unsigned int
+PropertyIndexHash(Atom name, unsigned int size)
+{
+    uint32_t h = (uint32_t) name * 0x9e3779b1u;
+
+    return (h ^ (h >> 16)) & (size - 1);
+}
+
+/* returns the slot holding name, or the empty slot where it would go */
+static unsigned int
+PropertyIndexSlot(PropertyIndexPtr index, Atom name)
+{
+    unsigned int i = PropertyIndexHash(name, index->size);
+
+    while (index->slots[i] && index->slots[i]->propertyName != name)
+        i = (i + 1) & (index->size - 1);
+    return i;
+}
+
+static PropertyIndexPtr
+PropertyIndexCreate(PropertyPtr list, unsigned int count)
+{
+    PropertyIndexPtr index;
+    unsigned int size = PROPERTY_INDEX_MIN_SIZE;
+
+    while (size * 3 <= count * 4)
+        size <<= 1;
+
+    index = calloc(1, sizeof(PropertyIndexRec) + size * sizeof(PropertyPtr));
+    if (!index)
+        return NULL;
+    index->count = count;
+    index->size = size;
+
+    for (PropertyPtr pProp = list; pProp; pProp = pProp->next) {
+        unsigned int i = PropertyIndexSlot(index, pProp->propertyName);
+
+        if (index->slots[i])
+            index->dups++;
+        else
+            index->slots[i] = pProp;
+    }
+    return index;
+}
+
+static void
+PropertyIndexInsert(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = PropertyIndexGet(pWin);
+    unsigned int i;
+
+    if (!index) {
+        unsigned int count = 0;
+
+        for (PropertyPtr p = pWin->properties; p; p = p->next)
+            count++;
+        /* without an index we just keep walking the list */
+        if (count >= PROPERTY_INDEX_MIN)
+            PropertyIndexSet(pWin,
+                             PropertyIndexCreate(pWin->properties, count));
+        return;
+    }
+
+    if ((index->count + 1 - index->dups) * 4 >= index->size * 3) {
+        PropertyIndexPtr grown = PropertyIndexCreate(pWin->properties,
+                                                     index->count + 1);
+
+        /* an allocation failure only costs us the index */
+        free(index);
+        PropertyIndexSet(pWin, grown);
+        return;
+    }
+
+    index->count++;
+    i = PropertyIndexSlot(index, pProp->propertyName);
+    if (index->slots[i])
+        index->dups++;
+    /* new properties are linked at the list head, so they always win */
+    index->slots[i] = pProp;
+}
+
+static void
+PropertyIndexRemove(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexPtr index = PropertyIndexGet(pWin);
+    unsigned int i, j, mask;
+
+    if (!index)
+        return;
+
+    if (--index->count < PROPERTY_INDEX_MIN / 2) {
+        free(index);
+        PropertyIndexSet(pWin, NULL);
+        return;
+    }
+
+    i = PropertyIndexSlot(index, pProp->propertyName);
+    if (index->slots[i] != pProp) {
+        /* a polyinstantiated copy further down the list */
+        index->dups--;
+        return;
+    }
+
+    if (index->dups) {
+        for (PropertyPtr next = pProp->next; next; next = next->next) {
+            if (next->propertyName == pProp->propertyName) {
+                index->slots[i] = next;
+                index->dups--;
+                return;
+            }
+        }
+    }
+
+    /* backward shift deletion, so probe sequences need no tombstones */
+    mask = index->size - 1;
+    index->slots[i] = NULL;
+    for (j = (i + 1) & mask; index->slots[j]; j = (j + 1) & mask) {
+        unsigned int home = PropertyIndexHash(index->slots[j]->propertyName,
+                                              index->size);
+
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            index->slots[i] = index->slots[j];
+            index->slots[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+static PropertyPtr
+FindProperty(WindowPtr pWin, Atom propertyName)
+{
+    PropertyIndexPtr index = PropertyIndexGet(pWin);
+    PropertyPtr pProp;
+
+    if (index)
+        return index->slots[PropertyIndexSlot(index, propertyName)];
+
+    for (pProp = pWin->properties; pProp; pProp = pProp->next)
+        if (pProp->propertyName == propertyName)
+            break;
+    return pProp;
+}
+
+static void
+LinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    pProp->prev = NULL;
+    pProp->next = pWin->properties;
+    if (pProp->next)
+        pProp->next->prev = pProp;
+    pWin->properties = pProp;
+    PropertyIndexInsert(pWin, pProp);
+}
+
+static void
+UnlinkProperty(WindowPtr pWin, PropertyPtr pProp)
+{
+    PropertyIndexRemove(pWin, pProp);
+    if (pProp->prev)
+        pProp->prev->next = pProp->next;
+    else
+        pWin->properties = pProp->next;
+    if (pProp->next)
+        pProp->next->prev = pProp->prev;
+
+    if (!pWin->properties)
+        CheckWindowOptionalNeed(pWin);
+}
+
 int
 dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
                   ClientPtr client, Mask access_mode)
@@ -102,9 +318,7 @@ dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom propertyName,
 
     client->errorValue = propertyName;
 
-    for (pProp = pWin->properties; pProp; pProp = pProp->next)
-        if (pProp->propertyName == propertyName)
-            break;
+    pProp = FindProperty(pWin, propertyName);
 
     if (pProp)
         rc = XaceHookPropertyAccess(client, pWin, &pProp, access_mode);
@@ -170,14 +384,31 @@ deliverPropertyNotifyEvent(WindowPtr pWin, int state, PropertyPtr pProp)
     DeliverEvents(pWin, &event, 1, (WindowPtr) NULL);
 }
 
+static int
+compareAtoms(const void *a, const void *b)
+{
+    Atom l = *(const Atom *) a, r = *(const Atom *) b;
+
+    return (l > r) - (l < r);
+}
+
+static Bool
+isDuplicateAtom(const Atom *sorted, size_t n, Atom atom)
+{
+    const Atom *found = bsearch(&atom, sorted, n, sizeof(Atom), compareAtoms);
+
+    if (!found)
+        return FALSE;
+    return (found > sorted && found[-1] == atom) ||
+           (found + 1 < sorted + n && found[1] == atom);
+}
+
 int
 ProcRotateProperties(ClientPtr client)
 {
-    int delta, rc;
+    int rc;
 
     REQUEST(xRotatePropertiesReq);
-    PropertyPtr *props;         /* array of pointer */
-    PropertyPtr pProp, saved;
 
     REQUEST_FIXED_SIZE(xRotatePropertiesReq, stuff->nAtoms << 2);
     UpdateCurrentTime();
@@ -200,26 +431,48 @@ ProcRotateProperties(ClientPtr client)
     if (rc != Success || stuff->nAtoms <= 0)
         return rc;
 
-    props = calloc(p.nAtoms, sizeof(PropertyPtr));
-    saved = calloc(p.nAtoms, sizeof(PropertyRec));
+    return dixRotateWindowProperties(p.client, pWin, p.atoms, p.nAtoms,
+                                     p.nPositions);
+}
+
+int
+dixRotateWindowProperties(ClientPtr client, WindowPtr pWin,
+                          const Atom *atoms, int nAtoms, int nPositions)
+{
+    int delta, rc = Success;
+    PropertyPtr *props;         /* array of pointer */
+    PropertyPtr pProp, saved;
+    Atom *sorted = NULL;
+
+    props = calloc(nAtoms, sizeof(PropertyPtr));
+    saved = calloc(nAtoms, sizeof(PropertyRec));
     if (!props || !saved) {
         rc = BadAlloc;
         goto out;
     }
 
-    for (int i = 0; i < p.nAtoms; i++) {
-        if (!ValidAtom(p.atoms[i])) {
+    /* sorted copy of the atom list, so duplicates are found without
+       comparing every pair */
+    sorted = calloc(nAtoms, sizeof(Atom));
+    if (!sorted) {
+        rc = BadAlloc;
+        goto out;
+    }
+    memcpy(sorted, atoms, nAtoms * sizeof(Atom));
+    qsort(sorted, nAtoms, sizeof(Atom), compareAtoms);
+
+    for (int i = 0; i < nAtoms; i++) {
+        if (!ValidAtom(atoms[i])) {
             rc = BadAtom;
-            client->errorValue = p.atoms[i];
+            client->errorValue = atoms[i];
+            goto out;
+        }
+        if (isDuplicateAtom(sorted, nAtoms, atoms[i])) {
+            rc = BadMatch;
             goto out;
         }
-        for (int j = i + 1; j < p.nAtoms; j++)
-            if (p.atoms[j] == p.atoms[i]) {
-                rc = BadMatch;
-                goto out;
-            }
 
-        rc = dixLookupProperty(&pProp, pWin, p.atoms[i], p.client,
+        rc = dixLookupProperty(&pProp, pWin, atoms[i], client,
                                DixReadAccess | DixWriteAccess);
 
         if (rc != Success)
@@ -228,16 +481,16 @@ ProcRotateProperties(ClientPtr client)
         props[i] = pProp;
         saved[i] = *pProp;
     }
-    delta = p.nPositions;
+    delta = nPositions;
 
     /* If the rotation is a complete 360 degrees, then moving the properties
        around and generating PropertyNotify events should be skipped. */
 
-    if (abs(delta) % p.nAtoms) {
+    if (abs(delta) % nAtoms) {
         while (delta < 0)       /* faster if abs value is small */
-            delta += p.nAtoms;
-        for (int i = 0; i < p.nAtoms; i++) {
-            int j = (i + delta) % p.nAtoms;
+            delta += nAtoms;
+        for (int i = 0; i < nAtoms; i++) {
+            int j = (i + delta) % nAtoms;
             deliverPropertyNotifyEvent(pWin, PropertyNewValue, props[i]);
             notifyVRRMode(client, pWin, PropertyNewValue, props[i]);
 
@@ -249,6 +502,7 @@ ProcRotateProperties(ClientPtr client)
         }
     }
  out:
+    free(sorted);
     free(saved);
     free(props);
     return rc;
@@ -363,8 +617,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
             pClient->errorValue = property;
             return rc;
         }
-        pProp->next = pWin->properties;
-        pWin->properties = pProp;
+        LinkProperty(pWin, pProp);
     }
     else if (rc == Success) {
         /* To append or prepend to a property the request format and type
@@ -442,7 +695,7 @@ dixChangeWindowProperty(ClientPtr pClient, WindowPtr pWin, Atom property,
 int
 DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     int rc;
 
     rc = dixLookupProperty(&pProp, pWin, propName, client, DixDestroyAccess);
@@ -450,18 +703,7 @@ DeleteProperty(ClientPtr client, WindowPtr pWin, Atom propName)
         return Success;         /* Succeed if property does not exist */
 
     if (rc == Success) {
-        if (pWin->properties == pProp) {
-            /* Takes care of head */
-            if (!(pWin->properties = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->properties;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         deliverPropertyNotifyEvent(pWin, PropertyDelete, pProp);
         notifyVRRMode(client, pWin, PropertyDelete, pProp);
@@ -485,6 +727,8 @@ DeleteAllWindowProperties(WindowPtr pWin)
     }
 
     pWin->properties = NULL;
+    free(PropertyIndexGet(pWin));
+    PropertyIndexSet(pWin, NULL);
 }
 
 /*****************
@@ -500,7 +744,7 @@ DeleteAllWindowProperties(WindowPtr pWin)
 int
 ProcGetProperty(ClientPtr client)
 {
-    PropertyPtr pProp, prevProp;
+    PropertyPtr pProp;
     unsigned long n, len, ind;
     int rc;
     Mask win_mode = DixGetPropAccess, prop_mode = DixReadAccess;
@@ -620,18 +864,7 @@ ProcGetProperty(ClientPtr client)
 
     if (p.delete && (rep.bytesAfter == 0)) {
         /* Delete the Property */
-        if (pWin->properties == pProp) {
-            /* Takes care of head */
-            if (!(pWin->properties = pProp->next))
-                CheckWindowOptionalNeed(pWin);
-        }
-        else {
-            /* Need to traverse to find the previous element */
-            prevProp = pWin->properties;
-            while (prevProp->next != pProp)
-                prevProp = prevProp->next;
-            prevProp->next = pProp->next;
-        }
+        UnlinkProperty(pWin, pProp);
 
         free(pProp->data);
         dixFreeObjectWithPrivates(pProp, PRIVATE_PROPERTY);
@@ -99,4 +99,11 @@ int dixLookupProperty(PropertyPtr *result, WindowPtr pWin, Atom proprty,
 
 void DeleteAllWindowProperties(WindowPtr pWin);
 
+/* registers the window private of the property index */
+Bool PropertyIndexInit(void);
+
+/* the work of RotateProperties, once the window is looked up */
+int dixRotateWindowProperties(ClientPtr client, WindowPtr pWin,
+                              const Atom *atoms, int nAtoms, int nPositions);
+
 #endif /* _XSERVER_PROPERTY_PRIV_H */
@@ -587,13 +587,13 @@ FeedTrackers(DeviceVelocityPtr vel, double dx, double dy, int cur_t)
 static double
 CalcTracker(const MotionTracker * tracker, int cur_t)
 {
-    double dist = sqrt(tracker->dx * tracker->dx + tracker->dy * tracker->dy);
     int dtime = cur_t - tracker->time;
 
-    if (dtime > 0)
-        return dist / dtime;
-    else
+    /* devices reporting at kHz rates fill several trackers per ms, don't
+     * bother with the distance of those */
+    if (dtime <= 0)
         return 0;               /* synonymous for NaN, since we're not C99 */
+    return sqrt(tracker->dx * tracker->dx + tracker->dy * tracker->dy) / dtime;
 }
 
 /* find the most plausible velocity. That is, the most distant
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Request profiler
+ *
+ * Dispatch() times every request and accounts it to the issuing client
+ * here.  Each client gets a small open-addressed table keyed by its
+ * major/minor opcodes, which is only allocated once the client sends
+ * its first request, and freed when it goes away.  Next to it is the CPU
+ * time of the client's turns, which fairsched accounts.
+ *
+ * The statistics can be queried by clients through the X-Resource
+ * extension, and SIGUSR2 dumps all of them into the server log, or into
+ * the file given by -reqproffile.
+ */
+
+#include <dix-config.h>
+
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dix/dix_priv.h"
+#include "dix/registry_priv.h"
+#include "dix/reqprof_priv.h"
+#include "mi/mi_priv.h"
+#include "os/client_priv.h"
+#include "os/osdep.h"
+
+#include "misc.h"
+#include "os.h"
+#include "dixstruct.h"
+
+#define REQPROF_INITSIZE 16     /* entries of a client's table at first */
+
+typedef struct _ReqProfTable {
+    ReqProfStatsPtr entries;    /* empty ones have count == 0 */
+    unsigned int size;          /* power of two */
+    unsigned int used;
+    FairSchedClientRec sched;
+} ReqProfTableRec;
+
+Bool RequestProfiling = TRUE;
+const char *RequestProfileFile = NULL;
+
+static ReqProfTableRec profiles[MAXCLIENTS];
+static volatile sig_atomic_t dumpRequested;
+
+static inline unsigned int
+ReqProfHash(CARD8 major, CARD16 minor, unsigned int size)
+{
+    return ((major * 0x9E3779B1u) ^ minor) & (size - 1);
+}
+
+static inline unsigned int
+ReqProfBucket(CARD64 usec)
+{
+    unsigned int bucket = 0;
+
+    for (; usec && bucket < REQPROF_BUCKETS - 1; usec >>= 1)
+        bucket++;
+    return bucket;
+}
+
+static ReqProfStatsPtr
+ReqProfFind(ReqProfTableRec *t, CARD8 major, CARD16 minor)
+{
+    unsigned int i = ReqProfHash(major, minor, t->size);
+
+    for (; t->entries[i].count; i = (i + 1) & (t->size - 1)) {
+        if (t->entries[i].major == major && t->entries[i].minor == minor)
+            return &t->entries[i];
+    }
+    return &t->entries[i];
+}
+
+static Bool
+ReqProfGrow(ReqProfTableRec *t)
+{
+    unsigned int size = t->size ? t->size * 2 : REQPROF_INITSIZE;
+    ReqProfTableRec grown = { calloc(size, sizeof(ReqProfStatsRec)), size, 0 };
+
+    if (!grown.entries)
+        return FALSE;
+    for (unsigned int i = 0; i < t->size; i++) {
+        if (t->entries[i].count) {
+            *ReqProfFind(&grown, t->entries[i].major, t->entries[i].minor) =
+                t->entries[i];
+            grown.used++;
+        }
+    }
+    free(t->entries);
+    *t = grown;
+    return TRUE;
+}
+
+void
+ReqProfAccount(ClientPtr client, CARD8 major, CARD16 minor, CARD64 usec)
+{
+    ReqProfTableRec *t = &profiles[client->index];
+    ReqProfStatsPtr stats;
+
+    if (client->clientGone)
+        return;
+    if ((t->used + 1) * 2 > t->size && !ReqProfGrow(t))
+        return;                 /* drop the sample rather than fail */
+
+    stats = ReqProfFind(t, major, minor);
+    if (!stats->count) {
+        stats->major = major;
+        stats->minor = minor;
+        t->used++;
+    }
+    stats->count++;
+    stats->totalUs += usec;
+    if (usec > stats->maxUs)
+        stats->maxUs = min(usec, UINT32_MAX);
+    stats->buckets[ReqProfBucket(usec)]++;
+}
+
+void
+ReqProfForEach(ClientPtr client, ReqProfStatsProcPtr func, void *data)
+{
+    ReqProfTableRec *t = &profiles[client->index];
+
+    for (unsigned int i = 0; i < t->size; i++) {
+        if (t->entries[i].count)
+            func(&t->entries[i], data);
+    }
+}
+
+FairSchedClientRec *
+ReqProfSchedClient(int index)
+{
+    return &profiles[index].sched;
+}
+
+void
+ReqProfClientGone(ClientPtr client)
+{
+    ReqProfTableRec *t = &profiles[client->index];
+
+    free(t->entries);
+    memset(t, 0, sizeof(*t));
+}
+
+static void _X_ATTRIBUTE_PRINTF(2, 3)
+ReqProfPrint(FILE *f, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    if (f)
+        vfprintf(f, format, args);
+    else
+        LogVMessageVerb(X_NONE, 0, format, args);
+    va_end(args);
+}
+
+static void
+ReqProfPrintStats(const ReqProfStatsRec *stats, void *data)
+{
+    char hist[REQPROF_BUCKETS * 11 + 1];
+    int len = 0;
+
+    for (int i = 0; i < REQPROF_BUCKETS; i++)
+        len += snprintf(hist + len, sizeof(hist) - len, " %u",
+                        (unsigned) stats->buckets[i]);
+
+    ReqProfPrint(data, "  %-40s %10u calls %12llu us total %10u us max |%s\n",
+                 LookupRequestName(stats->major, stats->minor),
+                 (unsigned) stats->count,
+                 (unsigned long long) stats->totalUs,
+                 (unsigned) stats->maxUs, hist);
+}
+
+void
+ReqProfDump(void)
+{
+    FILE *f = NULL;
+
+    dumpRequested = 0;
+    if (RequestProfileFile) {
+        f = fopen(RequestProfileFile, "w");
+        if (!f) {
+            ErrorF("[dix] can't write request profile to %s: %s\n",
+                   RequestProfileFile, strerror(errno));
+            return;
+        }
+    }
+
+    ReqProfPrint(f, "Request profile (histograms: <1us, then up to 2^n us)\n");
+    for (int i = 1; i < currentMaxClients; i++) {
+        ClientPtr client = clients[i];
+
+        if (!client || (!profiles[i].used && !profiles[i].sched.turns))
+            continue;
+        ReqProfPrint(f, "client %d (pid %ld, %s): %u turns, %llu us CPU\n", i,
+                     (long) GetClientPid(client),
+                     GetClientCmdName(client) ? GetClientCmdName(client) : "?",
+                     (unsigned) profiles[i].sched.turns,
+                     (unsigned long long) profiles[i].sched.cpuNs / 1000);
+        ReqProfForEach(client, ReqProfPrintStats, f);
+    }
+    ReqProfPrint(f, "all clients, gone ones too: %llu us CPU\n",
+                 (unsigned long long) FairSchedTotalCpuTime() / 1000);
+    ReqProfPrint(f, "input events dropped, queue full: %lu\n",
+                 (unsigned long) mieqDroppedEvents());
+
+    if (f)
+        fclose(f);
+}
+
+static void
+ReqProfSignal(int signo)
+{
+    dumpRequested = 1;
+}
+
+/* the signal only interrupts the poll, the dump happens from here */
+static void
+ReqProfWakeup(void *data, int result)
+{
+    if (dumpRequested)
+        ReqProfDump();
+}
+
+void
+ReqProfInit(void)
+{
+    if (!RequestProfiling)
+        return;
+#ifdef SIGUSR2
+    OsSignal(SIGUSR2, ReqProfSignal);
+#endif
+    RegisterBlockAndWakeupHandlers((ServerBlockHandlerProcPtr) NoopDDA,
+                                   ReqProfWakeup, NULL);
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+#ifndef _XSERVER_DIX_REQPROF_PRIV_H
+#define _XSERVER_DIX_REQPROF_PRIV_H
+
+#include <stdint.h>
+#include <X11/Xdefs.h>
+#include <X11/Xmd.h>
+
+#include "dix/fairsched_priv.h"
+#include "include/dix.h"
+#include "include/dixstruct.h"
+#include "include/os.h"
+
+/*
+ * Request profiler: per client and per major/minor opcode counters and
+ * latency histograms of request processing in Dispatch().
+ *
+ * Histogram bucket 0 counts requests done in less than 1us, bucket i
+ * those which took [2^(i-1), 2^i) us, and the last one everything
+ * slower than that.
+ */
+#define REQPROF_BUCKETS 20
+
+typedef struct _ReqProfStats {
+    CARD8 major;
+    CARD16 minor;
+    CARD32 count;
+    CARD32 maxUs;
+    uint64_t totalUs;
+    CARD32 buckets[REQPROF_BUCKETS];
+} ReqProfStatsRec, *ReqProfStatsPtr;
+
+typedef void (*ReqProfStatsProcPtr) (const ReqProfStatsRec *stats,
+                                     void *data);
+
+extern Bool RequestProfiling;           /* -noreqprof turns it off */
+extern const char *RequestProfileFile;  /* -reqproffile, log if NULL */
+
+void ReqProfInit(void);
+void ReqProfAccount(ClientPtr client, CARD8 major, CARD16 minor,
+                    CARD64 usec);
+void ReqProfForEach(ClientPtr client, ReqProfStatsProcPtr func, void *data);
+/* the client's CPU time and fair share state, whether profiling or not */
+FairSchedClientRec *ReqProfSchedClient(int index);
+void ReqProfClientGone(ClientPtr client);
+void ReqProfDump(void);
+
+/* called by Dispatch() around each request */
+static inline CARD64 ReqProfStart(void)
+{
+    return RequestProfiling ? GetTimeInMicros() : 0;
+}
+
+static inline void ReqProfDone(ClientPtr client, CARD64 start)
+{
+    if (RequestProfiling)
+        ReqProfAccount(client, client->majorOp, client->minorOp,
+                       GetTimeInMicros() - start);
+}
+
+#endif /* _XSERVER_DIX_REQPROF_PRIV_H */
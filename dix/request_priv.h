@@ -5,6 +5,7 @@
 #ifndef _XSERVER_DIX_REQUEST_PRIV_H
 #define _XSERVER_DIX_REQUEST_PRIV_H
 
+#include <string.h>
 #include <X11/Xproto.h>
 
 #include "dix/rpcbuf_priv.h" /* x_rpcbuf_t */
@@ -12,23 +13,28 @@
 #include "include/dixstruct.h"
 #include "include/misc.h"    /* bytes_to_int32 */
 #include "include/os.h"      /* WriteToClient */
+#include "os/client_priv.h"   /* WriteToClientNoCopy */
 
 /*
  * @brief write rpc buffer to client and then clear it
  *
+ * The buffer memory is handed over to the output queue, so large
+ * payloads go out without being copied once more.  The rpcbuf is left
+ * cleared, just like after x_rpcbuf_clear().
+ *
  * @param pClient the client to write buffer to
  * @param rpcbuf  the buffer whose contents will be written
- * @return the result of WriteToClient() call
+ * @return the result of WriteToClientNoCopy() call
  */
 static inline ssize_t WriteRpcbufToClient(ClientPtr pClient,
                                           x_rpcbuf_t *rpcbuf) {
     /* explicitly casting between (s)size_t and int - should be safe,
        since payloads are always small enough to easily fit into int. */
-    ssize_t ret = WriteToClient(pClient,
-                                (int)rpcbuf->wpos,
-                                rpcbuf->buffer);
-    x_rpcbuf_clear(rpcbuf);
-    return ret;
+    int count = (int)rpcbuf->wpos;
+    void *buffer = rpcbuf->buffer;
+
+    memset(rpcbuf, 0, sizeof(x_rpcbuf_t));
+    return WriteToClientNoCopy(pClient, count, buffer);
 }
 
 /* compute the amount of extra units a reply header needs.
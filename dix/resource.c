@@ -119,6 +119,8 @@ Equipment Corporation.
 
 #include <dix-config.h>
 
+#include <stdint.h>
+#include <string.h>
 #include <X11/X.h>
 
 #include "dix/colormap_priv.h"
@@ -152,27 +154,79 @@ Equipment Corporation.
 #define TypeNameString(t) LookupResourceName(t)
 #endif
 
-static void RebuildTable(int    /*client */
-    );
-
 #define SERVER_MINID 32
 
-#define INITBUCKETS 64
-#define INITHASHSIZE 6
-#define MAXHASHSIZE 16
+#define INITHASHSIZE 6          /* log(2) of a new client's table size */
+#define MIGRATE_STEP 4          /* old table buckets moved per AddResource() */
+#define POOL_MINCHUNK 32        /* records in a client's first pool chunk */
+#define POOL_MAXCHUNK 4096
 
 typedef struct _Resource {
-    struct _Resource *next;
+    struct _Resource *next;     /* older resource with the same id */
+    struct _Resource *hashNext; /* next chain in the bucket, heads only */
+    struct _ResourceChunk *chunk;       /* allocated from */
+    struct _Resource *allNext;  /* all resources of the client, newest first */
+    struct _Resource *allPrev;
+    struct _Resource *typeNext; /* resources of the same type, newest first */
+    struct _Resource *typePrev;
     XID id;
     RESTYPE type;
     void *value;
 } ResourceRec, *ResourcePtr;
 
+/*
+ * Hash table of resource chains, i.e. of the newest resource for each id
+ * in use, with the older ones hanging off it.  The table grows with the
+ * number of chains, without a cap, so that buckets hold about one chain
+ * even for huge clients.
+ *
+ * Growing doesn't rehash everything at once: the previous table is kept
+ * around and moved over a few buckets per AddResource().  Lookups check
+ * both tables meanwhile.
+ */
+typedef struct _ResourceTable {
+    ResourcePtr *buckets;
+    unsigned int hashsize;      /* log(2) of the number of buckets */
+    unsigned int used;          /* chains stored */
+} ResourceTableRec;
+
+/*
+ * Resource records are carved out of per-client chunks.  Freed records go
+ * back on their chunk's free list, and chunks with free records are kept
+ * ahead of the full ones, so AddResource() only looks at the first one.
+ * A chunk is given back once all of its records are free, unless it is
+ * the client's only empty one: that one is kept for the next resources,
+ * so a client going back and forth over a chunk boundary doesn't hammer
+ * malloc().
+ */
+typedef struct _ResourceChunk {
+    struct _ResourceChunk *next;
+    struct _ResourceChunk *prev;
+    ResourcePtr freeRecs;       /* linked through next */
+    unsigned int count;
+    unsigned int used;
+    ResourceRec recs[];
+} ResourceChunkRec;
+
+/* walk over a resource list which callbacks might modify */
+typedef struct _ResourceIter {
+    struct _ResourceIter *prev; /* enclosing walk over the same client */
+    ResourcePtr next;
+    Bool byType;
+} ResourceIterRec;
+
 typedef struct _ClientResource {
-    ResourcePtr *resources;
+    ResourceTableRec table;
+    ResourceTableRec old;       /* being moved into table, if buckets != NULL */
+    unsigned int migrated;      /* buckets of old already moved */
+    ResourcePtr all;            /* every resource, newest first */
+    ResourcePtr *byType;        /* indexed by type & TypeMask */
+    unsigned int numTypes;
+    ResourceIterRec *iters;     /* walks in progress */
+    ResourceChunkRec *chunks;   /* the ones with free records first */
+    unsigned int poolRecs;      /* records in all chunks */
+    Bool emptyChunk;            /* one of them is unused */
     int elements;
-    int buckets;
-    int hashsize;               /* log(2)(buckets) */
     XID fakeID;
     XID endFakeID;
 } ClientResourceRec;
@@ -655,13 +709,13 @@ InitClientResources(ClientPtr client)
             return FALSE;
         memcpy(resourceTypes, predefTypes, sizeof(predefTypes));
     }
-    clientTable[i = client->index].resources =
-        calloc(INITBUCKETS, sizeof(ResourcePtr));
-    if (!clientTable[i].resources)
+    i = client->index;
+    memset(&clientTable[i], 0, sizeof(ClientResourceRec));
+    clientTable[i].table.buckets = calloc(1U << INITHASHSIZE,
+                                           sizeof(ResourcePtr));
+    if (!clientTable[i].table.buckets)
         return FALSE;
-    clientTable[i].buckets = INITBUCKETS;
-    clientTable[i].elements = 0;
-    clientTable[i].hashsize = INITHASHSIZE;
+    clientTable[i].table.hashsize = INITHASHSIZE;
     /* Many IDs allocated from the server client are visible to clients,
      * so we don't use the SERVER_BIT for them, but we have to start
      * past the magic value constants used in the protocol.  For normal
@@ -670,9 +724,6 @@ InitClientResources(ClientPtr client)
     clientTable[i].fakeID = client->clientAsMask |
         (client->index ? SERVER_BIT : SERVER_MINID);
     clientTable[i].endFakeID = (clientTable[i].fakeID | RESOURCE_ID_MASK) + 1;
-    for (int j = 0; j < INITBUCKETS; j++) {
-        clientTable[i].resources[j] = NULL;
-    }
     return TRUE;
 }
 
@@ -689,18 +740,223 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0U) << numBits);
 }
 
+/* returns the link to the chain for id, or NULL */
+static ResourcePtr *
+TableFind(ResourceTableRec *t, XID id)
+{
+    ResourcePtr *link = &t->buckets[HashResourceID(id, t->hashsize)];
+
+    for (; *link; link = &(*link)->hashNext)
+        if ((*link)->id == id)
+            return link;
+    return NULL;
+}
+
+/* head's id must not be in the table yet */
+static void
+TableInsert(ResourceTableRec *t, ResourcePtr head)
+{
+    ResourcePtr *bucket = &t->buckets[HashResourceID(head->id, t->hashsize)];
+
+    head->hashNext = *bucket;
+    *bucket = head;
+    t->used++;
+}
+
+static void
+TableRemove(ResourceTableRec *t, ResourcePtr *link)
+{
+    *link = (*link)->hashNext;
+    t->used--;
+}
+
+static ResourcePtr
+LookupChain(ClientResourceRec *rrec, XID id)
+{
+    ResourcePtr *link = TableFind(&rrec->table, id);
+
+    if (!link && rrec->old.buckets)
+        link = TableFind(&rrec->old, id);
+    return link ? *link : NULL;
+}
+
+/* move some more buckets over from the table being replaced */
+static void
+MigrateTable(ClientResourceRec *rrec, unsigned int steps)
+{
+    while (rrec->old.buckets && steps--) {
+        ResourcePtr *bucket = &rrec->old.buckets[rrec->migrated];
+        ResourcePtr head;
+
+        while ((head = *bucket)) {
+            TableRemove(&rrec->old, bucket);
+            TableInsert(&rrec->table, head);
+        }
+        if (++rrec->migrated == 1U << rrec->old.hashsize) {
+            free(rrec->old.buckets);
+            rrec->old.buckets = NULL;
+            rrec->migrated = 0;
+        }
+    }
+}
+
+/*
+ * Best effort: the buckets are chains, so if there's no memory for more
+ * of them, the ones there are just get longer.
+ */
+static void
+GrowTable(ClientResourceRec *rrec)
+{
+    ResourcePtr *buckets;
+
+    /* MIGRATE_STEP is large enough for this to be a no-op normally */
+    MigrateTable(rrec, ~0U);
+
+    buckets = calloc(2U << rrec->table.hashsize, sizeof(ResourcePtr));
+    if (!buckets)
+        return;
+    rrec->old = rrec->table;
+    rrec->migrated = 0;
+    rrec->table.buckets = buckets;
+    rrec->table.hashsize++;
+    rrec->table.used = 0;
+}
+
+static Bool
+GrowTypeIndex(ClientResourceRec *rrec, RESTYPE type)
+{
+    unsigned int num = max(type & TypeMask, lastResourceType) + 1;
+    ResourcePtr *byType = reallocarray(rrec->byType, num, sizeof(ResourcePtr));
+
+    if (!byType)
+        return FALSE;
+    memset(byType + rrec->numTypes, 0,
+           (num - rrec->numTypes) * sizeof(ResourcePtr));
+    rrec->byType = byType;
+    rrec->numTypes = num;
+    return TRUE;
+}
+
+static void
+LinkResource(ClientResourceRec *rrec, ResourcePtr res)
+{
+    ResourcePtr *link = TableFind(&rrec->table, res->id);
+    ResourcePtr *typeHead = &rrec->byType[res->type & TypeMask];
+
+    if (!link && rrec->old.buckets)
+        link = TableFind(&rrec->old, res->id);
+    if (link) {
+        /* res takes the place of the old head */
+        res->next = *link;
+        res->hashNext = res->next->hashNext;
+        *link = res;
+    }
+    else {
+        res->next = NULL;
+        TableInsert(&rrec->table, res);
+    }
+
+    res->allPrev = NULL;
+    if ((res->allNext = rrec->all))
+        res->allNext->allPrev = res;
+    rrec->all = res;
+
+    res->typePrev = NULL;
+    if ((res->typeNext = *typeHead))
+        res->typeNext->typePrev = res;
+    *typeHead = res;
+
+    rrec->elements++;
+}
+
+static void
+UnlinkResource(ClientResourceRec *rrec, ResourcePtr res)
+{
+    ResourceTableRec *t = &rrec->table;
+    ResourcePtr *link, *prev;
+
+    if (!(link = TableFind(t, res->id))) {
+        t = &rrec->old;
+        link = TableFind(t, res->id);
+    }
+    if (*link != res) {
+        for (prev = &(*link)->next; *prev != res; prev = &(*prev)->next)
+            ;
+        *prev = res->next;
+    }
+    else if (res->next) {
+        /* the next older one becomes the head */
+        res->next->hashNext = res->hashNext;
+        *link = res->next;
+    }
+    else
+        TableRemove(t, link);   /* last one with that id */
+
+    for (ResourceIterRec *iter = rrec->iters; iter; iter = iter->prev)
+        if (iter->next == res)
+            iter->next = iter->byType ? res->typeNext : res->allNext;
+
+    if (res->allPrev)
+        res->allPrev->allNext = res->allNext;
+    else
+        rrec->all = res->allNext;
+    if (res->allNext)
+        res->allNext->allPrev = res->allPrev;
+
+    if (res->typePrev)
+        res->typePrev->typeNext = res->typeNext;
+    else
+        rrec->byType[res->type & TypeMask] = res->typeNext;
+    if (res->typeNext)
+        res->typeNext->typePrev = res->typePrev;
+
+    rrec->elements--;
+}
+
+/*
+ * Start walking all resources of a client, or only those of the given
+ * type.  Resources added during the walk might or might not be visited,
+ * resources freed during the walk are skipped.
+ */
+static ResourcePtr
+BeginResourceWalk(ClientResourceRec *rrec, ResourceIterRec *iter,
+                  RESTYPE type)
+{
+    ResourcePtr first;
+
+    if (!type)
+        first = rrec->all;
+    else if ((type & TypeMask) < rrec->numTypes)
+        first = rrec->byType[type & TypeMask];
+    else
+        first = NULL;
+
+    iter->prev = rrec->iters;
+    iter->byType = type != 0;
+    iter->next = first;
+    rrec->iters = iter;
+    return first;
+}
+
+static inline ResourcePtr
+NextResource(ResourceIterRec *iter, ResourcePtr this)
+{
+    return iter->next = iter->byType ? this->typeNext : this->allNext;
+}
+
+static inline void
+EndResourceWalk(ClientResourceRec *rrec, ResourceIterRec *iter)
+{
+    rrec->iters = iter->prev;
+}
+
 static XID
 AvailableID(int client, XID id, XID maxid, XID goodid)
 {
-    ResourcePtr res;
-
     if ((goodid >= id) && (goodid <= maxid))
         return goodid;
     for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
+        if (!LookupChain(&clientTable[client], id))
             return id;
     }
     return 0;
@@ -717,18 +973,15 @@ GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
         id |= client ? SERVER_BIT : SERVER_MINID;
     maxid = id | RESOURCE_ID_MASK;
     goodid = 0;
-    ResourcePtr *resp = clientTable[client].resources;
-    for (int i = clientTable[client].buckets; --i >= 0;) {
-        for (ResourcePtr res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
-        }
+    for (ResourcePtr res = clientTable[client].all; res; res = res->allNext) {
+        if ((res->id < id) || (res->id > maxid))
+            continue;
+        if (((res->id - id) >= (maxid - res->id)) ?
+            (goodid = AvailableID(client, id, res->id - 1, goodid)) :
+            !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
+            maxid = res->id - 1;
+        else
+            id = res->id + 1;
     }
     if (id > maxid)
         id = maxid = 0;
@@ -811,91 +1064,138 @@ FakeClientID(int client)
     return id;
 }
 
+static void
+UnlinkChunk(ClientResourceRec *rrec, ResourceChunkRec *chunk)
+{
+    if (chunk->prev)
+        chunk->prev->next = chunk->next;
+    else
+        rrec->chunks = chunk->next;
+    if (chunk->next)
+        chunk->next->prev = chunk->prev;
+}
+
+static void
+PushChunk(ClientResourceRec *rrec, ResourceChunkRec *chunk)
+{
+    chunk->prev = NULL;
+    chunk->next = rrec->chunks;
+    if (chunk->next)
+        chunk->next->prev = chunk;
+    rrec->chunks = chunk;
+}
+
+static ResourcePtr
+AllocResourceRec(ClientResourceRec *rrec)
+{
+    ResourceChunkRec *chunk = rrec->chunks;
+    ResourcePtr res;
+
+    if (!chunk || !chunk->freeRecs) {
+        unsigned int count = min(max(rrec->poolRecs, POOL_MINCHUNK),
+                                 POOL_MAXCHUNK);
+
+        chunk = malloc(sizeof(ResourceChunkRec) + count * sizeof(ResourceRec));
+        if (!chunk)
+            return NULL;
+        chunk->count = count;
+        chunk->used = 0;
+        chunk->freeRecs = NULL;
+        for (unsigned int i = count; i--; ) {
+            chunk->recs[i].chunk = chunk;
+            chunk->recs[i].next = chunk->freeRecs;
+            chunk->freeRecs = &chunk->recs[i];
+        }
+        rrec->poolRecs += count;
+        PushChunk(rrec, chunk);
+    }
+    else if (!chunk->used)
+        rrec->emptyChunk = FALSE;
+
+    res = chunk->freeRecs;
+    chunk->freeRecs = res->next;
+    chunk->used++;
+    if (!chunk->freeRecs && chunk->next) {
+        /* full, move it behind the others */
+        ResourceChunkRec *last = chunk->next;
+
+        while (last->next)
+            last = last->next;
+        UnlinkChunk(rrec, chunk);
+        chunk->prev = last;
+        chunk->next = NULL;
+        last->next = chunk;
+    }
+    return res;
+}
+
+static void
+FreeResourceRec(ClientResourceRec *rrec, ResourcePtr res)
+{
+    ResourceChunkRec *chunk = res->chunk;
+
+    if (!chunk->freeRecs && chunk != rrec->chunks) {
+        /* it has a free record again */
+        UnlinkChunk(rrec, chunk);
+        PushChunk(rrec, chunk);
+    }
+    res->next = chunk->freeRecs;
+    chunk->freeRecs = res;
+    if (--chunk->used)
+        return;
+
+    if (!rrec->emptyChunk) {
+        rrec->emptyChunk = TRUE;
+        return;
+    }
+    UnlinkChunk(rrec, chunk);
+    rrec->poolRecs -= chunk->count;
+    free(chunk);
+}
+
 Bool
 AddResource(XID id, RESTYPE type, void *value)
 {
     int client;
     ClientResourceRec *rrec;
-    ResourcePtr *head;
+    ResourcePtr res;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
 #endif
     client = dixClientIdForXID(id);
     rrec = &clientTable[client];
-    if (!rrec->buckets) {
+    if (!rrec->table.buckets) {
         ErrorF("[dix] AddResource(%lx, %x, %lx), client=%d \n",
                (unsigned long) id, type, (unsigned long) value, client);
         FatalError("client not in use\n");
     }
-    if ((rrec->elements >= 4 * rrec->buckets) && (rrec->hashsize < MAXHASHSIZE))
-        RebuildTable(client);
-    head = &rrec->resources[HashResourceID(id, clientTable[client].hashsize)];
-    ResourcePtr res = calloc(1, sizeof(ResourceRec));
-    if (!res) {
+    MigrateTable(rrec, MIGRATE_STEP);
+    if (rrec->table.used + rrec->old.used >= 1U << rrec->table.hashsize &&
+        !LookupChain(rrec, id))
+        GrowTable(rrec);
+    if (((type & TypeMask) >= rrec->numTypes && !GrowTypeIndex(rrec, type)) ||
+        !(res = AllocResourceRec(rrec))) {
         (*resourceTypes[type & TypeMask].deleteFunc) (value, id);
         return FALSE;
     }
-    res->next = *head;
     res->id = id;
     res->type = type;
     res->value = value;
-    *head = res;
-    rrec->elements++;
+    LinkResource(rrec, res);
     CallResourceStateCallback(ResourceStateAdding, res);
     return TRUE;
 }
 
 static void
-RebuildTable(int client)
-{
-    int j;
-    ResourcePtr **tails, *resources;
-
-    /*
-     * For now, preserve insertion order, since some ddx layers depend
-     * on resources being free in the opposite order they are added.
-     */
-
-    j = 2 * clientTable[client].buckets;
-    tails =  calloc(j, sizeof(ResourcePtr *));
-    if (!tails)
-        return;
-    resources =  calloc(j, sizeof(ResourcePtr));
-    if (!resources) {
-        free(tails);
-        return;
-    }
-    for (ResourcePtr *rptr = resources, **tptr = tails; --j >= 0; rptr++, tptr++) {
-        *rptr = NULL;
-        *tptr = rptr;
-    }
-    clientTable[client].hashsize++;
-    j = clientTable[client].buckets;
-    for (ResourcePtr *rptr = clientTable[client].resources, **tptr; --j >= 0; rptr++) {
-        for (ResourcePtr res = *rptr, next; res; res = next) {
-            next = res->next;
-            res->next = NULL;
-            tptr = &tails[HashResourceID(res->id, clientTable[client].hashsize)];
-            **tptr = res;
-            *tptr = &res->next;
-        }
-    }
-    free(tails);
-    clientTable[client].buckets *= 2;
-    free(clientTable[client].resources);
-    clientTable[client].resources = resources;
-}
-
-static void
-doFreeResource(ResourcePtr res, Bool skip)
+doFreeResource(ClientResourceRec *rrec, ResourcePtr res, Bool skip)
 {
     CallResourceStateCallback(ResourceStateFreeing, res);
 
     if (!skip)
         resourceTypes[res->type & TypeMask].deleteFunc(res->value, res->id);
 
-    free(res);
+    FreeResourceRec(rrec, res);
 }
 
 void
@@ -903,33 +1203,20 @@ FreeResource(XID id, RESTYPE skipDeleteFuncType)
 {
     int cid;
     ResourcePtr res;
-    ResourcePtr *prev, *head;
-    int *eltptr;
-    int elements;
 
-    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-        eltptr = &clientTable[cid].elements;
-
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id) {
-                RESTYPE rtype = res->type;
+    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].table.buckets) {
+        /* delete functions might free other resources with this id,
+           so always start over at the (new) head of the chain */
+        while ((res = LookupChain(&clientTable[cid], id))) {
+            RESTYPE rtype = res->type;
 
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(res->id, res->type,
-                                      res->value, TypeNameString(res->type));
+            XSERVER_RESOURCE_FREE(res->id, res->type,
+                                  res->value, TypeNameString(res->type));
 #endif
-                *prev = res->next;
-                elements = --*eltptr;
-
-                doFreeResource(res, rtype == skipDeleteFuncType);
+            UnlinkResource(&clientTable[cid], res);
 
-                if (*eltptr != elements)
-                    prev = head;        /* prev may no longer be valid */
-            }
-            else
-                prev = &res->next;
+            doFreeResource(&clientTable[cid], res, rtype == skipDeleteFuncType);
         }
     }
 }
@@ -938,28 +1225,21 @@ void
 FreeResourceByType(XID id, RESTYPE type, Bool skipFree)
 {
     int cid;
-    ResourcePtr res;
-    ResourcePtr *prev, *head;
-
-    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].buckets) {
-        head = &clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
 
-        prev = head;
-        while ((res = *prev)) {
-            if (res->id == id && res->type == type) {
+    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].table.buckets) {
+        for (ResourcePtr res = LookupChain(&clientTable[cid], id);
+             res; res = res->next) {
+            if (res->type == type) {
 #ifdef XSERVER_DTRACE
                 XSERVER_RESOURCE_FREE(res->id, res->type,
                                       res->value, TypeNameString(res->type));
 #endif
-                *prev = res->next;
-                clientTable[cid].elements--;
+                UnlinkResource(&clientTable[cid], res);
 
-                doFreeResource(res, skipFree);
+                doFreeResource(&clientTable[cid], res, skipFree);
 
                 break;
             }
-            else
-                prev = &res->next;
         }
     }
 }
@@ -975,10 +1255,10 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
 {
     int cid;
 
-    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].buckets) {
-        for (ResourcePtr res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-            res; res = res->next)
-            if ((res->id == id) && (res->type == rtype)) {
+    if (((cid = dixClientIdForXID(id)) < LimitClients) && clientTable[cid].table.buckets) {
+        for (ResourcePtr res = LookupChain(&clientTable[cid], id);
+             res; res = res->next)
+            if (res->type == rtype) {
                 res->value = value;
                 return TRUE;
             }
@@ -986,36 +1266,30 @@ ChangeResourceValue(XID id, RESTYPE rtype, void *value)
     return FALSE;
 }
 
-/* Note: if func adds or deletes resources, then func can get called
- * more than once for some resources.  If func adds new resources,
- * func might or might not get called for them.  func cannot both
- * add and delete an equal number of resources!
+/* Note: func may add or delete resources.  Resources deleted before
+ * they've been reached are skipped, resources added might or might not
+ * be visited.  Only resources of the given type are looked at, unless
+ * type is 0.
  */
 
 void
 FindClientResourcesByType(ClientPtr client,
                           RESTYPE type, FindResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    int elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (int i = 0; i < clientTable[client->index].buckets; i++) {
-        for (ResourcePtr this = resources[i], next; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                elements = *eltptr;
-                (*func) (this->value, this->id, cdata);
-                if (*eltptr != elements)
-                    next = resources[i];        /* start over */
-            }
-        }
+    rrec = &clientTable[client->index];
+    for (ResourcePtr this = BeginResourceWalk(rrec, &iter, type);
+         this; this = iter.next) {
+        NextResource(&iter, this);
+        if (!type || this->type == type)
+            (*func) (this->value, this->id, cdata);
     }
+    EndResourceWalk(rrec, &iter);
 }
 
 void FindSubResources(void *resource,
@@ -1030,24 +1304,19 @@ void FindSubResources(void *resource,
 void
 FindAllClientResources(ClientPtr client, FindAllRes func, void *cdata)
 {
-    ResourcePtr *resources;
-    int elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (int i = 0; i < clientTable[client->index].buckets; i++) {
-        for (ResourcePtr this = resources[i], next; this; this = next) {
-            next = this->next;
-            elements = *eltptr;
-            (*func) (this->value, this->id, this->type, cdata);
-            if (*eltptr != elements)
-                next = resources[i];    /* start over */
-        }
+    rrec = &clientTable[client->index];
+    for (ResourcePtr this = BeginResourceWalk(rrec, &iter, 0);
+         this; this = iter.next) {
+        NextResource(&iter, this);
+        (*func) (this->value, this->id, this->type, cdata);
     }
+    EndResourceWalk(rrec, &iter);
 }
 
 void *
@@ -1055,70 +1324,61 @@ LookupClientResourceComplex(ClientPtr client,
                             RESTYPE type,
                             FindComplexResType func, void *cdata)
 {
-    ResourcePtr *resources;
-    void *value;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
+    void *value, *found = NULL;
 
     if (!client)
         client = serverClient;
 
-    resources = clientTable[client->index].resources;
-    for (int i = 0; i < clientTable[client->index].buckets; i++) {
-        for (ResourcePtr this = resources[i], next; this; this = next) {
-            next = this->next;
-            if (!type || this->type == type) {
-                /* workaround func freeing the type as DRI1 does */
-                value = this->value;
-                if ((*func) (value, this->id, cdata))
-                    return value;
+    rrec = &clientTable[client->index];
+    for (ResourcePtr this = BeginResourceWalk(rrec, &iter, type);
+         this; this = iter.next) {
+        NextResource(&iter, this);
+        if (!type || this->type == type) {
+            /* workaround func freeing the type as DRI1 does */
+            value = this->value;
+            if ((*func) (value, this->id, cdata)) {
+                found = value;
+                break;
             }
         }
     }
-    return NULL;
+    EndResourceWalk(rrec, &iter);
+    return found;
 }
 
 void
 FreeClientNeverRetainResources(ClientPtr client)
 {
-    ResourcePtr *resources;
-    ResourcePtr this;
-    ResourcePtr *prev;
-    int elements;
-    int *eltptr;
+    ClientResourceRec *rrec;
+    ResourceIterRec iter;
 
     if (!client)
         return;
 
-    resources = clientTable[client->index].resources;
-    eltptr = &clientTable[client->index].elements;
-    for (int j = 0; j < clientTable[client->index].buckets; j++) {
-        prev = &resources[j];
-        while ((this = *prev)) {
-            RESTYPE rtype = this->type;
-
-            if (rtype & RC_NEVERRETAIN) {
+    rrec = &clientTable[client->index];
+    for (ResourcePtr this = BeginResourceWalk(rrec, &iter, 0);
+         this; this = iter.next) {
+        NextResource(&iter, this);
+        if (this->type & RC_NEVERRETAIN) {
 #ifdef XSERVER_DTRACE
-                XSERVER_RESOURCE_FREE(this->id, this->type,
-                                      this->value, TypeNameString(this->type));
+            XSERVER_RESOURCE_FREE(this->id, this->type,
+                                  this->value, TypeNameString(this->type));
 #endif
-                *prev = this->next;
-                clientTable[client->index].elements--;
-                elements = *eltptr;
+            UnlinkResource(rrec, this);
 
-                doFreeResource(this, FALSE);
-
-                if (*eltptr != elements)
-                    prev = &resources[j];       /* prev may no longer be valid */
-            }
-            else
-                prev = &this->next;
+            doFreeResource(rrec, this, FALSE);
         }
     }
+    EndResourceWalk(rrec, &iter);
 }
 
 void
 FreeClientResources(ClientPtr client)
 {
-    ResourcePtr *resources;
+    ClientResourceRec *rrec;
+    ResourcePtr this;
 
     /* This routine shouldn't be called with a null client, but just in
        case ... */
@@ -1128,42 +1388,45 @@ FreeClientResources(ClientPtr client)
 
     HandleSaveSet(client);
 
-    resources = clientTable[client->index].resources;
-    for (int j = 0; j < clientTable[client->index].buckets; j++) {
-        /* It may seem silly to update the head of this resource list as
-           we delete the members, since the entire list will be deleted any way,
-           but there are some resource deletion functions "FreeClientPixels" for
-           one which do a LookupID on another resource id (a Colormap id in this
-           case), so the resource list must be kept valid up to the point that
-           it is deleted, so every time we delete a resource, we must update the
-           head, just like in FreeResource. I hope that this doesn't slow down
-           mass deletion appreciably. PRH */
-
-        ResourcePtr *head;
+    rrec = &clientTable[client->index];
 
-        head = &resources[j];
-
-        for (ResourcePtr this = *head; this; this = *head) {
+    /* Some resource deletion functions ("FreeClientPixels" for one) do a
+       LookupID on another resource of the same client, so the table must
+       be kept valid up to the point that it is deleted.  Resources are
+       unlinked one by one, newest first, but that's O(1) each: no
+       scanning of buckets or chains. */
+    while ((this = rrec->all)) {
 #ifdef XSERVER_DTRACE
-            XSERVER_RESOURCE_FREE(this->id, this->type,
-                                  this->value, TypeNameString(this->type));
+        XSERVER_RESOURCE_FREE(this->id, this->type,
+                              this->value, TypeNameString(this->type));
 #endif
-            *head = this->next;
-            clientTable[client->index].elements--;
+        UnlinkResource(rrec, this);
 
-            doFreeResource(this, FALSE);
-        }
+        doFreeResource(rrec, this, FALSE);
+    }
+    free(rrec->table.buckets);
+    free(rrec->old.buckets);
+    free(rrec->byType);
+    while (rrec->chunks) {
+        ResourceChunkRec *chunk = rrec->chunks;
+
+        rrec->chunks = chunk->next;
+        free(chunk);
     }
-    free(clientTable[client->index].resources);
-    clientTable[client->index].resources = NULL;
-    clientTable[client->index].buckets = 0;
+    rrec->poolRecs = 0;
+    rrec->emptyChunk = FALSE;
+    memset(&rrec->table, 0, sizeof(rrec->table));
+    memset(&rrec->old, 0, sizeof(rrec->old));
+    rrec->migrated = 0;
+    rrec->byType = NULL;
+    rrec->numTypes = 0;
 }
 
 void
 FreeAllResources(void)
 {
     for (int i = currentMaxClients; --i >= 0;) {
-        if (clientTable[i].buckets)
+        if (clientTable[i].table.buckets)
             FreeClientResources(clients[i]);
     }
 }
@@ -1204,11 +1467,9 @@ dixLookupResourceByType(void **result, XID id, RESTYPE rtype,
     if ((rtype & TypeMask) > lastResourceType)
         return BadImplementation;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && res->type == rtype)
+    if ((cid < LimitClients) && clientTable[cid].table.buckets) {
+        for (res = LookupChain(&clientTable[cid], id); res; res = res->next)
+            if (res->type == rtype)
                 break;
     }
     if (client) {
@@ -1239,11 +1500,9 @@ dixLookupResourceByClass(void **result, XID id, RESTYPE rclass,
 
     *result = NULL;
 
-    if ((cid < LimitClients) && clientTable[cid].buckets) {
-        res = clientTable[cid].resources[HashResourceID(id, clientTable[cid].hashsize)];
-
-        for (; res; res = res->next)
-            if (res->id == id && (res->type & rclass))
+    if ((cid < LimitClients) && clientTable[cid].table.buckets) {
+        for (res = LookupChain(&clientTable[cid], id); res; res = res->next)
+            if (res->type & rclass)
                 break;
     }
     if (client) {
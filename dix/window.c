@@ -552,6 +552,9 @@ CreateRootWindow(ScreenPtr pScreen)
     BoxRec box;
     PixmapFormatRec *format;
 
+    if (!WindowIndexInit() || !PropertyIndexInit())
+        return FALSE;
+
     pWin = dixAllocateScreenObjectWithPrivates(pScreen, WindowRec, PRIVATE_WINDOW);
     if (!pWin)
         return FALSE;
@@ -975,6 +978,7 @@ FreeWindowResources(WindowPtr pWin)
     RegionUninit(&pWin->winSize);
     RegionUninit(&pWin->borderClip);
     RegionUninit(&pWin->borderSize);
+    WindowIndexRemove(pWin);
     if (wBoundingShape(pWin))
         RegionDestroy(wBoundingShape(pWin));
     if (wClipShape(pWin))
@@ -1674,6 +1678,7 @@ MoveWindowInStack(WindowPtr pWin, WindowPtr pNextSib)
                     pFirstChange = pFirstChange->nextSib;
             }
         }
+        WindowIndexRestacked(pWin);
         if (pWin->drawable.pScreen->RestackWindow)
             (*pWin->drawable.pScreen->RestackWindow) (pWin, pOldNextSib);
     }
@@ -1692,9 +1697,23 @@ MoveWindowInStack(WindowPtr pWin, WindowPtr pNextSib)
     return pFirstChange;
 }
 
+/*
+ * Tells ValidateTree that the regions of pWin have to be recomputed, no
+ * matter whether its surroundings changed.
+ */
+static void
+MarkClipDirty(WindowPtr pWin)
+{
+    pWin->clipDirty = TRUE;
+    for (pWin = pWin->parent; pWin && !pWin->dirtyDescendants;
+         pWin = pWin->parent)
+        pWin->dirtyDescendants = TRUE;
+}
+
 void
 SetWinSize(WindowPtr pWin)
 {
+    MarkClipDirty(pWin);
     if (pWin->redirectDraw != RedirectDrawNone) {
         BoxRec box;
 
@@ -1729,6 +1748,7 @@ SetBorderSize(WindowPtr pWin)
 {
     int bw;
 
+    MarkClipDirty(pWin);
     if (HasBorder(pWin)) {
         bw = wBorderWidth(pWin);
         if (pWin->redirectDraw != RedirectDrawNone) {
@@ -1762,6 +1782,7 @@ SetBorderSize(WindowPtr pWin)
     else {
         RegionCopy(&pWin->borderSize, &pWin->winSize);
     }
+    WindowIndexUpdate(pWin);
 }
 
 /**
@@ -2654,6 +2675,7 @@ MapWindow(WindowPtr pWin, ClientPtr client)
                 return Success;
 
         pWin->mapped = TRUE;
+        WindowIndexUpdate(pWin);
         if (SubStrSend(pWin, pParent))
             DeliverMapNotify(pWin);
 
@@ -2721,6 +2743,7 @@ MapSubwindows(WindowPtr pParent, ClientPtr client)
                     continue;
 
             pWin->mapped = TRUE;
+            WindowIndexUpdate(pWin);
             if (parentNotify || StrSend(pWin))
                 DeliverMapNotify(pWin);
 
@@ -2837,6 +2860,7 @@ UnmapWindow(WindowPtr pWin, Bool fromConfigure)
         (*pScreen->MarkWindow) (pLayerWin->parent);
     }
     pWin->mapped = FALSE;
+    WindowIndexUpdate(pWin);
     if (wasRealized)
         UnrealizeTree(pWin, fromConfigure);
     if (wasViewable && !fromConfigure) {
@@ -2886,6 +2910,7 @@ UnmapSubwindows(WindowPtr pWin)
                 anyMarked = TRUE;
             }
             pChild->mapped = FALSE;
+            WindowIndexUpdate(pChild);
             if (pChild->realized)
                 UnrealizeTree(pChild, FALSE);
         }
@@ -2944,8 +2969,10 @@ HandleSaveSet(ClientPtr client)
                                pParent->drawable.x,
                                pWin->drawable.y - wBorderWidth(pWin) -
                                pParent->drawable.y, client);
-                if (!pWin->realized && pWin->mapped)
+                if (!pWin->realized && pWin->mapped) {
                     pWin->mapped = FALSE;
+                    WindowIndexUpdate(pWin);
+                }
             }
             if (SaveSetShouldMap(client->saveSet[j]))
                 MapWindow(pWin, client);
@@ -0,0 +1,427 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Spatial index of top-level windows
+ *
+ * XYToWindow() runs on every pointer motion, and walking all children of
+ * the root to find the one under the pointer gets expensive with the
+ * thousands of top-levels some window managers and compositors keep
+ * around.  So each screen gets a uniform grid over the root window, and
+ * every mapped top-level is entered into the cells its border box
+ * touches; windows covering lots of cells go into a single list instead,
+ * which is checked for every point.
+ *
+ * window.c updates the grid whenever a top-level is mapped, unmapped,
+ * moved, resized, reparented, restacked or destroyed.  The grid itself is
+ * only built on the first lookup, and rebuilt when the root changes size.
+ *
+ * Each indexed window also gets a rank which goes up from the top of the
+ * stack to the bottom.  Ranks are spaced out, so a window that gets mapped
+ * or restacked usually finds room between its neighbours' ranks and none
+ * of the others have to change.  Only when there's no room left are the
+ * windows renumbered.
+ *
+ * The index only narrows down the candidates: the caller's hit test
+ * (bounding and input shapes etc) still decides, and the one highest in
+ * the stack wins, so the result is the same as walking the children.
+ */
+
+#include <dix-config.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dix/window_priv.h"
+
+#include "misc.h"
+#include "privates.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#define WINDOW_INDEX_CELL_SHIFT  7      /* 128x128 pixel cells */
+#define WINDOW_INDEX_LARGE_CELLS 64     /* larger windows live in one list */
+#define WINDOW_INDEX_RANK_FIRST  (1ULL << 62)   /* leaves room above */
+#define WINDOW_INDEX_RANK_STEP   (1ULL << 32)
+
+typedef struct _WindowIndexList {
+    WindowPtr *windows;         /* in no particular order */
+    int num;
+    int size;
+} WindowIndexListRec, *WindowIndexListPtr;
+
+typedef struct _WindowIndex {
+    int width, height;          /* root size the grid was built for */
+    int cols, rows;
+    WindowIndexListPtr cells;   /* cols * rows, row by row */
+    WindowIndexListRec large;
+    unsigned int serial;
+} WindowIndexRec, *WindowIndexPtr;
+
+typedef struct _WindowIndexWin {
+    BoxRec cells;               /* cells the window is in, x2/y2 exclusive */
+    unsigned int serial;        /* of the index it is in, if any */
+    Bool large;
+    uint64_t rank;              /* lower is higher up in the stack */
+} WindowIndexWinRec, *WindowIndexWinPtr;
+
+Bool WindowIndexEnabled = TRUE;
+
+static unsigned int windowIndexSerial;
+static DevPrivateKeyRec windowIndexKeyRec;
+static DevPrivateKeyRec windowIndexScreenKeyRec;
+
+#define windowIndexKey (&windowIndexKeyRec)
+#define windowIndexScreenKey (&windowIndexScreenKeyRec)
+
+static inline WindowIndexPtr
+WindowIndexGet(ScreenPtr pScreen)
+{
+    return dixLookupPrivate(&pScreen->devPrivates, windowIndexScreenKey);
+}
+
+static inline void
+WindowIndexSet(ScreenPtr pScreen, WindowIndexPtr idx)
+{
+    dixSetPrivate(&pScreen->devPrivates, windowIndexScreenKey, idx);
+}
+
+static inline WindowIndexWinPtr
+WindowIndexGetWin(WindowPtr pWin)
+{
+    return dixLookupPrivate(&pWin->devPrivates, windowIndexKey);
+}
+
+/* a window's entry is only valid for the index it was made for */
+static inline Bool
+IsIndexed(WindowIndexPtr idx, WindowIndexWinPtr priv)
+{
+    return priv->serial == idx->serial;
+}
+
+static inline Bool
+IsTopLevel(WindowPtr pWin)
+{
+    return pWin->parent && !pWin->parent->parent;
+}
+
+Bool
+WindowIndexInit(void)
+{
+    return dixRegisterPrivateKey(windowIndexKey, PRIVATE_WINDOW,
+                                 sizeof(WindowIndexWinRec)) &&
+        dixRegisterPrivateKey(windowIndexScreenKey, PRIVATE_SCREEN, 0);
+}
+
+static Bool
+WindowIndexListAdd(WindowIndexListPtr list, WindowPtr pWin)
+{
+    if (list->num == list->size) {
+        int size = list->size ? list->size * 2 : 4;
+        WindowPtr *windows = reallocarray(list->windows, size,
+                                          sizeof(WindowPtr));
+
+        if (!windows)
+            return FALSE;
+        list->windows = windows;
+        list->size = size;
+    }
+    list->windows[list->num++] = pWin;
+    return TRUE;
+}
+
+static void
+WindowIndexListRemove(WindowIndexListPtr list, WindowPtr pWin)
+{
+    for (int i = 0; i < list->num; i++) {
+        if (list->windows[i] == pWin) {
+            list->windows[i] = list->windows[--list->num];
+            return;
+        }
+    }
+}
+
+static void
+WindowIndexUnlink(WindowIndexPtr idx, WindowPtr pWin, WindowIndexWinPtr priv)
+{
+    if (!IsIndexed(idx, priv))
+        return;
+    if (priv->large)
+        WindowIndexListRemove(&idx->large, pWin);
+    else {
+        for (int y = priv->cells.y1; y < priv->cells.y2; y++)
+            for (int x = priv->cells.x1; x < priv->cells.x2; x++)
+                WindowIndexListRemove(&idx->cells[y * idx->cols + x], pWin);
+    }
+    priv->serial = 0;
+}
+
+/* the cells the border box of pWin touches; FALSE if it's off screen */
+static Bool
+WindowIndexCells(WindowIndexPtr idx, WindowPtr pWin, BoxPtr cells)
+{
+    int bw = wBorderWidth(pWin);
+    int x1 = max(pWin->drawable.x - bw, 0);
+    int y1 = max(pWin->drawable.y - bw, 0);
+    int x2 = min(pWin->drawable.x + (int) pWin->drawable.width + bw,
+                 idx->width);
+    int y2 = min(pWin->drawable.y + (int) pWin->drawable.height + bw,
+                 idx->height);
+
+    if (x1 >= x2 || y1 >= y2)
+        return FALSE;
+    cells->x1 = x1 >> WINDOW_INDEX_CELL_SHIFT;
+    cells->y1 = y1 >> WINDOW_INDEX_CELL_SHIFT;
+    cells->x2 = ((x2 - 1) >> WINDOW_INDEX_CELL_SHIFT) + 1;
+    cells->y2 = ((y2 - 1) >> WINDOW_INDEX_CELL_SHIFT) + 1;
+    return TRUE;
+}
+
+/* on failure the index is inconsistent and has to be dropped */
+static Bool
+WindowIndexLink(WindowIndexPtr idx, WindowPtr pWin, WindowIndexWinPtr priv)
+{
+    BoxRec cells;
+
+    if (!WindowIndexCells(idx, pWin, &cells))
+        return TRUE;
+
+    priv->cells = cells;
+    priv->large = (cells.x2 - cells.x1) * (cells.y2 - cells.y1) >
+        WINDOW_INDEX_LARGE_CELLS;
+    if (priv->large) {
+        if (!WindowIndexListAdd(&idx->large, pWin))
+            return FALSE;
+    }
+    else {
+        for (int y = cells.y1; y < cells.y2; y++) {
+            for (int x = cells.x1; x < cells.x2; x++) {
+                if (!WindowIndexListAdd(&idx->cells[y * idx->cols + x], pWin))
+                    return FALSE;
+            }
+        }
+    }
+    priv->serial = idx->serial;
+    return TRUE;
+}
+
+/* the nearest sibling of pWin in the index, above it or below it */
+static WindowIndexWinPtr
+WindowIndexNeighbour(WindowIndexPtr idx, WindowPtr pWin, Bool above)
+{
+    while ((pWin = above ? pWin->prevSib : pWin->nextSib)) {
+        WindowIndexWinPtr priv = WindowIndexGetWin(pWin);
+
+        if (IsIndexed(idx, priv))
+            return priv;
+    }
+    return NULL;
+}
+
+static void
+WindowIndexRenumber(WindowIndexPtr idx, WindowPtr pParent)
+{
+    uint64_t rank = WINDOW_INDEX_RANK_FIRST;
+
+    for (WindowPtr pWin = pParent->firstChild; pWin; pWin = pWin->nextSib) {
+        WindowIndexWinPtr priv = WindowIndexGetWin(pWin);
+
+        if (IsIndexed(idx, priv)) {
+            priv->rank = rank;
+            rank += WINDOW_INDEX_RANK_STEP;
+        }
+    }
+}
+
+/* an indexed window was mapped or restacked: rank it between its neighbours */
+static void
+WindowIndexRank(WindowIndexPtr idx, WindowPtr pWin, WindowIndexWinPtr priv)
+{
+    WindowIndexWinPtr above = WindowIndexNeighbour(idx, pWin, TRUE);
+    WindowIndexWinPtr below = WindowIndexNeighbour(idx, pWin, FALSE);
+
+    /* still where it was, relative to the other indexed windows */
+    if ((!above || above->rank < priv->rank) &&
+        (!below || priv->rank < below->rank))
+        return;
+
+    if (above && below) {
+        if (below->rank - above->rank < 2) {
+            WindowIndexRenumber(idx, pWin->parent);
+            return;
+        }
+        priv->rank = above->rank + (below->rank - above->rank) / 2;
+    }
+    else if (above) {
+        if (above->rank > UINT64_MAX - WINDOW_INDEX_RANK_STEP) {
+            WindowIndexRenumber(idx, pWin->parent);
+            return;
+        }
+        priv->rank = above->rank + WINDOW_INDEX_RANK_STEP;
+    }
+    else if (below) {
+        if (below->rank < WINDOW_INDEX_RANK_STEP) {
+            WindowIndexRenumber(idx, pWin->parent);
+            return;
+        }
+        priv->rank = below->rank - WINDOW_INDEX_RANK_STEP;
+    }
+    else
+        priv->rank = WINDOW_INDEX_RANK_FIRST;
+}
+
+static void
+WindowIndexFree(WindowIndexPtr idx)
+{
+    if (!idx)
+        return;
+    for (int i = 0; i < idx->cols * idx->rows; i++)
+        free(idx->cells[i].windows);
+    free(idx->cells);
+    free(idx->large.windows);
+    free(idx);
+}
+
+/* drops the index of the screen, the next lookup builds a new one */
+static void
+WindowIndexDrop(ScreenPtr pScreen)
+{
+    WindowIndexFree(WindowIndexGet(pScreen));
+    WindowIndexSet(pScreen, NULL);
+}
+
+static WindowIndexPtr
+WindowIndexBuild(WindowPtr pRoot)
+{
+    WindowIndexPtr idx;
+    int width = pRoot->drawable.width;
+    int height = pRoot->drawable.height;
+    uint64_t rank = WINDOW_INDEX_RANK_FIRST;
+
+    if (width <= 0 || height <= 0)
+        return NULL;
+    idx = calloc(1, sizeof(WindowIndexRec));
+    if (!idx)
+        return NULL;
+    idx->width = width;
+    idx->height = height;
+    idx->cols = ((width - 1) >> WINDOW_INDEX_CELL_SHIFT) + 1;
+    idx->rows = ((height - 1) >> WINDOW_INDEX_CELL_SHIFT) + 1;
+    idx->cells = calloc(idx->cols * idx->rows, sizeof(WindowIndexListRec));
+    if (!idx->cells) {
+        free(idx);
+        return NULL;
+    }
+    if (++windowIndexSerial == 0)
+        windowIndexSerial = 1;
+    idx->serial = windowIndexSerial;
+
+    for (WindowPtr pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib) {
+        WindowIndexWinPtr priv = WindowIndexGetWin(pWin);
+
+        if (!pWin->mapped)
+            continue;
+        if (!WindowIndexLink(idx, pWin, priv)) {
+            WindowIndexFree(idx);
+            return NULL;
+        }
+        priv->rank = rank;
+        rank += WINDOW_INDEX_RANK_STEP;
+    }
+    return idx;
+}
+
+void
+WindowIndexUpdate(WindowPtr pWin)
+{
+    WindowIndexPtr idx = WindowIndexGet(pWin->drawable.pScreen);
+    WindowIndexWinPtr priv;
+    Bool wasIndexed;
+
+    if (!idx || !pWin->parent)
+        return;
+    priv = WindowIndexGetWin(pWin);
+    wasIndexed = IsIndexed(idx, priv);
+    if (!wasIndexed && !(pWin->mapped && IsTopLevel(pWin)))
+        return;
+
+    WindowIndexUnlink(idx, pWin, priv);
+    if (pWin->mapped && IsTopLevel(pWin)) {
+        if (!WindowIndexLink(idx, pWin, priv)) {
+            WindowIndexDrop(pWin->drawable.pScreen);
+            return;
+        }
+        /* reparenting puts it on top, and it might be new to the index */
+        if (IsIndexed(idx, priv))
+            WindowIndexRank(idx, pWin, priv);
+    }
+}
+
+void
+WindowIndexRestacked(WindowPtr pWin)
+{
+    WindowIndexPtr idx = WindowIndexGet(pWin->drawable.pScreen);
+    WindowIndexWinPtr priv;
+
+    if (!idx || !IsTopLevel(pWin))
+        return;
+    priv = WindowIndexGetWin(pWin);
+    if (IsIndexed(idx, priv))
+        WindowIndexRank(idx, pWin, priv);
+}
+
+void
+WindowIndexRemove(WindowPtr pWin)
+{
+    WindowIndexPtr idx = WindowIndexGet(pWin->drawable.pScreen);
+
+    if (!idx)
+        return;
+    if (!pWin->parent)
+        WindowIndexDrop(pWin->drawable.pScreen);
+    else
+        WindowIndexUnlink(idx, pWin, WindowIndexGetWin(pWin));
+}
+
+Bool
+WindowIndexLookup(WindowPtr pRoot, int x, int y, WindowIndexHitProcPtr hit,
+                  WindowPtr *ppWin)
+{
+    ScreenPtr pScreen = pRoot->drawable.pScreen;
+    WindowIndexPtr idx = WindowIndexGet(pScreen);
+    WindowIndexListPtr lists[2];
+    WindowPtr best = NullWindow;
+    uint64_t bestRank = 0;
+
+    if (!WindowIndexEnabled)
+        return FALSE;
+    /* outside the grid, e.g. rootless windows on another virtual desktop */
+    if (x < 0 || y < 0 ||
+        x >= pRoot->drawable.width || y >= pRoot->drawable.height)
+        return FALSE;
+
+    if (!idx || idx->width != pRoot->drawable.width ||
+        idx->height != pRoot->drawable.height) {
+        WindowIndexDrop(pScreen);
+        idx = WindowIndexBuild(pRoot);
+        WindowIndexSet(pScreen, idx);
+        if (!idx)
+            return FALSE;
+    }
+
+    lists[0] = &idx->cells[(y >> WINDOW_INDEX_CELL_SHIFT) * idx->cols +
+                           (x >> WINDOW_INDEX_CELL_SHIFT)];
+    lists[1] = &idx->large;
+    for (int l = 0; l < 2; l++) {
+        for (int i = 0; i < lists[l]->num; i++) {
+            WindowPtr pWin = lists[l]->windows[i];
+            uint64_t rank = WindowIndexGetWin(pWin)->rank;
+
+            if ((!best || rank < bestRank) && hit(pWin, x, y)) {
+                best = pWin;
+                bestRank = rank;
+            }
+        }
+    }
+    *ppWin = best;
+    return TRUE;
+}
@@ -53,4 +53,42 @@ Bool MakeWindowOptional(WindowPtr pWin);
  */
 Bool dixWindowIsRoot(Window window);
 
+/*
+ * Spatial index of the mapped top-level windows of each screen, used by
+ * XYToWindow.  window.c keeps it up to date.
+ */
+
+typedef Bool (*WindowIndexHitProcPtr) (WindowPtr pWin, int x, int y);
+
+/* FALSE makes every lookup fall back to walking the window tree */
+extern Bool WindowIndexEnabled;
+
+/*
+ * @brief register the index' window and screen privates
+ *
+ * Must be called before the first window of a server generation is created.
+ */
+Bool WindowIndexInit(void);
+
+/* a window was mapped, unmapped, moved, resized or reparented */
+void WindowIndexUpdate(WindowPtr pWin);
+
+/* the stacking order of a window's siblings changed */
+void WindowIndexRestacked(WindowPtr pWin);
+
+/* a window is being destroyed */
+void WindowIndexRemove(WindowPtr pWin);
+
+/*
+ * @brief find the top-level window at x/y
+ *
+ * Sets *ppWin to the highest stacked child of pRoot for which hit() is
+ * TRUE, or NullWindow if there is none.
+ *
+ * @return FALSE if the index can't answer (x/y outside the root, out of
+ *         memory), the caller has to walk the children itself then.
+ */
+Bool WindowIndexLookup(WindowPtr pRoot, int x, int y,
+                       WindowIndexHitProcPtr hit, WindowPtr *ppWin);
+
 #endif /* _XSERVER_DIX_WINDOW_PRIV_H */
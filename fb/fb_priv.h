@@ -31,6 +31,83 @@ static inline void fbValidateDrawable(DrawablePtr d) {}
 
 #endif /* FB_DEBUG */
 
+/*
+ * Vector kernels for the middle words of fbBlt spans (fbbltsimd.c).  The
+ * wrapped access (wfb) build always goes through READ/WRITE instead.
+ */
+#if !defined(FB_ACCESS_WRAPPER) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__) || defined(__ARM_NEON))
+#define FB_BLT_SIMD
+
+/* the merge rop of FbDeclareMergeRop(), as values */
+typedef struct _FbBltRop {
+    FbBits ca1, cx1, ca2, cx2;
+} FbBltRopRec;
+
+static inline FbBits
+fbBltApplyRop(const FbBltRopRec *rop, FbBits src, FbBits dst)
+{
+    return (dst & ((src & rop->ca1) ^ rop->cx1)) ^ ((src & rop->ca2) ^ rop->cx2);
+}
+
+typedef struct _FbBltFuncs {
+    const char *name;
+    /* dst[i] = rop(src[i], dst[i]) for i < n */
+    void (*blt) (FbBits *dst, const FbBits *src, int n, Bool reverse,
+                 const FbBltRopRec *rop);
+    /* the same, with src[i] built from src[i] and src[i + 1] */
+    void (*bltShift) (FbBits *dst, const FbBits *src, int n,
+                      int leftShift, int rightShift, Bool reverse,
+                      const FbBltRopRec *rop);
+} FbBltFuncsRec;
+
+/* NULL until fbInitBltSimd() found a usable instruction set */
+extern const FbBltFuncsRec *fbBltFuncs;
+
+/* returns the name of the selected instruction set, NULL for plain C */
+const char *fbInitBltSimd(Bool enable);
+
+#endif /* FB_BLT_SIMD */
+
+/*
+ * Large fills, spans, images and composites in bands of scanlines on the
+ * server's worker threads (fbthread.c), on screens whose DDX opts in with
+ * fbSetThreaded().  An operation collects the boxes it draws with
+ * fbBandsAdd(), and fbBandsRun() then calls draw for the parts of them
+ * within each band, in the order they were added.  fbBandsInit() returns
+ * FALSE if the operation should just draw the boxes right away.
+ */
+#define FB_BAND_HEIGHT  64
+
+typedef void (*FbBandProc) (void *closure, const BoxRec *pBox);
+
+typedef struct _FbBands {
+    ScreenPtr pScreen;
+    FbBandProc draw;
+    void *closure;
+    BoxPtr boxes;
+    int nbox, size;
+    int y1, y2;                 /* extents of the boxes */
+    unsigned long area;
+} FbBandsRec, *FbBandsPtr;
+
+void fbSetThreaded(ScreenPtr pScreen, Bool threaded);
+
+Bool fbBandsInit(FbBandsPtr bands, ScreenPtr pScreen,
+                 FbBandProc draw, void *closure);
+Bool fbBandsInitGC(FbBandsPtr bands, DrawablePtr pDrawable, GCPtr pGC,
+                   FbBandProc draw, void *closure);
+void fbBandsAdd(FbBandsPtr bands, int x1, int y1, int x2, int y2);
+void fbBandsRun(FbBandsPtr bands);
+
+/* fbFill() of a box, for FbBandProc */
+typedef struct {
+    DrawablePtr pDrawable;
+    GCPtr pGC;
+} FbFillBandRec;
+
+void fbFillBand(void *closure, const BoxRec *pBox);
+
 Bool fbAllocatePrivates(ScreenPtr pScreen);
 int  fbListInstalledColormaps(ScreenPtr pScreen, Colormap* pmaps);
 
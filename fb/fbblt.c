@@ -23,7 +23,7 @@
 #include <dix-config.h>
 
 #include <string.h>
-#include "fb.h"
+#include "fb/fb_priv.h"
 
 #ifdef FB_ACCESS_WRAPPER
 
@@ -64,6 +64,90 @@
     } \
 }
 
+#ifdef FB_BLT_SIMD
+
+/* below this, setting up the vectors costs more than it saves */
+#define FB_BLT_SIMD_MIN 8
+
+/*
+ * Hands the middle words of a span to the vector kernels, if there are
+ * enough of them and the kernels can do them in blocks without reading
+ * back words they've already written.  Leaves *dst and *src where the
+ * scalar loop would have and returns how many words that loop still has
+ * to do.
+ */
+static inline int
+fbBltSimd(FbBits **dst, FbBits **src, int n, Bool reverse,
+          const FbBltRopRec *rop)
+{
+    FbBits *d = *dst, *s = *src;
+
+    if (!fbBltFuncs || n < FB_BLT_SIMD_MIN)
+        return n;
+    if (reverse) {
+        d -= n;
+        s -= n;
+        if (d < s && d + n > s)
+            return n;
+        *dst = d;
+        *src = s;
+    }
+    else {
+        if (d > s && d < s + n)
+            return n;
+        *dst = d + n;
+        *src = s + n;
+    }
+    fbBltFuncs->blt(d, s, n, reverse, rop);
+    return 0;
+}
+
+/*
+ * The same for spans which need shifting.  The first word is done here,
+ * as the scalar loop may not have read the word before it; afterwards
+ * *bits1 holds the last source word read, like in the scalar loop.
+ */
+static inline int
+fbBltShiftSimd(FbBits **dst, FbBits **src, FbBits *bits1, int n,
+               int leftShift, int rightShift, Bool reverse,
+               const FbBltRopRec *rop)
+{
+    FbBits *d = *dst, *s = *src;
+    int m = n - 1;
+
+    if (!fbBltFuncs || n < FB_BLT_SIMD_MIN)
+        return n;
+    if (reverse) {
+        d -= n;
+        s -= n;
+        if (d < s + 1 && d + n > s)
+            return n;
+        d[m] = fbBltApplyRop(rop, FbScrRight(*bits1, rightShift) |
+                             FbScrLeft(s[m], leftShift), d[m]);
+    }
+    else {
+        if (d >= s && d < s + n)
+            return n;
+        *d = fbBltApplyRop(rop, FbScrLeft(*bits1, leftShift) |
+                           FbScrRight(*s, rightShift), *d);
+        d++;
+    }
+    fbBltFuncs->bltShift(d, s, m, leftShift, rightShift, reverse, rop);
+    if (reverse) {
+        *dst = d;
+        *src = s;
+        *bits1 = *s;
+    }
+    else {
+        *dst = d + m;
+        *src = s + n;
+        *bits1 = s[m];
+    }
+    return 0;
+}
+
+#endif /* FB_BLT_SIMD */
+
 void
 fbBlt(FbBits * srcLine,
       FbStride srcStride,
@@ -119,6 +203,9 @@ fbBlt(FbBits * srcLine,
 
     FbInitializeMergeRop(alu, pm);
     destInvarient = FbDestInvarientMergeRop();
+#ifdef FB_BLT_SIMD
+    FbBltRopRec rop = { _ca1, _cx1, _ca2, _cx2 };
+#endif
     if (upsidedown) {
         srcLine += (height - 1) * (srcStride);
         dstLine += (height - 1) * (dstStride);
@@ -152,6 +239,9 @@ fbBlt(FbBits * srcLine,
                     FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
                 }
                 n = nmiddle;
+#ifdef FB_BLT_SIMD
+                n = fbBltSimd(&dst, &src, n, TRUE, &rop);
+#endif
                 if (destInvarient) {
                     while (n--)
                         WRITE(--dst, FbDoDestInvarientMergeRop(READ(--src)));
@@ -176,6 +266,9 @@ fbBlt(FbBits * srcLine,
                     dst++;
                 }
                 n = nmiddle;
+#ifdef FB_BLT_SIMD
+                n = fbBltSimd(&dst, &src, n, FALSE, &rop);
+#endif
                 if (destInvarient) {
 #if 0
                     /*
@@ -245,6 +338,10 @@ fbBlt(FbBits * srcLine,
                     FbDoRightMaskByteMergeRop(dst, bits, endbyte, endmask);
                 }
                 n = nmiddle;
+#ifdef FB_BLT_SIMD
+                n = fbBltShiftSimd(&dst, &src, &bits1, n, leftShift,
+                                   rightShift, TRUE, &rop);
+#endif
                 if (destInvarient) {
                     while (n--) {
                         bits = FbScrRight(bits1, rightShift);
@@ -286,6 +383,10 @@ fbBlt(FbBits * srcLine,
                     dst++;
                 }
                 n = nmiddle;
+#ifdef FB_BLT_SIMD
+                n = fbBltShiftSimd(&dst, &src, &bits1, n, leftShift,
+                                   rightShift, FALSE, &rop);
+#endif
                 if (destInvarient) {
                     while (n--) {
                         bits = FbScrLeft(bits1, leftShift);
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * SSE2, AVX2 and NEON versions of the inner fbBlt loops.
+ *
+ * They're built with per function target attributes, so the server
+ * doesn't need to be compiled for any particular CPU; fbInitBltSimd()
+ * picks the widest set the CPU we're running on supports.
+ */
+
+#include <dix-config.h>
+
+#include "fb/fb_priv.h"
+
+#ifdef FB_BLT_SIMD
+
+#include "os.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define FBV_NAME(n)             fbSSE2##n
+#define FBV_TARGET              __attribute__((target("sse2")))
+#define FBV_WORDS               4
+#define FbVec                   __m128i
+#define FbVecLoad(p)            _mm_loadu_si128((const __m128i *) (p))
+#define FbVecStore(p,v)         _mm_storeu_si128((__m128i *) (p), v)
+#define FbVecSplat(x)           _mm_set1_epi32((int) (x))
+#define FbVecAnd(a,b)           _mm_and_si128(a, b)
+#define FbVecOr(a,b)            _mm_or_si128(a, b)
+#define FbVecXor(a,b)           _mm_xor_si128(a, b)
+#define FbVecCount              __m128i
+#define FbVecScrLeftCount(n)    _mm_cvtsi32_si128(n)
+#define FbVecScrRightCount(n)   _mm_cvtsi32_si128(n)
+#if BITMAP_BIT_ORDER == LSBFirst
+#define FbVecScrLeft(v,c)       _mm_srl_epi32(v, c)
+#define FbVecScrRight(v,c)      _mm_sll_epi32(v, c)
+#else
+#define FbVecScrLeft(v,c)       _mm_sll_epi32(v, c)
+#define FbVecScrRight(v,c)      _mm_srl_epi32(v, c)
+#endif
+
+#include "fbbltsimd.h"
+
+#undef FBV_NAME
+#undef FBV_TARGET
+#undef FBV_WORDS
+#undef FbVec
+#undef FbVecLoad
+#undef FbVecStore
+#undef FbVecSplat
+#undef FbVecAnd
+#undef FbVecOr
+#undef FbVecXor
+#undef FbVecScrLeft
+#undef FbVecScrRight
+
+#define FBV_NAME(n)             fbAVX2##n
+#define FBV_TARGET              __attribute__((target("avx2")))
+#define FBV_WORDS               8
+#define FbVec                   __m256i
+#define FbVecLoad(p)            _mm256_loadu_si256((const __m256i *) (p))
+#define FbVecStore(p,v)         _mm256_storeu_si256((__m256i *) (p), v)
+#define FbVecSplat(x)           _mm256_set1_epi32((int) (x))
+#define FbVecAnd(a,b)           _mm256_and_si256(a, b)
+#define FbVecOr(a,b)            _mm256_or_si256(a, b)
+#define FbVecXor(a,b)           _mm256_xor_si256(a, b)
+#if BITMAP_BIT_ORDER == LSBFirst
+#define FbVecScrLeft(v,c)       _mm256_srl_epi32(v, c)
+#define FbVecScrRight(v,c)      _mm256_sll_epi32(v, c)
+#else
+#define FbVecScrLeft(v,c)       _mm256_sll_epi32(v, c)
+#define FbVecScrRight(v,c)      _mm256_srl_epi32(v, c)
+#endif
+
+#include "fbbltsimd.h"
+
+static const FbBltFuncsRec fbBltSSE2 = { "SSE2", fbSSE2Blt, fbSSE2BltShift };
+static const FbBltFuncsRec fbBltAVX2 = { "AVX2", fbAVX2Blt, fbAVX2BltShift };
+
+static const FbBltFuncsRec *
+fbBltSelect(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return &fbBltAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return &fbBltSSE2;
+    return NULL;
+}
+
+#else /* NEON */
+
+#include <arm_neon.h>
+
+#define FBV_NAME(n)             fbNEON##n
+#define FBV_TARGET
+#define FBV_WORDS               4
+#define FbVec                   uint32x4_t
+#define FbVecLoad(p)            vld1q_u32((const uint32_t *) (p))
+#define FbVecStore(p,v)         vst1q_u32((uint32_t *) (p), v)
+#define FbVecSplat(x)           vdupq_n_u32(x)
+#define FbVecAnd(a,b)           vandq_u32(a, b)
+#define FbVecOr(a,b)            vorrq_u32(a, b)
+#define FbVecXor(a,b)           veorq_u32(a, b)
+/* vshlq shifts right for negative counts */
+#define FbVecCount              int32x4_t
+#if BITMAP_BIT_ORDER == LSBFirst
+#define FbVecScrLeftCount(n)    vdupq_n_s32(-(n))
+#define FbVecScrRightCount(n)   vdupq_n_s32(n)
+#else
+#define FbVecScrLeftCount(n)    vdupq_n_s32(n)
+#define FbVecScrRightCount(n)   vdupq_n_s32(-(n))
+#endif
+#define FbVecScrLeft(v,c)       vshlq_u32(v, c)
+#define FbVecScrRight(v,c)      vshlq_u32(v, c)
+
+#include "fbbltsimd.h"
+
+static const FbBltFuncsRec fbBltNEON = { "NEON", fbNEONBlt, fbNEONBltShift };
+
+/* only built when NEON is part of the target baseline */
+static const FbBltFuncsRec *
+fbBltSelect(void)
+{
+    return &fbBltNEON;
+}
+
+#endif
+
+const FbBltFuncsRec *fbBltFuncs;
+
+const char *
+fbInitBltSimd(Bool enable)
+{
+    fbBltFuncs = enable ? fbBltSelect() : NULL;
+    return fbBltFuncs ? fbBltFuncs->name : NULL;
+}
+
+#endif /* FB_BLT_SIMD */
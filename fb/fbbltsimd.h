@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Vector fbBlt kernels.  This is a template, fbbltsimd.c includes it once
+ * per instruction set, after defining:
+ *
+ *   FBV_NAME(n)            the function name n for this instruction set
+ *   FBV_TARGET             attribute enabling the instruction set
+ *   FBV_WORDS              number of FbBits in a vector
+ *   FbVec                  the vector type
+ *   FbVecLoad(p)           unaligned load
+ *   FbVecStore(p,v)        unaligned store
+ *   FbVecSplat(x)          x in every lane
+ *   FbVecAnd/Or/Xor(a,b)
+ *   FbVecCount             shift count type
+ *   FbVecScrLeftCount(n)   FbVecScrLeft(v,c)  per lane FbScrLeft
+ *   FbVecScrRightCount(n)  FbVecScrRight(v,c) per lane FbScrRight
+ *
+ * Both kernels process blocks of FBV_WORDS, loading all the source words
+ * of a block before storing it, so they're fine with src and dst
+ * overlapping as long as dst doesn't run ahead of src in the direction
+ * they're walking.  fbBlt checks that before calling them.
+ */
+
+/*
+ * One loop per class of raster op: plain copy, other destination
+ * invariant ops, ops which only mask the destination with a constant
+ * (copy with a planemask, xor), and everything else.
+ */
+#define FBV_COPY(s, d)          (s)
+#define FBV_INVARIANT(s, d)     FbVecXor(FbVecAnd(s, ca2), cx2)
+#define FBV_MASKED(s, d)        FbVecXor(FbVecAnd(d, cx1), FBV_INVARIANT(s, d))
+#define FBV_MERGE(s, d)         FbVecXor(FbVecAnd(d, FbVecXor(FbVecAnd(s, ca1), cx1)), \
+                                         FBV_INVARIANT(s, d))
+
+#define FBV_LOOP(VSRC, SSRC, VOP) {                                       \
+    if (!reverse) {                                                       \
+        for (i = 0; i + FBV_WORDS <= n; i += FBV_WORDS)                   \
+            FbVecStore(dst + i, VOP(VSRC(i), FbVecLoad(dst + i)));        \
+        for (; i < n; i++)                                                \
+            dst[i] = fbBltApplyRop(rop, SSRC(i), dst[i]);                 \
+    }                                                                     \
+    else {                                                                \
+        for (i = n; i >= FBV_WORDS;) {                                    \
+            i -= FBV_WORDS;                                               \
+            FbVecStore(dst + i, VOP(VSRC(i), FbVecLoad(dst + i)));        \
+        }                                                                 \
+        while (i--)                                                       \
+            dst[i] = fbBltApplyRop(rop, SSRC(i), dst[i]);                 \
+    }                                                                     \
+}
+
+#define FBV_DISPATCH(VSRC, SSRC) {                                        \
+    if (rop->ca1 == 0 && rop->cx1 == 0) {                                 \
+        if (rop->ca2 == FB_ALLONES && rop->cx2 == 0)                      \
+            FBV_LOOP(VSRC, SSRC, FBV_COPY)                                \
+        else                                                              \
+            FBV_LOOP(VSRC, SSRC, FBV_INVARIANT)                           \
+    }                                                                     \
+    else if (rop->ca1 == 0)                                               \
+        FBV_LOOP(VSRC, SSRC, FBV_MASKED)                                  \
+    else                                                                  \
+        FBV_LOOP(VSRC, SSRC, FBV_MERGE)                                   \
+}
+
+/* dst[i] = rop(src[i], dst[i]) */
+static FBV_TARGET void
+FBV_NAME(Blt)(FbBits *dst, const FbBits *src, int n, Bool reverse,
+              const FbBltRopRec *rop)
+{
+    FbVec ca1 = FbVecSplat(rop->ca1), cx1 = FbVecSplat(rop->cx1);
+    FbVec ca2 = FbVecSplat(rop->ca2), cx2 = FbVecSplat(rop->cx2);
+    int i;
+
+#define VSRC(i) FbVecLoad(src + (i))
+#define SSRC(i) src[i]
+    FBV_DISPATCH(VSRC, SSRC)
+#undef VSRC
+#undef SSRC
+    (void) ca1; (void) cx1; (void) ca2; (void) cx2;
+}
+
+/* dst[i] = rop(FbScrLeft(src[i], leftShift) | FbScrRight(src[i + 1], rightShift), dst[i]) */
+static FBV_TARGET void
+FBV_NAME(BltShift)(FbBits *dst, const FbBits *src, int n,
+                   int leftShift, int rightShift, Bool reverse,
+                   const FbBltRopRec *rop)
+{
+    FbVec ca1 = FbVecSplat(rop->ca1), cx1 = FbVecSplat(rop->cx1);
+    FbVec ca2 = FbVecSplat(rop->ca2), cx2 = FbVecSplat(rop->cx2);
+    FbVecCount ls = FbVecScrLeftCount(leftShift);
+    FbVecCount rs = FbVecScrRightCount(rightShift);
+    int i;
+
+#define VSRC(i) FbVecOr(FbVecScrLeft(FbVecLoad(src + (i)), ls), \
+                        FbVecScrRight(FbVecLoad(src + (i) + 1), rs))
+#define SSRC(i) (FbScrLeft(src[i], leftShift) | FbScrRight(src[(i) + 1], rightShift))
+    FBV_DISPATCH(VSRC, SSRC)
+#undef VSRC
+#undef SSRC
+    (void) ca1; (void) cx1; (void) ca2; (void) cx2;
+}
+
+#undef FBV_COPY
+#undef FBV_INVARIANT
+#undef FBV_MASKED
+#undef FBV_MERGE
+#undef FBV_LOOP
+#undef FBV_DISPATCH
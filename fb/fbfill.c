@@ -180,6 +180,15 @@ fbFill(DrawablePtr pDrawable, GCPtr pGC, int x, int y, int width, int height)
     fbFinishAccess(pDrawable);
 }
 
+void
+fbFillBand(void *closure, const BoxRec *pBox)
+{
+    FbFillBandRec *fill = closure;
+
+    fbFill(fill->pDrawable, fill->pGC, pBox->x1, pBox->y1,
+           pBox->x2 - pBox->x1, pBox->y2 - pBox->y1);
+}
+
 void
 fbSolidBoxClipped(DrawablePtr pDrawable,
                   RegionPtr pClip,
@@ -22,7 +22,7 @@
 
 #include <dix-config.h>
 
-#include "fb.h"
+#include "fb/fb_priv.h"
 
 void
 fbPolyFillRect(DrawablePtr pDrawable, GCPtr pGC, int nrect, xRectangle *prect)
@@ -35,6 +35,9 @@ fbPolyFillRect(DrawablePtr pDrawable, GCPtr pGC, int nrect, xRectangle *prect)
     int partX1, partX2, partY1, partY2;
     int xorg, yorg;
     int n;
+    FbFillBandRec fill = { pDrawable, pGC };
+    FbBandsRec bands;
+    Bool threaded = fbBandsInitGC(&bands, pDrawable, pGC, fbFillBand, &fill);
 
     xorg = pDrawable->x;
     yorg = pDrawable->y;
@@ -67,8 +70,11 @@ fbPolyFillRect(DrawablePtr pDrawable, GCPtr pGC, int nrect, xRectangle *prect)
             continue;
         n = RegionNumRects(pClip);
         if (n == 1) {
-            fbFill(pDrawable,
-                   pGC, fullX1, fullY1, fullX2 - fullX1, fullY2 - fullY1);
+            if (threaded)
+                fbBandsAdd(&bands, fullX1, fullY1, fullX2, fullY2);
+            else
+                fbFill(pDrawable,
+                       pGC, fullX1, fullY1, fullX2 - fullX1, fullY2 - fullY1);
         }
         else {
             pbox = RegionRects(pClip);
@@ -92,10 +98,16 @@ fbPolyFillRect(DrawablePtr pDrawable, GCPtr pGC, int nrect, xRectangle *prect)
 
                 pbox++;
 
-                if (partX1 < partX2 && partY1 < partY2)
+                if (partX1 >= partX2 || partY1 >= partY2)
+                    continue;
+                if (threaded)
+                    fbBandsAdd(&bands, partX1, partY1, partX2, partY2);
+                else
                     fbFill(pDrawable, pGC,
                            partX1, partY1, partX2 - partX1, partY2 - partY1);
             }
         }
     }
+    if (threaded)
+        fbBandsRun(&bands);
 }
@@ -22,7 +22,7 @@
 
 #include <dix-config.h>
 
-#include "fb.h"
+#include "fb/fb_priv.h"
 
 void
 fbFillSpans(DrawablePtr pDrawable,
@@ -34,6 +34,9 @@ fbFillSpans(DrawablePtr pDrawable,
     int extentX1, extentX2, extentY1, extentY2;
     int fullX1, fullX2, fullY1;
     int partX1, partX2;
+    FbFillBandRec fill = { pDrawable, pGC };
+    FbBandsRec bands;
+    Bool threaded = fbBandsInitGC(&bands, pDrawable, pGC, fbFillBand, &fill);
 
     pextent = RegionExtents(pClip);
     extentX1 = pextent->x1;
@@ -61,7 +64,10 @@ fbFillSpans(DrawablePtr pDrawable,
 
         nbox = RegionNumRects(pClip);
         if (nbox == 1) {
-            fbFill(pDrawable, pGC, fullX1, fullY1, fullX2 - fullX1, 1);
+            if (threaded)
+                fbBandsAdd(&bands, fullX1, fullY1, fullX2, fullY1 + 1);
+            else
+                fbFill(pDrawable, pGC, fullX1, fullY1, fullX2 - fullX1, 1);
         }
         else {
             pbox = RegionRects(pClip);
@@ -73,7 +79,10 @@ fbFillSpans(DrawablePtr pDrawable,
                     partX2 = pbox->x2;
                     if (partX2 > fullX2)
                         partX2 = fullX2;
-                    if (partX2 > partX1) {
+                    if (partX2 > partX1 && threaded) {
+                        fbBandsAdd(&bands, partX1, fullY1, partX2, fullY1 + 1);
+                    }
+                    else if (partX2 > partX1) {
                         fbFill(pDrawable, pGC,
                                partX1, fullY1, partX2 - partX1, 1);
                     }
@@ -82,4 +91,6 @@ fbFillSpans(DrawablePtr pDrawable,
             }
         }
     }
+    if (threaded)
+        fbBandsRun(&bands);
 }
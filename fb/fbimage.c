@@ -72,6 +72,34 @@ fbPutImage(DrawablePtr pDrawable,
     }
 }
 
+typedef struct {
+    FbStip *dst;
+    FbStride dstStride;
+    int dstBpp;
+    int dstXoff, dstYoff;
+    FbStip *src;
+    FbStride srcStride;
+    int x, y;
+    int alu;
+    FbBits pm;
+} FbPutZImageRec;
+
+static void
+fbPutZImageBox(void *closure, const BoxRec *pBox)
+{
+    FbPutZImageRec *put = closure;
+    int dstBpp = put->dstBpp;
+
+    fbBltStip(put->src + (pBox->y1 - put->y) * put->srcStride,
+              put->srcStride,
+              (pBox->x1 - put->x) * dstBpp,
+              put->dst + (pBox->y1 + put->dstYoff) * put->dstStride,
+              put->dstStride,
+              (pBox->x1 + put->dstXoff) * dstBpp,
+              (pBox->x2 - pBox->x1) * dstBpp, (pBox->y2 - pBox->y1),
+              put->alu, put->pm, dstBpp);
+}
+
 void
 fbPutZImage(DrawablePtr pDrawable,
             RegionPtr pClip,
@@ -87,9 +115,20 @@ fbPutZImage(DrawablePtr pDrawable,
     int nbox;
     BoxPtr pbox;
     int x1, y1, x2, y2;
+    FbPutZImageRec put;
+    FbBandsRec bands;
+    Bool threaded;
 
     fbGetStipDrawable(pDrawable, dst, dstStride, dstBpp, dstXoff, dstYoff);
 
+    put = (FbPutZImageRec) {
+        .dst = dst, .dstStride = dstStride, .dstBpp = dstBpp,
+        .dstXoff = dstXoff, .dstYoff = dstYoff,
+        .src = src, .srcStride = srcStride, .x = x, .y = y,
+        .alu = alu, .pm = pm,
+    };
+    threaded = fbBandsInit(&bands, pDrawable->pScreen, fbPutZImageBox, &put);
+
     for (nbox = RegionNumRects(pClip),
          pbox = RegionRects(pClip); nbox--; pbox++) {
         x1 = x;
@@ -106,14 +145,17 @@ fbPutZImage(DrawablePtr pDrawable,
             y2 = pbox->y2;
         if (x1 >= x2 || y1 >= y2)
             continue;
-        fbBltStip(src + (y1 - y) * srcStride,
-                  srcStride,
-                  (x1 - x) * dstBpp,
-                  dst + (y1 + dstYoff) * dstStride,
-                  dstStride,
-                  (x1 + dstXoff) * dstBpp,
-                  (x2 - x1) * dstBpp, (y2 - y1), alu, pm, dstBpp);
+        if (threaded) {
+            fbBandsAdd(&bands, x1, y1, x2, y2);
+        }
+        else {
+            BoxRec box = { x1, y1, x2, y2 };
+
+            fbPutZImageBox(&put, &box);
+        }
     }
+    if (threaded)
+        fbBandsRun(&bands);
 
     fbFinishAccess(pDrawable);
 }
@@ -27,6 +27,7 @@
 
 #include <string.h>
 
+#include "fb/fb_priv.h"
 #include "fb/fbpict_priv.h"
 
 #include "fb.h"
@@ -34,6 +35,39 @@
 #include "picturestr.h"
 #include "mipict.h"
 
+typedef struct {
+    pixman_op_t op;
+    pixman_image_t *src, *mask, *dest;
+    int xSrc, ySrc, xMask, yMask, xDst, yDst;
+} FbCompositeRec;
+
+static void
+fbCompositeBox(void *closure, const BoxRec *pBox)
+{
+    FbCompositeRec *c = closure;
+    int dx = pBox->x1 - c->xDst, dy = pBox->y1 - c->yDst;
+
+    pixman_image_composite32(c->op, c->src, c->mask, c->dest,
+                             c->xSrc + dx, c->ySrc + dy,
+                             c->xMask + dx, c->yMask + dy,
+                             pBox->x1, pBox->y1,
+                             pBox->x2 - pBox->x1, pBox->y2 - pBox->y1);
+}
+
+/* a picture reading from the pixmap pDst draws to */
+static Bool
+fbCompositeReadsDst(PicturePtr pPict, PicturePtr pDst)
+{
+    PixmapPtr pPixmap, pDstPixmap;
+    _X_UNUSED int xoff, yoff;
+
+    if (!pPict || !pPict->pDrawable)
+        return FALSE;
+    fbGetDrawablePixmap(pPict->pDrawable, pPixmap, xoff, yoff);
+    fbGetDrawablePixmap(pDst->pDrawable, pDstPixmap, xoff, yoff);
+    return pPixmap == pDstPixmap;
+}
+
 void
 fbComposite(CARD8 op,
             PicturePtr pSrc,
@@ -43,25 +77,62 @@ fbComposite(CARD8 op,
             INT16 ySrc,
             INT16 xMask,
             INT16 yMask, INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
+{
+    miCompositeSourceValidate(pSrc);
+    if (pMask)
+        miCompositeSourceValidate(pMask);
+
+    fbCompositeValidated(op, pSrc, pMask, pDst, xSrc, ySrc, xMask, yMask,
+                         xDst, yDst, width, height);
+}
+
+void
+fbCompositeValidated(CARD8 op,
+                     PicturePtr pSrc,
+                     PicturePtr pMask,
+                     PicturePtr pDst,
+                     INT16 xSrc,
+                     INT16 ySrc,
+                     INT16 xMask,
+                     INT16 yMask,
+                     INT16 xDst, INT16 yDst, CARD16 width, CARD16 height)
 {
     pixman_image_t *src, *mask, *dest;
     int src_xoff, src_yoff;
     int msk_xoff, msk_yoff;
     int dst_xoff, dst_yoff;
 
-    miCompositeSourceValidate(pSrc);
-    if (pMask)
-        miCompositeSourceValidate(pMask);
-
     src = image_from_pict(pSrc, FALSE, &src_xoff, &src_yoff);
     mask = image_from_pict(pMask, FALSE, &msk_xoff, &msk_yoff);
     dest = image_from_pict(pDst, TRUE, &dst_xoff, &dst_yoff);
 
     if (src && dest && !(pMask && !mask)) {
-        pixman_image_composite(op, src, mask, dest,
-                               xSrc + src_xoff, ySrc + src_yoff,
-                               xMask + msk_xoff, yMask + msk_yoff,
-                               xDst + dst_xoff, yDst + dst_yoff, width, height);
+        FbCompositeRec c = {
+            .op = op, .src = src, .mask = mask, .dest = dest,
+            .xSrc = xSrc + src_xoff, .ySrc = ySrc + src_yoff,
+            .xMask = xMask + msk_xoff, .yMask = yMask + msk_yoff,
+            .xDst = xDst + dst_xoff, .yDst = yDst + dst_yoff,
+        };
+        FbBandsRec bands;
+
+        if (!fbCompositeReadsDst(pSrc, pDst) &&
+            !fbCompositeReadsDst(pMask, pDst) &&
+            fbBandsInit(&bands, pDst->pDrawable->pScreen,
+                        fbCompositeBox, &c)) {
+            /*
+             * pixman sets up images on first use; do that here, so the
+             * workers only read them
+             */
+            pixman_image_composite32(c.op, src, mask, dest,
+                                     0, 0, 0, 0, 0, 0, 0, 0);
+            fbBandsAdd(&bands, c.xDst, c.yDst, c.xDst + width, c.yDst + height);
+            fbBandsRun(&bands);
+        }
+        else {
+            pixman_image_composite(op, src, mask, dest,
+                                   c.xSrc, c.ySrc, c.xMask, c.yMask,
+                                   c.xDst, c.yDst, width, height);
+        }
     }
 
     free_pixman_pict(pSrc, src);
@@ -20,6 +20,16 @@ void fbTrapezoids(CARD8 op, PicturePtr pSrc, PicturePtr pDst,
                   PictFormatPtr maskFormat, INT16 xSrc, INT16 ySrc,
                   int ntrap, xTrapezoid *traps);
 
+/*
+ * fbComposite() for sources the screen's SourceValidate has been called
+ * on already.  It doesn't call into the rest of the server, so it can
+ * run on worker threads, as long as no other thread uses the pictures.
+ */
+void fbCompositeValidated(CARD8 op, PicturePtr pSrc, PicturePtr pMask,
+                          PicturePtr pDst, INT16 xSrc, INT16 ySrc,
+                          INT16 xMask, INT16 yMask, INT16 xDst, INT16 yDst,
+                          CARD16 width, CARD16 height);
+
 _X_EXPORT /* only for glamor module, not supposed to be used by external drivers */
 void fbTriangles(CARD8 op, PicturePtr pSrc, PicturePtr pDst,
                  PictFormatPtr maskFormat, INT16 xSrc, INT16 ySrc,
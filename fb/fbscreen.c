@@ -137,6 +137,12 @@ fbSetupScreen(ScreenPtr pScreen, void *pbits, /* pointer to screen bitmap */
     pScreen->GetWindowPixmap = _fbGetWindowPixmap;
     pScreen->SetWindowPixmap = _fbSetWindowPixmap;
 
+#ifdef FB_BLT_SIMD
+    if (!fbBltFuncs && fbInitBltSimd(TRUE))
+        LogMessageVerb(X_INFO, 3, "fb: using %s blit kernels\n",
+                       fbBltFuncs->name);
+#endif
+
     return TRUE;
 }
 
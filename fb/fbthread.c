@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Threaded fb rendering
+ *
+ * fb draws everything on the dispatch thread, so a big fill, image or
+ * composite into a software rendered screen keeps one CPU busy while all
+ * others idle.  On screens whose DDX opts in with fbSetThreaded(), those
+ * operations collect the boxes they draw instead, and have the server's
+ * worker threads draw them in bands of FB_BAND_HEIGHT scanlines.
+ *
+ * Each band draws the parts of all boxes within it, in the order they
+ * were added, so overlapping boxes end up the way a single thread draws
+ * them, whatever the raster op.  Bands start at multiples of
+ * FB_BAND_HEIGHT, and everything split up this way is drawn row by row
+ * anyway, so the result is the same with any number of threads, or none.
+ * Operations reading from the pixmap they draw to can't be split up; the
+ * callers check for that.
+ */
+
+#include <dix-config.h>
+
+#include <string.h>
+
+#include "os/threadpool_priv.h"
+
+#include "fb/fb_priv.h"
+
+void
+fbSetThreaded(ScreenPtr pScreen, Bool threaded)
+{
+    fbGetScreenPrivate(pScreen)->threaded =
+        threaded && ThreadPoolDefaultThreads() > 1;
+}
+
+Bool
+fbBandsInit(FbBandsPtr bands, ScreenPtr pScreen,
+            FbBandProc draw, void *closure)
+{
+#ifdef FB_ACCESS_WRAPPER
+    /* wfbReadMemory and wfbWriteMemory are set up for one thread only */
+    return FALSE;
+#else
+    if (!fbGetScreenPrivate(pScreen)->threaded)
+        return FALSE;
+
+    memset(bands, 0, sizeof(*bands));
+    bands->pScreen = pScreen;
+    bands->draw = draw;
+    bands->closure = closure;
+    return TRUE;
+#endif
+}
+
+/* fills with the pixmap they draw to as tile or stipple stay in one piece */
+Bool
+fbBandsInitGC(FbBandsPtr bands, DrawablePtr pDrawable, GCPtr pGC,
+              FbBandProc draw, void *closure)
+{
+    PixmapPtr pPixmap;
+    _X_UNUSED int xoff, yoff;
+
+    fbGetDrawablePixmap(pDrawable, pPixmap, xoff, yoff);
+    switch (pGC->fillStyle) {
+    case FillTiled:
+        if (pGC->tile.pixmap == pPixmap)
+            return FALSE;
+        break;
+    case FillStippled:
+    case FillOpaqueStippled:
+        if (pGC->stipple == pPixmap)
+            return FALSE;
+        break;
+    }
+    return fbBandsInit(bands, pDrawable->pScreen, draw, closure);
+}
+
+static void
+fbBandsTask(void *data, int band)
+{
+    FbBandsPtr bands = data;
+    int y1 = bands->y1 + band * FB_BAND_HEIGHT;
+    int y2 = y1 + FB_BAND_HEIGHT;
+
+    for (int i = 0; i < bands->nbox; i++) {
+        BoxRec box = bands->boxes[i];
+
+        if (box.y1 >= y2 || box.y2 <= y1)
+            continue;
+        box.y1 = max(box.y1, y1);
+        box.y2 = min(box.y2, y2);
+        (*bands->draw) (bands->closure, &box);
+    }
+}
+
+static void
+fbBandsFlush(FbBandsPtr bands)
+{
+    ThreadPoolPtr pool = NULL;
+
+    if (!bands->nbox)
+        return;
+
+    if (bands->area >= THREADPOOL_MIN_AREA) {
+        pool = ThreadPoolServer();
+        /* no workers, don't bother collecting boxes anymore */
+        if (!pool)
+            fbGetScreenPrivate(bands->pScreen)->threaded = FALSE;
+    }
+
+    if (pool) {
+        /* rounded down, for negative coordinates too */
+        int y1 = bands->y1 - ((bands->y1 % FB_BAND_HEIGHT) +
+                              FB_BAND_HEIGHT) % FB_BAND_HEIGHT;
+
+        bands->y1 = y1;
+        ThreadPoolRun(pool, fbBandsTask, bands,
+                      (bands->y2 - y1 + FB_BAND_HEIGHT - 1) / FB_BAND_HEIGHT);
+    }
+    else {
+        for (int i = 0; i < bands->nbox; i++)
+            (*bands->draw) (bands->closure, &bands->boxes[i]);
+    }
+    bands->nbox = 0;
+    bands->area = 0;
+}
+
+void
+fbBandsAdd(FbBandsPtr bands, int x1, int y1, int x2, int y2)
+{
+    BoxPtr pBox;
+
+    if (bands->nbox == bands->size) {
+        int size = bands->size ? bands->size * 2 : 32;
+        BoxPtr boxes = reallocarray(bands->boxes, size, sizeof(BoxRec));
+
+        if (boxes) {
+            bands->boxes = boxes;
+            bands->size = size;
+        }
+        else {
+            /* out of memory: draw what's there, then go on with less */
+            fbBandsFlush(bands);
+            if (!bands->size) {
+                BoxRec box = { x1, y1, x2, y2 };
+
+                (*bands->draw) (bands->closure, &box);
+                return;
+            }
+        }
+    }
+
+    if (!bands->nbox) {
+        bands->y1 = y1;
+        bands->y2 = y2;
+    }
+    else {
+        bands->y1 = min(bands->y1, y1);
+        bands->y2 = max(bands->y2, y2);
+    }
+    pBox = &bands->boxes[bands->nbox++];
+    pBox->x1 = x1;
+    pBox->y1 = y1;
+    pBox->x2 = x2;
+    pBox->y2 = y2;
+    bands->area += (unsigned long) (x2 - x1) * (y2 - y1);
+}
+
+void
+fbBandsRun(FbBandsPtr bands)
+{
+    fbBandsFlush(bands);
+    free(bands->boxes);
+    bands->boxes = NULL;
+    bands->size = 0;
+}
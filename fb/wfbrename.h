@@ -7,6 +7,10 @@
 #define fbArc16 wfbArc16
 #define fbArc32 wfbArc32
 #define fbArc8 wfbArc8
+#define fbBandsAdd wfbBandsAdd
+#define fbBandsInit wfbBandsInit
+#define fbBandsInitGC wfbBandsInitGC
+#define fbBandsRun wfbBandsRun
 #define fbBlt wfbBlt
 #define fbBltOne wfbBltOne
 #define fbBltPlane wfbBltPlane
@@ -26,6 +30,7 @@
 #define fbClearVisualTypes wfbClearVisualTypes
 #define fbCloseScreen wfbCloseScreen
 #define fbComposite wfbComposite
+#define fbCompositeValidated wfbCompositeValidated
 #define fbCopy1toN wfbCopy1toN
 #define fbCopyArea wfbCopyArea
 #define fbCopyNto1 wfbCopyNto1
@@ -49,6 +54,7 @@
 #define fbEvenTile wfbEvenTile
 #define fbExpandDirectColors wfbExpandDirectColors
 #define fbFill wfbFill
+#define fbFillBand wfbFillBand
 #define fbFillRegionSolid wfbFillRegionSolid
 #define fbFillSpans wfbFillSpans
 #define fbFixCoordModePrevious wfbFixCoordModePrevious
@@ -105,6 +111,7 @@
 #define fbSegment wfbSegment
 #define fbSelectBres wfbSelectBres
 #define fbSetSpans wfbSetSpans
+#define fbSetThreaded wfbSetThreaded
 #define fbSetupScreen wfbSetupScreen
 #define fbSetVisualTypes wfbSetVisualTypes
 #define fbSetVisualTypesAndMasks wfbSetVisualTypesAndMasks
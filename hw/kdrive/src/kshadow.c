@@ -65,8 +65,11 @@ KdShadowSet(ScreenPtr pScreen, int randr, ShadowUpdateProc update,
 
     shadowRemove(pScreen, pScreen->GetScreenPixmap(pScreen));
     if (screen->fb.shadow) {
-        return shadowAdd(pScreen, pScreen->GetScreenPixmap(pScreen),
-                         update, window, randr, 0);
+        if (!shadowAdd(pScreen, pScreen->GetScreenPixmap(pScreen),
+                       update, window, randr, 0))
+            return FALSE;
+        /* all our window procs just compute addresses in the frame buffer */
+        shadowSetThreaded(pScreen, TRUE);
     }
     return TRUE;
 }
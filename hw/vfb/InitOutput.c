@@ -38,7 +38,9 @@ from The Open Group.
 
 #include "dix/colormap_priv.h"
 #include "dix/dix_priv.h"
+#include "dix/screen_hooks_priv.h"
 #include "dix/screenint_priv.h"
+#include "fb/fb_priv.h"
 #include "include/extinit.h"
 #include "mi/mi_priv.h"
 #include "mi/mipointer_priv.h"
@@ -49,6 +51,7 @@ from The Open Group.
 
 #include "scrnintstr.h"
 #include "servermd.h"
+#include "compositeext.h"
 #define PSZ 8
 #include "fb.h"
 #include "gcstruct.h"
@@ -144,6 +147,7 @@ typedef enum { NORMAL_MEMORY_FB, SHARED_MEMORY_FB, MMAPPED_FILE_FB } fbMemType;
 static fbMemType fbmemtype = NORMAL_MEMORY_FB;
 static char needswap = 0;
 static Bool Render = TRUE;
+static Bool vfbThreaded = FALSE;
 
 #define swapcopy16(_dst, _src) \
     if (needswap) { CARD16 _s = _src; cpswaps(_s, _dst); } \
@@ -302,6 +306,9 @@ ddxUseMsg(void)
 
     ErrorF("-crtcs n               number of CRTCs per screen (default: %d)\n",
            VFB_DEFAULT_NUM_CRTCS);
+    ErrorF("-threaded              split up large drawing operations and\n"
+           "                       compositing across the -workerthreads\n"
+           "                       (default off)\n");
 }
 
 int
@@ -438,6 +445,11 @@ ddxProcessArgument(int argc, char *argv[], int i)
         return 2;
     }
 
+    if (strcmp(argv[i], "-threaded") == 0) {    /* -threaded */
+        vfbThreaded = TRUE;
+        return 1;
+    }
+
     return 0;
 }
 
@@ -776,6 +788,14 @@ static miPointerScreenFuncRec vfbPointerCursorFuncs = {
     miPointerWarpCursor
 };
 
+/* once the extensions are set up */
+static void
+vfbCreateScreenResources(CallbackListPtr *pcbl, ScreenPtr pScreen, Bool *ret)
+{
+    CompositeSetThreaded(pScreen, vfbThreaded);
+    CompositeSetPixmapPool(pScreen, 64 * 1024 * 1024);
+}
+
 static Bool
 vfbCloseScreen(ScreenPtr pScreen)
 {
@@ -1025,6 +1045,14 @@ vfbScreenInit(ScreenPtr pScreen, int argc, char **argv)
     if (!vfbRandRInit(pScreen))
        return FALSE;
 
+    /*
+     * all pixmaps are in memory: with -threaded, large drawing operations
+     * and updating redirected windows can be split up.  Backing pixmaps of
+     * the latter are shrunk in place for reuse either way.
+     */
+    fbSetThreaded(pScreen, vfbThreaded);
+    dixScreenHookPostCreateResources(pScreen, vfbCreateScreenResources);
+
     pScreen->InstallColormap = vfbInstallColormap;
     pScreen->StoreColors = vfbStoreColors;
 
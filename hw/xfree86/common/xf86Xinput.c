@@ -1338,6 +1338,34 @@ xf86PostMotionEventM(DeviceIntPtr device,
     QueuePointerEvents(device, MotionNotify, 0, flags, mask);
 }
 
+/**
+ * Post the motion of a whole burst of events read from the device at once,
+ * like calling xf86PostMotionEventM() for each of them, only cheaper.
+ */
+void
+xf86PostMotionEventsM(DeviceIntPtr device,
+                      int is_absolute, const ValuatorMask *masks, int nmasks)
+{
+    int flags = is_absolute ? POINTER_ABSOLUTE :
+        POINTER_RELATIVE | POINTER_ACCELERATE;
+
+#ifdef XFreeXDGA
+    /*
+     * DGA only takes events while in a DGA mode.  It has to see each one
+     * after the ones before it are queued, so then they go one by one.
+     */
+    for (int i = 0; i < screenInfo.numScreens; i++) {
+        if (DGAActive(i)) {
+            for (int j = 0; j < nmasks; j++)
+                xf86PostMotionEventM(device, is_absolute, &masks[j]);
+            return;
+        }
+    }
+#endif
+
+    QueuePointerMotionEvents(device, flags, masks, nmasks);
+}
+
 void
 xf86PostProximityEvent(DeviceIntPtr device,
                        int is_in, int first_valuator, int num_valuators, ...)
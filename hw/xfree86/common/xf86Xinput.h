@@ -120,6 +120,10 @@ extern _X_EXPORT void xf86PostMotionEvent(DeviceIntPtr device, int is_absolute,
                                           ...);
 extern _X_EXPORT void xf86PostMotionEventM(DeviceIntPtr device, int is_absolute,
                                            const ValuatorMask *mask);
+extern _X_EXPORT void xf86PostMotionEventsM(DeviceIntPtr device,
+                                            int is_absolute,
+                                            const ValuatorMask *masks,
+                                            int nmasks);
 extern _X_EXPORT void xf86PostProximityEvent(DeviceIntPtr device, int is_in,
                                              int first_valuator,
                                              int num_valuators, ...);
@@ -437,6 +437,11 @@ extern _X_EXPORT void QueuePointerEvents(DeviceIntPtr pDev,
                                          int buttons,
                                          int flags, const ValuatorMask *mask);
 
+extern _X_EXPORT void QueuePointerMotionEvents(DeviceIntPtr pDev,
+                                               int flags,
+                                               const ValuatorMask *masks,
+                                               int nmasks);
+
 extern _X_EXPORT int GetKeyboardEvents(InternalEvent *events,
                                        DeviceIntPtr pDev,
                                        int type,
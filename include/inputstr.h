@@ -599,6 +599,12 @@ typedef struct _DeviceIntRec {
     struct _SyncCounter *idle_counter;
 
     Bool ignoreXkbActionsBehaviors; /* TRUE if keys don't trigger behaviors and actions */
+
+    /* precomputed from the matrices above whenever they change, so events
+     * don't have to. See DeviceSetTransform */
+    struct pixman_f_transform scale_and_transform_inverse;
+    Bool relative_transform_identity;
+    Bool scale_and_transform_identity;
 } DeviceIntRec;
 
 typedef struct {
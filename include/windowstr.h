@@ -162,6 +162,9 @@ typedef struct _Window {
     unsigned unhittable:1;      /* doesn't hit-test, for rootless */
     unsigned damagedDescendants:1;      /* some descendants are damaged */
     unsigned inhibitBGPaint:1;  /* paint the background? */
+    unsigned clipDirty:1;       /* winSize/borderSize changed since the
+                                   last ValidateTree */
+    unsigned dirtyDescendants:1;        /* some descendants are clipDirty */
 
     PropertyPtr properties;     /* default: NULL */
 } WindowRec;
@@ -44,6 +44,7 @@ void mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr sc
 void mieqProcessInputEvents(void);
 void mieqAddCallbackOnDrained(CallbackProcPtr callback, void *param);
 void mieqRemoveCallbackOnDrained(CallbackProcPtr callback, void *param);
+size_t mieqDroppedEvents(void);
 
 /**
  * Custom input event handler. If you need to process input events in some
@@ -70,6 +71,53 @@ int miShapedWindowIn(RegionPtr universe, RegionPtr bounding, BoxPtr rect,
                      int x, int y);
 int miValidateTree(WindowPtr pParent, WindowPtr pChild, VTKind kind);
 
+/* how miValidateTree() deals with subtrees whose clips can't change */
+enum {
+    MI_VALIDATE_FULL,           /* recompute them anyway */
+    MI_VALIDATE_INCREMENTAL,    /* skip them */
+    MI_VALIDATE_CHECK,          /* recompute them and compare, for testing */
+};
+
+extern int miValidateMode;      /* -validatetree */
+
+typedef struct {
+    unsigned long computed;     /* windows whose clips were computed */
+    unsigned long skipped;      /* subtrees found unchanged */
+    unsigned long mismatches;   /* of those, ones that did change (check) */
+} miValidateStatsRec;
+
+extern miValidateStatsRec miValidateStats;
+
+/*
+ * Spans of wide arcs and round line ends, cached by kind, line width and
+ * size across all screens and GCs.  miSpanCacheFind() and
+ * miSpanCacheAlloc() return data referenced by the caller, which drops it
+ * with miSpanCacheRelease(); miSpanCacheAdd() puts freshly computed data
+ * into the cache.
+ */
+enum {
+    MI_SPAN_CACHE_ARC,          /* miArcSpanData of a wide ellipse */
+    MI_SPAN_CACHE_LINE_ARC,     /* round cap or join of a wide line */
+};
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} miSpanCacheStatsRec;
+
+extern miSpanCacheStatsRec miSpanCacheStats;
+
+void *miSpanCacheFind(int kind, int lw, int width, int height);
+void *miSpanCacheAlloc(int kind, int lw, int width, int height, size_t size);
+void miSpanCacheAdd(void *data);
+void miSpanCacheRelease(void *data);
+void miSpanCacheFlush(void);
+
+/* in bytes, 0 disables the cache */
+#define MI_SPAN_CACHE_BYTES     (1024 * 1024)
+void miSpanCacheSetSize(size_t bytes);
+
 void miClearToBackground(WindowPtr pWin, int x, int y, int w, int h,
                          Bool generateExposures);
 void miMarkWindow(WindowPtr pWin);
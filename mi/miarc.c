@@ -744,15 +744,27 @@ tailX(double K,
     return xs[0];
 }
 
+/*
+ * The spans only depend on the size of the arc and the line width, so
+ * they come from the span cache; drop them with miSpanCacheRelease().
+ */
 static miArcSpanData *
 miComputeWideEllipse(int lw, xArc * parc)
 {
+    miArcSpanData *spdata;
     int k;
 
     if (!lw)
         lw = 1;
+    spdata = miSpanCacheFind(MI_SPAN_CACHE_ARC, lw,
+                             parc->width, parc->height);
+    if (spdata)
+        return spdata;
     k = (parc->height >> 1) + ((lw - 1) >> 1);
-    miArcSpanData *spdata = calloc(1, sizeof(miArcSpanData) + sizeof(miArcSpan) * (k + 2));
+    spdata = miSpanCacheAlloc(MI_SPAN_CACHE_ARC, lw,
+                              parc->width, parc->height,
+                              sizeof(miArcSpanData) +
+                              sizeof(miArcSpan) * (k + 2));
     if (!spdata)
         return NULL;
     spdata->spans = (miArcSpan *) (spdata + 1);
@@ -763,6 +775,7 @@ miComputeWideEllipse(int lw, xArc * parc)
         miComputeCircleSpans(lw, parc, spdata);
     else
         miComputeEllipseSpans(lw, parc, spdata);
+    miSpanCacheAdd(spdata);
     return spdata;
 }
 
@@ -866,7 +879,7 @@ miFillWideEllipse(DrawablePtr pDraw, GCPtr pGC, xArc * parc)
             wids += 2;
         }
     }
-    free(spdata);
+    miSpanCacheRelease(spdata);
     (*pGC->ops->FillSpans) (pDraw, pGC, pts - points, points, widths, FALSE);
 
     free(widths);
@@ -907,7 +920,8 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
         for (i = narcs, parc = parcs; --i >= 0; parc++) {
             miArcSpanData *spdata;
             spdata = miArcSegment(pDraw, pGC, *parc, NULL, NULL, NULL);
-            free(spdata);
+            if (spdata)
+                miSpanCacheRelease(spdata);
         }
         fillSpans(pDraw, pGC);
         return;
@@ -1039,7 +1053,7 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
             if (spdata) {
                 if (lastArc.width != arcData->arc.width ||
                     lastArc.height != arcData->arc.height) {
-                    free(spdata);
+                    miSpanCacheRelease(spdata);
                     spdata = NULL;
                 }
             }
@@ -1103,7 +1117,8 @@ miWideArc(DrawablePtr pDraw, GCPtr pGC, int narcs, xArc * parcs)
                 }
             }
         }
-        free(spdata);
+        if (spdata)
+            miSpanCacheRelease(spdata);
         spdata = NULL;
     }
     miFreeArcs(polyArcs, pGC);
@@ -48,6 +48,7 @@ in this Software without prior written authorization from The Open Group.
 #include   "mi/mi_priv.h"
 #include   "mi/mipointer_priv.h"
 #include   "os/bug_priv.h"
+#include   "os/client_priv.h"
 #include   "os/screensaver.h"
 
 #include   "misc.h"
@@ -65,14 +66,35 @@ in this Software without prior written authorization from The Open Group.
 
 /* Maximum size should be initial size multiplied by a power of 2 */
 #define QUEUE_INITIAL_SIZE                 512
-#define QUEUE_RESERVED_SIZE                 64
 #define QUEUE_MAXIMUM_SIZE                4096
-#define QUEUE_DROP_BACKTRACE_FREQUENCY     100
-#define QUEUE_DROP_BACKTRACE_MAX            10
 
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
 
+/*
+ * The queue is a single producer, single consumer ring.  Producers (the
+ * input thread, or DDX code on the main thread) are serialized by
+ * input_lock() as before; the consumer in mieqProcessInputEvents() no
+ * longer takes that lock for every event.  The producer publishes a slot
+ * by storing tail, the consumer releases one by storing head.
+ *
+ * Two operations need the consumer to stay away from a slot it may be
+ * copying: merging a motion event into the last queued slot and growing
+ * the ring.  Both take the gate, which the consumer holds just for the
+ * copy of one event.  Merging only tries the gate and falls back to
+ * appending, so the producer never waits on the main thread.  Growing
+ * allocates the new ring first and takes the gate only to move the slots
+ * over; it happens a bounded number of times, as the ring only doubles up
+ * to QUEUE_MAXIMUM_SIZE.  Overflows beyond that are counted for
+ * mieqDroppedEvents(), and the main thread notes them in the log at most
+ * every DROPPED_REPORT_MS.
+ */
+#define DROPPED_REPORT_MS       60000
+
+#define GATE_OPEN       0
+#define GATE_CONSUMER   1
+#define GATE_PRODUCER   2
+
 typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
@@ -81,11 +103,13 @@ typedef struct _Event {
 
 typedef struct _EventQueue {
     HWEventQueueType head, tail;        /* long for SetInputCheck */
+    int gate;                   /* GATE_*, only accessed atomically */
     CARD32 lastEventTime;       /* to avoid time running backwards */
     int lastMotion;             /* device ID if last event motion? */
     EventRec *events;           /* our queue as an array */
     size_t nevents;             /* the number of buckets in our queue */
-    size_t dropped;             /* counter for number of consecutive dropped events */
+    size_t dropped;             /* dropped since the consumer last looked */
+    size_t totalDropped;        /* dropped since server start */
     mieqHandler handlers[128];  /* custom event handler */
 } EventQueueRec, *EventQueuePtr;
 
@@ -93,26 +117,55 @@ static EventQueueRec miEventQueue;
 
 static CallbackListPtr miCallbacksWhenDrained = NULL;
 
+static inline Bool
+mieqTryGate(EventQueuePtr eventQueue, int owner)
+{
+    int open = GATE_OPEN;
+
+    return __atomic_compare_exchange_n(&eventQueue->gate, &open, owner, FALSE,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void
+mieqEnterGate(EventQueuePtr eventQueue, int owner)
+{
+    while (!mieqTryGate(eventQueue, owner))
+        ;
+}
+
+static inline void
+mieqLeaveGate(EventQueuePtr eventQueue)
+{
+    __atomic_store_n(&eventQueue->gate, GATE_OPEN, __ATOMIC_RELEASE);
+}
+
 static size_t
 mieqNumEnqueued(EventQueuePtr eventQueue)
 {
     size_t n_enqueued = 0;
 
     if (eventQueue->nevents) {
+        HWEventQueueType head = __atomic_load_n(&eventQueue->head,
+                                                __ATOMIC_ACQUIRE);
+
         /* % is not well-defined with negative numbers... sigh */
-        n_enqueued = eventQueue->tail - eventQueue->head + eventQueue->nevents;
+        n_enqueued = eventQueue->tail - head + eventQueue->nevents;
         if (n_enqueued >= eventQueue->nevents)
             n_enqueued -= eventQueue->nevents;
     }
     return n_enqueued;
 }
 
-/* Pre-condition: Called with input_lock held */
+/*
+ * Pre-condition: Called with input_lock held, by the producer.  The new
+ * ring is allocated before taking the gate, so the consumer only waits for
+ * the slots to be moved over.
+ */
 static Bool
 mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
 {
     size_t i, n_enqueued, first_hunk;
-    EventRec *new_events;
+    EventRec *new_events, *old_events;
 
     if (!eventQueue) {
         ErrorF("[mi] mieqGrowQueue called with a NULL eventQueue\n");
@@ -123,22 +176,8 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
         return FALSE;
 
     new_events = calloc(new_nevents, sizeof(EventRec));
-    if (new_events == NULL) {
-        ErrorF("[mi] mieqGrowQueue memory allocation error.\n");
+    if (new_events == NULL)
         return FALSE;
-    }
-
-    n_enqueued = mieqNumEnqueued(eventQueue);
-
-    /* First copy the existing events */
-    first_hunk = eventQueue->nevents - eventQueue->head;
-    if (eventQueue->events) {
-        memcpy(new_events,
-               &eventQueue->events[eventQueue->head],
-               first_hunk * sizeof(EventRec));
-        memcpy(&new_events[first_hunk],
-               eventQueue->events, eventQueue->head * sizeof(EventRec));
-    }
 
     /* Initialize the new portion */
     for (i = eventQueue->nevents; i < new_nevents; i++) {
@@ -147,7 +186,7 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
         if (!evlist) {
             size_t j;
 
-            for (j = 0; j < i; j++)
+            for (j = eventQueue->nevents; j < i; j++)
                 FreeEventList(new_events[j].events, 1);
             free(new_events);
             return FALSE;
@@ -155,13 +194,30 @@ mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
         new_events[i].events = evlist;
     }
 
+    mieqEnterGate(eventQueue, GATE_PRODUCER);
+
+    n_enqueued = mieqNumEnqueued(eventQueue);
+
+    /* Then move the existing slots over, oldest first */
+    first_hunk = eventQueue->nevents - eventQueue->head;
+    if (eventQueue->events) {
+        memcpy(new_events,
+               &eventQueue->events[eventQueue->head],
+               first_hunk * sizeof(EventRec));
+        memcpy(&new_events[first_hunk],
+               eventQueue->events, eventQueue->head * sizeof(EventRec));
+    }
+
     /* And update our record */
     eventQueue->tail = n_enqueued;
     eventQueue->head = 0;
     eventQueue->nevents = new_nevents;
-    free(eventQueue->events);
+    old_events = eventQueue->events;
     eventQueue->events = new_events;
 
+    mieqLeaveGate(eventQueue);
+
+    free(old_events);
     return TRUE;
 }
 
@@ -194,6 +250,37 @@ mieqFini(void)
     free(miEventQueue.events);
 }
 
+/**
+ * Number of events discarded because the queue was full, since server
+ * start.  Safe to call from any thread.
+ */
+size_t
+mieqDroppedEvents(void)
+{
+    return __atomic_load_n(&miEventQueue.totalDropped, __ATOMIC_RELAXED);
+}
+
+/* Pre-condition: called with input_lock held, by the producer only */
+static void
+mieqStoreEvent(EventRec *slot, DeviceIntPtr pDev, InternalEvent *e)
+{
+    InternalEvent *evt = slot->events;
+    Time time;
+
+    memcpy(evt, e, e->any.length);
+
+    time = e->any.time;
+    /* Make sure that event times don't go backwards - this
+     * is "unnecessary", but very useful. */
+    if (time < miEventQueue.lastEventTime &&
+        miEventQueue.lastEventTime - time < 10000)
+        e->any.time = miEventQueue.lastEventTime;
+
+    miEventQueue.lastEventTime = evt->any.time;
+    slot->pScreen = pDev ? EnqueueScreen(pDev) : NULL;
+    slot->pDev = pDev;
+}
+
 /*
  * Must be reentrant with ProcessInputEvents.  Assumption: mieqEnqueue
  * will never be interrupted. Must be called with input_lock held
@@ -202,73 +289,81 @@ mieqFini(void)
 void
 mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
 {
-    unsigned int oldtail = miEventQueue.tail;
-    InternalEvent *evt;
+    HWEventQueueType tail = miEventQueue.tail;
     int isMotion = 0;
-    int evlen;
-    Time time;
-    size_t n_enqueued;
 
     verify_internal_event(e);
 
-    n_enqueued = mieqNumEnqueued(&miEventQueue);
-
     /* avoid merging events from different devices */
     if (e->any.type == ET_Motion)
         isMotion = pDev->id;
 
+    /* Overwrite the last queued motion event, unless the consumer is
+     * busy copying an event right now, or has already taken it. */
     if (isMotion && isMotion == miEventQueue.lastMotion &&
-        oldtail != miEventQueue.head) {
-        oldtail = (oldtail - 1) % miEventQueue.nevents;
+        mieqTryGate(&miEventQueue, GATE_PRODUCER)) {
+        if (tail != miEventQueue.head) {
+            HWEventQueueType last = (tail - 1 + miEventQueue.nevents) %
+                miEventQueue.nevents;
+
+            mieqStoreEvent(&miEventQueue.events[last], pDev, e);
+            mieqLeaveGate(&miEventQueue);
+            return;
+        }
+        mieqLeaveGate(&miEventQueue);
     }
-    else if (n_enqueued + 1 == miEventQueue.nevents) {
-        if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
-            /* Toss events which come in late.  Usually this means your server's
-             * stuck in an infinite loop in the main thread.
+
+    if (mieqNumEnqueued(&miEventQueue) + 1 == miEventQueue.nevents) {
+        Bool grown = FALSE;
+
+        if (miEventQueue.nevents < QUEUE_MAXIMUM_SIZE)
+            grown = mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1);
+        if (!grown) {
+            /* Toss events which come in late.  Usually this means your
+             * server's stuck in an infinite loop in the main thread.  The
+             * consumer reports the count once it catches up again.
              */
-            miEventQueue.dropped++;
-            if (miEventQueue.dropped == 1) {
-                ErrorF("[mi] EQ overflowing.  Additional events will be "
-                       "discarded until existing events are processed.\n");
-                xorg_backtrace();
-                ErrorF("[mi] These backtraces from mieqEnqueue may point to "
-                       "a culprit higher up the stack.\n");
-                ErrorF("[mi] mieq is *NOT* the cause.  It is a victim.\n");
-            }
-            else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
-                     miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
-                     QUEUE_DROP_BACKTRACE_MAX) {
-                ErrorF("[mi] EQ overflow continuing. %lu events have been "
-                       "dropped.\n", (unsigned long)miEventQueue.dropped);
-                if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
-                    QUEUE_DROP_BACKTRACE_MAX) {
-                    ErrorF("[mi] No further overflow reports will be "
-                           "reported until the clog is cleared.\n");
-                }
-                xorg_backtrace();
-            }
+            __atomic_add_fetch(&miEventQueue.dropped, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&miEventQueue.totalDropped, 1, __ATOMIC_RELAXED);
             return;
         }
-        oldtail = miEventQueue.tail;
+        tail = miEventQueue.tail;
     }
 
-    evlen = e->any.length;
-    evt = miEventQueue.events[oldtail].events;
-    memcpy(evt, e, evlen);
+    mieqStoreEvent(&miEventQueue.events[tail], pDev, e);
 
-    time = e->any.time;
-    /* Make sure that event times don't go backwards - this
-     * is "unnecessary", but very useful. */
-    if (time < miEventQueue.lastEventTime &&
-        miEventQueue.lastEventTime - time < 10000)
-        e->any.time = miEventQueue.lastEventTime;
+    miEventQueue.lastMotion = isMotion;
+    __atomic_store_n(&miEventQueue.tail, (tail + 1) % miEventQueue.nevents,
+                     __ATOMIC_RELEASE);
+}
 
-    miEventQueue.lastEventTime = evt->any.time;
-    miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
-    miEventQueue.events[oldtail].pDev = pDev;
+/*
+ * Copy the oldest queued event into the caller's storage.  Called by the
+ * consumer only, without input_lock.
+ */
+static Bool
+mieqDequeue(InternalEvent *event, DeviceIntPtr *dev, ScreenPtr *screen)
+{
+    EventRec *e;
+    HWEventQueueType head;
 
-    miEventQueue.lastMotion = isMotion;
-    miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    mieqEnterGate(&miEventQueue, GATE_CONSUMER);
+
+    head = miEventQueue.head;
+    if (head == __atomic_load_n(&miEventQueue.tail, __ATOMIC_ACQUIRE)) {
+        mieqLeaveGate(&miEventQueue);
+        return FALSE;
+    }
+
+    e = &miEventQueue.events[head];
+    memcpy(event, e->events, e->events->any.length);
+    *dev = e->pDev;
+    *screen = e->pScreen;
+
+    __atomic_store_n(&miEventQueue.head, (head + 1) % miEventQueue.nevents,
+                     __ATOMIC_RELEASE);
+    mieqLeaveGate(&miEventQueue);
+    return TRUE;
 }
 
 /**
@@ -520,13 +615,13 @@ mieqProcessDeviceEvent(DeviceIntPtr dev, InternalEvent *event, ScreenPtr screen)
 void
 mieqProcessInputEvents(void)
 {
-    EventRec *e = NULL;
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
+    size_t dropped;
     static Bool inProcessInputEvents = FALSE;
-
-    input_lock();
+    static Bool droppedReported = FALSE;
+    static CARD32 lastDroppedReport;
 
     /*
      * report an error if mieqProcessInputEvents() is called recursively;
@@ -536,25 +631,23 @@ mieqProcessInputEvents(void)
     BUG_WARN_MSG(inProcessInputEvents, "[mi] mieqProcessInputEvents() called recursively.\n");
     inProcessInputEvents = TRUE;
 
-    if (miEventQueue.dropped) {
-        ErrorF("[mi] EQ processing has resumed after %lu dropped events.\n",
-               (unsigned long) miEventQueue.dropped);
-        ErrorF
-            ("[mi] This may be caused by a misbehaving driver monopolizing the server's resources.\n");
-        miEventQueue.dropped = 0;
+    if (__atomic_load_n(&miEventQueue.dropped, __ATOMIC_RELAXED) &&
+        (!droppedReported ||
+         GetTimeInMillis() - lastDroppedReport >= DROPPED_REPORT_MS)) {
+        dropped = __atomic_exchange_n(&miEventQueue.dropped, 0,
+                                      __ATOMIC_RELAXED);
+        ErrorF("[mi] EQ overflowed, %lu events were dropped (%lu in total).\n",
+               (unsigned long) dropped, (unsigned long) mieqDroppedEvents());
+        if (!droppedReported)
+            ErrorF
+                ("[mi] This may be caused by a misbehaving driver monopolizing the server's resources.\n");
+        droppedReported = TRUE;
+        lastDroppedReport = GetTimeInMillis();
     }
 
-    while (miEventQueue.head != miEventQueue.tail) {
-        e = &miEventQueue.events[miEventQueue.head];
-
-        event = *e->events;
-        dev = e->pDev;
-        screen = e->pScreen;
-
-        miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
-
-        input_unlock();
-
+    /* one write per client for the whole lot */
+    OutputBatchBegin();
+    while (mieqDequeue(&event, &dev, &screen)) {
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
 
         if (screenIsSaved == SCREEN_SAVER_ON)
@@ -576,14 +669,13 @@ mieqProcessInputEvents(void)
                event.any.type == ET_TouchUpdate) &&
               event.device_event.flags & TOUCH_POINTER_EMULATED)))
             miPointerUpdateSprite(dev);
-
-        input_lock();
     }
+    OutputBatchEnd();
 
     inProcessInputEvents = FALSE;
 
+    input_lock();
     CallCallbacks(&miCallbacksWhenDrained, NULL);
-
     input_unlock();
 }
 
@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Span cache for wide arcs and round line ends
+ *
+ * The spans of a wide ellipse only depend on its size and the line
+ * width, yet miarc.c computes them for every arc it draws, solving a
+ * quartic per scanline for anything that isn't a circle.  Toolkits draw
+ * the same rounded corners, radio buttons and focus rings over and over,
+ * so the span data is kept in a small LRU cache shared by all screens,
+ * GCs and clients instead, and so are the spans of integer round caps
+ * and joins in miwideline.c.
+ *
+ * Entries are reference counted: whoever looks one up holds on to it
+ * until miSpanCacheRelease(), even if it gets evicted in the meantime.
+ * Everything here runs on the main thread only.
+ */
+
+#include <dix-config.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/list.h"
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+
+#define MI_SPAN_CACHE_BUCKETS   256
+
+typedef struct _miSpanCacheEntry {
+    struct xorg_list lru;       /* most recently used first */
+    struct _miSpanCacheEntry *next;     /* in the same bucket */
+    int kind, lw, width, height;
+    size_t size;
+    int refcnt;
+    Bool cached;
+    union {
+        double d;
+        void *p;
+    } data[];
+} miSpanCacheEntryRec, *miSpanCacheEntryPtr;
+
+miSpanCacheStatsRec miSpanCacheStats;
+
+static miSpanCacheEntryPtr buckets[MI_SPAN_CACHE_BUCKETS];
+static struct xorg_list lru = { &lru, &lru };
+static size_t cachedBytes;
+static size_t maxBytes = MI_SPAN_CACHE_BYTES;
+
+static miSpanCacheEntryPtr
+miSpanCacheEntry(void *data)
+{
+    return (miSpanCacheEntryPtr) ((char *) data -
+                                  offsetof(miSpanCacheEntryRec, data));
+}
+
+static unsigned int
+miSpanCacheHash(int kind, int lw, int width, int height)
+{
+    unsigned int h = kind;
+
+    h = h * 0x9e3779b1u + lw;
+    h = h * 0x9e3779b1u + width;
+    h = h * 0x9e3779b1u + height;
+    return (h ^ (h >> 16)) % MI_SPAN_CACHE_BUCKETS;
+}
+
+void *
+miSpanCacheFind(int kind, int lw, int width, int height)
+{
+    miSpanCacheEntryPtr entry;
+
+    for (entry = buckets[miSpanCacheHash(kind, lw, width, height)];
+         entry; entry = entry->next) {
+        if (entry->kind == kind && entry->lw == lw &&
+            entry->width == width && entry->height == height) {
+            xorg_list_del(&entry->lru);
+            xorg_list_add(&entry->lru, &lru);
+            entry->refcnt++;
+            miSpanCacheStats.hits++;
+            return entry->data;
+        }
+    }
+    miSpanCacheStats.misses++;
+    return NULL;
+}
+
+void *
+miSpanCacheAlloc(int kind, int lw, int width, int height, size_t size)
+{
+    miSpanCacheEntryPtr entry = calloc(1, sizeof(*entry) + size);
+
+    if (!entry)
+        return NULL;
+    entry->kind = kind;
+    entry->lw = lw;
+    entry->width = width;
+    entry->height = height;
+    entry->size = size;
+    entry->refcnt = 1;
+    return entry->data;
+}
+
+void
+miSpanCacheRelease(void *data)
+{
+    miSpanCacheEntryPtr entry = miSpanCacheEntry(data);
+
+    if (--entry->refcnt == 0)
+        free(entry);
+}
+
+static void
+miSpanCacheEvict(miSpanCacheEntryPtr entry)
+{
+    miSpanCacheEntryPtr *prev;
+
+    prev = &buckets[miSpanCacheHash(entry->kind, entry->lw,
+                                    entry->width, entry->height)];
+    while (*prev != entry)
+        prev = &(*prev)->next;
+    *prev = entry->next;
+    xorg_list_del(&entry->lru);
+    cachedBytes -= entry->size;
+    entry->cached = FALSE;
+    miSpanCacheRelease(entry->data);
+}
+
+void
+miSpanCacheAdd(void *data)
+{
+    miSpanCacheEntryPtr entry = miSpanCacheEntry(data);
+    unsigned int h;
+
+    /* huge arcs are rarely drawn twice, don't let them flush the cache */
+    if (entry->cached || entry->size > maxBytes / 16)
+        return;
+
+    while (cachedBytes + entry->size > maxBytes) {
+        miSpanCacheEvict(xorg_list_last_entry(&lru, miSpanCacheEntryRec,
+                                              lru));
+        miSpanCacheStats.evictions++;
+    }
+
+    h = miSpanCacheHash(entry->kind, entry->lw, entry->width, entry->height);
+    entry->next = buckets[h];
+    buckets[h] = entry;
+    xorg_list_add(&entry->lru, &lru);
+    cachedBytes += entry->size;
+    entry->cached = TRUE;
+    entry->refcnt++;
+}
+
+void
+miSpanCacheFlush(void)
+{
+    unsigned long lookups = miSpanCacheStats.hits + miSpanCacheStats.misses;
+
+    if (lookups)
+        LogMessageVerb(X_INFO, 3,
+                       "mi: span cache: %lu of %lu lookups hit (%lu%%), "
+                       "%lu evicted\n", miSpanCacheStats.hits, lookups,
+                       miSpanCacheStats.hits * 100 / lookups,
+                       miSpanCacheStats.evictions);
+    while (!xorg_list_is_empty(&lru))
+        miSpanCacheEvict(xorg_list_first_entry(&lru, miSpanCacheEntryRec,
+                                               lru));
+    memset(&miSpanCacheStats, 0, sizeof(miSpanCacheStats));
+}
+
+void
+miSpanCacheSetSize(size_t bytes)
+{
+    miSpanCacheFlush();
+    maxBytes = bytes;
+}
@@ -90,6 +90,7 @@ Equipment Corporation.
   */
 #include <dix-config.h>
 
+#include    <stdlib.h>
 #include    <X11/X.h>
 
 #include    "mi/mi_priv.h"
@@ -171,6 +172,163 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
 				    HasBorder(w) && \
 				    (w)->backgroundState == ParentRelative)
 
+/*
+ * Incremental validation
+ *
+ * A marked window which hasn't moved, whose own regions and those of its
+ * inferiors haven't changed since they were last validated (clipDirty,
+ * dirtyDescendants), and which is handed the same borderClip as last time
+ * would end up with exactly the clips it already has, and so would every
+ * window below it.  So miComputeClips() leaves such subtrees alone
+ * instead of redoing all their region arithmetic.
+ *
+ * In MI_VALIDATE_CHECK mode those subtrees are recomputed anyway, and
+ * compared against what skipping them would have left behind.
+ */
+
+int miValidateMode = MI_VALIDATE_INCREMENTAL;
+miValidateStatsRec miValidateStats;
+
+static void miComputeClips(WindowPtr pParent, ScreenPtr pScreen,
+                           RegionPtr universe, VTKind kind, RegionPtr exposed);
+
+/* empty regions may differ in their extents */
+static Bool
+miRegionsEqual(RegionPtr a, RegionPtr b)
+{
+    if (!RegionNotEmpty(a))
+        return !RegionNotEmpty(b);
+    return RegionEqual(a, b);
+}
+
+static Bool
+miClipsUnchanged(WindowPtr pParent, RegionPtr universe, VTKind kind)
+{
+    ValidatePtr val = pParent->valdata;
+
+    return kind != VTBroken &&
+        !pParent->clipDirty && !pParent->dirtyDescendants &&
+        pParent->redirectDraw == RedirectDrawNone &&
+        pParent->visibility != VisibilityNotViewable &&
+        pParent->drawable.x == val->before.oldAbsCorner.x &&
+        pParent->drawable.y == val->before.oldAbsCorner.y &&
+        !val->before.resized && !val->before.borderVisible &&
+        miRegionsEqual(universe, &pParent->borderClip);
+}
+
+/*
+ * Calls func for pParent and every inferior miComputeClips() would
+ * recurse into: the viewable, marked ones below marked windows.
+ */
+static void
+miWalkMarked(WindowPtr pParent, void (*func) (WindowPtr pWin, void *data),
+             void *data)
+{
+    WindowPtr pChild = pParent;
+
+    while (1) {
+        if (pChild->viewable && pChild->valdata) {
+            func(pChild, data);
+            if (pChild->firstChild) {
+                pChild = pChild->firstChild;
+                continue;
+            }
+        }
+        while (!pChild->nextSib && (pChild != pParent))
+            pChild = pChild->parent;
+        if (pChild == pParent)
+            break;
+        pChild = pChild->nextSib;
+    }
+}
+
+/* what miComputeClips() leaves for windows whose clips didn't change */
+static void
+miSkipClips(WindowPtr pWin, void *data)
+{
+    RegionNull(&pWin->valdata->after.borderExposed);
+    RegionNull(&pWin->valdata->after.exposed);
+}
+
+typedef struct _miClipSnapshot {
+    WindowPtr pWin;
+    RegionRec borderClip;
+    RegionRec clipList;
+    int visibility;
+} miClipSnapshotRec, *miClipSnapshotPtr;
+
+typedef struct _miClipSnapshots {
+    miClipSnapshotPtr windows;
+    int num;
+    int size;
+} miClipSnapshotsRec, *miClipSnapshotsPtr;
+
+static void
+miSnapshotClips(WindowPtr pWin, void *data)
+{
+    miClipSnapshotsPtr snap = data;
+    miClipSnapshotPtr s;
+
+    if (snap->num == snap->size) {
+        int size = snap->size ? snap->size * 2 : 16;
+        miClipSnapshotPtr windows = reallocarray(snap->windows, size,
+                                                 sizeof(miClipSnapshotRec));
+
+        if (!windows)
+            return;             /* just check fewer windows */
+        snap->windows = windows;
+        snap->size = size;
+    }
+    s = &snap->windows[snap->num++];
+    s->pWin = pWin;
+    RegionNull(&s->borderClip);
+    RegionNull(&s->clipList);
+    RegionCopy(&s->borderClip, &pWin->borderClip);
+    RegionCopy(&s->clipList, &pWin->clipList);
+    s->visibility = pWin->visibility;
+}
+
+/* compares a fully recomputed subtree against its snapshot */
+static void
+miCheckClips(miClipSnapshotsPtr snap)
+{
+    for (int i = 0; i < snap->num; i++) {
+        miClipSnapshotPtr s = &snap->windows[i];
+        WindowPtr pWin = s->pWin;
+
+        if (!miRegionsEqual(&s->borderClip, &pWin->borderClip) ||
+            !miRegionsEqual(&s->clipList, &pWin->clipList) ||
+            s->visibility != pWin->visibility ||
+            RegionNotEmpty(&pWin->valdata->after.exposed) ||
+            RegionNotEmpty(&pWin->valdata->after.borderExposed)) {
+            ErrorF("miValidateTree: incremental clips of window 0x%x "
+                   "differ from recomputed ones\n",
+                   (unsigned int) pWin->drawable.id);
+            miValidateStats.mismatches++;
+        }
+        RegionUninit(&s->borderClip);
+        RegionUninit(&s->clipList);
+    }
+    free(snap->windows);
+}
+
+/*
+ * The window is clean once its viewable inferiors are.  Unviewable ones
+ * aren't validated and keep their flags: their clips are empty, so they
+ * get recomputed as soon as they become viewable anyway.
+ */
+static void
+miClipsValidated(WindowPtr pParent)
+{
+    Bool dirty = FALSE;
+
+    for (WindowPtr pChild = pParent->firstChild; pChild && !dirty;
+         pChild = pChild->nextSib)
+        dirty = pChild->viewable &&
+            (pChild->clipDirty || pChild->dirtyDescendants);
+    pParent->dirtyDescendants = dirty;
+}
+
 /*
  *-----------------------------------------------------------------------
  * miComputeClips --
@@ -188,9 +346,9 @@ miShapedWindowIn(RegionPtr universe, RegionPtr bounding,
  *-----------------------------------------------------------------------
  */
 static void
-miComputeClips(WindowPtr pParent,
-               ScreenPtr pScreen,
-               RegionPtr universe, VTKind kind, RegionPtr exposed)
+miComputeClipsFull(WindowPtr pParent,
+                   ScreenPtr pScreen,
+                   RegionPtr universe, VTKind kind, RegionPtr exposed)
 {                               /* for intermediate calculations */
     int dx, dy;
     RegionRec childUniverse;
@@ -286,6 +444,9 @@ miComputeClips(WindowPtr pParent,
             pChild = pParent;
             while (1) {
                 if (pChild->viewable) {
+                    /* this walk covers every viewable inferior */
+                    pChild->clipDirty = FALSE;
+                    pChild->dirtyDescendants = FALSE;
                     if (pChild->visibility != VisibilityFullyObscured) {
                         RegionTranslate(&pChild->borderClip, dx, dy);
                         RegionTranslate(&pChild->clipList, dx, dy);
@@ -434,6 +595,8 @@ miComputeClips(WindowPtr pParent,
         RegionUninit(&childUnion);
         RegionUninit(&childUniverse);
     }                           /* if any children */
+    pParent->clipDirty = FALSE;
+    miClipsValidated(pParent);
 
     /*
      * 'universe' now contains the new clipList for the parent window.
@@ -470,6 +633,34 @@ miComputeClips(WindowPtr pParent,
         (*pScreen->ClipNotify) (pParent, dx, dy);
 }
 
+static void
+miComputeClips(WindowPtr pParent,
+               ScreenPtr pScreen,
+               RegionPtr universe, VTKind kind, RegionPtr exposed)
+{
+    miClipSnapshotsRec snap = { 0 };
+    Bool check = FALSE;
+
+    if (miValidateMode != MI_VALIDATE_FULL &&
+        miClipsUnchanged(pParent, universe, kind)) {
+        if (miValidateMode != MI_VALIDATE_CHECK) {
+            miWalkMarked(pParent, miSkipClips, NULL);
+            miValidateStats.skipped++;
+            return;
+        }
+        miWalkMarked(pParent, miSnapshotClips, &snap);
+        check = TRUE;
+    }
+
+    miComputeClipsFull(pParent, pScreen, universe, kind, exposed);
+    miValidateStats.computed++;
+
+    if (check) {
+        miCheckClips(&snap);
+        miValidateStats.skipped++;
+    }
+}
+
 static void
 miTreeObscured(WindowPtr pParent)
 {
@@ -722,6 +913,7 @@ miValidateTree(WindowPtr pParent,       /* Parent to validate */
 
     RegionUninit(&totalClip);
     RegionUninit(&exposed);
+    miClipsValidated(pParent);
     if (pScreen->ClipNotify)
         (*pScreen->ClipNotify) (pParent, 0, 0);
     return 1;
@@ -55,6 +55,7 @@ SOFTWARE.
 #include <dix-config.h>
 
 #include <stdio.h>
+#include <string.h>
 #ifdef _XOPEN_SOURCE
 #include <math.h>
 #else
@@ -1099,27 +1100,16 @@ miLineJoin(DrawablePtr pDrawable,
                      nleft, nright);
 }
 
-static int
-miLineArcI(DrawablePtr pDraw,
-           GCPtr pGC, int xorg, int yorg, DDXPointPtr points, int *widths)
+/* spans of a round line end of width slw, around the origin */
+static void
+miLineArcSpans(int slw, DDXPointPtr points, int *widths)
 {
     DDXPointPtr tpts, bpts;
     int *twids, *bwids;
-    int x, y, e, ex, slw;
+    int x, y, e, ex;
 
     tpts = points;
     twids = widths;
-    if (pGC->miTranslate) {
-        xorg += pDraw->x;
-        yorg += pDraw->y;
-    }
-    slw = pGC->lineWidth;
-    if (slw == 1) {
-        tpts->x = xorg;
-        tpts->y = yorg;
-        *twids = 1;
-        return 1;
-    }
     bpts = tpts + slw;
     bwids = twids + slw;
     y = (slw >> 1) + 1;
@@ -1139,18 +1129,59 @@ miLineArcI(DrawablePtr pDraw,
         slw = (x << 1) + 1;
         if ((e == ex) && (slw > 1))
             slw--;
-        tpts->x = xorg - x;
-        tpts->y = yorg - y;
+        tpts->x = -x;
+        tpts->y = -y;
         tpts++;
         *twids++ = slw;
         if ((y != 0) && ((slw > 1) || (e != ex))) {
             bpts--;
-            bpts->x = xorg - x;
-            bpts->y = yorg + y;
+            bpts->x = -x;
+            bpts->y = y;
             *--bwids = slw;
         }
     }
-    return pGC->lineWidth;
+}
+
+static int
+miLineArcI(DrawablePtr pDraw,
+           GCPtr pGC, int xorg, int yorg, DDXPointPtr points, int *widths)
+{
+    int slw = pGC->lineWidth;
+    DDXPointPtr cached;
+
+    if (pGC->miTranslate) {
+        xorg += pDraw->x;
+        yorg += pDraw->y;
+    }
+    if (slw == 1) {
+        points->x = xorg;
+        points->y = yorg;
+        *widths = 1;
+        return 1;
+    }
+
+    /* the same for every round cap and join of a line width */
+    cached = miSpanCacheFind(MI_SPAN_CACHE_LINE_ARC, slw, 0, 0);
+    if (!cached) {
+        cached = miSpanCacheAlloc(MI_SPAN_CACHE_LINE_ARC, slw, 0, 0,
+                                  slw * (sizeof(DDXPointRec) + sizeof(int)));
+        if (cached) {
+            miLineArcSpans(slw, cached, (int *) (cached + slw));
+            miSpanCacheAdd(cached);
+        }
+    }
+    if (cached) {
+        memcpy(points, cached, slw * sizeof(DDXPointRec));
+        memcpy(widths, cached + slw, slw * sizeof(int));
+        miSpanCacheRelease(cached);
+    }
+    else
+        miLineArcSpans(slw, points, widths);
+    for (int i = 0; i < slw; i++) {
+        points[i].x += xorg;
+        points[i].y += yorg;
+    }
+    return slw;
 }
 
 #define CLIPSTEPEDGE(edgey,edge,edgeleft) \
@@ -52,6 +52,7 @@ SOFTWARE.
 #include "dix/cursor_priv.h"
 #include "dix/dix_priv.h"
 #include "dix/input_priv.h"
+#include "dix/window_priv.h"
 #include "mi/mi_priv.h"
 
 #include "regionstr.h"
@@ -742,42 +743,56 @@ miMarkUnrealizedWindow(WindowPtr pChild, WindowPtr pWin, Bool fromConfigure)
     }
 }
 
+/* whether the pointer at x/y is in pWin, as far as picking goes */
+static Bool
+miSpriteHit(WindowPtr pWin, int x, int y)
+{
+    BoxRec box;
+
+    return (pWin->mapped) &&
+        (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
+        (x < pWin->drawable.x + (int) pWin->drawable.width +
+         wBorderWidth(pWin)) &&
+        (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
+        (y < pWin->drawable.y + (int) pWin->drawable.height +
+         wBorderWidth(pWin))
+        /* When a window is shaped, a further check
+         * is made to see if the point is inside
+         * borderSize
+         */
+        && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
+        && (!wInputShape(pWin) ||
+            RegionContainsPoint(wInputShape(pWin),
+                                x - pWin->drawable.x,
+                                y - pWin->drawable.y, &box))
+        /* In rootless mode windows may be offscreen, even when
+         * they're in X's stack. (E.g. if the native window system
+         * implements some form of virtual desktop system).
+         */
+        && !pWin->unhittable;
+}
+
+static void
+miSpriteTracePush(SpritePtr pSprite, WindowPtr pWin)
+{
+    if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
+        pSprite->spriteTraceSize += 10;
+        pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
+                                            pSprite->spriteTraceSize,
+                                            sizeof(WindowPtr));
+    }
+    pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+}
+
 WindowPtr
 miSpriteTrace(SpritePtr pSprite, int x, int y)
 {
     WindowPtr pWin;
-    BoxRec box;
 
     pWin = DeepestSpriteWin(pSprite)->firstChild;
     while (pWin) {
-        if ((pWin->mapped) &&
-            (x >= pWin->drawable.x - wBorderWidth(pWin)) &&
-            (x < pWin->drawable.x + (int) pWin->drawable.width +
-             wBorderWidth(pWin)) &&
-            (y >= pWin->drawable.y - wBorderWidth(pWin)) &&
-            (y < pWin->drawable.y + (int) pWin->drawable.height +
-             wBorderWidth(pWin))
-            /* When a window is shaped, a further check
-             * is made to see if the point is inside
-             * borderSize
-             */
-            && (!wBoundingShape(pWin) || PointInBorderSize(pWin, x, y))
-            && (!wInputShape(pWin) ||
-                RegionContainsPoint(wInputShape(pWin),
-                                    x - pWin->drawable.x,
-                                    y - pWin->drawable.y, &box))
-            /* In rootless mode windows may be offscreen, even when
-             * they're in X's stack. (E.g. if the native window system
-             * implements some form of virtual desktop system).
-             */
-            && !pWin->unhittable) {
-            if (pSprite->spriteTraceGood >= pSprite->spriteTraceSize) {
-                pSprite->spriteTraceSize += 10;
-                pSprite->spriteTrace = reallocarray(pSprite->spriteTrace,
-                                                    pSprite->spriteTraceSize,
-                                                    sizeof(WindowPtr));
-            }
-            pSprite->spriteTrace[pSprite->spriteTraceGood++] = pWin;
+        if (miSpriteHit(pWin, x, y)) {
+            miSpriteTracePush(pSprite, pWin);
             pWin = pWin->firstChild;
         }
         else
@@ -795,11 +810,21 @@ miSpriteTrace(SpritePtr pSprite, int x, int y)
  *       ...
  *   spriteTrace[spriteTraceGood - 1] ... window at x/y
  *
+ * The top level window is looked up in the screen's window index, which
+ * saves walking all children of the root.
+ *
  * @returns the window at the given coordinates.
  */
 WindowPtr
 miXYToWindow(ScreenPtr pScreen, SpritePtr pSprite, int x, int y)
 {
+    WindowPtr pTop;
+
     pSprite->spriteTraceGood = 1;       /* root window still there */
+    if (WindowIndexLookup(pSprite->spriteTrace[0], x, y, miSpriteHit, &pTop)) {
+        if (!pTop)
+            return pSprite->spriteTrace[0];
+        miSpriteTracePush(pSprite, pTop);
+    }
     return miSpriteTrace(pSprite, x, y);
 }
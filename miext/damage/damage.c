@@ -23,6 +23,7 @@
 #include <dix-config.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "dix/screen_hooks_priv.h"
 #include "os/osdep.h"
@@ -123,6 +124,127 @@ getDrawableDamageRef(DrawablePtr pDrawable)
     DamagePtr	*pPrev = (DamagePtr *) \
 	dixLookupPrivateAddr(&(pWindow)->devPrivates, damageWinPrivateKey)
 
+/*
+ * Damages without a report function only ever add up what's drawn, and
+ * every op adding its bit to a region of many boxes is what makes
+ * accumulating damage expensive with lots of small primitives.  The
+ * boxes are collected instead, and added to the region all at once when
+ * there are enough of them, or when somebody wants to see the region.
+ */
+static void
+damageFlushDeferred(DamagePtr pDamage)
+{
+    RegionRec region;
+
+    if (!pDamage->numDeferred)
+        return;
+    RegionInitBoxes(&region, pDamage->deferred, pDamage->numDeferred);
+    RegionUnion(&pDamage->damage, &pDamage->damage, &region);
+    RegionUninit(&region);
+    pDamage->numDeferred = 0;
+}
+
+static void
+damageDefer(DamagePtr pDamage, RegionPtr pRegion)
+{
+    int nbox = RegionNumRects(pRegion);
+
+    /* only damages that get drawn to need them */
+    if (!pDamage->deferred)
+        pDamage->deferred = calloc(DAMAGE_DEFERRED_BOXES, sizeof(BoxRec));
+    if (!pDamage->deferred) {
+        RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+        return;
+    }
+    if (pDamage->numDeferred + nbox > DAMAGE_DEFERRED_BOXES) {
+        damageFlushDeferred(pDamage);
+        if (nbox > DAMAGE_DEFERRED_BOXES) {
+            RegionUnion(&pDamage->damage, &pDamage->damage, pRegion);
+            return;
+        }
+    }
+    memcpy(&pDamage->deferred[pDamage->numDeferred], RegionRects(pRegion),
+           nbox * sizeof(BoxRec));
+    pDamage->numDeferred += nbox;
+}
+
+static Bool
+damageSkip(DamageScrPrivPtr pScrPriv, DamagePtr pDamage)
+{
+    /* internal drawing doesn't count, nor does drawing unrealized windows */
+    if (pScrPriv->internalLevel > 0 && !pDamage->isInternal) {
+        DAMAGE_DEBUG(("non internal damage, skipping at %d\n",
+                      pScrPriv->internalLevel));
+        return TRUE;
+    }
+    return pDamage->pDrawable->type == DRAWABLE_WINDOW &&
+        !((WindowPtr) (pDamage->pDrawable))->realized;
+}
+
+static void
+damageOrigin(DamagePtr pDamage, int *draw_x, int *draw_y)
+{
+    *draw_x = pDamage->pDrawable->x;
+    *draw_y = pDamage->pDrawable->y;
+    /*
+     * Need to move everyone to screen coordinates
+     * XXX what about off-screen pixmaps with non-zero x/y?
+     */
+    if (!WindowDrawable(pDamage->pDrawable->type)) {
+        *draw_x += ((PixmapPtr) pDamage->pDrawable)->screen_x;
+        *draw_y += ((PixmapPtr) pDamage->pDrawable)->screen_y;
+    }
+}
+
+/*
+ * Whether drawing pBox (in screen coordinates) can't change anything for
+ * pDamage, as the area is damaged already.  Only raw reports tell about
+ * the same area over and over again.
+ */
+static Bool
+damageCovers(DamagePtr pDamage, const BoxRec *pBox, int draw_x, int draw_y)
+{
+    BoxRec box;
+
+    if (pDamage->damageReport &&
+        pDamage->damageLevel == DamageReportRawRegion)
+        return FALSE;
+
+    box.x1 = pBox->x1 - draw_x;
+    box.y1 = pBox->y1 - draw_y;
+    box.x2 = pBox->x2 - draw_x;
+    box.y2 = pBox->y2 - draw_y;
+    for (int i = pDamage->numDeferred - 1; i >= 0; i--) {
+        BoxPtr pDeferred = &pDamage->deferred[i];
+
+        if (pDeferred->x1 <= box.x1 && box.x2 <= pDeferred->x2 &&
+            pDeferred->y1 <= box.y1 && box.y2 <= pDeferred->y2)
+            return TRUE;
+    }
+    return RegionContainsRect(&pDamage->damage, &box) == rgnIN;
+}
+
+/*
+ * Repeatedly drawing into the same area, like a terminal or a stipple
+ * heavy application does, needs no region math at all once every damage
+ * of the drawable has it.
+ */
+static Bool
+damageAllCover(DamageScrPrivPtr pScrPriv, DamagePtr pDamage,
+               const BoxRec *pBox)
+{
+    int draw_x, draw_y;
+
+    for (; pDamage; pDamage = pDamage->pNext) {
+        if (damageSkip(pScrPriv, pDamage))
+            continue;
+        damageOrigin(pDamage, &draw_x, &draw_y);
+        if (!damageCovers(pDamage, pBox, draw_x, draw_y))
+            return FALSE;
+    }
+    return TRUE;
+}
+
 #if DAMAGE_DEBUG_ENABLE
 static void
 _damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
@@ -162,6 +284,13 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
     if (screen_x || screen_y)
         RegionTranslate(pRegion, screen_x, screen_y);
 
+    if (!pRegion->data &&
+        damageAllCover(pScrPriv, pDamage, RegionExtents(pRegion))) {
+        if (screen_x || screen_y)
+            RegionTranslate(pRegion, -screen_x, -screen_y);
+        return;
+    }
+
     if (pDrawable->type == DRAWABLE_WINDOW &&
         ((WindowPtr) (pDrawable))->backingStore == NotUseful) {
         if (subWindowMode == ClipByChildren) {
@@ -181,32 +310,13 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
     RegionNull(&clippedRec);
     for (; pDamage; pDamage = pNext) {
         pNext = pDamage->pNext;
-        /*
-         * Check for internal damage and don't send events
-         */
-        if (pScrPriv->internalLevel > 0 && !pDamage->isInternal) {
-            DAMAGE_DEBUG(("non internal damage, skipping at %d\n",
-                          pScrPriv->internalLevel));
+        if (damageSkip(pScrPriv, pDamage))
             continue;
-        }
-        /*
-         * Check for unrealized windows
-         */
-        if (pDamage->pDrawable->type == DRAWABLE_WINDOW &&
-            !((WindowPtr) (pDamage->pDrawable))->realized) {
-            continue;
-        }
 
-        draw_x = pDamage->pDrawable->x;
-        draw_y = pDamage->pDrawable->y;
-        /*
-         * Need to move everyone to screen coordinates
-         * XXX what about off-screen pixmaps with non-zero x/y?
-         */
-        if (!WindowDrawable(pDamage->pDrawable->type)) {
-            draw_x += ((PixmapPtr) pDamage->pDrawable)->screen_x;
-            draw_y += ((PixmapPtr) pDamage->pDrawable)->screen_y;
-        }
+        damageOrigin(pDamage, &draw_x, &draw_y);
+        if (!pRegion->data &&
+            damageCovers(pDamage, RegionExtents(pRegion), draw_x, draw_y))
+            continue;
 
         /*
          * Clip against border or pixmap bounds
@@ -261,7 +371,7 @@ damageRegionAppend(DrawablePtr pDrawable, RegionPtr pRegion, Bool clip,
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, pDamageRegion);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
+                damageDefer(pDamage, pDamageRegion);
         }
 
         /*
@@ -287,8 +397,7 @@ damageRegionProcessPending(DrawablePtr pDrawable)
             if (pDamage->damageReport)
                 DamageReportDamage(pDamage, &pDamage->pendingDamage);
             else
-                RegionUnion(&pDamage->damage, &pDamage->damage,
-                            &pDamage->pendingDamage);
+                damageDefer(pDamage, &pDamage->pendingDamage);
         }
 
         if (pDamage->reportAfter)
@@ -1826,6 +1935,7 @@ DamageDestroy(DamagePtr pDamage)
 
     RegionUninit(&pDamage->damage);
     RegionUninit(&pDamage->pendingDamage);
+    free(pDamage->deferred);
     free(pDamage);
 }
 
@@ -1836,6 +1946,7 @@ DamageSubtract(DamagePtr pDamage, const RegionPtr pRegion)
     RegionRec pixmapClip;
     DrawablePtr pDrawable = pDamage->pDrawable;
 
+    damageFlushDeferred(pDamage);
     RegionSubtract(&pDamage->damage, &pDamage->damage, pRegion);
     if (pDrawable) {
         if (pDrawable->type == DRAWABLE_WINDOW)
@@ -1863,11 +1974,13 @@ void
 DamageEmpty(DamagePtr pDamage)
 {
     RegionEmpty(&pDamage->damage);
+    pDamage->numDeferred = 0;
 }
 
 RegionPtr
 DamageRegion(DamagePtr pDamage)
 {
+    damageFlushDeferred(pDamage);
     return &pDamage->damage;
 }
 
@@ -1922,6 +2035,7 @@ DamageReportDamage(DamagePtr pDamage, RegionPtr pDamageRegion)
     RegionRec tmpRegion;
     Bool was_empty;
 
+    damageFlushDeferred(pDamage);
     switch (pDamage->damageLevel) {
     case DamageReportRawRegion:
         RegionUnion(&pDamage->damage, &pDamage->damage, pDamageRegion);
@@ -32,6 +32,9 @@
 #include "privates.h"
 #include "picturestr.h"
 
+/* boxes a damage without report function collects before adding them up */
+#define DAMAGE_DEFERRED_BOXES   32
+
 typedef struct _damage {
     DamagePtr pNext;
     DamagePtr pNextWin;
@@ -49,6 +52,13 @@ typedef struct _damage {
     Bool reportAfter;
     RegionRec pendingDamage;    /* will be flushed post submission at the latest */
     ScreenPtr pScreen;
+
+    /*
+     * not in damage yet, use DamageRegion() rather than damage directly;
+     * DAMAGE_DEFERRED_BOXES of them, allocated when first needed
+     */
+    int numDeferred;
+    BoxPtr deferred;
 } DamageRec;
 
 typedef struct _damageScrPriv {
@@ -22,6 +22,8 @@
 
 #include "dix-config.h"
 
+#include "miext/shadow/shadow_priv.h"
+
 #include "shadow.h"
 #include "fb.h"
 
@@ -98,7 +100,7 @@ sh24_32BltLine(CARD8 *srcLine,
 void
 shadowUpdate32to24(ScreenPtr pScreen, shadowBufPtr pBuf)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    RegionPtr damage = shadowDamage(pBuf);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
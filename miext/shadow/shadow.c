@@ -26,6 +26,8 @@
 #include <X11/X.h>
 
 #include "dix/screen_hooks_priv.h"
+#include "miext/shadow/shadow_priv.h"
+#include "os/threadpool_priv.h"
 
 #include    "scrnintstr.h"
 #include    "windowstr.h"
@@ -36,6 +38,13 @@
 #include    "gcstruct.h"
 #include    "shadow.h"
 
+#define SHADOW_TILES_PER_THREAD   4
+
+typedef struct _shadowScrPriv {
+    shadowBufRec buf;           /* what drivers get to see, keep it first */
+    Bool threaded;              /* shadowSetThreaded() */
+} shadowScrPrivRec, *shadowScrPrivPtr;
+
 static DevPrivateKeyRec shadowScrPrivateKeyRec;
 #define shadowScrPrivateKey (&shadowScrPrivateKeyRec)
 
@@ -52,6 +61,130 @@ static DevPrivateKeyRec shadowScrPrivateKeyRec;
     real->mem = priv->mem; \
 }
 
+typedef struct _shadowTileJob {
+    ScreenPtr pScreen;
+    shadowBufPtr pBuf;
+    RegionPtr pRegion;          /* the damage, taken on the main thread */
+    BoxRec extents;
+    Bool columns;               /* split along x instead of y */
+    int ntiles;
+} shadowTileJobRec;
+
+/*
+ * Which way to cut the damage so that the tiles end up in different
+ * scanlines of the screen, for the update procs which only ever write
+ * what's inside the boxes they're given.  Those rotating by 90 or 270
+ * degrees turn shadow columns into screen scanlines.
+ */
+static int
+shadowTileSplit(ShadowUpdateProc update)
+{
+    if (update == shadowUpdatePacked ||
+        update == shadowUpdate32to24 ||
+        update == shadowUpdateRotate8 ||
+        update == shadowUpdateRotate16 ||
+        update == shadowUpdateRotate32 ||
+        update == shadowUpdateRotate8_180 ||
+        update == shadowUpdateRotate16_180 ||
+        update == shadowUpdateRotate32_180)
+        return 'y';
+    if (update == shadowUpdateRotate8_90 ||
+        update == shadowUpdateRotate16_90 ||
+        update == shadowUpdateRotate16_90YX ||
+        update == shadowUpdateRotate32_90 ||
+        update == shadowUpdateRotate8_270 ||
+        update == shadowUpdateRotate16_270 ||
+        update == shadowUpdateRotate16_270YX ||
+        update == shadowUpdateRotate32_270)
+        return 'x';
+    return 0;
+}
+
+/*
+ * Runs the update proc on one tile.  It gets a copy of the shadow buffer
+ * with just the part of the damage inside the tile, and never touches the
+ * damage itself: that's only for the main thread.
+ */
+static void
+shadowUpdateTile(void *data, int tile)
+{
+    shadowTileJobRec *job = data;
+    shadowTileBufRec tileBuf = { .buf = *job->pBuf };
+    RegionRec region;
+    BoxRec box = job->extents;
+
+    if (job->columns) {
+        int w = box.x2 - box.x1;
+
+        box.x1 = job->extents.x1 + w * tile / job->ntiles;
+        box.x2 = job->extents.x1 + w * (tile + 1) / job->ntiles;
+    }
+    else {
+        int h = box.y2 - box.y1;
+
+        box.y1 = job->extents.y1 + h * tile / job->ntiles;
+        box.y2 = job->extents.y1 + h * (tile + 1) / job->ntiles;
+    }
+
+    RegionInit(&region, &box, 1);
+    RegionIntersect(&region, &region, job->pRegion);
+    if (RegionNotEmpty(&region)) {
+        tileBuf.buf.pDamage = NULL;
+        tileBuf.pRegion = &region;
+        (*tileBuf.buf.update) (job->pScreen, &tileBuf.buf);
+    }
+    RegionUninit(&region);
+}
+
+Bool
+shadowUpdateThreaded(ScreenPtr pScreen, shadowBufPtr pBuf, ThreadPoolPtr pool)
+{
+    RegionPtr pRegion = DamageRegion(pBuf->pDamage);
+    int split = shadowTileSplit(pBuf->update);
+    shadowTileJobRec job;
+
+    if (!pool || !split)
+        return FALSE;
+
+    job.pScreen = pScreen;
+    job.pBuf = pBuf;
+    job.pRegion = pRegion;
+    job.extents = *RegionExtents(pRegion);
+    job.columns = split == 'x';
+    job.ntiles = ThreadPoolThreads(pool) * SHADOW_TILES_PER_THREAD;
+    if (job.columns)
+        job.ntiles = min(job.ntiles, job.extents.x2 - job.extents.x1);
+    else
+        job.ntiles = min(job.ntiles, job.extents.y2 - job.extents.y1);
+
+    ThreadPoolRun(pool, shadowUpdateTile, &job, job.ntiles);
+    return TRUE;
+}
+
+static Bool
+shadowRedisplayThreaded(ScreenPtr pScreen, shadowScrPrivPtr pPriv)
+{
+    BoxPtr extents = RegionExtents(DamageRegion(pPriv->buf.pDamage));
+    ThreadPoolPtr pool;
+
+    if (!pPriv->threaded ||
+        (extents->x2 - extents->x1) * (extents->y2 - extents->y1) <
+        THREADPOOL_MIN_AREA)
+        return FALSE;
+
+    pool = ThreadPoolServer();
+    /* single CPU or no threads, don't try again */
+    if (!pool) {
+        pPriv->threaded = FALSE;
+        return FALSE;
+    }
+    return shadowUpdateThreaded(pScreen, &pPriv->buf, pool);
+}
+
+/*
+ * The tiles are done in parallel, but all of them before returning: once
+ * the block handler chain moves on, the driver may present the scanout.
+ */
 static void
 shadowRedisplay(ScreenPtr pScreen)
 {
@@ -62,7 +195,8 @@ shadowRedisplay(ScreenPtr pScreen)
         return;
     pRegion = DamageRegion(pBuf->pDamage);
     if (RegionNotEmpty(pRegion)) {
-        (*pBuf->update) (pScreen, pBuf);
+        if (!shadowRedisplayThreaded(pScreen, (shadowScrPrivPtr) pBuf))
+            (*pBuf->update) (pScreen, pBuf);
         DamageEmpty(pBuf->pDamage);
     }
 }
@@ -118,7 +252,7 @@ shadowSetup(ScreenPtr pScreen)
     if (!DamageSetup(pScreen))
         return FALSE;
 
-    shadowBufPtr pBuf = calloc(1, sizeof(shadowBufRec));
+    shadowBufPtr pBuf = calloc(1, sizeof(shadowScrPrivRec));
     if (!pBuf)
         return FALSE;
     pBuf->pDamage = DamageCreate((DamageReportFunc) NULL,
@@ -188,5 +322,14 @@ shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap)
         pBuf->randr = 0;
         pBuf->closure = 0;
         pBuf->pPixmap = 0;
+        ((shadowScrPrivPtr) pBuf)->threaded = FALSE;
     }
 }
+
+void
+shadowSetThreaded(ScreenPtr pScreen, Bool threaded)
+{
+    shadowScrPrivPtr pPriv = (shadowScrPrivPtr) shadowGetBuf(pScreen);
+
+    pPriv->threaded = threaded && ThreadPoolDefaultThreads() > 1;
+}
@@ -81,6 +81,15 @@ shadowAdd(ScreenPtr pScreen,
 extern _X_EXPORT void
  shadowRemove(ScreenPtr pScreen, PixmapPtr pPixmap);
 
+/*
+ * Lets the update proc run on several threads at once, each on its own
+ * part of the damage.  Only for window procs which return pointers into
+ * a linear frame buffer that stay valid across calls.  Reset by
+ * shadowRemove().
+ */
+extern _X_EXPORT void
+ shadowSetThreaded(ScreenPtr pScreen, Bool threaded);
+
 extern _X_EXPORT void
  shadowUpdateAfb4(ScreenPtr pScreen, shadowBufPtr pBuf);
 
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+#ifndef _XSERVER_MIEXT_SHADOW_PRIV_H
+#define _XSERVER_MIEXT_SHADOW_PRIV_H
+
+#include <X11/Xdefs.h>
+
+#include "miext/shadow/shadow.h"
+#include "os/threadpool_priv.h"
+
+#include "regionstr.h"
+
+/*
+ * What shadowUpdateThreaded() hands the update procs on the worker
+ * threads: a copy of the shadow buffer without its damage, and the part
+ * of the damage inside one tile instead.
+ */
+typedef struct _shadowTileBuf {
+    shadowBufRec buf;           /* buf.pDamage is NULL, keep it first */
+    RegionPtr pRegion;
+} shadowTileBufRec, *shadowTileBufPtr;
+
+/* the region an update proc has to copy to the screen */
+static inline RegionPtr
+shadowDamage(shadowBufPtr pBuf)
+{
+    if (!pBuf->pDamage)
+        return ((shadowTileBufPtr) pBuf)->pRegion;
+    return DamageRegion(pBuf->pDamage);
+}
+
+/*
+ * Cuts the damage of pBuf into tiles and runs its update proc on them on
+ * the threads of pool.  Returns FALSE, without doing anything, if the
+ * update proc isn't one which can be split up like that.
+ */
+Bool shadowUpdateThreaded(ScreenPtr pScreen, shadowBufPtr pBuf,
+                          ThreadPoolPtr pool);
+
+#endif /* _XSERVER_MIEXT_SHADOW_PRIV_H */
@@ -26,6 +26,9 @@
 #include <stdlib.h>
 
 #include    <X11/X.h>
+
+#include "miext/shadow/shadow_priv.h"
+
 #include    "scrnintstr.h"
 #include    "windowstr.h"
 #include    <X11/fonts/font.h>
@@ -41,7 +44,7 @@
 void
 shadowUpdatePacked(ScreenPtr pScreen, shadowBufPtr pBuf)
 {
-    RegionPtr damage = DamageRegion(pBuf->pDamage);
+    RegionPtr damage = shadowDamage(pBuf);
     PixmapPtr pShadow = pBuf->pPixmap;
     int nbox = RegionNumRects(damage);
     BoxPtr pbox = RegionRects(damage);
@@ -51,6 +51,7 @@ typedef struct _SyncCounter {
     SyncObject sync;            /* Common sync object data */
     int64_t value;              /* counter value */
     struct _SysCounterInfo *pSysCounterInfo; /* NULL if not a system counter */
+    struct _SyncTriggerIndex *pTrigindex; /* triggers, instead of pTriglist */
 } SyncCounter;
 
 struct _SyncFence {
@@ -67,6 +68,8 @@ struct _SyncTrigger {
     unsigned int value_type;    /* Absolute or Relative */
     unsigned int test_type;     /* transition or Comparison type */
     int64_t test_value;         /* trigger event threshold value */
+    int64_t indexed_value;      /* test_value and test_type the trigger */
+    unsigned int indexed_type;  /* is filed under in its counter's index */
     Bool (*CheckTrigger)(struct _SyncTrigger *pTrigger,
                          int64_t newval);
     void (*TriggerFired)(struct _SyncTrigger *pTrigger);
@@ -698,6 +698,11 @@ ssize_t _XSERVTransWrite (XtransConnInfo ciptr, const char *buf, size_t size)
     return ciptr->transptr->Write (ciptr, buf, size);
 }
 
+ssize_t _XSERVTransWritev (XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
+{
+    return ciptr->transptr->Writev (ciptr, iov, iovcnt);
+}
+
 #if XTRANS_SEND_FDS
 int _XSERVTransSendFd (XtransConnInfo ciptr, int fd, int do_close)
 {
@@ -58,6 +58,12 @@ from The Open Group.
 
 #ifndef WIN32
 #include <sys/socket.h>
+#include <sys/uio.h>
+#else
+struct iovec {
+    caddr_t iov_base;
+    long iov_len;
+};
 #endif
 
 #ifdef __clang__
@@ -209,6 +215,12 @@ ssize_t _XSERVTransWrite (
     size_t		/* size */
 );
 
+ssize_t _XSERVTransWritev (
+    XtransConnInfo,	/* ciptr */
+    struct iovec *,	/* iov */
+    int			/* iovcnt */
+);
+
 int _XSERVTransSendFd (XtransConnInfo ciptr, int fd, int do_close);
 
 int _XSERVTransRecvFd (XtransConnInfo ciptr);
@@ -178,6 +178,8 @@ typedef struct _Xtransport {
 
     ssize_t (*Write)(XtransConnInfo ciptr, const char *buf, size_t size);
 
+    ssize_t (*Writev)(XtransConnInfo ciptr, struct iovec *iov, int iovcnt);
+
 #if XTRANS_SEND_FDS
     int (*SendFd)(
 	XtransConnInfo,		/* connection */
@@ -753,6 +753,13 @@ static ssize_t _XSERVTransLocalWrite(XtransConnInfo ciptr, const char *buf, size
     return write(ciptr->fd,buf,size);
 }
 
+static ssize_t _XSERVTransLocalWritev(XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
+{
+    prmsg(2,"LocalWritev(%d,%p,%d)\n", ciptr->fd, (const void *) iov, iovcnt );
+
+    return writev(ciptr->fd,iov,iovcnt);
+}
+
 static int _XSERVTransLocalDisconnect(XtransConnInfo ciptr)
 {
     prmsg(2,"LocalDisconnect(%p->%d)\n", (void *) ciptr, ciptr->fd);
@@ -822,6 +829,7 @@ static Xtransport _XSERVTransLocalFuncs = {
 	_XSERVTransLocalAccept,
 	_XSERVTransLocalRead,
 	_XSERVTransLocalWrite,
+	_XSERVTransLocalWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransLocalSendFdInvalid,
 	_XSERVTransLocalRecvFdInvalid,
@@ -847,6 +855,7 @@ static Xtransport _XSERVTransNAMEDFuncs = {
 	_XSERVTransLocalAccept,
 	_XSERVTransLocalRead,
 	_XSERVTransLocalWrite,
+	_XSERVTransLocalWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransLocalSendFdInvalid,
 	_XSERVTransLocalRecvFdInvalid,
@@ -869,6 +878,7 @@ static Xtransport _XSERVTransPIPEFuncs = {
 	_XSERVTransLocalAccept,
 	_XSERVTransLocalRead,
 	_XSERVTransLocalWrite,
+	_XSERVTransLocalWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransLocalSendFdInvalid,
 	_XSERVTransLocalRecvFdInvalid,
@@ -1327,10 +1327,10 @@ static int _XSERVTransSocketRead (
 #endif /* WIN32 */
 }
 
-static ssize_t _XSERVTransSocketWrite (
-    XtransConnInfo ciptr, const char *buf, size_t size)
+static ssize_t _XSERVTransSocketWritev (
+    XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
 {
-    prmsg (2,"SocketWrite(%d,%p,%lu)\n", ciptr->fd, (void *) buf, (unsigned long)size);
+    prmsg (2,"SocketWritev(%d,%p,%d)\n", ciptr->fd, (void *) iov, iovcnt);
 
 #if XTRANS_SEND_FDS
     if (ciptr->send_fds)
@@ -1338,15 +1338,11 @@ static ssize_t _XSERVTransSocketWrite (
         union fd_pass           cmsgbuf;
         int                     nfd = nFd(&ciptr->send_fds);
         struct _XtransConnFd    *cf = ciptr->send_fds;
-        struct iovec iov = {
-            .iov_len = size,
-            .iov_base = (char*)buf,
-        };
         struct msghdr           msg = {
             .msg_name = NULL,
             .msg_namelen = 0,
-            .msg_iov = &iov,
-            .msg_iovlen = 1,
+            .msg_iov = iov,
+            .msg_iovlen = iovcnt,
             .msg_control = cmsgbuf.buf,
             .msg_controllen = CMSG_LEN(nfd * sizeof(int))
         };
@@ -1372,6 +1368,38 @@ static ssize_t _XSERVTransSocketWrite (
     }
 #endif
 
+#ifdef WIN32
+    /* no gathering send on winsock here: push out the first non-empty
+       vector, callers advance and retry with the rest */
+    for (int n = 0; n < iovcnt; n++) {
+        if (!iov[n].iov_len)
+            continue;
+        int ret = send ((SOCKET)ciptr->fd, iov[n].iov_base, iov[n].iov_len, 0);
+        if (ret == SOCKET_ERROR) errno = WSAGetLastError();
+        return ret;
+    }
+    return 0;
+#else
+    return writev (ciptr->fd, iov, iovcnt);
+#endif
+}
+
+static ssize_t _XSERVTransSocketWrite (
+    XtransConnInfo ciptr, const char *buf, size_t size)
+{
+    prmsg (2,"SocketWrite(%d,%p,%lu)\n", ciptr->fd, (void *) buf, (unsigned long)size);
+
+#if XTRANS_SEND_FDS
+    if (ciptr->send_fds)
+    {
+        struct iovec iov = {
+            .iov_len = size,
+            .iov_base = (char*)buf,
+        };
+        return _XSERVTransSocketWritev (ciptr, &iov, 1);
+    }
+#endif
+
 #ifdef WIN32
     int ret = send ((SOCKET)ciptr->fd, buf, size, 0);
     if (ret == SOCKET_ERROR) errno = WSAGetLastError();
@@ -1475,6 +1503,7 @@ static Xtransport _XSERVTransSocketTCPFuncs = {
 	_XSERVTransSocketINETAccept,
 	_XSERVTransSocketRead,
 	_XSERVTransSocketWrite,
+	_XSERVTransSocketWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransSocketSendFdInvalid,
 	_XSERVTransSocketRecvFdInvalid,
@@ -1497,6 +1526,7 @@ static Xtransport _XSERVTransSocketINETFuncs = {
 	_XSERVTransSocketINETAccept,
 	_XSERVTransSocketRead,
 	_XSERVTransSocketWrite,
+	_XSERVTransSocketWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransSocketSendFdInvalid,
 	_XSERVTransSocketRecvFdInvalid,
@@ -1520,6 +1550,7 @@ static Xtransport _XSERVTransSocketINET6Funcs = {
 	_XSERVTransSocketINETAccept,
 	_XSERVTransSocketRead,
 	_XSERVTransSocketWrite,
+	_XSERVTransSocketWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransSocketSendFdInvalid,
 	_XSERVTransSocketRecvFdInvalid,
@@ -1550,6 +1581,7 @@ static Xtransport _XSERVTransSocketLocalFuncs = {
 	_XSERVTransSocketUNIXAccept,
 	_XSERVTransSocketRead,
 	_XSERVTransSocketWrite,
+	_XSERVTransSocketWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransSocketSendFd,
 	_XSERVTransSocketRecvFd,
@@ -1584,6 +1616,7 @@ static Xtransport _XSERVTransSocketUNIXFuncs = {
 	_XSERVTransSocketUNIXAccept,
 	_XSERVTransSocketRead,
 	_XSERVTransSocketWrite,
+	_XSERVTransSocketWritev,
 #if XTRANS_SEND_FDS
 	_XSERVTransSocketSendFd,
 	_XSERVTransSocketRecvFd,
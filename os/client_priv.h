@@ -47,9 +47,41 @@ Bool AddClientOnOpenFD(int fd);
 void ListenOnOpenFD(int fd, int noxauth);
 int ReadRequestFromClient(struct _Client *client);
 int WriteFdToClient(struct _Client *client, int fd, Bool do_close);
+
+/*
+ * write a malloc()ed buffer to client, taking over ownership of it.
+ * large buffers are sent without copying them into the output buffer
+ * and freed once written; the caller must not touch buf afterwards.
+ *
+ * @param client the client to write to
+ * @param count  number of bytes in buf (padded to 4 bytes on the wire)
+ * @param buf    buffer to send and release, may be NULL if count is 0
+ * @return count on success, -1 if the client has been aborted
+ */
+int WriteToClientNoCopy(struct _Client *client, int count, void *buf);
 Bool InsertFakeRequest(struct _Client *client, char *data, int count);
 void FlushAllOutput(void);
 void FlushIfCriticalOutputPending(void);
+
+/*
+ * @brief collect output of local clients instead of flushing it right away
+ *
+ * Batches nest; the outermost OutputBatchEnd() flushes the local clients
+ * which got output in between.
+ */
+void OutputBatchBegin(void);
+void OutputBatchEnd(void);
+
+/* the last write to the client was a single event, see below */
+void OutputBatchMarkEvent(struct _Client *client);
+
+/*
+ * @brief the client's last marked event, if it's still in the buffer
+ *
+ * @return the event, which may be overwritten, or NULL if not in a batch,
+ *         anything else has been written since or the output is recorded
+ */
+void *OutputBatchLastEvent(struct _Client *client);
 void ResetOsBuffers(void);
 void NotifyParentProcess(void);
 void CreateWellKnownSockets(void);
@@ -61,6 +61,7 @@ SOFTWARE.
 #include <X11/Xwinsock.h>
 #endif
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "os/Xtrans.h"
@@ -95,17 +96,40 @@ typedef struct _connectionInput {
     unsigned int ignoreBytes;   /* bytes to ignore before the next request */
 } ConnectionInput;
 
+/*
+ * Data queued behind the output buffer.  Large payloads handed over via
+ * WriteToClientNoCopy() are referenced, not copied (size == 0); small
+ * writes arriving while references are still pending are copied into
+ * chunks of their own (size > 0) so the stream keeps its order.  Chunk
+ * data is owned by the chunk and freed once it has been written out or
+ * the connection goes away.
+ */
+typedef struct _outputChunk {
+    struct _outputChunk *next;
+    unsigned char *data;
+    size_t size;                /* allocated size of data, 0 if referenced */
+    size_t count;               /* payload bytes in data */
+    size_t written;             /* bytes (payload and pad) already sent */
+    int pad;                    /* zero bytes to send after the payload */
+} OutputChunk;
+
 typedef struct _connectionOutput {
     struct _connectionOutput *next;
     unsigned char *buf;
     int size;
     int count;
+    OutputChunk *chunks;        /* sent after buf, in order */
+    OutputChunk *lastChunk;
+    int lastEvent;              /* count right after the last event written
+                                   in an output batch, 0 if none */
 } ConnectionOutput;
 
 static ConnectionInputPtr AllocateInputBuffer(void);
 static ConnectionOutputPtr AllocateOutputBuffer(void);
 
 static Bool CriticalOutputPending;
+static int OutputBatching;      /* nesting depth of OutputBatchBegin() */
+static Bool OutputBatchDeferred;        /* skipped flushing a local client */
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
@@ -123,6 +147,16 @@ static OsCommPtr AvailableInput = (OsCommPtr) NULL;
 #define BUFSIZE 16384
 #define BUFWATERMARK 32768
 
+/* input buffers grow up to that size for clients sending large bursts */
+#define INPUT_BUFSIZE_MAX (8 * BUFSIZE)
+/* drained for this long, grown input buffers are shrunk back */
+#define INPUT_IDLE_MS 1000
+
+/* payloads below this are cheaper to copy than to reference */
+#define ZEROCOPY_MIN BUFSIZE
+/* max. number of vectors handed to one writev() call */
+#define OUTPUT_IOV_MAX 64
+
 /*
  *   A lot of the code in this file manipulates a ConnectionInputPtr:
  *
@@ -201,6 +235,71 @@ YieldControlDeath(void)
     timesThisConnection = 0;
 }
 
+/*
+ * Input buffer size fitting the amount of data the client usually sends
+ * at once: clients which keep filling up their buffer get a larger one,
+ * so they're served with fewer reads and fewer trips through Dispatch().
+ */
+static int
+InputBufferTarget(OsCommPtr oc)
+{
+    int target = BUFSIZE;
+
+    while (target < INPUT_BUFSIZE_MAX && target < 2 * oc->input_burst)
+        target <<= 1;
+    return target;
+}
+
+/*
+ * Clients often go quiet right after a burst, waiting for a reply or for
+ * the user.  Their grown buffers are given back once they've been drained
+ * for INPUT_IDLE_MS; clients which keep streaming keep theirs.
+ */
+static OsTimerPtr idleInputTimer;
+static Bool idleInputPending;
+
+static CARD32
+ShrinkIdleInputs(OsTimerPtr timer, CARD32 now, void *arg)
+{
+    CARD32 next = 0;
+
+    for (int i = 1; i < currentMaxClients; i++) {
+        OsCommPtr oc;
+        ConnectionInputPtr oci;
+        char *ibuf;
+
+        if (!clients[i] || !(oc = clients[i]->osPrivate) ||
+            !(oci = oc->input) || oci->size <= BUFSIZE || oci->bufcnt)
+            continue;
+        if (now - oc->input_idle < INPUT_IDLE_MS) {
+            CARD32 left = INPUT_IDLE_MS - (now - oc->input_idle);
+
+            if (!next || left < next)
+                next = left;
+            continue;
+        }
+        if ((ibuf = (char *) realloc(oci->buffer, BUFSIZE))) {
+            oci->buffer = oci->bufptr = ibuf;
+            oci->size = BUFSIZE;
+        }
+        oc->input_burst = 0;
+    }
+    idleInputPending = next != 0;
+    return next;
+}
+
+/* called when a grown input buffer has been drained and nothing is left */
+static void
+InputBufferIdle(OsCommPtr oc)
+{
+    oc->input_idle = GetTimeInMillis();
+    if (!idleInputPending) {
+        idleInputTimer = TimerSet(idleInputTimer, 0, INPUT_IDLE_MS,
+                                  ShrinkIdleInputs, NULL);
+        idleInputPending = idleInputTimer != NULL;
+    }
+}
+
 /* If an input buffer was empty, either free it if it is too big or link it
  * into our list of free input buffers.  This means that different clients can
  * share the same input buffer (at different times).  This was done to save
@@ -213,15 +312,19 @@ NextAvailableInput(OsCommPtr oc)
         if (AvailableInput != oc) {
             ConnectionInputPtr aci = AvailableInput->input;
 
-            if (aci->size > BUFWATERMARK) {
+            if (aci->size > BUFWATERMARK &&
+                aci->size > InputBufferTarget(AvailableInput)) {
                 free(aci->buffer);
                 free(aci);
+                AvailableInput->input = NULL;
             }
-            else {
+            else if (aci->size <= BUFSIZE) {
                 aci->next = FreeInputs;
                 FreeInputs = aci;
+                AvailableInput->input = NULL;
             }
-            AvailableInput->input = NULL;
+            /* else it has been grown for this client's bursts, keep it:
+               it's shrunk once they're over, or the client goes idle */
         }
         AvailableInput = NULL;
     }
@@ -357,10 +460,23 @@ ReadRequestFromClient(ClientPtr client)
             YieldControlDeath();
             return -1;
         }
+        if (oci->size < InputBufferTarget(oc)) {
+            /* client keeps sending more than fits, read it in one go */
+            const int target = InputBufferTarget(oc);
+            char *ibuf = (char *) realloc(oci->buffer, target);
+
+            if (ibuf) {
+                oci->bufptr = ibuf + (oci->bufptr - oci->buffer);
+                oci->buffer = ibuf;
+                oci->size = target;
+            }
+        }
         result = _XSERVTransRead(oc->trans_conn, oci->buffer + oci->bufcnt,
                                  oci->size - oci->bufcnt);
         if (result <= 0) {
             if ((result < 0) && ETEST(errno)) {
+                if (!gotnow && oci->size > BUFSIZE)
+                    InputBufferIdle(oc);
                 mark_client_not_ready(client);
                 YieldControlNoInput(client);
                 return 0;
@@ -370,14 +486,16 @@ ReadRequestFromClient(ClientPtr client)
         }
         oci->bufcnt += result;
         gotnow += result;
-        /* free up some space after huge requests */
-        if ((oci->size > BUFWATERMARK) &&
-            (oci->bufcnt < BUFSIZE) && (needed < BUFSIZE)) {
+        oc->input_burst = (3 * oc->input_burst + result) / 4;
+        /* free up some space after huge requests and bursts */
+        const int target = InputBufferTarget(oc);
+        if ((oci->size > target) &&
+            (oci->bufcnt < target) && (needed < target)) {
             char *ibuf;
 
-            ibuf = (char *) realloc(oci->buffer, BUFSIZE);
+            ibuf = (char *) realloc(oci->buffer, target);
             if (ibuf) {
-                oci->size = BUFSIZE;
+                oci->size = target;
                 oci->buffer = ibuf;
                 oci->bufptr = ibuf + oci->bufcnt - gotnow;
             }
@@ -651,6 +769,71 @@ SetCriticalOutputPending(void)
     CriticalOutputPending = TRUE;
 }
 
+/*****************
+ * Output batches:
+ *    Local clients normally have their output flushed with the first
+ *    write into an empty buffer, so a burst of input events costs one
+ *    writev() per event and client.  Within a batch their output is
+ *    collected like everybody else's and OutputBatchEnd() flushes it,
+ *    one write per client.  While a client's last output is an event
+ *    written in the current batch, the caller can still replace it,
+ *    e.g. to merge consecutive motion events.
+ *****************/
+
+void
+OutputBatchBegin(void)
+{
+    OutputBatching++;
+}
+
+void
+OutputBatchEnd(void)
+{
+    ClientPtr client, tmp;
+
+    if (--OutputBatching || !OutputBatchDeferred)
+        return;
+    OutputBatchDeferred = FALSE;
+
+    /* what would have been flushed right away without the batch */
+    xorg_list_for_each_entry_safe(client, tmp, &output_pending_clients, output_pending) {
+        if (!client->clientGone && client->local)
+            FlushClient(client, (OsCommPtr) client->osPrivate);
+    }
+    if (!any_output_pending()) {
+        CriticalOutputPending = FALSE;
+        NewOutputPending = FALSE;
+    }
+}
+
+void
+OutputBatchMarkEvent(ClientPtr who)
+{
+    OsCommPtr oc = who->osPrivate;
+    ConnectionOutputPtr oco;
+
+    if (!OutputBatching || who->clientGone || !(oco = oc->output))
+        return;
+    /* unless it's been flushed (partially) already */
+    if (!oco->chunks && oco->count >= (int) sizeof(xEvent))
+        oco->lastEvent = oco->count;
+}
+
+void *
+OutputBatchLastEvent(ClientPtr who)
+{
+    OsCommPtr oc = who->osPrivate;
+    ConnectionOutputPtr oco;
+
+    /* RECORD has seen the event already */
+    if (!OutputBatching || ReplyCallback || who->clientGone ||
+        !(oco = oc->output))
+        return NULL;
+    if (!oco->lastEvent || oco->lastEvent != oco->count || oco->chunks)
+        return NULL;
+    return oco->buf + oco->count - sizeof(xEvent);
+}
+
 /*****************
  * AbortClient:
  *    When a write error occurs to a client, close
@@ -692,6 +875,60 @@ static bool OutputEnsureBuffer(ClientPtr who, OsCommPtr oc)
     return false;
 }
 
+static void
+OutputFreeChunks(ConnectionOutputPtr oco)
+{
+    OutputChunk *chunk;
+
+    while ((chunk = oco->chunks)) {
+        oco->chunks = chunk->next;
+        free(chunk->data);
+        free(chunk);
+    }
+    oco->lastChunk = NULL;
+}
+
+static inline void
+OutputAppendChunk(ConnectionOutputPtr oco, OutputChunk *chunk)
+{
+    chunk->next = NULL;
+    if (oco->lastChunk)
+        oco->lastChunk->next = chunk;
+    else
+        oco->chunks = chunk;
+    oco->lastChunk = chunk;
+}
+
+/*
+ * queue a copy of buf (plus padding) behind the pending chunks,
+ * filling up the last copied chunk first.
+ */
+static bool
+OutputQueueCopy(ConnectionOutputPtr oco, const void *buf, size_t count,
+                size_t padBytes)
+{
+    OutputChunk *chunk = oco->lastChunk;
+    const size_t needed = count + padBytes;
+
+    if (!chunk || !chunk->size || chunk->count + needed > chunk->size) {
+        const size_t size = max(needed, BUFSIZE);
+
+        if (!(chunk = calloc(1, sizeof(OutputChunk))))
+            return false;
+        if (!(chunk->data = malloc(size))) {
+            free(chunk);
+            return false;
+        }
+        chunk->size = size;
+        OutputAppendChunk(oco, chunk);
+    }
+
+    memcpy(chunk->data + chunk->count, buf, count);
+    memset(chunk->data + chunk->count + count, 0, padBytes);
+    chunk->count += needed;
+    return true;
+}
+
 static inline int
 memcpy_and_flush(ClientPtr who, OsCommPtr oc, const void* extra_buf, size_t extra_size, size_t padsize)
 {
@@ -757,6 +994,35 @@ OutputBufferMakeRoomAndFlush(ClientPtr who, OsCommPtr oc, const void* extra_buf,
     return memcpy_and_flush(who, oc, extra_buf, extra_size, padsize);
 }
 
+static void
+CallReplyCallback(ClientPtr who, const char *buf, int count, int padBytes)
+{
+    ReplyInfoRec replyinfo;
+
+    replyinfo.client = who;
+    replyinfo.replyData = buf;
+    replyinfo.dataLenBytes = count + padBytes;
+    replyinfo.padBytes = padBytes;
+    if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
+        who->replyBytesRemaining -= count + padBytes;
+        replyinfo.startOfReply = FALSE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+    else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
+        CARD32 replylen;
+        unsigned long bytesleft;
+
+        replylen = ((const xGenericReply *) buf)->length;
+        if (who->swapped)
+            swapl(&replylen);
+        bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
+        replyinfo.startOfReply = TRUE;
+        replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
+        CallCallbacks((&ReplyCallback), (void *) &replyinfo);
+    }
+}
+
 /*****************
  * WriteToClient
  *    Copies buf into ClientPtr.buf if it fits (with padding), else
@@ -827,32 +1093,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 
     padBytes = padding_for_int32(count);
 
-    if (ReplyCallback) {
-        ReplyInfoRec replyinfo;
-
-        replyinfo.client = who;
-        replyinfo.replyData = buf;
-        replyinfo.dataLenBytes = count + padBytes;
-        replyinfo.padBytes = padBytes;
-        if (who->replyBytesRemaining) { /* still sending data of an earlier reply */
-            who->replyBytesRemaining -= count + padBytes;
-            replyinfo.startOfReply = FALSE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-        else if (who->clientState == ClientStateRunning && buf[0] == X_Reply) { /* start of new reply */
-            CARD32 replylen;
-            unsigned long bytesleft;
-
-            replylen = ((const xGenericReply *) buf)->length;
-            if (who->swapped)
-                swapl(&replylen);
-            bytesleft = (replylen * 4) + SIZEOF(xReply) - count - padBytes;
-            replyinfo.startOfReply = TRUE;
-            replyinfo.bytesRemaining = who->replyBytesRemaining = bytesleft;
-            CallCallbacks((&ReplyCallback), (void *) &replyinfo);
-        }
-    }
+    if (ReplyCallback)
+        CallReplyCallback(who, buf, count, padBytes);
 #ifdef DEBUG_COMMUNICATION
     else if (multicount) {
         if (who->replyBytesRemaining) {
@@ -873,7 +1115,28 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
 
     ConnectionOutputPtr oco = oc->output;
 
-    if ((oco->count == 0 && who->local) || oco->count + count + padBytes > oco->size) {
+    oco->lastEvent = 0;         /* something else follows it now */
+    if (oco->chunks) {
+        /* must not overtake data still queued by reference */
+        if (!OutputQueueCopy(oco, buf, count, padBytes)) {
+            AbortClient(who);
+            dixMarkClientException(who);
+            return -1;
+        }
+        NewOutputPending = TRUE;
+        output_pending_mark(who);
+        return count;
+    }
+
+    /* local clients get their output right away, unless in a batch */
+    Bool flushNow = oco->count == 0 && who->local;
+
+    if (flushNow && OutputBatching) {
+        OutputBatchDeferred = TRUE;
+        flushNow = FALSE;
+    }
+
+    if (flushNow || oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
             CriticalOutputPending = FALSE;
@@ -893,6 +1156,63 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
     return count;
 }
 
+ /********************
+ * WriteToClientNoCopy
+ *    Like WriteToClient, but takes over ownership of buf, which must
+ *    have been allocated by malloc().  Large payloads are not copied
+ *    into the output buffer: they're queued by reference behind it and
+ *    written straight out of buf, which gets freed once it has been
+ *    sent completely (or the client is gone).  Small payloads are just
+ *    copied and freed right away.  Either way, the caller must not touch
+ *    buf anymore after the call.
+ **********************/
+
+int
+WriteToClientNoCopy(ClientPtr who, int count, void *buf)
+{
+    OsCommPtr oc;
+    OutputChunk *chunk;
+    int padBytes;
+    int ret;
+
+    if (count < ZEROCOPY_MIN || !who || who == serverClient ||
+        who->clientGone || in_input_thread()) {
+        ret = WriteToClient(who, count, buf);
+        free(buf);
+        return ret;
+    }
+
+    oc = who->osPrivate;
+    padBytes = padding_for_int32(count);
+
+    if (ReplyCallback)
+        CallReplyCallback(who, buf, count, padBytes);
+
+    if (!OutputEnsureBuffer(who, oc)) {
+        free(buf);
+        return -1;
+    }
+
+    if (!(chunk = calloc(1, sizeof(OutputChunk)))) {
+        free(buf);
+        AbortClient(who);
+        dixMarkClientException(who);
+        return -1;
+    }
+    chunk->data = buf;
+    chunk->count = count;
+    chunk->pad = padBytes;
+    OutputAppendChunk(oc->output, chunk);
+    oc->output->lastEvent = 0;
+
+    output_pending_clear(who);
+    if (!any_output_pending()) {
+        CriticalOutputPending = FALSE;
+        NewOutputPending = FALSE;
+    }
+    return (FlushClient(who, oc) == -1) ? -1 : count;
+}
+
  /********************
  * FlushClient()
  *    If the client isn't keeping up with us, then we try to continue
@@ -901,13 +1221,20 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
  *    a permanent error, or we can't allocate any more space, we then
  *    close the connection.
  *
+ *    The output buffer and the chunks queued behind it are gathered
+ *    into one writev() call; chunks are released as soon as they've
+ *    been written completely.
+ *
  **********************/
 
 int
 FlushClient(ClientPtr who, OsCommPtr oc)
 {
+    static char padding[3];
     ConnectionOutputPtr oco = oc->output;
     XtransConnInfo trans_conn = oc->trans_conn;
+    struct iovec iov[OUTPUT_IOV_MAX];
+    OutputChunk *chunk;
 
     /* if no output buffer, then nothing to do */
     if (!oco)
@@ -918,24 +1245,70 @@ FlushClient(ClientPtr who, OsCommPtr oc)
         goto abortClient;
     }
 
-    size_t written = 0;
-    size_t notWritten = oco->count;
-
     /* do nothing if we haven't anything to write */
-    if (!notWritten)
+    if (!oco->count && !oco->chunks)
         return 0;
+    oco->lastEvent = 0;
 
     if (FlushCallback)
         CallCallbacks(&FlushCallback, who);
 
-    size_t todo = notWritten; /* trying to write that much this time */
-    while (notWritten) {
+    const size_t bufCount = oco->count;
+    size_t written = 0;         /* bytes of oco->buf already sent */
+    size_t limit = SIZE_MAX;    /* trying to write at most that much */
+    while (written < bufCount || oco->chunks) {
+        size_t todo = 0;
+        int iovcnt = 0;
+
+        if (written < bufCount) {
+            iov[0].iov_base = (char *) oco->buf + written;
+            iov[0].iov_len = todo = min(bufCount - written, limit);
+            iovcnt = 1;
+        }
+
+        /* each chunk takes up to two vectors: payload and padding */
+        for (chunk = oco->chunks;
+             chunk && iovcnt < OUTPUT_IOV_MAX - 1 && todo < limit;
+             chunk = chunk->next) {
+            if (chunk->written < chunk->count) {
+                iov[iovcnt].iov_base = (char *) chunk->data + chunk->written;
+                iov[iovcnt].iov_len = min(chunk->count - chunk->written,
+                                          limit - todo);
+                todo += iov[iovcnt++].iov_len;
+            }
+            const size_t padLeft = chunk->count + chunk->pad -
+                                   max(chunk->written, chunk->count);
+            if (padLeft && todo < limit) {
+                iov[iovcnt].iov_base = padding;
+                iov[iovcnt].iov_len = min(padLeft, limit - todo);
+                todo += iov[iovcnt++].iov_len;
+            }
+        }
+
         errno = 0;
-        ssize_t len = _XSERVTransWrite(trans_conn, ((const char*)oco->buf) + written, todo);
+        ssize_t len = _XSERVTransWritev(trans_conn, iov, iovcnt);
         if (len >= 0) {
-            written += len;
-            notWritten -= len;
-            todo = notWritten;
+            size_t done = len;
+
+            if (written < bufCount) {
+                size_t n = min(done, bufCount - written);
+                written += n;
+                done -= n;
+            }
+            while ((chunk = oco->chunks)) {
+                size_t left = chunk->count + chunk->pad - chunk->written;
+                if (done < left) {
+                    chunk->written += done;
+                    break;
+                }
+                done -= left;
+                oco->chunks = chunk->next;
+                if (!oco->chunks)
+                    oco->lastChunk = NULL;
+                free(chunk->data);
+                free(chunk);
+            }
+            limit = SIZE_MAX;
         }
         else if (ETEST(errno)
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
@@ -951,10 +1324,8 @@ FlushClient(ClientPtr who, OsCommPtr oc)
                 oco->count -= written;
                 memmove((char *) oco->buf,
                         (char *) oco->buf + written, oco->count);
-                written = 0;
             }
 
-            oco->count = notWritten;
             ospoll_listen(server_poll, oc->fd, X_NOTIFY_WRITE);
 
             /* return only the amount explicitly requested */
@@ -963,7 +1334,7 @@ FlushClient(ClientPtr who, OsCommPtr oc)
 #ifdef EMSGSIZE                 /* check for another brain-damaged OS bug */
         else if (errno == EMSGSIZE) {
             /* making separate try with half of the size */
-            todo /= 2;
+            limit = todo / 2;
         }
 #endif
         else {
@@ -990,6 +1361,7 @@ abortClient:
     AbortClient(who);
     dixMarkClientException(who);
     oco->count = 0;
+    OutputFreeChunks(oco);
     return -1;
 }
 
@@ -1051,6 +1423,7 @@ FreeOsBuffers(OsCommPtr oc)
         }
     }
     if ((oco = oc->output)) {
+        OutputFreeChunks(oco);
         if (FreeOutputs) {
             free(oco->buf);
             free(oco);
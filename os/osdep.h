@@ -91,6 +91,8 @@ typedef struct _osComm {
     CARD32 conn_time;           /* timestamp if not established, else 0  */
     struct _XtransConnInfo *trans_conn; /* transport connection object */
     int flags;
+    int input_burst;            /* smoothed amount of data per read */
+    CARD32 input_idle;          /* when its grown input buffer ran dry */
 } OsCommRec, *OsCommPtr;
 
 #define OS_COMM_GRAB_IMPERVIOUS 1
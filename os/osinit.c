@@ -63,6 +63,7 @@ SOFTWARE.
 #include "os/log_priv.h"
 #include "os/osdep.h"
 #include "os/serverlock.h"
+#include "os/threadpool_priv.h"
 
 #include "misc.h"
 #include "os.h"
@@ -231,6 +232,7 @@ void
 OsCleanup(Bool terminating)
 {
     if (terminating) {
+        ThreadPoolServerFini();
         UnlockServer();
     }
 }
@@ -54,6 +54,13 @@
 #include <sys/epoll.h>
 #define EPOLL           1
 #define HAVE_OSPOLL     1
+#if HAVE_LIBURING
+#include <errno.h>
+#include <poll.h>
+#include <liburing.h>
+#include "os.h"
+#define URING           1
+#endif
 #endif
 
 #if !HAVE_OSPOLL
@@ -93,6 +100,12 @@ struct ospollfd {
     void                (*callback)(int fd, int xevents, void *data);
     void                *data;
     struct xorg_list    deleted;
+#if URING
+    unsigned int        gen;            /* of the poll armed last */
+    unsigned int        armed;          /* its poll events, 0 if none */
+    int                 inflight;       /* polls the ring still has */
+    struct xorg_list    pending;        /* to be armed before waiting */
+#endif
 };
 
 struct ospoll {
@@ -101,10 +114,232 @@ struct ospoll {
     int                 num;
     int                 size;
     struct xorg_list    deleted;
+#if URING
+    struct io_uring     ring;
+    bool                uring;
+    struct xorg_list    pending;
+#endif
 };
 
 #endif
 
+#if URING
+
+/*
+ * io_uring-based implementation, on top of the epoll one
+ *
+ * Every ospoll_listen(), ospoll_mute() or re-arm costs epoll an
+ * epoll_ctl() call of its own.  Here they only put the fd on a pending
+ * list; right before waiting, each pending fd gets at most one one-shot
+ * poll request for the events it ends up with, and those go to the kernel
+ * along with the wait itself, all in a single io_uring_enter().  Being
+ * one-shot, polls work like event ports: level triggered fds get re-armed
+ * after their callback, edge triggered ones by ospoll_reset_events() and
+ * interest changes.  Polls for more events than wanted are left alone,
+ * what they report is masked instead.
+ *
+ * Where the kernel refuses to set up a ring, ospoll falls back to epoll.
+ */
+
+#define URING_ENTRIES   256
+
+/*
+ * A poll's user_data is its ospollfd, which calloc() aligns to at least
+ * 8 bytes, with the low bits telling the poll armed last apart from the
+ * ones cancelled before it.
+ */
+#define URING_GEN_MASK  7
+
+static bool
+uring_init(struct ospoll *ospoll)
+{
+    if (io_uring_queue_init(URING_ENTRIES, &ospoll->ring, 0) < 0)
+        return false;
+    ospoll->uring = true;
+    ospoll->epoll_fd = -1;
+    xorg_list_init(&ospoll->pending);
+    return true;
+}
+
+static struct io_uring_sqe *
+uring_get_sqe(struct ospoll *ospoll)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&ospoll->ring);
+
+    /* submission queue full, hand it to the kernel early */
+    if (!sqe) {
+        io_uring_submit(&ospoll->ring);
+        sqe = io_uring_get_sqe(&ospoll->ring);
+    }
+    return sqe;
+}
+
+static uint64_t
+uring_user_data(struct ospollfd *osfd)
+{
+    return (uintptr_t) osfd | (osfd->gen & URING_GEN_MASK);
+}
+
+static void
+uring_disarm(struct ospoll *ospoll, struct ospollfd *osfd)
+{
+    struct io_uring_sqe *sqe;
+
+    if (!osfd->armed)
+        return;
+
+    sqe = uring_get_sqe(ospoll);
+    if (!sqe)
+        return;
+    io_uring_prep_poll_remove(sqe, uring_user_data(osfd));
+    io_uring_sqe_set_data64(sqe, 0);
+    osfd->armed = 0;
+    osfd->gen++;
+}
+
+/* (re)arms osfd with the next submission */
+static void
+uring_update(struct ospoll *ospoll, struct ospollfd *osfd)
+{
+    if (xorg_list_is_empty(&osfd->pending))
+        xorg_list_append(&osfd->pending, &ospoll->pending);
+}
+
+static void
+uring_arm(struct ospoll *ospoll, struct ospollfd *osfd)
+{
+    struct io_uring_sqe *sqe;
+    unsigned int events = 0;
+
+    if (osfd->xevents & X_NOTIFY_READ)
+        events |= POLLIN;
+    if (osfd->xevents & X_NOTIFY_WRITE)
+        events |= POLLOUT;
+    if (osfd->armed && !(events & ~osfd->armed))
+        return;
+
+    uring_disarm(ospoll, osfd);
+    if (!events)
+        return;
+
+    sqe = uring_get_sqe(ospoll);
+    if (!sqe)
+        return;
+    io_uring_prep_poll_add(sqe, osfd->fd, events);
+    io_uring_sqe_set_data64(sqe, uring_user_data(osfd));
+    osfd->armed = events;
+    osfd->inflight++;
+}
+
+static void
+uring_arm_pending(struct ospoll *ospoll)
+{
+    struct ospollfd *osfd, *tmp;
+
+    xorg_list_for_each_entry_safe(osfd, tmp, &ospoll->pending, pending) {
+        xorg_list_del(&osfd->pending);
+        uring_arm(ospoll, osfd);
+    }
+}
+
+/* dispatches what completed, returns how many fds were ready */
+static int
+uring_reap(struct ospoll *ospoll)
+{
+    struct io_uring_cqe *cqe;
+    unsigned int head, seen = 0;
+    int nready = 0;
+
+    io_uring_for_each_cqe(&ospoll->ring, head, cqe) {
+        uint64_t user_data = io_uring_cqe_get_data64(cqe);
+        struct ospollfd *osfd =
+            (struct ospollfd *) (uintptr_t) (user_data & ~URING_GEN_MASK);
+        int xevents = 0;
+
+        seen++;
+        /* completion of a poll removal */
+        if (!osfd)
+            continue;
+
+        osfd->inflight--;
+        /* cancelled by uring_disarm(), whatever generation it was */
+        if (cqe->res == -ECANCELED || !osfd->armed ||
+            (user_data & URING_GEN_MASK) != (osfd->gen & URING_GEN_MASK))
+            continue;
+        osfd->armed = 0;
+
+        if (cqe->res < 0)
+            xevents |= X_NOTIFY_ERROR;
+        else {
+            if (cqe->res & POLLIN)
+                xevents |= X_NOTIFY_READ;
+            if (cqe->res & POLLOUT)
+                xevents |= X_NOTIFY_WRITE;
+            if (cqe->res & ~(POLLIN|POLLOUT))
+                xevents |= X_NOTIFY_ERROR;
+        }
+        xevents &= osfd->xevents | X_NOTIFY_ERROR;
+
+        /* only events muted since the poll was armed */
+        if (!xevents) {
+            uring_update(ospoll, osfd);
+            continue;
+        }
+
+        nready++;
+        if (osfd->callback)
+            osfd->callback(osfd->fd, xevents, osfd->data);
+
+        if (osfd->callback && osfd->trigger == ospoll_trigger_level &&
+            !osfd->armed)
+            uring_update(ospoll, osfd);
+    }
+    io_uring_cq_advance(&ospoll->ring, seen);
+
+    return nready;
+}
+
+static int
+uring_wait(struct ospoll *ospoll, int timeout)
+{
+    CARD32 end = GetTimeInMillis() + timeout;
+    struct io_uring_cqe *cqe;
+    int nready;
+    int ret;
+
+    /*
+     * Removals, cancelled polls and polls for events muted meanwhile wake
+     * it up with nothing to dispatch, which doesn't mean the timeout
+     * expired.  Waiting again is only for what's left of it though.
+     */
+    do {
+        struct __kernel_timespec ts = {
+            .tv_sec = timeout / 1000,
+            .tv_nsec = (timeout % 1000) * 1000000
+        };
+
+        uring_arm_pending(ospoll);
+        ret = io_uring_submit_and_wait_timeout(&ospoll->ring, &cqe, 1,
+                                               timeout < 0 ? NULL : &ts,
+                                               NULL);
+        if (ret < 0 && ret != -ETIME) {
+            errno = -ret;
+            return -1;
+        }
+        nready = uring_reap(ospoll);
+
+        if (timeout > 0) {
+            timeout = (int) (end - GetTimeInMillis());
+            if (timeout < 0)
+                timeout = 0;
+        }
+    } while (nready == 0 && ret != -ETIME);
+
+    return nready;
+}
+
+#endif
+
 #if POLL
 
 /* poll-based implementation */
@@ -163,6 +398,10 @@ ospoll_clean_deleted(struct ospoll *ospoll)
     struct ospollfd     *osfd, *tmp;
 
     xorg_list_for_each_entry_safe(osfd, tmp, &ospoll->deleted, deleted) {
+#if URING
+        if (osfd->inflight)
+            continue;
+#endif
         xorg_list_del(&osfd->deleted);
         free(osfd);
     }
@@ -202,6 +441,7 @@ array_delete(void *base, size_t num, size_t size, size_t pos)
             (num - pos - 1) * size);
 }
 
+bool ospoll_use_uring = true;
 
 struct ospoll *
 ospoll_create(void)
@@ -231,12 +471,16 @@ ospoll_create(void)
     struct ospoll *ospoll = calloc(1, sizeof (struct ospoll));
     if (ospoll == NULL)
         return NULL;
+    xorg_list_init(&ospoll->deleted);
+#if URING
+    if (ospoll_use_uring && uring_init(ospoll))
+        return ospoll;
+#endif
     ospoll->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
     if (ospoll->epoll_fd < 0) {
         free (ospoll);
         return NULL;
     }
-    xorg_list_init(&ospoll->deleted);
     return ospoll;
 #endif
 #if POLL
@@ -258,6 +502,17 @@ ospoll_destroy(struct ospoll *ospoll)
 #if EPOLL || PORT
     if (ospoll) {
         assert (ospoll->num == 0);
+#if URING
+        if (ospoll->uring) {
+            struct ospollfd *osfd;
+
+            /* the ring is gone, and so are the polls it had */
+            io_uring_queue_exit(&ospoll->ring);
+            xorg_list_for_each_entry(osfd, &ospoll->deleted, deleted)
+                osfd->inflight = 0;
+        }
+        else
+#endif
         close(ospoll->epoll_fd);
         ospoll_clean_deleted(ospoll);
         free(ospoll->fds);
@@ -368,12 +623,19 @@ ospoll_add(struct ospoll *ospoll, int fd,
         ev.data.ptr = osfd;
         if (trigger == ospoll_trigger_edge)
             ev.events |= EPOLLET;
-        if (epoll_ctl(ospoll->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        if (
+#if URING
+            !ospoll->uring &&
+#endif
+            epoll_ctl(ospoll->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
             free(osfd);
             return false;
         }
         osfd->fd = fd;
         osfd->xevents = 0;
+#if URING
+        xorg_list_init(&osfd->pending);
+#endif
 
         pos = -pos - 1;
         array_insert(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
@@ -451,6 +713,13 @@ ospoll_remove(struct ospoll *ospoll, int fd)
         struct epoll_event ev;
         ev.events = 0;
         ev.data.ptr = osfd;
+#if URING
+        if (ospoll->uring) {
+            xorg_list_del(&osfd->pending);
+            uring_disarm(ospoll, osfd);
+        }
+        else
+#endif
         (void) epoll_ctl(ospoll->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
 
         array_delete(ospoll->fds, ospoll->num, sizeof (ospoll->fds[0]), pos);
@@ -486,6 +755,12 @@ static void
 epoll_mod(struct ospoll *ospoll, struct ospollfd *osfd)
 {
     struct epoll_event ev;
+#if URING
+    if (ospoll->uring) {
+        uring_update(ospoll, osfd);
+        return;
+    }
+#endif
     ev.events = 0;
     if (osfd->xevents & X_NOTIFY_READ)
         ev.events |= EPOLLIN;
@@ -645,6 +920,13 @@ ospoll_wait(struct ospoll *ospoll, int timeout)
     struct epoll_event events[MAX_EVENTS];
     int i;
 
+#if URING
+    if (ospoll->uring) {
+        nready = uring_wait(ospoll, timeout);
+        ospoll_clean_deleted(ospoll);
+        return nready;
+    }
+#endif
     nready = epoll_wait(ospoll->epoll_fd, events, MAX_EVENTS, timeout);
     for (i = 0; i < nready; i++) {
         struct epoll_event *ev = &events[i];
@@ -718,6 +1000,14 @@ ospoll_reset_events(struct ospoll *ospoll, int fd)
 
     epoll_mod(ospoll, ospoll->fds[pos]);
 #endif
+#if URING
+    int pos = ospoll_find(ospoll, fd);
+
+    if (pos < 0 || !ospoll->uring || ospoll->fds[pos]->armed)
+        return;
+
+    uring_update(ospoll, ospoll->fds[pos]);
+#endif
 #if POLL
     int pos = ospoll_find(ospoll, fd);
 
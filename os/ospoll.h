@@ -49,6 +49,12 @@ enum ospoll_trigger {
 struct ospoll *
 ospoll_create(void);
 
+/**
+ * Whether ospoll_create() tries io_uring before epoll, where the server
+ * is built with it.  Defaults to true.
+ */
+extern bool ospoll_use_uring;
+
 /**
  * Destroy an ospoll structure
  *
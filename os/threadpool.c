@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Worker thread pool
+ *
+ * ThreadPoolRun() publishes a job, wakes up the workers and works on it
+ * itself; every thread then keeps taking the next task until there are
+ * none left.  Tasks are expected to be coarse (a tile of a redisplay,
+ * say), so a mutex protecting the task counter is all we need.
+ */
+
+#include <dix-config.h>
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "os/threadpool_priv.h"
+
+#include "misc.h"
+#include "os.h"
+
+#define THREADPOOL_MAX_DEFAULT 8
+
+int WorkerThreads = 0;
+
+static ThreadPoolPtr serverPool;
+static Bool serverPoolFailed;   /* don't try starting it again */
+
+int
+ThreadPoolDefaultThreads(void)
+{
+    if (WorkerThreads > 0)
+        return WorkerThreads;
+#ifdef _SC_NPROCESSORS_ONLN
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpus > 0)
+        return min(cpus, THREADPOOL_MAX_DEFAULT);
+#endif
+    return 1;
+}
+
+ThreadPoolPtr
+ThreadPoolServer(void)
+{
+    if (!serverPool && !serverPoolFailed) {
+        serverPool = ThreadPoolCreate(ThreadPoolDefaultThreads(), "Worker");
+        serverPoolFailed = !serverPool;
+    }
+    return serverPool;
+}
+
+void
+ThreadPoolServerFini(void)
+{
+    ThreadPoolDestroy(serverPool);
+    serverPool = NULL;
+    serverPoolFailed = FALSE;
+}
+
+#ifdef INPUTTHREAD
+
+#include <pthread.h>
+#include <time.h>
+
+typedef struct _ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work;        /* there are tasks to take, or quit */
+    pthread_cond_t done;        /* the last task of a job finished */
+    pthread_t *workers;
+    int nworkers;
+    Bool quit;
+
+    /* the current job, all protected by lock */
+    ThreadPoolTaskProc func;
+    void *data;
+    int ntasks;
+    int next;                   /* next task to hand out */
+    int pending;                /* tasks not finished yet */
+} ThreadPoolRec;
+
+static CARD64 workerCpuNs;
+
+static CARD64
+ThreadPoolThreadCpuTime(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return (CARD64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+    return 0;
+}
+
+CARD64
+ThreadPoolCpuTime(void)
+{
+    return __atomic_load_n(&workerCpuNs, __ATOMIC_RELAXED);
+}
+
+/* called and returns with pool->lock held */
+static void
+ThreadPoolDoTasks(ThreadPoolPtr pool)
+{
+    while (pool->next < pool->ntasks) {
+        ThreadPoolTaskProc func = pool->func;
+        void *data = pool->data;
+        int task = pool->next++;
+
+        pthread_mutex_unlock(&pool->lock);
+        func(data, task);
+        pthread_mutex_lock(&pool->lock);
+
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+    }
+}
+
+static void *
+ThreadPoolWorker(void *arg)
+{
+    ThreadPoolPtr pool = arg;
+    sigset_t set;
+
+    /* signals are for the main thread */
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->quit) {
+        if (pool->next < pool->ntasks) {
+            CARD64 start = ThreadPoolThreadCpuTime();
+
+            ThreadPoolDoTasks(pool);
+            /* still holding the lock, so before ThreadPoolRun() returns */
+            __atomic_add_fetch(&workerCpuNs,
+                               ThreadPoolThreadCpuTime() - start,
+                               __ATOMIC_RELAXED);
+        }
+        else
+            pthread_cond_wait(&pool->work, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPoolPtr
+ThreadPoolCreate(int threads, const char *name)
+{
+    ThreadPoolPtr pool;
+
+    if (threads < 2)
+        return NULL;
+    pool = calloc(1, sizeof(ThreadPoolRec));
+    if (!pool)
+        return NULL;
+    pool->workers = calloc(threads - 1, sizeof(pthread_t));
+    if (!pool->workers) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (; pool->nworkers < threads - 1; pool->nworkers++) {
+        pthread_t *thread = &pool->workers[pool->nworkers];
+
+        if (pthread_create(thread, NULL, ThreadPoolWorker, pool) != 0)
+            break;
+#if defined(HAVE_PTHREAD_SETNAME_NP_WITH_TID)
+        pthread_setname_np(*thread, name);
+#elif defined(HAVE_PTHREAD_SETNAME_NP_WITHOUT_TID)
+        (void) name;        /* can only name the calling thread */
+#endif
+    }
+    if (!pool->nworkers) {
+        ThreadPoolDestroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void
+ThreadPoolDestroy(ThreadPoolPtr pool)
+{
+    if (!pool)
+        return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = TRUE;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->nworkers; i++)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+int
+ThreadPoolThreads(ThreadPoolPtr pool)
+{
+    return pool ? pool->nworkers + 1 : 1;
+}
+
+void
+ThreadPoolRun(ThreadPoolPtr pool, ThreadPoolTaskProc func, void *data,
+              int ntasks)
+{
+    if (!pool || ntasks < 2) {
+        for (int task = 0; task < ntasks; task++)
+            func(data, task);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->ntasks) {
+        /* busy with the job this is part of, or somebody else's */
+        pthread_mutex_unlock(&pool->lock);
+        for (int task = 0; task < ntasks; task++)
+            func(data, task);
+        return;
+    }
+    pool->func = func;
+    pool->data = data;
+    pool->ntasks = ntasks;
+    pool->next = 0;
+    pool->pending = ntasks;
+    pthread_cond_broadcast(&pool->work);
+
+    ThreadPoolDoTasks(pool);
+    while (pool->pending)
+        pthread_cond_wait(&pool->done, &pool->lock);
+
+    pool->func = NULL;
+    pool->data = NULL;
+    pool->ntasks = pool->next = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#else /* INPUTTHREAD */
+
+CARD64
+ThreadPoolCpuTime(void)
+{
+    return 0;
+}
+
+ThreadPoolPtr
+ThreadPoolCreate(int threads, const char *name)
+{
+    return NULL;
+}
+
+void
+ThreadPoolDestroy(ThreadPoolPtr pool)
+{
+}
+
+int
+ThreadPoolThreads(ThreadPoolPtr pool)
+{
+    return 1;
+}
+
+void
+ThreadPoolRun(ThreadPoolPtr pool, ThreadPoolTaskProc func, void *data,
+              int ntasks)
+{
+    for (int task = 0; task < ntasks; task++)
+        func(data, task);
+}
+
+#endif /* INPUTTHREAD */
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+#ifndef _XSERVER_OS_THREADPOOL_PRIV_H
+#define _XSERVER_OS_THREADPOOL_PRIV_H
+
+#include <X11/Xdefs.h>
+#include <X11/Xfuncproto.h>
+#include <X11/Xmd.h>
+
+/*
+ * A small pool of worker threads for splitting up rendering work which
+ * the main thread has to wait for anyway.  The workers never touch any
+ * server state on their own; ThreadPoolRun() hands them independent tasks
+ * and returns once all of them are done.
+ *
+ * Needs the same pthread support as the input thread; without it
+ * ThreadPoolCreate() returns NULL, and ThreadPoolRun() on a NULL pool
+ * just does all the tasks on the calling thread.
+ *
+ * Exported for the shadow module.
+ */
+
+typedef struct _ThreadPool *ThreadPoolPtr;
+
+/* called once for each task, 0 <= task < ntasks, from any thread */
+typedef void (*ThreadPoolTaskProc) (void *data, int task);
+
+extern int WorkerThreads;      /* -workerthreads, 0 for the default */
+
+/* threads to use: -workerthreads, or one per CPU */
+_X_EXPORT int ThreadPoolDefaultThreads(void);
+
+/* below this many pixels, waking up the workers isn't worth it */
+#define THREADPOOL_MIN_AREA     (256 * 256)
+
+/*
+ * The pool everything in the server splits its work up on, created with
+ * ThreadPoolDefaultThreads() threads on first use.  NULL if that's just
+ * one, or the workers can't be started.
+ */
+_X_EXPORT ThreadPoolPtr ThreadPoolServer(void);
+
+/* shuts it down, the next ThreadPoolServer() starts a new one */
+_X_EXPORT void ThreadPoolServerFini(void);
+
+/*
+ * Creates a pool of threads - 1 workers, the thread calling
+ * ThreadPoolRun() being the last one.  NULL if threads < 2 or the
+ * workers can't be started.
+ */
+_X_EXPORT ThreadPoolPtr ThreadPoolCreate(int threads, const char *name);
+_X_EXPORT void ThreadPoolDestroy(ThreadPoolPtr pool);
+
+/* threads working on a ThreadPoolRun(), including the caller */
+_X_EXPORT int ThreadPoolThreads(ThreadPoolPtr pool);
+
+/*
+ * Does all the tasks.  A task running another job on the pool, or another
+ * thread while it's busy, gets that one done on the calling thread.
+ */
+_X_EXPORT void ThreadPoolRun(ThreadPoolPtr pool, ThreadPoolTaskProc func,
+                             void *data, int ntasks);
+
+/*
+ * CPU time in ns the workers of all pools have spent on tasks so far.
+ * It's complete once ThreadPoolRun() returns, so the calling thread can
+ * add what a job cost on other threads to its own CPU time.
+ */
+CARD64 ThreadPoolCpuTime(void);
+
+#endif /* _XSERVER_OS_THREADPOOL_PRIV_H */
@@ -95,8 +95,11 @@ OR PERFORMANCE OF THIS SOFTWARE.
 #endif
 
 #include "dix/dix_priv.h"
+#include "dix/fairsched_priv.h"
 #include "dix/input_priv.h"
+#include "dix/reqprof_priv.h"
 #include "dix/screensaver_priv.h"
+#include "mi/mi_priv.h"
 #include "miext/extinit_priv.h"
 #include "os/audit_priv.h"
 #include "os/auth.h"
@@ -106,6 +109,7 @@ OR PERFORMANCE OF THIS SOFTWARE.
 #include "os/ddx_priv.h"
 #include "os/log_priv.h"
 #include "os/osdep.h"
+#include "os/threadpool_priv.h"
 #include "os/serverlock.h"
 #include "os/xhostname.h"
 #include "present/present_priv.h"
@@ -282,6 +286,7 @@ UseMsg(void)
     ErrorF("-c                     turns off key-click\n");
     ErrorF("c #                    key-click volume (0-100)\n");
     ErrorF("-cc int                default color visual class\n");
+    ErrorF("-coalescemotion        merge queued core motion events\n");
     ErrorF("-nocursor              disable the cursor\n");
     ErrorF("-core                  generate core dump on fatal error\n");
     ErrorF("-displayfd fd          file descriptor to write display number to when ready to connect\n");
@@ -311,6 +316,8 @@ UseMsg(void)
     ErrorF("-p #                   screen-saver pattern duration (minutes)\n");
     ErrorF("-pn                    accept failure to listen on all ports\n");
     ErrorF("-nopn                  reject failure to listen on all ports\n");
+    ErrorF("-noreqprof             disable the request profiler\n");
+    ErrorF("-reqproffile file      dump request profile to file on SIGUSR2\n");
     ErrorF("-r                     turns off auto-repeat\n");
     ErrorF("r                      turns on auto-repeat \n");
     ErrorF("-render [default|mono|gray|color] set render color alloc policy\n");
@@ -323,7 +330,9 @@ UseMsg(void)
     ErrorF("ttyxx                  server started from init on /dev/ttyxx\n");
     ErrorF("v                      video blanking for screen-saver\n");
     ErrorF("-v                     screen-saver without video blanking\n");
+    ErrorF("-validatetree [incremental|full|check] clip list recomputation\n");
     ErrorF("-wr                    create root window with white background\n");
+    ErrorF("-workerthreads n       threads for parallel rendering work (1: none)\n");
     ErrorF("-maxbigreqsize         set maximal bigrequest size \n");
 #ifdef XINERAMA
     ErrorF("+xinerama              Enable XINERAMA extension\n");
@@ -331,6 +340,7 @@ UseMsg(void)
 #endif /* XINERAMA */
     ErrorF("-dumbSched             Disable smart scheduling and threaded input, enable old behavior\n");
     ErrorF("-schedInterval int     Set scheduler interval in msec\n");
+    ErrorF("-fairsched             Share CPU time fairly among busy clients\n");
     ErrorF("+extension name        Enable extension\n");
     ErrorF("-extension name        Disable extension\n");
     ListStaticExtensions();
@@ -497,6 +507,8 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-coalescemotion") == 0)
+            CoalesceMotionEvents = TRUE;
         else if (strcmp(argv[i], "-core") == 0) {
 #if !defined(WIN32) || !defined(__MINGW32__)
             struct rlimit core_limit;
@@ -614,6 +626,15 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-noreqprof") == 0) {
+            RequestProfiling = FALSE;
+        }
+        else if (strcmp(argv[i], "-reqproffile") == 0) {
+            if (++i < argc)
+                RequestProfileFile = argv[i];
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-noreset") == 0) {
             dispatchExceptionAtReset = 0;
         }
@@ -673,8 +694,26 @@ ProcessCommandLine(int argc, char *argv[])
             defaultScreenSaverBlanking = PreferBlanking;
         else if (strcmp(argv[i], "-v") == 0)
             defaultScreenSaverBlanking = DontPreferBlanking;
+        else if (strcmp(argv[i], "-validatetree") == 0) {
+            if (++i >= argc)
+                UseMsg();
+            else if (strcmp(argv[i], "incremental") == 0)
+                miValidateMode = MI_VALIDATE_INCREMENTAL;
+            else if (strcmp(argv[i], "full") == 0)
+                miValidateMode = MI_VALIDATE_FULL;
+            else if (strcmp(argv[i], "check") == 0)
+                miValidateMode = MI_VALIDATE_CHECK;
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-wr") == 0)
             whiteRoot = TRUE;
+        else if (strcmp(argv[i], "-workerthreads") == 0) {
+            if (++i < argc && atoi(argv[i]) > 0)
+                WorkerThreads = atoi(argv[i]);
+            else
+                UseMsg();
+        }
         else if (strcmp(argv[i], "-background") == 0) {
             if (++i < argc) {
                 if (!strcmp(argv[i], "none"))
@@ -746,6 +785,9 @@ ProcessCommandLine(int argc, char *argv[])
             else
                 UseMsg();
         }
+        else if (strcmp(argv[i], "-fairsched") == 0) {
+            FairScheduling = TRUE;
+        }
         else if (strcmp(argv[i], "-schedMax") == 0) {
             if (++i < argc) {
                 SmartScheduleMaxSlice = atoi(argv[i]);
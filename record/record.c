@@ -46,6 +46,7 @@ and Jim Haggerty of Metheus.
 #include "dix/resource_priv.h"
 #include "dix/screenint_priv.h"
 #include "miext/extinit_priv.h"
+#include "Xext/geext_priv.h"
 #include "os/client_priv.h"
 #include "os/osdep.h"
 #include "Xext/panoramiX.h"
@@ -53,6 +54,8 @@ and Jim Haggerty of Metheus.
 
 #include "dixstruct.h"
 #include "extnsionst.h"
+#include "record_priv.h"
+#include "ring.h"
 #include "set.h"
 #include "swaprep.h"
 #include "inputstr.h"
@@ -64,6 +67,8 @@ and Jim Haggerty of Metheus.
 
 static RESTYPE RTContext;       /* internal resource type for Record contexts */
 
+static int RecordReqCode;       /* major opcode, for RecordRingNotify */
+
 /* How many bytes of protocol data to buffer in a context. Don't set to less
  * than 32.
  */
@@ -82,6 +87,7 @@ typedef struct {
     int numBufBytes;            /* number of bytes in replyBuffer */
     char replyBuffer[REPLY_BUF_SIZE];   /* buffered recorded protocol */
     int inFlush;                /*  are we inside RecordFlushReplyBuffer */
+    RecordRingPtr pRing;        /* shared memory ring instead of replies */
 } RecordContextRec, *RecordContextPtr;
 
 /*  RecordMinorOpRec - to hold minor opcode selections for extension requests
@@ -120,6 +126,14 @@ typedef struct _RecordClientsAndProtocolRec {
     unsigned int clientStarted:1;       /* record new client connections? */
     unsigned int clientDied:1;  /* record client disconnections? */
     unsigned int clientIDsSeparatelyAllocated:1;        /* pClientIDs calloced? */
+    /* the sets above compiled for lookups, see RecordCompileRCAP */
+    RecordSetMaskRec requestMajorOpMask;
+    RecordSetMaskRec replyMajorOpMask;
+    RecordSetMaskRec deviceEventMask;
+    RecordSetMaskRec deliveredEventMask;
+    RecordSetMaskRec errorMask;
+    RecordSetMaskPtr pRequestMinOpMasks;        /* by major opcode - 128 */
+    RecordSetMaskPtr pReplyMinOpMasks;          /* by major opcode - 128 */
 } RecordClientsAndProtocolRec, *RecordClientsAndProtocolPtr;
 
 /* how much bigger to make pRCAP->pClientIDs when reallocing */
@@ -143,6 +157,8 @@ static int numEnabledRCAPs;
 static int RecordDeleteContext(void     *value,
                                XID      id);
 
+static void RecordDisableContext(RecordContextPtr pContext);
+
 /***************************************************************************/
 
 /* client private stuff */
@@ -217,6 +233,48 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
 
 /***************************************************************************/
 
+/* RecordSendRingNotify
+ *
+ * Arguments:
+ *	pContext is a context recording into a ring.
+ *	head is the position the ring has been written up to.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	A RecordRingNotify event is sent to the recording client.
+ */
+static void
+RecordSendRingNotify(RecordContextPtr pContext, CARD64 head)
+{
+    xRecordRingNotifyEvent ev = {
+        .type = GenericEvent,
+        .extension = RecordReqCode,
+        .sequenceNumber = pContext->pRecordingClient->sequence,
+        .length = 0,
+        .evtype = RecordRingNotify,
+        .context = pContext->id,
+        .headLo = head & 0xffffffff,
+        .headHi = head >> 32,
+    };
+
+    WriteEventsToClient(pContext->pRecordingClient, 1, (xEvent *) &ev);
+}                               /* RecordSendRingNotify */
+
+static void _X_COLD
+SRecordRingNotifyEvent(xGenericEvent * from, xGenericEvent * to)
+{
+    xRecordRingNotifyEvent *ev = (xRecordRingNotifyEvent *) to;
+
+    *to = *from;
+    swaps(&ev->sequenceNumber);
+    swapl(&ev->length);
+    swaps(&ev->evtype);
+    swapl(&ev->context);
+    swapl(&ev->headLo);
+    swapl(&ev->headHi);
+}                               /* SRecordRingNotifyEvent */
+
 /* RecordFlushReplyBuffer
  *
  * Arguments:
@@ -231,7 +289,9 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
  *	to the recording client, and the number of buffered bytes is set to
  *	zero.  If len1 is not zero, data1/len1 are then written to the
  *	recording client, and similarly for data2/len2 (written after
- *	data1/len1).
+ *	data1/len1).  For contexts enabled with EnableContextRing, all of
+ *	it goes into the ring, and the recording client gets a
+ *	RecordRingNotify if it asked for one.
  */
 static void
 RecordFlushReplyBuffer(RecordContextPtr pContext,
@@ -241,6 +301,26 @@ RecordFlushReplyBuffer(RecordContextPtr pContext,
         pContext->inFlush)
         return;
     ++pContext->inFlush;
+    if (pContext->pRing) {
+        Bool swapped = pContext->pRecordingClient->swapped;
+        Bool notify = FALSE;
+        CARD64 head = 0;
+
+        if (pContext->numBufBytes)
+            notify |= RecordRingWrite(pContext->pRing, pContext->replyBuffer,
+                                      pContext->numBufBytes, swapped, &head);
+        pContext->numBufBytes = 0;
+        if (len1)
+            notify |= RecordRingWrite(pContext->pRing, data1, len1, swapped,
+                                      &head);
+        if (len2)
+            notify |= RecordRingWrite(pContext->pRing, data2, len2, swapped,
+                                      &head);
+        if (notify)
+            RecordSendRingNotify(pContext, head);
+        --pContext->inFlush;
+        return;
+    }
     if (pContext->numBufBytes)
         WriteToClient(pContext->pRecordingClient, pContext->numBufBytes,
                       pContext->replyBuffer);
@@ -483,6 +563,41 @@ RecordABigRequest(RecordContextPtr pContext, ClientPtr client, xReq * stuff)
                            /* continuation */ -1);
 }                               /* RecordABigRequest */
 
+/* RecordIsMinorOpRecorded
+ *
+ * Arguments:
+ *	pMinorOpInfo is the extension request or reply selection of an RCAP.
+ *	pMasks are the minor opcode masks compiled from it.
+ *	majorop and minorop are the opcodes of an extension request.
+ *
+ * Returns:
+ *	TRUE if the RCAP records the request or reply, else FALSE.
+ *
+ * Side Effects: none.
+ */
+static Bool
+RecordIsMinorOpRecorded(RecordMinorOpPtr pMinorOpInfo,
+                        RecordSetMaskPtr pMasks, int majorop, int minorop)
+{
+    int numMinOpInfo;
+
+    assert(pMinorOpInfo && pMasks && majorop >= 128);
+    /* always the case for the minor opcodes in a request's data byte */
+    if (minorop < 256)
+        return RecordMaskIsMember(&pMasks[majorop - 128], minorop);
+
+    numMinOpInfo = pMinorOpInfo->count;
+    pMinorOpInfo++;
+    assert(numMinOpInfo);
+    for (; numMinOpInfo; numMinOpInfo--, pMinorOpInfo++) {
+        if (majorop >= pMinorOpInfo->major.first &&
+            majorop <= pMinorOpInfo->major.last &&
+            RecordIsMemberOfSet(pMinorOpInfo->major.pMinOpSet, minorop))
+            return TRUE;
+    }
+    return FALSE;
+}                               /* RecordIsMinorOpRecorded */
+
 /* RecordARequest
  *
  * Arguments:
@@ -515,44 +630,19 @@ RecordARequest(ClientPtr client)
     for (i = 0; i < numEnabledContexts; i++) {
         pContext = ppAllContexts[i];
         pRCAP = RecordFindClientOnContext(pContext, client->clientAsMask, NULL);
-        if (pRCAP && pRCAP->pRequestMajorOpSet &&
-            RecordIsMemberOfSet(pRCAP->pRequestMajorOpSet, majorop)) {
-            if (majorop <= 127) {       /* core request */
-
-                if (client->req_len == 0)
-                    RecordABigRequest(pContext, client, stuff);
-                else
-                    RecordAProtocolElement(pContext, client, XRecordFromClient,
-                                           (void *) stuff,
-                                           client->req_len << 2, 0, 0);
-            }
-            else {              /* extension, check minor opcode */
-
-                int minorop = client->minorOp;
-                int numMinOpInfo;
-                RecordMinorOpPtr pMinorOpInfo = pRCAP->pRequestMinOpInfo;
-
-                assert(pMinorOpInfo);
-                numMinOpInfo = pMinorOpInfo->count;
-                pMinorOpInfo++;
-                assert(numMinOpInfo);
-                for (; numMinOpInfo; numMinOpInfo--, pMinorOpInfo++) {
-                    if (majorop >= pMinorOpInfo->major.first &&
-                        majorop <= pMinorOpInfo->major.last &&
-                        RecordIsMemberOfSet(pMinorOpInfo->major.pMinOpSet,
-                                            minorop)) {
-                        if (client->req_len == 0)
-                            RecordABigRequest(pContext, client, stuff);
-                        else
-                            RecordAProtocolElement(pContext, client,
-                                                   XRecordFromClient,
-                                                   (void *) stuff,
-                                                   client->req_len << 2, 0, 0);
-                        break;
-                    }
-                }               /* end for each minor op info */
-            }                   /* end extension request */
-        }                       /* end this RCAP wants this major opcode */
+        if (pRCAP &&
+            RecordMaskIsMember(&pRCAP->requestMajorOpMask, majorop) &&
+            (majorop <= 127 ||  /* core request, else check minor opcode */
+             RecordIsMinorOpRecorded(pRCAP->pRequestMinOpInfo,
+                                     pRCAP->pRequestMinOpMasks,
+                                     majorop, client->minorOp))) {
+            if (client->req_len == 0)
+                RecordABigRequest(pContext, client, stuff);
+            else
+                RecordAProtocolElement(pContext, client, XRecordFromClient,
+                                       (void *) stuff,
+                                       client->req_len << 2, 0, 0);
+        }                       /* end this RCAP wants this request */
     }                           /* end for each context */
     pClientPriv = RecordClientPrivate(client);
     assert(pClientPriv);
@@ -601,42 +691,18 @@ RecordAReply(CallbackListPtr *pcbl, void *nulldata, void *calldata)
                 if (!pri->bytesRemaining)
                     pContext->continuedReply = 0;
             }
-            else if (pri->startOfReply && pRCAP->pReplyMajorOpSet &&
-                     RecordIsMemberOfSet(pRCAP->pReplyMajorOpSet, majorop)) {
-                if (majorop <= 127) {   /* core reply */
-                    RecordAProtocolElement(pContext, client, XRecordFromServer,
-                                           (void *) pri->replyData,
-                                           pri->dataLenBytes, 0,
-                                           pri->bytesRemaining);
-                    if (pri->bytesRemaining)
-                        pContext->continuedReply = 1;
-                }
-                else {          /* extension, check minor opcode */
-
-                    int minorop = client->minorOp;
-                    int numMinOpInfo;
-                    RecordMinorOpPtr pMinorOpInfo = pRCAP->pReplyMinOpInfo;
-
-                    assert(pMinorOpInfo);
-                    numMinOpInfo = pMinorOpInfo->count;
-                    pMinorOpInfo++;
-                    assert(numMinOpInfo);
-                    for (; numMinOpInfo; numMinOpInfo--, pMinorOpInfo++) {
-                        if (majorop >= pMinorOpInfo->major.first &&
-                            majorop <= pMinorOpInfo->major.last &&
-                            RecordIsMemberOfSet(pMinorOpInfo->major.pMinOpSet,
-                                                minorop)) {
-                            RecordAProtocolElement(pContext, client,
-                                                   XRecordFromServer,
-                                                   (void *) pri->replyData,
-                                                   pri->dataLenBytes, 0,
-                                                   pri->bytesRemaining);
-                            if (pri->bytesRemaining)
-                                pContext->continuedReply = 1;
-                            break;
-                        }
-                    }           /* end for each minor op info */
-                }               /* end extension reply */
+            else if (pri->startOfReply &&
+                     RecordMaskIsMember(&pRCAP->replyMajorOpMask, majorop) &&
+                     (majorop <= 127 || /* core reply, else check minor opcode */
+                      RecordIsMinorOpRecorded(pRCAP->pReplyMinOpInfo,
+                                              pRCAP->pReplyMinOpMasks,
+                                              majorop, client->minorOp))) {
+                RecordAProtocolElement(pContext, client, XRecordFromServer,
+                                       (void *) pri->replyData,
+                                       pri->dataLenBytes, 0,
+                                       pri->bytesRemaining);
+                if (pri->bytesRemaining)
+                    pContext->continuedReply = 1;
             }                   /* end continued reply vs. start of reply */
         }                       /* end client is registered on this context */
     }                           /* end for each context */
@@ -679,13 +745,13 @@ RecordADeliveredEventOrError(CallbackListPtr *pcbl, void *nulldata,
                 int recordit = 0;
 
                 if (pRCAP->pErrorSet) {
-                    recordit = RecordIsMemberOfSet(pRCAP->pErrorSet,
-                                                   ((xError *) (pev))->
-                                                   errorCode);
+                    recordit = RecordMaskIsMember(&pRCAP->errorMask,
+                                                  ((xError *) (pev))->
+                                                  errorCode);
                 }
                 else if (pRCAP->pDeliveredEventSet) {
-                    recordit = RecordIsMemberOfSet(pRCAP->pDeliveredEventSet,
-                                                   pev->u.u.type & 0177);
+                    recordit = RecordMaskIsMember(&pRCAP->deliveredEventMask,
+                                                  pev->u.u.type & 0177);
                 }
                 if (recordit) {
                     xEvent swappedEvent;
@@ -713,7 +779,7 @@ RecordSendProtocolEvents(RecordClientsAndProtocolPtr pRCAP,
     int ev;                     /* event index */
 
     for (ev = 0; ev < count; ev++, pev++) {
-        if (RecordIsMemberOfSet(pRCAP->pDeviceEventSet, pev->u.u.type & 0177)) {
+        if (RecordMaskIsMember(&pRCAP->deviceEventMask, pev->u.u.type & 0177)) {
             xEvent swappedEvent;
             xEvent *pEvToRecord = pev;
 
@@ -1515,6 +1581,61 @@ RecordConvertRangesToIntervals(SetInfoPtr psi,
 #define offset_of(_structure, _field) \
     ((char *)(& (_structure . _field)) - (char *)(&_structure))
 
+/* RecordCompileMinorOps
+ *
+ * Arguments:
+ *	pMinorOpInfo is an extension request or reply selection.
+ *	pMasks is an array of 128 cleared masks.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	pMasks[major - 128] is set to the minor opcodes below 256 recorded
+ *	for each extension major opcode.
+ */
+static void
+RecordCompileMinorOps(RecordMinorOpPtr pMinorOpInfo, RecordSetMaskPtr pMasks)
+{
+    int numMinOpInfo = pMinorOpInfo->count;
+
+    for (pMinorOpInfo++; numMinOpInfo; numMinOpInfo--, pMinorOpInfo++) {
+        for (int major = max(pMinorOpInfo->major.first, 128);
+             major <= min(pMinorOpInfo->major.last, 255); major++)
+            RecordSetCompileMask(pMinorOpInfo->major.pMinOpSet,
+                                 &pMasks[major - 128]);
+    }
+}                               /* RecordCompileMinorOps */
+
+/* RecordCompileRCAP
+ *
+ * Arguments:
+ *	pRCAP is a newly created RCAP with all its sets filled in.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The masks of pRCAP are computed from its sets, so that recording
+ *	hooks can test membership without walking the sets.  The sets of
+ *	an RCAP never change, so this is only done once.
+ */
+static void
+RecordCompileRCAP(RecordClientsAndProtocolPtr pRCAP)
+{
+    RecordSetCompileMask(pRCAP->pRequestMajorOpSet,
+                         &pRCAP->requestMajorOpMask);
+    RecordSetCompileMask(pRCAP->pReplyMajorOpSet, &pRCAP->replyMajorOpMask);
+    RecordSetCompileMask(pRCAP->pDeviceEventSet, &pRCAP->deviceEventMask);
+    RecordSetCompileMask(pRCAP->pDeliveredEventSet,
+                         &pRCAP->deliveredEventMask);
+    RecordSetCompileMask(pRCAP->pErrorSet, &pRCAP->errorMask);
+    if (pRCAP->pRequestMinOpInfo)
+        RecordCompileMinorOps(pRCAP->pRequestMinOpInfo,
+                              pRCAP->pRequestMinOpMasks);
+    if (pRCAP->pReplyMinOpInfo)
+        RecordCompileMinorOps(pRCAP->pReplyMinOpInfo,
+                              pRCAP->pReplyMinOpMasks);
+}                               /* RecordCompileRCAP */
+
 /* RecordRegisterClients
  *
  * Arguments:
@@ -1547,6 +1668,8 @@ RecordRegisterClients(RecordContextPtr pContext, ClientPtr client,
     int nExtRepSets = 0;
     int extReqSetsOffset = 0;
     int extRepSetsOffset = 0;
+    int extReqMasksOffset = 0;
+    int extRepMasksOffset = 0;
     SetInfoPtr pExtReqSets, pExtRepSets;
     int clientListOffset;
     XID *pCanonClients;
@@ -1679,6 +1802,18 @@ RecordRegisterClients(RecordContextPtr pContext, ClientPtr client,
         totRCAPsize += pad + (nExtRepSets + 1) * sizeof(RecordMinorOpRec);
     }
 
+    /* minor opcode masks of all extension major opcodes */
+    if (nExtReqSets) {
+        pad = RecordPadAlign(totRCAPsize, sizeof(CARD64));
+        extReqMasksOffset = totRCAPsize + pad;
+        totRCAPsize += pad + 128 * sizeof(RecordSetMaskRec);
+    }
+    if (nExtRepSets) {
+        pad = RecordPadAlign(totRCAPsize, sizeof(CARD64));
+        extRepMasksOffset = totRCAPsize + pad;
+        totRCAPsize += pad + 128 * sizeof(RecordSetMaskRec);
+    }
+
     for (i = 0; i < maxSets; i++) {
         if (si[i].nintervals) {
             si[i].size =
@@ -1793,6 +1928,14 @@ RecordRegisterClients(RecordContextPtr pContext, ClientPtr client,
     else
         pRCAP->pReplyMinOpInfo = NULL;
 
+    if (nExtReqSets)
+        pRCAP->pRequestMinOpMasks = (RecordSetMaskPtr)
+            ((char *) pRCAP + extReqMasksOffset);
+    if (nExtRepSets)
+        pRCAP->pReplyMinOpMasks = (RecordSetMaskPtr)
+            ((char *) pRCAP + extRepMasksOffset);
+    RecordCompileRCAP(pRCAP);
+
     pRCAP->clientStarted = clientStarted;
     pRCAP->clientDied = clientDied;
 
@@ -2307,23 +2450,28 @@ ProcRecordGetContext(ClientPtr client)
     return err;
 }                               /* ProcRecordGetContext */
 
+/* RecordEnableContext
+ *
+ * Arguments:
+ *	client is the client enabling the context.
+ *	pContext is the (disabled) context to enable.
+ *	pRing is the ring to record into, or NULL to send replies.
+ *
+ * Returns: Success or an error from installing the hooks.
+ *
+ * Side Effects:
+ *	Recording hooks are installed, the context is moved to the enabled
+ *	part of ppAllContexts and StartOfData is sent.  Without a ring,
+ *	further request processing on client's connection stops until the
+ *	context is disabled.  On success, the context owns pRing.
+ */
 static int
-ProcRecordEnableContext(ClientPtr client)
+RecordEnableContext(ClientPtr client, RecordContextPtr pContext,
+                    RecordRingPtr pRing)
 {
-    REQUEST(xRecordEnableContextReq);
-    REQUEST_SIZE_MATCH(xRecordEnableContextReq);
-
-    if (client->swapped)
-        swapl(&stuff->context);
-
-    RecordContextPtr pContext;
     int i;
     RecordClientsAndProtocolPtr pRCAP;
 
-    VERIFY_CONTEXT(pContext, stuff->context, client);
-    if (pContext->pRecordingClient)
-        return BadMatch;        /* already enabled */
-
     /* install record hooks for each RCAP */
 
     for (pRCAP = pContext->pListOfRCAP; pRCAP; pRCAP = pRCAP->pNextRCAP) {
@@ -2342,10 +2490,13 @@ ProcRecordEnableContext(ClientPtr client)
     }
 
     /* Disallow further request processing on this connection until
-     * the context is disabled.
+     * the context is disabled.  The protocol goes elsewhere with a ring,
+     * so the connection stays usable.
      */
-    IgnoreClient(client);
+    if (!pRing)
+        IgnoreClient(client);
     pContext->pRecordingClient = client;
+    pContext->pRing = pRing;
 
     /* Don't allow the data connection to record itself; unregister it. */
     RecordDeleteClientFromContext(pContext,
@@ -2368,8 +2519,77 @@ ProcRecordEnableContext(ClientPtr client)
     RecordAProtocolElement(pContext, NULL, XRecordStartOfData, NULL, 0, 0, 0);
     RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     return Success;
+}                               /* RecordEnableContext */
+
+static int
+ProcRecordEnableContext(ClientPtr client)
+{
+    REQUEST(xRecordEnableContextReq);
+    REQUEST_SIZE_MATCH(xRecordEnableContextReq);
+
+    if (client->swapped)
+        swapl(&stuff->context);
+
+    RecordContextPtr pContext;
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+
+    return RecordEnableContext(client, pContext, NULL);
 }                               /* ProcRecordEnableContext */
 
+static int
+ProcRecordEnableContextRing(ClientPtr client)
+{
+    REQUEST(xRecordEnableContextRingReq);
+    REQUEST_SIZE_MATCH(xRecordEnableContextRingReq);
+
+    if (client->swapped) {
+        swapl(&stuff->context);
+        swapl(&stuff->size);
+    }
+
+    RecordContextPtr pContext;
+    RecordRingPtr pRing;
+    int fd, err;
+
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+    if (!client->local)
+        return BadAccess;       /* can't pass the ring */
+
+    pRing = RecordRingCreate(stuff->size, &fd);
+    if (!pRing)
+        return BadAlloc;
+
+    xRecordEnableContextRingReply reply = {
+        .nfd = 1,
+        .size = RecordRingSize(pRing),
+        .dataOffset = RecordRingDataOffset(pRing),
+    };
+
+    if (client->swapped) {
+        swapl(&reply.size);
+        swapl(&reply.dataOffset);
+    }
+
+    err = RecordEnableContext(client, pContext, pRing);
+    if (err != Success) {
+        RecordRingDestroy(pRing);
+        close(fd);
+        return err;
+    }
+
+    if (WriteFdToClient(client, fd, TRUE) < 0) {
+        RecordDisableContext(pContext);
+        close(fd);
+        return BadAlloc;
+    }
+
+    return X_SEND_REPLY_SIMPLE(client, reply);
+}                               /* ProcRecordEnableContextRing */
+
 /* RecordDisableContext
  *
  * Arguments:
@@ -2384,7 +2604,8 @@ ProcRecordEnableContext(ClientPtr client)
  *	this context are uninstalled.  The context is moved to the
  *	rear part of the ppAllContexts array.  numEnabledContexts is
  *	decremented.  Request processing for the formerly recording client
- *	is resumed.
+ *	is resumed, or for contexts enabled with EnableContextRing, the
+ *	ring is freed.
  */
 static void
 RecordDisableContext(RecordContextPtr pContext)
@@ -2398,8 +2619,15 @@ RecordDisableContext(RecordContextPtr pContext)
         RecordAProtocolElement(pContext, NULL, XRecordEndOfData, NULL, 0, 0, 0);
         RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     }
-    /* Re-enable request processing on this connection. */
-    AttendClient(pContext->pRecordingClient);
+    /* Re-enable request processing on this connection, or drop the
+     * ring (the client keeps its mapping) if it was never stopped.
+     */
+    if (pContext->pRing) {
+        RecordRingDestroy(pContext->pRing);
+        pContext->pRing = NULL;
+    }
+    else
+        AttendClient(pContext->pRecordingClient);
 
     for (pRCAP = pContext->pListOfRCAP; pRCAP; pRCAP = pRCAP->pNextRCAP) {
         RecordUninstallHooks(pRCAP, 0);
@@ -2521,6 +2749,8 @@ ProcRecordDispatch(ClientPtr client)
         return ProcRecordDisableContext(client);
     case X_RecordFreeContext:
         return ProcRecordFreeContext(client);
+    case X_RecordEnableContextRing:
+        return ProcRecordEnableContextRing(client);
     default:
         return BadRequest;
     }
@@ -2732,5 +2962,7 @@ RecordExtensionInit(void)
     }
     SetResourceTypeErrorValue(RTContext,
                               extentry->errorBase + XRecordBadContext);
+    RecordReqCode = extentry->base;
+    GERegisterExtension(RecordReqCode, SRecordRingNotifyEvent);
 
 }                               /* RecordExtensionInit */
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+#ifndef _XORG_RECORD_PRIV_H
+#define _XORG_RECORD_PRIV_H
+
+#include <X11/Xmd.h>
+
+/*
+ * Server specific RECORD requests.  They're numbered well above the
+ * standard ones, so they won't clash with future protocol versions.
+ */
+
+#define X_RecordEnableContextRing       64
+
+/*
+ * Like EnableContext, but the recorded protocol goes into a ring buffer
+ * in shared memory instead of being sent as replies, and the connection
+ * isn't blocked: it can still issue requests, e.g. DisableContext.
+ *
+ * The reply carries the file descriptor of the ring.  The ring data is
+ * the byte stream the replies to EnableContext would have been, in the
+ * byte order of the recording client.  Replies are never split: if one
+ * doesn't fit into the free space of the ring it is dropped as a whole
+ * and counted in the ring header.
+ */
+typedef struct {
+    CARD8   reqType;
+    CARD8   recordReqType;
+    CARD16  length;
+    CARD32  context;
+    CARD32  size;               /* of the ring data, rounded up to a power
+                                   of two and clamped by the server */
+} xRecordEnableContextRingReq;
+#define sz_xRecordEnableContextRingReq 12
+
+typedef struct {
+    CARD8   type;
+    CARD8   nfd;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD32  size;               /* of the ring data */
+    CARD32  dataOffset;         /* of the ring data in the mapping */
+    CARD32  pad2;
+    CARD32  pad3;
+    CARD32  pad4;
+    CARD32  pad5;
+} xRecordEnableContextRingReply;
+#define sz_xRecordEnableContextRingReply 32
+
+/*
+ * At the start of the mapping, in the byte order of the server (the fd
+ * only works for local clients anyway).  head and tail are byte counts
+ * which never wrap, the data of position p is at data[p % size].
+ *
+ * The server advances head once a reply is complete, with release
+ * semantics.  The client advances tail after it has consumed data.  To
+ * sleep, the client sets wakeup to 1, checks head once more, and waits
+ * for a RecordRingNotify event; the server clears wakeup when it sends
+ * one.
+ */
+#define RECORD_RING_MAGIC       0x58524e47      /* "XRNG" */
+
+typedef struct {
+    CARD32  magic;
+    CARD32  size;               /* of the ring data, a power of two */
+    CARD32  dataOffset;         /* of the ring data in the mapping */
+    CARD32  wakeup;             /* written by the client */
+    CARD64  head;               /* written by the server */
+    CARD64  tail;               /* written by the client */
+    CARD64  dropped;            /* replies which didn't fit */
+} xRecordRingHeader;
+
+/* GenericEvent, extension is the major opcode of RECORD */
+#define RecordRingNotify        0
+
+typedef struct {
+    CARD8   type;
+    CARD8   extension;
+    CARD16  sequenceNumber;
+    CARD32  length;
+    CARD16  evtype;
+    CARD16  pad0;
+    CARD32  context;
+    CARD32  headLo;             /* head after the write that notified */
+    CARD32  headHi;
+    CARD32  pad1;
+    CARD32  pad2;
+} xRecordRingNotifyEvent;
+#define sz_xRecordRingNotifyEvent 32
+
+#endif /* _XORG_RECORD_PRIV_H */
@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Shared memory ring for RECORD contexts
+ *
+ * Recording busy displays through replies means copying every recorded
+ * element into the context's buffer, then into the output buffer of the
+ * recording client, and if that client doesn't keep up, its output
+ * buffer keeps growing.  With a ring, the reply stream goes straight into
+ * memory the recording client has mapped: the server only ever writes
+ * the data and head, the client only the tail and its wakeup flag, so
+ * there's no locking, and a client falling behind loses whole replies
+ * instead of slowing down the server.
+ */
+
+#include <dix-config.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <X11/Xproto.h>
+#include <X11/extensions/recordproto.h>
+
+#include "misc.h"
+#include "record_priv.h"
+#include "ring.h"
+
+#define RECORD_RING_MIN_SIZE    (64 * 1024)
+#define RECORD_RING_MAX_SIZE    (64 * 1024 * 1024)
+#define RECORD_RING_DATA_OFFSET 4096    /* keep the data page aligned */
+
+struct _RecordRing {
+    xRecordRingHeader *header;
+    unsigned char *data;
+    size_t mapSize;
+    CARD32 size;
+    CARD64 head;                /* including the current reply so far */
+    CARD32 pending;             /* bytes of the current reply to come */
+    Bool dropping;              /* the current reply doesn't fit */
+    Bool swapped;               /* byte order of the reply lengths */
+};
+
+RecordRingPtr
+RecordRingCreate(CARD32 size, int *fd)
+{
+#if defined(HAVE_MEMFD_CREATE) && defined(F_SEAL_SHRINK)
+    RecordRingPtr ring;
+    CARD32 ringSize = RECORD_RING_MIN_SIZE;
+    void *map;
+
+    while (ringSize < size && ringSize < RECORD_RING_MAX_SIZE)
+        ringSize <<= 1;
+
+    ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return NULL;
+    ring->size = ringSize;
+    ring->mapSize = RECORD_RING_DATA_OFFSET + ringSize;
+
+    /* the client mustn't be able to shrink it under our feet */
+    *fd = memfd_create("xorg-record", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (*fd < 0)
+        goto fail;
+    if (ftruncate(*fd, ring->mapSize) < 0 ||
+        fcntl(*fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) < 0)
+        goto fail_fd;
+
+    map = mmap(NULL, ring->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+               *fd, 0);
+    if (map == MAP_FAILED)
+        goto fail_fd;
+
+    ring->header = map;
+    ring->data = (unsigned char *) map + RECORD_RING_DATA_OFFSET;
+    ring->header->magic = RECORD_RING_MAGIC;
+    ring->header->size = ringSize;
+    ring->header->dataOffset = RECORD_RING_DATA_OFFSET;
+    return ring;
+
+ fail_fd:
+    close(*fd);
+ fail:
+    free(ring);
+    return NULL;
+#else
+    return NULL;
+#endif
+}
+
+void
+RecordRingDestroy(RecordRingPtr ring)
+{
+    if (!ring)
+        return;
+    munmap(ring->header, ring->mapSize);
+    free(ring);
+}
+
+CARD32
+RecordRingSize(RecordRingPtr ring)
+{
+    return ring->size;
+}
+
+CARD32
+RecordRingDataOffset(RecordRingPtr ring)
+{
+    return RECORD_RING_DATA_OFFSET;
+}
+
+/* bytes free for the server, the tail is whatever the client wrote */
+static CARD32
+RecordRingSpace(RecordRingPtr ring)
+{
+    CARD64 tail = __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE);
+    CARD64 used = ring->head - tail;
+
+    return used > ring->size ? 0 : ring->size - used;
+}
+
+static void
+RecordRingCopy(RecordRingPtr ring, const unsigned char *data, CARD32 len)
+{
+    CARD32 offset = ring->head & (ring->size - 1);
+    CARD32 first = min(len, ring->size - offset);
+
+    if (data) {
+        memcpy(ring->data + offset, data, first);
+        memcpy(ring->data, data + first, len - first);
+    }
+    else {
+        memset(ring->data + offset, 0, first);
+        memset(ring->data, 0, len - first);
+    }
+    ring->head += len;
+}
+
+/* data NULL is len zeros; TRUE if a reply was completed */
+static Bool
+RecordRingAppend(RecordRingPtr ring, const unsigned char *data, CARD32 len)
+{
+    Bool completed = FALSE;
+
+    while (len) {
+        CARD32 n;
+
+        if (!ring->pending) {
+            /* the start of the next reply */
+            const xRecordEnableContextReply *rep = (const void *) data;
+            CARD32 length;
+
+            if (!data || len < sz_xRecordEnableContextReply)
+                return completed;       /* not a reply stream */
+            length = rep->length;
+            if (ring->swapped)
+                swapl(&length);
+            if (length > (RECORD_RING_MAX_SIZE -
+                          sz_xRecordEnableContextReply) / 4)
+                ring->pending = RECORD_RING_MAX_SIZE;
+            else
+                ring->pending = sz_xRecordEnableContextReply + length * 4;
+            ring->dropping = ring->pending > RecordRingSpace(ring);
+            if (ring->dropping)
+                __atomic_add_fetch(&ring->header->dropped, 1,
+                                   __ATOMIC_RELAXED);
+        }
+
+        n = min(len, ring->pending);
+        if (!ring->dropping)
+            RecordRingCopy(ring, data, n);
+        if (data)
+            data += n;
+        len -= n;
+        ring->pending -= n;
+
+        if (!ring->pending && !ring->dropping) {
+            __atomic_store_n(&ring->header->head, ring->head,
+                             __ATOMIC_RELEASE);
+            completed = TRUE;
+        }
+    }
+    return completed;
+}
+
+Bool
+RecordRingWrite(RecordRingPtr ring, const void *data, int len,
+                Bool swapped, CARD64 *head)
+{
+    Bool completed;
+
+    if (len <= 0)
+        return FALSE;
+    ring->swapped = swapped;
+    completed = RecordRingAppend(ring, data, len);
+    completed |= RecordRingAppend(ring, NULL, padding_for_int32(len));
+    if (!completed)
+        return FALSE;
+
+    *head = ring->head;
+    /* only one notify per wakeup the client asked for */
+    return __atomic_load_n(&ring->header->wakeup, __ATOMIC_ACQUIRE) &&
+        __atomic_exchange_n(&ring->header->wakeup, 0, __ATOMIC_ACQ_REL);
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+#ifndef XSERVER_RECORD_RING_H
+#define XSERVER_RECORD_RING_H
+
+#include <X11/Xdefs.h>
+#include <X11/Xmd.h>
+
+/*
+ * Shared memory ring the protocol of a RECORD context can be written to,
+ * see record_priv.h for the layout the recording client sees.
+ */
+
+typedef struct _RecordRing *RecordRingPtr;
+
+/*
+ * @brief create a ring of (at least) size bytes
+ *
+ * @param fd set to a file descriptor of the ring for the client
+ * @return the ring, or NULL if there's no memory or no sealable memfds
+ */
+RecordRingPtr RecordRingCreate(CARD32 size, int *fd);
+
+void RecordRingDestroy(RecordRingPtr ring);
+
+/* size of the ring data and where it starts in the mapping */
+CARD32 RecordRingSize(RecordRingPtr ring);
+CARD32 RecordRingDataOffset(RecordRingPtr ring);
+
+/*
+ * @brief append a piece of the RECORD reply stream
+ *
+ * The stream must consist of complete replies, each one starting with an
+ * xRecordEnableContextReply; swapped tells the byte order of its length.
+ * len is padded to a multiple of 4 with zeros, like WriteToClient does.
+ *
+ * @param head set to the new head if it was advanced
+ * @return TRUE if a reply was completed and the client asked to be woken
+ */
+Bool RecordRingWrite(RecordRingPtr ring, const void *data, int len,
+                     Bool swapped, CARD64 *head);
+
+#endif /* XSERVER_RECORD_RING_H */
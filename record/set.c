@@ -431,3 +431,19 @@ RecordCreateSet(RecordSetInterval * pIntervals, int nIntervals, void *pMem,
     }
     return (*pCreateSet) (pIntervals, nIntervals, pMem, size);
 }
+
+void
+RecordSetCompileMask(RecordSetPtr pSet, RecordSetMaskPtr pMask)
+{
+    RecordSetIteratePtr pIter = NULL;
+    RecordSetInterval interval;
+
+    if (!pSet)
+        return;
+    while ((pIter = RecordIterateSet(pSet, pIter, &interval))) {
+        for (int m = interval.first; m <= min(interval.last, 255); m++)
+            pMask->bits[m >> 6] |= (CARD64) 1 << (m & 63);
+        if (interval.last >= 255)
+            break;
+    }
+}
@@ -137,4 +137,31 @@ int RecordSetMemoryRequirements(RecordSetInterval * /*pIntervals */ ,
 	}
 */
 
+/*
+    Sets are looked up for every recorded request, reply and event, and the
+    members looked up are nearly always below 256: major opcodes, error
+    codes, event types and (in practice) extension minor opcodes.  A mask
+    of those members makes that a single load and shift.
+*/
+
+typedef struct {
+    CARD64 bits[4];
+} RecordSetMaskRec, *RecordSetMaskPtr;
+
+void RecordSetCompileMask(RecordSetPtr pSet, RecordSetMaskPtr pMask);
+/*
+    RecordSetCompileMask adds the members of pSet below 256 to pMask, which
+    the caller has to have cleared.  pSet may be NULL.
+*/
+
+static inline unsigned long
+RecordMaskIsMember(const RecordSetMaskRec *pMask, unsigned int member)
+{
+    return (pMask->bits[(member >> 6) & 3] >> (member & 63)) & 1;
+}
+/*
+    RecordMaskIsMember returns 1 if member, which must be below 256, is in
+    pMask, else 0.
+*/
+
 #endif /* XSERVER_SET_H */
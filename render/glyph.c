@@ -24,9 +24,11 @@
 
 #include <dix-config.h>
 
+#include <stdint.h>
+#include <string.h>
+
 #include "dix/screenint_priv.h"
 #include "os/bug_priv.h"
-#include "os/xsha1.h"
 
 #include "misc.h"
 #include "scrnintstr.h"
@@ -81,6 +83,49 @@ static GlyphHashSetRec glyphHashSets[] = {
 
 static GlyphHashRec globalGlyphs[GlyphFormatNum];
 
+/* what a glyph is looked up by in the global (deduplicating) tables */
+typedef struct {
+    const unsigned char *hash;  /* HashGlyph() digest */
+    const xGlyphInfo *info;
+    const CARD8 *bits;          /* as uploaded */
+    GlyphPtr glyph;             /* if the key is an existing glyph */
+} GlyphKeyRec;
+
+static inline void
+GlyphKeyFromGlyph(GlyphKeyRec *key, GlyphPtr glyph)
+{
+    key->hash = glyph->sha1;
+    key->info = &glyph->info;
+    key->bits = GlyphBits(glyph);
+    key->glyph = glyph;
+}
+
+/* HashGlyph() appends the size of the bits to the digest */
+static inline CARD32
+GlyphBitsSize(const unsigned char *hash)
+{
+    CARD32 size;
+
+    memcpy(&size, hash + 16, sizeof(size));
+    return size;
+}
+
+/*
+ * The digest isn't a cryptographic one, so clients could make up
+ * colliding glyphs on purpose: matches are verified against the copy of
+ * the bits kept with each glyph, never read back from its pictures.
+ */
+static Bool
+GlyphMatches(GlyphPtr glyph, const GlyphKeyRec *key)
+{
+    if (memcmp(glyph->sha1, key->hash, sizeof(glyph->sha1)) != 0)
+        return FALSE;
+    if (glyph == key->glyph)
+        return TRUE;
+    return memcmp(&glyph->info, key->info, sizeof(xGlyphInfo)) == 0 &&
+        memcmp(GlyphBits(glyph), key->bits, GlyphBitsSize(key->hash)) == 0;
+}
+
 void
 GlyphUninit(ScreenPtr pScreen)
 {
@@ -117,8 +162,7 @@ FindGlyphHashSet(CARD32 filled)
 }
 
 static GlyphRefPtr
-FindGlyphRef(GlyphHashPtr hash,
-             CARD32 signature, Bool match, unsigned char sha1[20])
+FindGlyphRef(GlyphHashPtr hash, CARD32 signature, const GlyphKeyRec *match)
 {
     CARD32 elt, step, s;
     GlyphPtr glyph;
@@ -148,8 +192,7 @@ FindGlyphRef(GlyphHashPtr hash,
             else if (gr == del)
                 break;
         }
-        else if (s == signature &&
-                 (!match || memcmp(glyph->sha1, sha1, 20) == 0)) {
+        else if (s == signature && (!match || GlyphMatches(glyph, match))) {
             break;
         }
         if (!step) {
@@ -164,38 +207,121 @@ FindGlyphRef(GlyphHashPtr hash,
     return gr;
 }
 
+static inline uint64_t
+HashRotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+HashFmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/* MurmurHash3 (x64, 128 bit), seeded with the glyph metrics */
+static void
+HashGlyphBits(const xGlyphInfo *gi, const CARD8 *bits, unsigned long size,
+              uint64_t out[2])
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1, h2, k1, k2;
+    CARD8 seed[16] = { 0 };
+    unsigned long i;
+
+    memcpy(seed, gi, sizeof(xGlyphInfo));
+    memcpy(&h1, seed, 8);
+    memcpy(&h2, seed + 8, 8);
+
+    for (i = 0; i + 16 <= size; i += 16) {
+        memcpy(&k1, bits + i, 8);
+        memcpy(&k2, bits + i + 8, 8);
+
+        k1 *= c1;
+        k1 = HashRotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = HashRotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = HashRotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = HashRotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    if (i < size) {
+        CARD8 tail[16] = { 0 };
+
+        memcpy(tail, bits + i, size - i);
+        memcpy(&k1, tail, 8);
+        memcpy(&k2, tail + 8, 8);
+
+        k2 *= c2;
+        k2 = HashRotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+
+        k1 *= c1;
+        k1 = HashRotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = HashFmix64(h1);
+    h2 = HashFmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    out[0] = h1;
+    out[1] = h2;
+}
+
+/*
+ * Glyphs are deduplicated by the digest computed here, stored in the
+ * (historically named) sha1 field.  It's a fast 128 bit hash followed by
+ * the size of the bits, and only used to find candidates: see
+ * GlyphMatches().
+ */
 int
 HashGlyph(xGlyphInfo * gi,
           CARD8 *bits, unsigned long size, unsigned char sha1[20])
 {
-    void *ctx = x_sha1_init();
-    int success;
-
-    if (!ctx)
-        return BadAlloc;
-
-    success = x_sha1_update(ctx, gi, sizeof(xGlyphInfo));
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_update(ctx, bits, size);
-    if (!success)
-        return BadAlloc;
-    success = x_sha1_final(ctx, sha1);
-    if (!success)
-        return BadAlloc;
+    uint64_t digest[2];
+    CARD32 size32 = size;
+
+    HashGlyphBits(gi, bits, size, digest);
+    memcpy(sha1, digest, sizeof(digest));
+    memcpy(sha1 + sizeof(digest), &size32, sizeof(size32));
     return Success;
 }
 
 GlyphPtr
-FindGlyphByHash(unsigned char sha1[20], int format)
+FindGlyphByHash(unsigned char sha1[20], int format,
+                xGlyphInfo * gi, CARD8 *bits)
 {
     GlyphRefPtr gr;
     CARD32 signature = *(CARD32 *) sha1;
+    GlyphKeyRec key = { sha1, gi, bits, NULL };
 
     if (!globalGlyphs[format].hashSet)
         return NULL;
 
-    gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, sha1);
+    gr = FindGlyphRef(&globalGlyphs[format], signature, &key);
 
     if (gr->glyph && gr->glyph != DeletedGlyph)
         return gr->glyph;
@@ -250,23 +376,29 @@ FreeGlyph(GlyphPtr glyph, int format)
     BUG_RETURN(glyph->refcnt == 0);
     if (--glyph->refcnt == 0) {
         GlyphRefPtr gr;
-        int i;
-        int first;
+        GlyphKeyRec key;
         CARD32 signature;
 
-        first = -1;
-        for (i = 0; i < globalGlyphs[format].hashSet->size; i++)
+#ifdef CHECK_DUPLICATES
+        int first = -1;
+
+        for (int i = 0; i < globalGlyphs[format].hashSet->size; i++)
             if (globalGlyphs[format].table[i].glyph == glyph) {
                 if (first != -1)
                     DuplicateRef(glyph, "FreeGlyph check");
                 first = i;
             }
+#endif
 
         signature = *(CARD32 *) glyph->sha1;
-        gr = FindGlyphRef(&globalGlyphs[format], signature, TRUE, glyph->sha1);
+        GlyphKeyFromGlyph(&key, glyph);
+        gr = FindGlyphRef(&globalGlyphs[format], signature, &key);
+#ifdef CHECK_DUPLICATES
         if (gr - globalGlyphs[format].table != first)
             DuplicateRef(glyph, "Found wrong one");
-        if (gr && gr->glyph && gr->glyph != DeletedGlyph) {
+#endif
+        /* a duplicate which AddGlyph() dropped isn't in the table */
+        if (gr && gr->glyph == glyph) {
             gr->glyph = DeletedGlyph;
             gr->signature = 0;
             globalGlyphs[format].tableEntries--;
@@ -281,13 +413,14 @@ void
 AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
 {
     GlyphRefPtr gr;
+    GlyphKeyRec key;
     CARD32 signature;
 
     CheckDuplicates(&globalGlyphs[glyphSet->fdepth], "AddGlyph top global");
     /* Locate existing matching glyph */
     signature = *(CARD32 *) glyph->sha1;
-    gr = FindGlyphRef(&globalGlyphs[glyphSet->fdepth], signature,
-                      TRUE, glyph->sha1);
+    GlyphKeyFromGlyph(&key, glyph);
+    gr = FindGlyphRef(&globalGlyphs[glyphSet->fdepth], signature, &key);
     if (gr->glyph && gr->glyph != DeletedGlyph && gr->glyph != glyph) {
         glyph = gr->glyph;
     }
@@ -298,7 +431,7 @@ AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id)
     }
 
     /* Insert/replace glyphset value */
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL);
     ++glyph->refcnt;
     if (gr->glyph && gr->glyph != DeletedGlyph)
         FreeGlyph(gr->glyph, glyphSet->fdepth);
@@ -315,7 +448,7 @@ DeleteGlyph(GlyphSetPtr glyphSet, Glyph id)
     GlyphRefPtr gr;
     GlyphPtr glyph;
 
-    gr = FindGlyphRef(&glyphSet->hash, id, FALSE, 0);
+    gr = FindGlyphRef(&glyphSet->hash, id, NULL);
     glyph = gr->glyph;
     if (glyph && glyph != DeletedGlyph) {
         gr->glyph = DeletedGlyph;
@@ -331,19 +464,21 @@ FindGlyph(GlyphSetPtr glyphSet, Glyph id)
 {
     GlyphPtr glyph;
 
-    glyph = FindGlyphRef(&glyphSet->hash, id, FALSE, 0)->glyph;
+    glyph = FindGlyphRef(&glyphSet->hash, id, NULL)->glyph;
     if (glyph == DeletedGlyph)
         glyph = 0;
     return glyph;
 }
 
 GlyphPtr
-AllocateGlyph(xGlyphInfo * gi, int fdepth)
+AllocateGlyph(xGlyphInfo * gi, int fdepth, CARD8 *bits, unsigned long bits_size)
 {
-    int size;
-    int head_size;
+    size_t size;
+    size_t head_size;
 
+    /* the bits are kept (right behind the pictures) to verify matches */
     head_size = sizeof(GlyphRec) + screenInfo.numScreens * sizeof(PicturePtr);
+    head_size += (bits_size + 7) & ~7UL;
     size = (head_size + dixPrivatesSize(PRIVATE_GLYPH));
     GlyphPtr glyph = calloc(1, size);
     if (!glyph)
@@ -351,6 +486,7 @@ AllocateGlyph(xGlyphInfo * gi, int fdepth)
     glyph->refcnt = 1;
     glyph->size = size + sizeof(xGlyphInfo);
     glyph->info = *gi;
+    memcpy(GlyphBits(glyph), bits, bits_size);
     dixInitPrivates(glyph, (char *) glyph + head_size, PRIVATE_GLYPH);
 
     unsigned int i = 0;
@@ -416,8 +552,12 @@ ResizeGlyphHash(GlyphHashPtr hash, CARD32 change, Bool global)
         for (i = 0; i < oldSize; i++) {
             glyph = hash->table[i].glyph;
             if (glyph && glyph != DeletedGlyph) {
+                GlyphKeyRec key;
+
                 s = hash->table[i].signature;
-                if ((gr = FindGlyphRef(&newHash, s, global, glyph->sha1))) {
+                if (global)
+                    GlyphKeyFromGlyph(&key, glyph);
+                if ((gr = FindGlyphRef(&newHash, s, global ? &key : NULL))) {
                     gr->signature = s;
                     gr->glyph = glyph;
                 }
@@ -10,12 +10,17 @@
 #include "glyphstr.h"
 #include "picture.h"
 #include "screenint.h"
+#include "scrnintstr.h"
 #include "regionstr.h"
 #include "miscstruct.h"
 #include "privates.h"
 
 #define GlyphPicture(glyph) ((PicturePtr *) ((glyph) + 1))
 
+/* copy of the glyph's bits, as uploaded by the client */
+#define GlyphBits(glyph) \
+    ((CARD8 *) (GlyphPicture(glyph) + screenInfo.numScreens))
+
 typedef struct {
     CARD32 signature;
     GlyphPtr glyph;
@@ -50,12 +55,14 @@ typedef struct {
     dixSetPrivate(&(pGlyphSet)->devPrivates, k, ptr)
 
 void GlyphUninit(ScreenPtr pScreen);
-GlyphPtr FindGlyphByHash(unsigned char sha1[20], int format);
+GlyphPtr FindGlyphByHash(unsigned char sha1[20], int format,
+                         xGlyphInfo * gi, CARD8 *bits);
 int HashGlyph(xGlyphInfo * gi, CARD8 *bits, unsigned long size, unsigned char sha1[20]);
 void AddGlyph(GlyphSetPtr glyphSet, GlyphPtr glyph, Glyph id);
 Bool DeleteGlyph(GlyphSetPtr glyphSet, Glyph id);
 GlyphPtr FindGlyph(GlyphSetPtr glyphSet, Glyph id);
-GlyphPtr AllocateGlyph(xGlyphInfo * gi, int format);
+GlyphPtr AllocateGlyph(xGlyphInfo * gi, int format,
+                       CARD8 *bits, unsigned long size);
 void FreeGlyph(GlyphPtr glyph, int format);
 Bool ResizeGlyphSet(GlyphSetPtr glyphSet, CARD32 change);
 GlyphSetPtr AllocateGlyphSet(int fdepth, PictFormatPtr format);
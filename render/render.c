@@ -1003,7 +1003,8 @@ ProcRenderAddGlyphs(ClientPtr client)
         if (err)
             goto bail;
 
-        glyph_new->glyph = FindGlyphByHash(glyph_new->sha1, glyphSet->fdepth);
+        glyph_new->glyph = FindGlyphByHash(glyph_new->sha1, glyphSet->fdepth,
+                                           &gi[i], bits);
 
         if (glyph_new->glyph && glyph_new->glyph != DeletedGlyph) {
             glyph_new->found = TRUE;
@@ -1013,7 +1014,8 @@ ProcRenderAddGlyphs(ClientPtr client)
             GlyphPtr glyph;
 
             glyph_new->found = FALSE;
-            glyph_new->glyph = glyph = AllocateGlyph(&gi[i], glyphSet->fdepth);
+            glyph_new->glyph = glyph = AllocateGlyph(&gi[i], glyphSet->fdepth,
+                                                   bits, size);
             if (!glyph) {
                 err = BadAlloc;
                 goto bail;
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+
+#include "dix/atom_priv.h"
+
+#include "misc.h"
+#include "dix.h"
+
+#include "tests-common.h"
+
+static void
+atom_predefined(void)
+{
+    InitAtoms();
+
+    assert(strcmp(NameForAtom(XA_PRIMARY), "PRIMARY") == 0);
+    assert(strcmp(NameForAtom(XA_WM_TRANSIENT_FOR), "WM_TRANSIENT_FOR") == 0);
+    assert(MakeAtom("STRING", strlen("STRING"), FALSE) == XA_STRING);
+    assert(MakeAtom("STRING", strlen("STRING"), TRUE) == XA_STRING);
+
+    assert(!ValidAtom(None));
+    assert(ValidAtom(XA_LAST_PREDEFINED));
+    assert(!ValidAtom(XA_LAST_PREDEFINED + 1));
+    assert(NameForAtom(XA_LAST_PREDEFINED + 1) == NULL);
+
+    FreeAllAtoms();
+}
+
+static void
+atom_intern(void)
+{
+    const char buf[] = "_NET_WM_NAMEXXX";
+    Atom a, b;
+
+    InitAtoms();
+
+    assert(MakeAtom("_NET_WM_NAME", 12, FALSE) == None);
+
+    /* names are length delimited, not NUL terminated */
+    a = MakeAtom(buf, 12, TRUE);
+    assert(a == XA_LAST_PREDEFINED + 1);
+    assert(ValidAtom(a));
+    assert(strcmp(NameForAtom(a), "_NET_WM_NAME") == 0);
+    assert(MakeAtom("_NET_WM_NAME", 12, FALSE) == a);
+
+    /* prefixes and extensions of an existing name are distinct atoms */
+    assert(MakeAtom(buf, 11, FALSE) == None);
+    assert(MakeAtom(buf, 13, FALSE) == None);
+    b = MakeAtom(buf, 11, TRUE);
+    assert(b == a + 1);
+    assert(strcmp(NameForAtom(b), "_NET_WM_NAM") == 0);
+    assert(MakeAtom(buf, 12, TRUE) == a);
+
+    /* the empty name is a valid atom name */
+    assert(MakeAtom("", 0, FALSE) == None);
+    assert(MakeAtom("", 0, TRUE) == b + 1);
+    assert(strcmp(NameForAtom(b + 1), "") == 0);
+
+    FreeAllAtoms();
+}
+
+static void
+atom_uninitialized(void)
+{
+    FreeAllAtoms();
+
+    assert(MakeAtom("PRIMARY", strlen("PRIMARY"), FALSE) == None);
+    assert(MakeAtom("_NET_WM_NAME", 12, TRUE) == None);
+    assert(NameForAtom(None) == NULL);
+    assert(NameForAtom(XA_PRIMARY) == NULL);
+    assert(!ValidAtom(XA_PRIMARY));
+}
+
+static void
+atom_grow(void)
+{
+    const int count = 50000;
+    char name[32];
+
+    InitAtoms();
+
+    for (int i = 0; i < count; i++) {
+        int len = snprintf(name, sizeof(name), "ATOM_%d", i);
+
+        assert(MakeAtom(name, len, TRUE) == XA_LAST_PREDEFINED + 1 + i);
+    }
+
+    for (int i = 0; i < count; i++) {
+        Atom a = XA_LAST_PREDEFINED + 1 + i;
+        int len = snprintf(name, sizeof(name), "ATOM_%d", i);
+
+        assert(MakeAtom(name, len, FALSE) == a);
+        assert(strcmp(NameForAtom(a), name) == 0);
+    }
+
+    assert(strcmp(NameForAtom(XA_CUT_BUFFER0), "CUT_BUFFER0") == 0);
+    assert(!ValidAtom(XA_LAST_PREDEFINED + 1 + count));
+
+    FreeAllAtoms();
+}
+
+const testfunc_t*
+atom_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        atom_predefined,
+        atom_intern,
+        atom_uninitialized,
+        atom_grow,
+        NULL,
+    };
+    return testfuncs;
+}
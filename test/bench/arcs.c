@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for PolyArc and wide PolyLine requests as toolkits send
+ * them: radio buttons, rounded corners, elliptic gauges and round-capped
+ * polylines, again and again at the same sizes.  Each runs without the
+ * span cache and with it; the spans go nowhere, the spancache unit test
+ * checks they're the same either way.
+ */
+
+#include <dix-config.h>
+
+#include <X11/X.h>
+
+#include "mi/mi_priv.h"
+
+#include "gcstruct.h"
+#include "misc.h"
+#include "pixmapstr.h"
+
+#include "bench.h"
+
+#define REQUESTS    2000
+#define PER_REQUEST 32
+
+static PixmapRec pixmap;
+static GCRec gc;
+static GCOps ops;
+
+static void
+bench_fill_spans(DrawablePtr pDrawable, GCPtr pGC, int n, DDXPointPtr ppt,
+                 int *pwidth, int fSorted)
+{
+}
+
+static void
+bench_setup(void)
+{
+    pixmap.drawable.type = DRAWABLE_PIXMAP;
+    pixmap.drawable.width = 2048;
+    pixmap.drawable.height = 2048;
+    pixmap.drawable.depth = 24;
+
+    ops.FillSpans = bench_fill_spans;
+    gc.ops = &ops;
+    gc.alu = GXcopy;
+    gc.fillStyle = FillSolid;
+    gc.lineStyle = LineSolid;
+    gc.capStyle = CapButt;
+    gc.joinStyle = JoinMiter;
+    gc.miTranslate = 1;
+}
+
+static void
+bench_radio_buttons(int request)
+{
+    xArc arcs[PER_REQUEST];
+
+    gc.lineWidth = 2;
+    for (int i = 0; i < PER_REQUEST; i++)
+        arcs[i] = (xArc) {
+            .x = i * 20, .y = request % 100 * 20,
+            .width = 13, .height = 13, .angle1 = 0, .angle2 = 360 * 64
+        };
+    miPolyArc(&pixmap.drawable, &gc, PER_REQUEST, arcs);
+}
+
+static void
+bench_rounded_corners(int request)
+{
+    xArc arcs[PER_REQUEST];
+
+    gc.lineWidth = 3;
+    for (int i = 0; i < PER_REQUEST; i++)
+        arcs[i] = (xArc) {
+            .x = i * 40, .y = request % 100 * 20,
+            .width = 16, .height = 16,
+            .angle1 = i % 4 * 90 * 64, .angle2 = 90 * 64
+        };
+    miPolyArc(&pixmap.drawable, &gc, PER_REQUEST, arcs);
+}
+
+static void
+bench_gauges(int request)
+{
+    xArc arcs[PER_REQUEST];
+
+    gc.lineWidth = 5;
+    for (int i = 0; i < PER_REQUEST; i++)
+        arcs[i] = (xArc) {
+            .x = i * 64, .y = request % 50 * 40,
+            .width = 60, .height = 30 + i % 2 * 10,
+            .angle1 = -45 * 64, .angle2 = 270 * 64
+        };
+    miPolyArc(&pixmap.drawable, &gc, PER_REQUEST, arcs);
+}
+
+static void
+bench_round_lines(int request)
+{
+    DDXPointRec points[PER_REQUEST];
+
+    gc.lineWidth = 9;
+    gc.capStyle = CapRound;
+    gc.joinStyle = JoinRound;
+    for (int i = 0; i < PER_REQUEST; i++) {
+        points[i].x = i * 60;
+        points[i].y = request % 100 * 20 + i % 2 * 15;
+    }
+    miWideLine(&pixmap.drawable, &gc, CoordModeOrigin, PER_REQUEST, points);
+    gc.capStyle = CapButt;
+    gc.joinStyle = JoinMiter;
+}
+
+static void
+bench_run(const char *name, void (*request)(int))
+{
+    uint64_t start;
+    char label[64];
+
+    miSpanCacheSetSize(0);
+    start = bench_now_ns();
+    for (int i = 0; i < REQUESTS; i++)
+        request(i);
+    snprintf(label, sizeof(label), "%s, uncached", name);
+    bench_report(label, REQUESTS * PER_REQUEST, bench_now_ns() - start);
+
+    miSpanCacheSetSize(MI_SPAN_CACHE_BYTES);
+    start = bench_now_ns();
+    for (int i = 0; i < REQUESTS; i++)
+        request(i);
+    snprintf(label, sizeof(label), "%s, cached", name);
+    bench_report(label, REQUESTS * PER_REQUEST, bench_now_ns() - start);
+    printf("%-40s %lu hits, %lu misses\n", "", miSpanCacheStats.hits,
+           miSpanCacheStats.misses);
+}
+
+int
+main(void)
+{
+    bench_setup();
+
+    bench_run("radio buttons 13x13", bench_radio_buttons);
+    bench_run("rounded corners 16x16", bench_rounded_corners);
+    bench_run("elliptic gauges 60x30", bench_gauges);
+    bench_run("round polylines", bench_round_lines);
+
+    miSpanCacheFlush();
+    return 0;
+}
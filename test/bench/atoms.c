@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Microbenchmark for InternAtom / GetAtomName style lookups */
+
+#include <dix-config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+
+#include "dix/atom_priv.h"
+
+#include "misc.h"
+#include "dix.h"
+
+#include "bench.h"
+
+static char **
+make_names(unsigned long count)
+{
+    char **names = calloc(count, sizeof(char *));
+
+    if (!names)
+        abort();
+    for (unsigned long i = 0; i < count; i++) {
+        /* look roughly like what toolkits intern per window/selection */
+        if (asprintf(&names[i], "_XLIB_BENCH_ATOM_%lx_%lu", i * 2654435761ul, i) < 0)
+            abort();
+    }
+    return names;
+}
+
+static void
+bench_atoms(unsigned long count)
+{
+    char **names = make_names(count);
+    char label[64];
+    volatile const char *sink;
+    uint64_t start;
+
+    InitAtoms();
+
+    snprintf(label, sizeof(label), "intern new (%lu atoms)", count);
+    start = bench_now_ns();
+    for (unsigned long i = 0; i < count; i++)
+        MakeAtom(names[i], strlen(names[i]), TRUE);
+    bench_report(label, count, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "intern existing (%lu atoms)", count);
+    start = bench_now_ns();
+    for (unsigned long i = 0; i < count; i++)
+        MakeAtom(names[i], strlen(names[i]), TRUE);
+    bench_report(label, count, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "lookup only-if-exists miss (%lu)", count);
+    start = bench_now_ns();
+    for (unsigned long i = 0; i < count; i++)
+        MakeAtom(names[i], strlen(names[i]) - 1, FALSE);
+    bench_report(label, count, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "NameForAtom (%lu atoms)", count);
+    start = bench_now_ns();
+    for (unsigned long i = 0; i < count; i++)
+        sink = NameForAtom(XA_LAST_PREDEFINED + 1 + i);
+    bench_report(label, count, bench_now_ns() - start);
+    (void) sink;
+
+    FreeAllAtoms();
+
+    for (unsigned long i = 0; i < count; i++)
+        free(names[i]);
+    free(names);
+}
+
+int
+main(void)
+{
+    bench_atoms(1000);
+    bench_atoms(100000);
+    bench_atoms(1000000);
+    return 0;
+}
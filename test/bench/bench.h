@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+#ifndef XSERVER_TEST_BENCH_H
+#define XSERVER_TEST_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Minimal helpers shared by the microbenchmarks in this directory.  They
+ * are run by `meson test --benchmark` and only print their results; they
+ * never fail on timing.
+ */
+
+static inline uint64_t
+bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void
+bench_report(const char *name, unsigned long n, uint64_t ns)
+{
+    printf("%-40s %10lu ops %10.1f ns/op %12.0f ops/s\n",
+           name, n, n ? (double) ns / n : 0.0,
+           ns ? (double) n * 1e9 / ns : 0.0);
+}
+
+/* for throughput benchmarks: n operations moving bytes in total */
+static inline void
+bench_report_bytes(const char *name, unsigned long n, uint64_t bytes,
+                   uint64_t ns)
+{
+    printf("%-40s %10lu ops %10.1f ns/op %12.1f MB/s\n",
+           name, n, n ? (double) ns / n : 0.0,
+           ns ? (double) bytes * 1e3 / ns : 0.0);
+}
+
+#endif /* XSERVER_TEST_BENCH_H */
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Microbenchmark for fbBlt, with and without the vector kernels */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "fb/fb_priv.h"
+
+#include "bench.h"
+
+#define WIDTH   1920
+#define HEIGHT  1080
+#define ROUNDS  20
+
+static FbBits *src, *dst;
+
+/* one blit of almost the whole buffer, shaped like CopyArea does it */
+static void
+bench_blt(const char *impl, const char *what, int bpp, int alu,
+          FbBits *from, int sx, int sy, int dx, int dy)
+{
+    FbStride stride = WIDTH * bpp / FB_UNIT;
+    int w = WIDTH - 64, h = HEIGHT - 16;
+    Bool reverse = from == dst && dy == sy && dx > sx;
+    Bool upsidedown = from == dst && dy > sy;
+    char label[64];
+    uint64_t start;
+
+    snprintf(label, sizeof(label), "%s %s %s %dbpp", impl,
+             alu == GXcopy ? "copy" : "xor", what, bpp);
+    start = bench_now_ns();
+    for (int i = 0; i < ROUNDS; i++)
+        fbBlt(from + sy * stride, stride, sx * bpp, dst + dy * stride, stride,
+              dx * bpp, w * bpp, h, alu, FB_ALLONES, bpp, reverse, upsidedown);
+    bench_report_bytes(label, ROUNDS, (uint64_t) ROUNDS * w * h * bpp / 8,
+                       bench_now_ns() - start);
+}
+
+static void
+bench_bpp(const char *impl, int bpp)
+{
+    static const int alus[] = { GXcopy, GXxor };
+
+    for (size_t i = 0; i < ARRAY_SIZE(alus); i++) {
+        /* same offset within the words, different buffers */
+        bench_blt(impl, "aligned", bpp, alus[i], src, 32, 8, 32, 8);
+        /* needs shifting */
+        bench_blt(impl, "unaligned", bpp, alus[i], src, 33, 8, 40, 8);
+        /* scrolling within one buffer, in both directions */
+        bench_blt(impl, "overlap left", bpp, alus[i], dst, 40, 8, 32, 8);
+        bench_blt(impl, "overlap right", bpp, alus[i], dst, 32, 8, 37, 8);
+        bench_blt(impl, "overlap up", bpp, alus[i], dst, 32, 12, 32, 4);
+    }
+}
+
+int
+main(void)
+{
+    static const int bpps[] = { 8, 16, 32 };
+    size_t size = (size_t) WIDTH * HEIGHT * 4;
+
+    src = malloc(size);
+    dst = malloc(size);
+    if (!src || !dst)
+        abort();
+    memset(src, 0x5a, size);
+    memset(dst, 0xa5, size);
+
+    for (size_t i = 0; i < ARRAY_SIZE(bpps); i++) {
+#ifdef FB_BLT_SIMD
+        const char *simd;
+
+        fbInitBltSimd(FALSE);
+        bench_bpp("C", bpps[i]);
+        simd = fbInitBltSimd(TRUE);
+        if (simd)
+            bench_bpp(simd, bpps[i]);
+#else
+        bench_bpp("C", bpps[i]);
+#endif
+    }
+
+    free(src);
+    free(dst);
+    return 0;
+}
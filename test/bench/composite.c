@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for updating automatically redirected windows, single vs.
+ * multi threaded: a grid of windows over a 4K screen, every other one
+ * with a redirected child of its own.  Each threaded run is checked
+ * against a single threaded one byte for byte.  Like in the fb bench, the
+ * screen and pictures are just enough for fb to work with; the windows
+ * are small enough for each to be a task of its own.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "composite/compint.h"
+#include "fb/fb_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "misc.h"
+#include "pixmapstr.h"
+#include "picturestr.h"
+
+#include "bench.h"
+
+#define WIDTH   3840
+#define HEIGHT  2160
+#define COLUMNS 16
+#define ROWS    10
+#define ROUNDS  10
+
+#define WINDOWS (COLUMNS * ROWS)
+
+static ScreenRec screen;
+static FbScreenPrivRec fbScreen;
+static PictFormatRec format;
+
+static void
+bench_setup(void)
+{
+    DevPrivateKey key = fbGetScreenPrivateKey();
+
+    key->offset = 0;
+    key->size = sizeof(FbScreenPrivRec);
+    key->initialized = TRUE;
+    screen.devPrivates = (PrivatePtr) &fbScreen;
+    format.format = PICT_a8r8g8b8;
+}
+
+static void
+bench_pixmap(PixmapPtr pPixmap, int x, int y, int w, int h, int seed)
+{
+    CARD32 *bits;
+
+    pPixmap->drawable.type = DRAWABLE_PIXMAP;
+    pPixmap->drawable.pScreen = &screen;
+    pPixmap->drawable.width = w;
+    pPixmap->drawable.height = h;
+    pPixmap->drawable.depth = 32;
+    pPixmap->drawable.bitsPerPixel = 32;
+    pPixmap->devKind = w * 4;
+    pPixmap->screen_x = x;
+    pPixmap->screen_y = y;
+    pPixmap->devPrivate.ptr = bits = calloc(h, pPixmap->devKind);
+    if (!bits)
+        abort();
+    for (int i = 0; i < w * h; i++)
+        bits[i] = seed * 0x01010101u + i;
+}
+
+static PicturePtr
+bench_picture(PixmapPtr pPixmap, pixman_format_code_t pictFormat)
+{
+    PicturePtr pPicture = calloc(1, sizeof(PictureRec));
+
+    if (!pPicture)
+        abort();
+    pPicture->pDrawable = &pPixmap->drawable;
+    pPicture->pFormat = &format;
+    pPicture->format = pictFormat;
+    return pPicture;
+}
+
+/* the damage of a window: a band through the middle and a corner */
+static void
+bench_job(CompPaintJobPtr job, PixmapPtr pSrc, PixmapPtr pDst, int level)
+{
+    int x = pSrc->screen_x, y = pSrc->screen_y;
+    int w = pSrc->drawable.width, h = pSrc->drawable.height;
+    BoxRec boxes[] = {
+        { x, y, x + w / 3, y + h / 3 },
+        { x, y + h / 2, x + w, y + h / 2 + h / 4 },
+    };
+    RegionRec corner;
+
+    RegionInit(&job->region, &boxes[1], 1);
+    RegionInit(&corner, &boxes[0], 1);
+    RegionUnion(&job->region, &job->region, &corner);
+    RegionUninit(&corner);
+
+    job->pSrc = bench_picture(pSrc, PICT_a8r8g8b8);
+    job->pDst = bench_picture(pDst, PICT_x8r8g8b8);
+    /* the parent's pixmap stands in for the parent window */
+    job->pDst->pCompositeClip = RegionCreate(NullBox, 0);
+    RegionCopy(job->pDst->pCompositeClip, &job->region);
+    RegionTranslate(job->pDst->pCompositeClip, -pDst->screen_x,
+                    -pDst->screen_y);
+    job->pSrcPixmap = pSrc;
+    job->pDstPixmap = pDst;
+    job->xDst = pSrc->screen_x - pDst->screen_x;
+    job->yDst = pSrc->screen_y - pDst->screen_y;
+    job->level = level;
+}
+
+int
+main(void)
+{
+    static PixmapRec windows[WINDOWS], children[WINDOWS];
+    static CompPaintJobRec jobs[2 * WINDOWS];
+    PixmapRec root = { 0 }, reference = { 0 };
+    int cpus = ThreadPoolDefaultThreads();
+    int w = WIDTH / COLUMNS, h = HEIGHT / ROWS;
+    int njobs = 0;
+    uint64_t bytes = 0;
+
+    bench_setup();
+    bench_pixmap(&root, 0, 0, WIDTH, HEIGHT, 0);
+    bench_pixmap(&reference, 0, 0, WIDTH, HEIGHT, 0);
+    for (int i = 0; i < WINDOWS; i++) {
+        int x = (i % COLUMNS) * w, y = (i / COLUMNS) * h;
+
+        bench_pixmap(&windows[i], x, y, w, h, i + 1);
+        if (i % 2) {
+            bench_pixmap(&children[i], x + w / 4, y + h / 4, w / 2, h / 2,
+                         i + 101);
+            bench_job(&jobs[njobs++], &children[i], &windows[i], 0);
+            bench_job(&jobs[njobs++], &windows[i], &root, 1);
+        }
+        else {
+            bench_job(&jobs[njobs++], &windows[i], &root, 0);
+        }
+    }
+    for (int i = 0; i < njobs; i++) {
+        BoxPtr extents = RegionExtents(&jobs[i].region);
+
+        bytes += (uint64_t) (extents->x2 - extents->x1) *
+            (extents->y2 - extents->y1) * 4;
+    }
+
+    /* what the main thread does on its own */
+    memset(reference.devPrivate.ptr, 0, HEIGHT * reference.devKind);
+    for (int i = 0; i < njobs; i++) {
+        if (jobs[i].pDstPixmap == &root)
+            jobs[i].pDst->pDrawable = &reference.drawable;
+    }
+    compPaintRun(NULL, jobs, njobs);
+    for (int i = 0; i < njobs; i++) {
+        if (jobs[i].pDstPixmap == &root)
+            jobs[i].pDst->pDrawable = &root.drawable;
+    }
+
+    for (int threads = 1; threads <= cpus; threads *= 2) {
+        ThreadPoolPtr pool = ThreadPoolCreate(threads, "bench");
+        char label[64];
+        uint64_t start;
+
+        memset(root.devPrivate.ptr, 0, HEIGHT * root.devKind);
+        snprintf(label, sizeof(label), "%d windows, %d threads", njobs,
+                 ThreadPoolThreads(pool));
+        start = bench_now_ns();
+        for (int i = 0; i < ROUNDS; i++)
+            compPaintRun(pool, jobs, njobs);
+        bench_report_bytes(label, ROUNDS, ROUNDS * bytes,
+                           bench_now_ns() - start);
+
+        /* only the damage is copied, everything else stays 0 */
+        if (memcmp(root.devPrivate.ptr, reference.devPrivate.ptr,
+                   HEIGHT * root.devKind) != 0) {
+            fprintf(stderr, "threaded result differs\n");
+            abort();
+        }
+        ThreadPoolDestroy(pool);
+    }
+
+    for (int i = 0; i < njobs; i++) {
+        RegionUninit(&jobs[i].region);
+        RegionDestroy(jobs[i].pDst->pCompositeClip);
+        free(jobs[i].pSrc);
+        free(jobs[i].pDst);
+    }
+    for (int i = 0; i < WINDOWS; i++) {
+        free(windows[i].devPrivate.ptr);
+        free(children[i].devPrivate.ptr);
+    }
+    free(root.devPrivate.ptr);
+    free(reference.devPrivate.ptr);
+    return 0;
+}
@@ -0,0 +1,205 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for threaded fb rendering: fills, image uploads and
+ * composites over a 4K pixmap, with the worker pool at different sizes.
+ * Each threaded run is checked against a single threaded one byte for
+ * byte.  The screen, GC and pictures are just enough for fb to work with.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "fb/fb_priv.h"
+#include "fb/fbpict_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "gcstruct.h"
+#include "misc.h"
+#include "pixmapstr.h"
+#include "picturestr.h"
+
+#include "bench.h"
+
+#define WIDTH   3840
+#define HEIGHT  2160
+#define ROUNDS  10
+#define RECTS   20000
+
+static ScreenRec screen;
+static FbScreenPrivRec fbScreen;
+static PixmapRec pixmap;
+static GCRec gc;
+static FbGCPrivRec fbGC;
+static RegionRec clip;
+static PictFormatRec format;
+static PictureRec srcPicture, dstPicture;
+static PixmapRec srcPixmap;
+static xRectangle rects[RECTS];
+static CARD32 *reference;
+
+static void
+bench_source_validate(DrawablePtr pDrawable, int x, int y, int w, int h,
+                      unsigned int subWindowMode)
+{
+}
+
+static void
+bench_pixmap(PixmapPtr pPixmap, int depth, int seed)
+{
+    CARD32 *bits;
+
+    pPixmap->drawable.type = DRAWABLE_PIXMAP;
+    pPixmap->drawable.pScreen = &screen;
+    pPixmap->drawable.width = WIDTH;
+    pPixmap->drawable.height = HEIGHT;
+    pPixmap->drawable.depth = depth;
+    pPixmap->drawable.bitsPerPixel = 32;
+    pPixmap->devKind = WIDTH * 4;
+    pPixmap->devPrivate.ptr = bits = malloc(HEIGHT * pPixmap->devKind);
+    if (!bits)
+        abort();
+    for (int i = 0; i < WIDTH * HEIGHT; i++)
+        bits[i] = seed * 0x01010101u + i * 0x9e3779b9u;
+}
+
+static void
+bench_setup(void)
+{
+    DevPrivateKey key = fbGetScreenPrivateKey();
+    BoxRec box = { 0, 0, WIDTH, HEIGHT };
+
+    key->offset = 0;
+    key->size = sizeof(FbScreenPrivRec);
+    key->initialized = TRUE;
+    screen.devPrivates = (PrivatePtr) &fbScreen;
+    screen.SourceValidate = bench_source_validate;
+
+    fbScreen.gcPrivateKeyRec.size = sizeof(FbGCPrivRec);
+    fbScreen.gcPrivateKeyRec.initialized = TRUE;
+    gc.devPrivates = (PrivatePtr) &fbGC;
+    gc.pScreen = &screen;
+    gc.fillStyle = FillSolid;
+    gc.pCompositeClip = &clip;
+    RegionInit(&clip, &box, 1);
+
+    bench_pixmap(&pixmap, 24, 0);
+    bench_pixmap(&srcPixmap, 32, 1);
+    reference = malloc(HEIGHT * pixmap.devKind);
+    if (!reference)
+        abort();
+
+    format.format = PICT_a8r8g8b8;
+    srcPicture.pDrawable = &srcPixmap.drawable;
+    srcPicture.pFormat = &format;
+    srcPicture.format = PICT_a8r8g8b8;
+    dstPicture.pDrawable = &pixmap.drawable;
+    dstPicture.pFormat = &format;
+    dstPicture.format = PICT_x8r8g8b8;
+    dstPicture.pCompositeClip = &clip;
+
+    srand(1);
+    for (int i = 0; i < RECTS; i++) {
+        rects[i].x = rand() % WIDTH - 24;
+        rects[i].y = rand() % HEIGHT - 24;
+        rects[i].width = 48;
+        rects[i].height = 48;
+    }
+}
+
+/* a solid fill of the whole pixmap, done by pixman */
+static void
+bench_fill(void)
+{
+    xRectangle rect = { 0, 0, WIDTH, HEIGHT };
+
+    gc.alu = GXcopy;
+    fbGC.and = 0;
+    fbGC.xor = 0x336699;
+    fbPolyFillRect(&pixmap.drawable, &gc, 1, &rect);
+}
+
+/* lots of overlapping small rectangles, where the order matters */
+static void
+bench_fill_xor(void)
+{
+    gc.alu = GXxor;
+    fbGC.and = FB_ALLONES;
+    fbGC.xor = 0x010203;
+    fbPolyFillRect(&pixmap.drawable, &gc, RECTS, rects);
+}
+
+/* what fbPutImage() does with a ZPixmap */
+static void
+bench_put_image(void)
+{
+    fbPutZImage(&pixmap.drawable, &clip, GXcopy, FB_ALLONES,
+                0, 0, WIDTH, HEIGHT, srcPixmap.devPrivate.ptr, WIDTH);
+}
+
+static void
+bench_composite(void)
+{
+    fbComposite(PictOpOver, &srcPicture, NULL, &dstPicture,
+                0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+}
+
+static void
+bench_run(const char *name, void (*op)(void), uint64_t pixels)
+{
+    int cpus;
+
+    WorkerThreads = 0;
+    cpus = ThreadPoolDefaultThreads();
+
+    /* what the main thread does on its own */
+    fbSetThreaded(&screen, FALSE);
+    memset(pixmap.devPrivate.ptr, 0, HEIGHT * pixmap.devKind);
+    op();
+    memcpy(reference, pixmap.devPrivate.ptr, HEIGHT * pixmap.devKind);
+
+    for (int threads = 1; threads <= cpus; threads *= 2) {
+        char label[64];
+        uint64_t start;
+
+        WorkerThreads = threads;
+        ThreadPoolServerFini();
+        fbSetThreaded(&screen, TRUE);
+
+        memset(pixmap.devPrivate.ptr, 0, HEIGHT * pixmap.devKind);
+        op();
+        if (memcmp(pixmap.devPrivate.ptr, reference,
+                   HEIGHT * pixmap.devKind) != 0) {
+            fprintf(stderr, "%s: threaded result differs\n", name);
+            abort();
+        }
+
+        snprintf(label, sizeof(label), "%s, %d threads", name, threads);
+        start = bench_now_ns();
+        for (int i = 0; i < ROUNDS; i++)
+            op();
+        bench_report_bytes(label, ROUNDS, ROUNDS * pixels * 4,
+                           bench_now_ns() - start);
+    }
+    ThreadPoolServerFini();
+}
+
+int
+main(void)
+{
+    bench_setup();
+
+    bench_run("fill", bench_fill, (uint64_t) WIDTH * HEIGHT);
+    bench_run("fill xor 48x48", bench_fill_xor, (uint64_t) RECTS * 48 * 48);
+    bench_run("put image", bench_put_image, (uint64_t) WIDTH * HEIGHT);
+    bench_run("composite over", bench_composite, (uint64_t) WIDTH * HEIGHT);
+
+    RegionUninit(&clip);
+    free(pixmap.devPrivate.ptr);
+    free(srcPixmap.devPrivate.ptr);
+    free(reference);
+    return 0;
+}
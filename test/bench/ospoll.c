@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for the ospoll loop the way connection.c and io.c use
+ * it: edge triggered clients that all send a request at once, get read
+ * and reset, some with replies waiting to be flushed.  Which backend it
+ * measures depends on how the server is built.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <X11/X.h>
+
+#include "os/ospoll.h"
+
+#include "misc.h"
+
+#include "bench.h"
+
+#define ROUNDS      2000
+#define MAX_CLIENTS 400
+
+static struct ospoll *ospoll;
+static int sockets[MAX_CLIENTS][2];
+static int pending;
+static Bool flushing;
+
+static void
+bench_client_ready(int fd, int xevents, void *data)
+{
+    char buf[64];
+
+    if (xevents & X_NOTIFY_WRITE)
+        ospoll_mute(ospoll, fd, X_NOTIFY_WRITE);
+    if (!(xevents & X_NOTIFY_READ))
+        return;
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+    ospoll_reset_events(ospoll, fd);
+    /* a reply that didn't fit, as FlushClient() would leave it */
+    if (flushing)
+        ospoll_listen(ospoll, fd, X_NOTIFY_WRITE);
+    pending--;
+}
+
+static void
+bench_run(const char *name, int clients, Bool flush)
+{
+    uint64_t start;
+
+    flushing = flush;
+    for (int i = 0; i < clients; i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0,
+                       sockets[i]) < 0 ||
+            !ospoll_add(ospoll, sockets[i][0], ospoll_trigger_edge,
+                        bench_client_ready, NULL))
+            abort();
+        ospoll_listen(ospoll, sockets[i][0], X_NOTIFY_READ);
+    }
+
+    start = bench_now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < clients; i++)
+            if (write(sockets[i][1], "r", 1) != 1)
+                abort();
+        pending = clients;
+        while (pending > 0)
+            if (ospoll_wait(ospoll, 1000) <= 0)
+                abort();
+    }
+    bench_report(name, (unsigned long) ROUNDS * clients,
+                 bench_now_ns() - start);
+
+    for (int i = 0; i < clients; i++) {
+        ospoll_remove(ospoll, sockets[i][0]);
+        close(sockets[i][0]);
+        close(sockets[i][1]);
+    }
+}
+
+int
+main(void)
+{
+    ospoll = ospoll_create();
+    if (!ospoll)
+        abort();
+
+    bench_run("16 clients", 16, FALSE);
+    bench_run("16 clients, flushing", 16, TRUE);
+    bench_run("400 clients", 400, FALSE);
+    bench_run("400 clients, flushing", 400, TRUE);
+
+    ospoll_destroy(ospoll);
+    return 0;
+}
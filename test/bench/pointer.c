@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for turning pointer motion into events: replays traces
+ * of a high rate mouse with pointer acceleration and of a tablet, with
+ * and without a coordinate transformation matrix, through
+ * GetPointerEvents().  The devices are floating, so nothing but the
+ * valuator pipeline itself is measured.
+ */
+
+#include <dix-config.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+
+#include "dix/atom_priv.h"
+#include "dix/dix_priv.h"
+#include "dix/inpututils_priv.h"
+#include "mi/mipointer_priv.h"
+#include "Xi/xibarriers.h"
+
+#include "exevents.h"
+#include "inputstr.h"
+#include "misc.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+#include "xserver-properties.h"
+
+#include "bench.h"
+
+#define WIDTH       3840
+#define HEIGHT      2160
+#define EVENTS      200000
+#define TABLET_MAX  32767
+
+static ScreenRec screen;
+static WindowRec root;
+static WindowOptRec rootOptional;
+static InternalEvent *events;
+
+static Bool
+bench_sprite_init(DeviceIntPtr pDev, ScreenPtr pScreen)
+{
+    return TRUE;
+}
+
+static void
+bench_sprite_cleanup(DeviceIntPtr pDev, ScreenPtr pScreen)
+{
+}
+
+static Bool
+bench_realize_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
+{
+    return TRUE;
+}
+
+static void
+bench_set_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor,
+                 int x, int y)
+{
+}
+
+static void
+bench_move_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
+{
+}
+
+static Bool
+bench_cursor_off_screen(ScreenPtr *ppScreen, int *x, int *y)
+{
+    return FALSE;
+}
+
+static miPointerSpriteFuncRec spriteFuncs = {
+    .RealizeCursor = bench_realize_cursor,
+    .UnrealizeCursor = bench_realize_cursor,
+    .SetCursor = bench_set_cursor,
+    .MoveCursor = bench_move_cursor,
+    .DeviceCursorInitialize = bench_sprite_init,
+    .DeviceCursorCleanup = bench_sprite_cleanup,
+};
+
+static miPointerScreenFuncRec screenFuncs = {
+    .CursorOffScreen = bench_cursor_off_screen,
+    .WarpCursor = miPointerWarpCursor,
+};
+
+static int
+bench_device_proc(DeviceIntPtr dev, int what, int mode, int max)
+{
+    CARD8 map[4] = { 0, 1, 2, 3 };
+    Atom btn_labels[3] = { 0 };
+    Atom axes_labels[4] = { 0 };
+
+    if (what != DEVICE_INIT)
+        return Success;
+
+    if (!InitPointerDeviceStruct((DevicePtr) dev, map, 3, btn_labels,
+                                 (PtrCtrlProcPtr) NoopDDA,
+                                 GetMotionHistorySize(), 4, axes_labels))
+        return BadAlloc;
+    /* wheels are smooth scrolling axes, as with libinput */
+    SetScrollValuator(dev, 2, SCROLL_TYPE_VERTICAL, 15, SCROLL_FLAG_PREFERRED);
+    SetScrollValuator(dev, 3, SCROLL_TYPE_HORIZONTAL, 15, SCROLL_FLAG_NONE);
+    if (mode == Absolute) {
+        InitValuatorAxisStruct(dev, 0, axes_labels[0], 0, max, 1, 0, 1,
+                               Absolute);
+        InitValuatorAxisStruct(dev, 1, axes_labels[1], 0, max, 1, 0, 1,
+                               Absolute);
+    }
+    return Success;
+}
+
+static int
+bench_mouse_proc(DeviceIntPtr dev, int what)
+{
+    return bench_device_proc(dev, what, Relative, -1);
+}
+
+static int
+bench_tablet_proc(DeviceIntPtr dev, int what)
+{
+    return bench_device_proc(dev, what, Absolute, TABLET_MAX);
+}
+
+/*
+ * A floating slave, set up the way ActivateDevice() and AttachDevice() do,
+ * but without the core devices, clients and extensions they'd notify.
+ */
+static DeviceIntPtr
+bench_device(const char *name, DeviceProc proc)
+{
+    DeviceIntPtr dev = AddInputDevice(NULL, proc, TRUE);
+
+    if (!dev)
+        abort();
+    dev->name = strdup(name);
+    dev->type = SLAVE;
+    dev->coreEvents = FALSE;
+    if (proc(dev, DEVICE_INIT) != Success ||
+        !screen.DeviceCursorInitialize(dev, &screen))
+        abort();
+    dev->inited = TRUE;
+
+    dev->spriteInfo->sprite = calloc(1, sizeof(SpriteRec));
+    if (!dev->spriteInfo->sprite)
+        abort();
+    InitializeSprite(dev, &root);
+    dev->spriteInfo->spriteOwner = FALSE;
+    dev->spriteInfo->paired = dev;
+    dev->enabled = TRUE;
+    return dev;
+}
+
+static void
+bench_setup(void)
+{
+    screenInfo.numScreens = 1;
+    screenInfo.screens[0] = &screen;
+    screenInfo.width = WIDTH;
+    screenInfo.height = HEIGHT;
+    screen.width = WIDTH;
+    screen.height = HEIGHT;
+    screen.root = &root;
+    root.drawable.pScreen = &screen;
+    root.drawable.width = WIDTH;
+    root.drawable.height = HEIGHT;
+    root.optional = &rootOptional;
+
+    dixResetPrivates();
+    InitAtoms();
+    if (!miPointerInitialize(&screen, &spriteFuncs, &screenFuncs, TRUE) ||
+        !XIBarrierInit())
+        abort();
+
+    events = InitEventList(GetMaximumEventsNum());
+    if (!events)
+        abort();
+}
+
+static void
+bench_run(const char *name, DeviceIntPtr dev, int flags,
+          void (*motion)(ValuatorMask *mask, int i))
+{
+    ValuatorMask mask;
+    unsigned long n = 0;
+    uint64_t start;
+
+    start = bench_now_ns();
+    for (int i = 0; i < EVENTS; i++) {
+        valuator_mask_zero(&mask);
+        motion(&mask, i);
+        n += GetPointerEvents(events, dev, MotionNotify, 0, flags, &mask);
+    }
+    bench_report(name, EVENTS, bench_now_ns() - start);
+    if (!n) {
+        fprintf(stderr, "%s: no events\n", name);
+        abort();
+    }
+}
+
+/* an 8 kHz gaming mouse: small deltas, often on one axis only */
+static void
+bench_mouse_motion(ValuatorMask *mask, int i)
+{
+    int dx = (i / 500) % 2 ? -1 - i % 3 : 1 + i % 3;
+
+    valuator_mask_set(mask, 0, dx);
+    if (i % 4)
+        valuator_mask_set(mask, 1, i % 8 < 4 ? 1 : -1);
+}
+
+/* a pen drawing circles, now and then moving along one axis only */
+static void
+bench_tablet_motion(ValuatorMask *mask, int i)
+{
+    double a = i * 0.001;
+
+    valuator_mask_set(mask, 0, TABLET_MAX / 2 + cos(a) * TABLET_MAX / 3);
+    if (i % 16)
+        valuator_mask_set(mask, 1, TABLET_MAX / 2 + sin(a) * TABLET_MAX / 3);
+}
+
+/* a tablet turned on its side, as set up by xinput or xrandr scripts */
+static void
+bench_rotate(DeviceIntPtr dev)
+{
+    float rotation[9] = { 0, -1, 1, 1, 0, 0, 0, 0, 1 };
+
+    if (XIChangeDeviceProperty(dev, XIGetKnownProperty(XI_PROP_TRANSFORM),
+                               XIGetKnownProperty(XATOM_FLOAT), 32,
+                               PropModeReplace, 9, rotation,
+                               FALSE) != Success)
+        abort();
+}
+
+int
+main(void)
+{
+    DeviceIntPtr mouse, tablet;
+
+    bench_setup();
+    mouse = bench_device("bench mouse", bench_mouse_proc);
+    tablet = bench_device("bench tablet", bench_tablet_proc);
+
+    bench_run("mouse, accelerated", mouse,
+              POINTER_RELATIVE | POINTER_ACCELERATE, bench_mouse_motion);
+    bench_run("mouse, unaccelerated", mouse,
+              POINTER_RELATIVE, bench_mouse_motion);
+    bench_run("tablet", tablet, POINTER_ABSOLUTE, bench_tablet_motion);
+    bench_rotate(tablet);
+    bench_run("tablet, rotated", tablet, POINTER_ABSOLUTE,
+              bench_tablet_motion);
+
+    FreeEventList(events, GetMaximumEventsNum());
+    return 0;
+}
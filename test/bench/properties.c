@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Microbenchmark for window property lookup vs. property count */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+
+#include "dix/property_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "privates.h"
+#include "windowstr.h"
+#include "propertyst.h"
+
+#include "bench.h"
+
+#define LOOKUPS 1000000
+
+static void
+bench_properties(unsigned int count)
+{
+    ClientRec client = { 0 };
+    WindowOptRec optional = { 0 };
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+    CARD32 value = 0;
+    PropertyPtr pProp;
+    char label[64];
+    uint64_t start;
+
+    if (!pWin)
+        abort();
+    pWin->optional = &optional;
+
+    for (unsigned int i = 0; i < count; i++) {
+        if (dixChangeWindowProperty(&client, pWin, XA_LAST_PREDEFINED + 1 + i,
+                                    XA_CARDINAL, 32, PropModeReplace, 1,
+                                    &value, FALSE) != Success)
+            abort();
+    }
+
+    snprintf(label, sizeof(label), "lookup hit (%u properties)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        Atom name = XA_LAST_PREDEFINED + 1 + (i * 2654435761u) % count;
+
+        if (dixLookupProperty(&pProp, pWin, name, &client,
+                              DixReadAccess) != Success)
+            abort();
+    }
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "lookup miss (%u properties)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < LOOKUPS; i++)
+        dixLookupProperty(&pProp, pWin, XA_LAST_PREDEFINED + 1 + count + i,
+                          &client, DixReadAccess);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "change replace (%u properties)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        Atom name = XA_LAST_PREDEFINED + 1 + (i * 2654435761u) % count;
+
+        dixChangeWindowProperty(&client, pWin, name, XA_CARDINAL, 32,
+                                PropModeReplace, 1, &value, FALSE);
+    }
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    /* properties are leaked on purpose, deleting them would deliver
+       PropertyNotify events through the whole input machinery */
+}
+
+int
+main(void)
+{
+    static const unsigned int counts[] = { 1, 4, 8, 16, 64, 256, 1024 };
+
+    if (!PropertyIndexInit())
+        abort();
+    for (size_t i = 0; i < ARRAY_SIZE(counts); i++)
+        bench_properties(counts[i]);
+    return 0;
+}
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for the RECORD set lookups done for every recorded
+ * request, reply and event: the set operations vs. the compiled masks,
+ * for major opcodes and for a recorder selecting minor opcodes of lots of
+ * extensions.  Every mask is checked against the set it came from.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix.h"
+#include "misc.h"
+#include "record/set.h"
+
+#include "bench.h"
+
+#define LOOKUPS     1000000
+#define EXTENSIONS  32
+
+static void
+bench_check(RecordSetPtr pSet, const RecordSetMaskRec *pMask)
+{
+    for (int m = 0; m < 256; m++) {
+        if (!RecordIsMemberOfSet(pSet, m) != !RecordMaskIsMember(pMask, m)) {
+            fprintf(stderr, "mask disagrees on %d\n", m);
+            abort();
+        }
+    }
+}
+
+static RecordSetPtr
+bench_set(RecordSetInterval *intervals, int n, RecordSetMaskPtr pMask)
+{
+    RecordSetPtr pSet = RecordCreateSet(intervals, n, NULL, 0);
+
+    if (!pSet)
+        abort();
+    memset(pMask, 0, sizeof(*pMask));
+    RecordSetCompileMask(pSet, pMask);
+    bench_check(pSet, pMask);
+    return pSet;
+}
+
+static void
+bench_majors(const char *name, RecordSetInterval *intervals, int n)
+{
+    RecordSetMaskRec mask;
+    RecordSetPtr pSet = bench_set(intervals, n, &mask);
+    unsigned long found = 0;
+    char label[64];
+    uint64_t start;
+
+    snprintf(label, sizeof(label), "set %s", name);
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++)
+        found += !!RecordIsMemberOfSet(pSet, (i * 7) & 255);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "mask %s", name);
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++)
+        found -= RecordMaskIsMember(&mask, (i * 7) & 255);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    if (found)
+        abort();
+    RecordDestroySet(pSet);
+}
+
+/* a selection of a few minor opcodes of each of lots of extensions */
+static void
+bench_minors(void)
+{
+    RecordSetPtr sets[EXTENSIONS];
+    int majors[EXTENSIONS];
+    RecordSetMaskPtr masks = calloc(128, sizeof(RecordSetMaskRec));
+    unsigned long found = 0;
+    uint64_t start;
+
+    if (!masks)
+        abort();
+    srandom(1);
+    for (int e = 0; e < EXTENSIONS; e++) {
+        RecordSetInterval intervals[4];
+        RecordSetMaskRec mask;
+
+        for (int i = 0; i < 4; i++) {
+            intervals[i].first = random() % 40;
+            intervals[i].last = intervals[i].first + random() % 3;
+        }
+        majors[e] = 128 + e * 3;
+        sets[e] = bench_set(intervals, 4, &mask);
+        RecordSetCompileMask(sets[e], &masks[majors[e] - 128]);
+    }
+
+    /* what RecordARequest walked for each extension request */
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++) {
+        int major = 128 + (i * 7) % 100;
+        int minor = (i * 13) % 48;
+
+        for (int e = 0; e < EXTENSIONS; e++) {
+            if (major == majors[e] && RecordIsMemberOfSet(sets[e], minor)) {
+                found++;
+                break;
+            }
+        }
+    }
+    bench_report("set walk, 32 extensions", LOOKUPS, bench_now_ns() - start);
+
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++) {
+        int major = 128 + (i * 7) % 100;
+        int minor = (i * 13) % 48;
+
+        found -= RecordMaskIsMember(&masks[major - 128], minor);
+    }
+    bench_report("masks, 32 extensions", LOOKUPS, bench_now_ns() - start);
+
+    if (found)
+        abort();
+    for (int e = 0; e < EXTENSIONS; e++)
+        RecordDestroySet(sets[e]);
+    free(masks);
+}
+
+int
+main(void)
+{
+    RecordSetInterval all[] = { { 0, 255 } };
+    RecordSetInterval core[] = { { 1, 127 } };
+    RecordSetInterval scattered[] = {
+        { 1, 1 }, { 8, 12 }, { 18, 18 }, { 40, 45 }, { 60, 61 }, { 98, 98 },
+        { 130, 140 }, { 200, 255 },
+    };
+    RecordSetInterval minors[] = { { 0, 65535 } };
+
+    bench_majors("all majors", all, ARRAY_SIZE(all));
+    bench_majors("core majors", core, ARRAY_SIZE(core));
+    bench_majors("scattered majors", scattered, ARRAY_SIZE(scattered));
+    bench_majors("all minors", minors, ARRAY_SIZE(minors));
+    bench_minors();
+    return 0;
+}
@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for ReadRequestFromClient() the way Dispatch() calls it:
+ * a client streaming small requests, handed out one by one until its
+ * input runs dry, then read again.  The transport is a buffer, so only
+ * the splitting up of the input is measured, not the socket.
+ */
+
+#include <dix-config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+
+#include "dix/dixstruct_priv.h"
+#include "os/client_priv.h"
+#include "os/osdep.h"
+#include "os/ospoll.h"
+#include "os/Xtransint.h"
+
+#include "dixstruct.h"
+#include "misc.h"
+
+#include "bench.h"
+
+#define STREAM  (64 * 1024)
+#define ROUNDS  2000
+
+static char stream[STREAM];
+static int streamLen, streamPos;
+
+static int
+bench_read(XtransConnInfo ciptr, char *buf, int size)
+{
+    if (streamPos == streamLen) {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (size > streamLen - streamPos)
+        size = streamLen - streamPos;
+    memcpy(buf, stream + streamPos, size);
+    streamPos += size;
+    return size;
+}
+
+static Xtransport transport = {
+    .TransName = "bench",
+    .Read = bench_read,
+};
+
+/* fills the stream with requests of these sizes in 4 byte units, in turn */
+static void
+bench_stream(const int *lengths, int n)
+{
+    streamLen = 0;
+    for (int i = 0; streamLen + lengths[i % n] * 4 <= STREAM; i++) {
+        xReq *req = (xReq *) (stream + streamLen);
+
+        req->reqType = X_NoOperation;
+        req->length = lengths[i % n];
+        streamLen += lengths[i % n] * 4;
+    }
+}
+
+static void
+bench_run(const char *name, const int *lengths, int n)
+{
+    struct _XtransConnInfo conn = { .transptr = &transport };
+    OsCommRec oc = { .fd = -1, .trans_conn = &conn };
+    ClientRec client = {
+        .index = 1,
+        .osPrivate = &oc,
+        .clientState = ClientStateRunning,
+    };
+    unsigned long requests = 0;
+    uint64_t start;
+
+    xorg_list_init(&client.ready);
+    xorg_list_init(&client.output_pending);
+    bench_stream(lengths, n);
+
+    start = bench_now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        streamPos = 0;
+        while (ReadRequestFromClient(&client) > 0)
+            requests++;
+    }
+    bench_report(name, requests, bench_now_ns() - start);
+
+    FreeOsBuffers(&oc);
+}
+
+int
+main(void)
+{
+    /* NoOperation, and the sizes of one rectangle or point fills */
+    static const int tiny[] = { 1 };
+    static const int fills[] = { 5, 3, 4 };
+    /* RenderComposite and text from older toolkits */
+    static const int mixed[] = { 9, 9, 5, 16, 2, 9 };
+
+    server_poll = ospoll_create();
+    if (!server_poll)
+        abort();
+
+    bench_run("4 byte requests", tiny, ARRAY_SIZE(tiny));
+    bench_run("12-20 byte requests", fills, ARRAY_SIZE(fills));
+    bench_run("8-64 byte requests", mixed, ARRAY_SIZE(mixed));
+
+    ospoll_destroy(server_poll);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Microbenchmark for the per-client resource tables */
+
+#include <dix-config.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix/resource_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "resource.h"
+
+#include "bench.h"
+
+#define LOOKUPS 1000000
+
+static ClientRec server_client;
+static ClientRec bench_client;
+
+static int
+delete_nothing(void *value, XID id)
+{
+    return Success;
+}
+
+static void
+count_resource(void *value, XID id, void *cdata)
+{
+    (*(unsigned int *) cdata)++;
+}
+
+static void
+bench_resources(unsigned int count)
+{
+    RESTYPE type, other;
+    unsigned int found = 0;
+    char label[64];
+    uint64_t start;
+    void *value;
+
+    memset(&server_client, 0, sizeof(server_client));
+    memset(&bench_client, 0, sizeof(bench_client));
+    serverClient = &server_client;
+    if (!InitClientResources(serverClient))
+        abort();
+    bench_client.index = 1;
+    bench_client.clientAsMask = (Mask) 1 << CLIENTOFFSET;
+    if (!InitClientResources(&bench_client))
+        abort();
+
+    type = CreateNewResourceType(delete_nothing, "BENCH");
+    other = CreateNewResourceType(delete_nothing, "BENCH_OTHER");
+
+    snprintf(label, sizeof(label), "AddResource (%u resources)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 1; i <= count; i++) {
+        if (!AddResource(bench_client.clientAsMask | i, (i & 15) ? type : other,
+                         (void *) (uintptr_t) i))
+            abort();
+    }
+    bench_report(label, count, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "lookup hit (%u resources)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < LOOKUPS; i++) {
+        unsigned int n = 1 + (i * 2654435761u) % count;
+
+        dixLookupResourceByType(&value, bench_client.clientAsMask | n,
+                                (n & 15) ? type : other, NULL, DixReadAccess);
+    }
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "lookup miss (%u resources)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 0; i < LOOKUPS; i++)
+        dixLookupResourceByType(&value, bench_client.clientAsMask | (count + 1 + i),
+                                type, NULL, DixReadAccess);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "FindClientResourcesByType (%u resources)", count);
+    start = bench_now_ns();
+    FindClientResourcesByType(&bench_client, other, count_resource, &found);
+    bench_report(label, found, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "FreeClientResources (%u resources)", count);
+    start = bench_now_ns();
+    FreeClientResources(&bench_client);
+    bench_report(label, count, bench_now_ns() - start);
+
+    FreeClientResources(serverClient);
+}
+
+/*
+ * What the dispatch loop does with the table over a client's lifetime:
+ * a working set of windows, pixmaps and GCs, every request looking up a
+ * drawable and a GC, and every 16th request creating a scratch pixmap
+ * and freeing an older one.  The server client meanwhile holds resources
+ * of its own.
+ */
+static void
+bench_session(unsigned int count)
+{
+    const unsigned int requests = 4 * LOOKUPS;
+    RESTYPE drawable, gc;
+    XID scratch[8] = { 0 };
+    XID next = count + 1;
+    char label[64];
+    uint64_t start;
+    void *value;
+
+    memset(&server_client, 0, sizeof(server_client));
+    memset(&bench_client, 0, sizeof(bench_client));
+    serverClient = &server_client;
+    if (!InitClientResources(serverClient))
+        abort();
+    bench_client.index = 1;
+    bench_client.clientAsMask = (Mask) 1 << CLIENTOFFSET;
+    if (!InitClientResources(&bench_client))
+        abort();
+
+    drawable = CreateNewResourceType(delete_nothing, "BENCH_DRAWABLE");
+    gc = CreateNewResourceType(delete_nothing, "BENCH_GC");
+    for (unsigned int i = 0; i < 1000; i++)
+        if (!AddResource(FakeClientID(0), drawable, NULL))
+            abort();
+
+    snprintf(label, sizeof(label), "session (%u resources)", count);
+    start = bench_now_ns();
+    for (unsigned int i = 1; i <= count; i++)
+        if (!AddResource(bench_client.clientAsMask | i, (i & 7) ? drawable : gc,
+                         (void *) (uintptr_t) i))
+            abort();
+    for (unsigned int i = 0; i < requests; i++) {
+        unsigned int n = (i * 2654435761u) % count;
+
+        /* odd ids are drawables, multiples of 8 GCs */
+        dixLookupResourceByType(&value, bench_client.clientAsMask | (n | 1),
+                                drawable, NULL, DixReadAccess);
+        dixLookupResourceByType(&value, bench_client.clientAsMask | ((n & ~7) + 8),
+                                gc, NULL, DixReadAccess);
+        if (!(i & 15)) {
+            XID *slot = &scratch[(i >> 4) & 7];
+
+            if (*slot)
+                FreeResource(*slot, X11_RESTYPE_NONE);
+            *slot = bench_client.clientAsMask | next++;
+            if (!AddResource(*slot, drawable, NULL))
+                abort();
+        }
+    }
+    FreeClientResources(&bench_client);
+    bench_report(label, requests, bench_now_ns() - start);
+
+    FreeClientResources(serverClient);
+}
+
+int
+main(void)
+{
+    static const unsigned int counts[] = { 1000, 100000, 1000000 };
+    static const unsigned int sessions[] = { 1000, 10000, 100000, 1000000 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(counts); i++)
+        bench_resources(counts[i]);
+    for (size_t i = 0; i < ARRAY_SIZE(sessions); i++)
+        bench_session(sessions[i]);
+    return 0;
+}
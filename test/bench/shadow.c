@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for shadow frame buffer updates, single vs. multi
+ * threaded.  The threaded updates have to come out the same as the plain
+ * ones, or it aborts.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "miext/shadow/shadow_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "misc.h"
+#include "scrnintstr.h"
+#include "pixmapstr.h"
+
+#include "bench.h"
+
+#define WIDTH   3840
+#define HEIGHT  2160
+#define ROUNDS  10
+
+static CARD8 *frameBuffer;
+static CARD32 frameStride;
+
+static void *
+bench_window(ScreenPtr pScreen, CARD32 row, CARD32 offset, int mode,
+             CARD32 *size, void *closure)
+{
+    *size = frameStride;
+    return frameBuffer + row * frameStride + offset;
+}
+
+static void
+bench_update(const char *name, ShadowUpdateProc update, int bpp,
+             Bool rotated, int threads)
+{
+    ScreenRec screen = { .width = WIDTH, .height = HEIGHT };
+    PixmapRec pixmap = { 0 };
+    DamageRec damage = { 0 };
+    shadowBufRec buf = { 0 };
+    BoxRec box = { 0, 0, WIDTH, HEIGHT };
+    ThreadPoolPtr pool = ThreadPoolCreate(threads, "bench");
+    size_t frameSize;
+    CARD8 *reference;
+    char label[64];
+    uint64_t start;
+
+    pixmap.drawable.type = DRAWABLE_PIXMAP;
+    pixmap.drawable.width = WIDTH;
+    pixmap.drawable.height = HEIGHT;
+    pixmap.drawable.bitsPerPixel = bpp;
+    pixmap.devKind = WIDTH * bpp / 8;
+    pixmap.devPrivate.ptr = calloc(HEIGHT, pixmap.devKind);
+    frameStride = (rotated ? HEIGHT : WIDTH) * bpp / 8;
+    frameSize = (size_t) (rotated ? WIDTH : HEIGHT) * frameStride;
+    frameBuffer = malloc(frameSize);
+    reference = malloc(frameSize);
+    if (!pixmap.devPrivate.ptr || !frameBuffer || !reference)
+        abort();
+    for (size_t i = 0; i < (size_t) HEIGHT * pixmap.devKind; i++)
+        ((CARD8 *) pixmap.devPrivate.ptr)[i] = i * 7 + (i >> 12);
+
+    /* a full screen repaint */
+    RegionInit(&damage.damage, &box, 1);
+    buf.pDamage = &damage;
+    buf.update = update;
+    buf.window = bench_window;
+    buf.pPixmap = &pixmap;
+
+    /* what the main thread does on its own */
+    memset(frameBuffer, 0, frameSize);
+    update(&screen, &buf);
+    memcpy(reference, frameBuffer, frameSize);
+
+    memset(frameBuffer, 0, frameSize);
+    if (!shadowUpdateThreaded(&screen, &buf, pool))
+        update(&screen, &buf);
+    if (memcmp(frameBuffer, reference, frameSize) != 0) {
+        fprintf(stderr, "%s %dbpp, %d threads: threaded result differs\n",
+                name, bpp, threads);
+        abort();
+    }
+
+    snprintf(label, sizeof(label), "%s %dbpp, %d threads", name, bpp,
+             ThreadPoolThreads(pool));
+    start = bench_now_ns();
+    for (int i = 0; i < ROUNDS; i++) {
+        if (!shadowUpdateThreaded(&screen, &buf, pool))
+            update(&screen, &buf);
+    }
+    bench_report_bytes(label, ROUNDS, (uint64_t) ROUNDS * WIDTH * HEIGHT * bpp / 8,
+                       bench_now_ns() - start);
+
+    RegionUninit(&damage.damage);
+    ThreadPoolDestroy(pool);
+    free(pixmap.devPrivate.ptr);
+    free(frameBuffer);
+    free(reference);
+}
+
+int
+main(void)
+{
+    static const struct {
+        const char *name;
+        ShadowUpdateProc update;
+        int bpp;
+        Bool rotated;
+    } procs[] = {
+        { "packed", shadowUpdatePacked, 32, FALSE },
+        { "rotate 90", shadowUpdateRotate8_90, 8, TRUE },
+        { "rotate 90", shadowUpdateRotate16_90, 16, TRUE },
+        { "rotate 90", shadowUpdateRotate32_90, 32, TRUE },
+        { "rotate 180", shadowUpdateRotate32_180, 32, FALSE },
+        { "rotate 270", shadowUpdateRotate32_270, 32, TRUE },
+    };
+    int cpus = ThreadPoolDefaultThreads();
+
+    for (size_t i = 0; i < ARRAY_SIZE(procs); i++) {
+        for (int threads = 1; threads <= cpus; threads *= 2)
+            bench_update(procs[i].name, procs[i].update, procs[i].bpp,
+                         procs[i].rotated, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for SYNC counter changes with lots of triggers attached,
+ * like the alarms and awaits of compositors on per-frame counters.  The
+ * triggers fired and the bracket values of a system counter are checked
+ * against testing every single trigger.
+ */
+
+#include <dix-config.h>
+
+#include <limits.h>
+#include <stdlib.h>
+#include <X11/X.h>
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "scrnintstr.h"
+#include "syncsrv.h"
+
+#include "bench.h"
+
+#define UPDATES 10000
+
+static unsigned long fired;
+static int64_t bracket_less, bracket_greater;
+
+static Bool
+bench_fires(const SyncTrigger *pTrigger, int64_t oldval, int64_t value)
+{
+    int64_t test = pTrigger->test_value;
+
+    switch (pTrigger->test_type) {
+    case XSyncPositiveTransition:
+        return oldval < test && value >= test;
+    case XSyncNegativeTransition:
+        return oldval > test && value <= test;
+    case XSyncPositiveComparison:
+        return value >= test;
+    default:
+        return value <= test;
+    }
+}
+
+static Bool
+bench_check(SyncTrigger *pTrigger, int64_t oldval)
+{
+    return bench_fires(pTrigger, oldval,
+                       ((SyncCounter *) pTrigger->pSync)->value);
+}
+
+/* like a client waiting for the next frame: a new await a bit further on */
+static void
+bench_fired(SyncTrigger *pTrigger)
+{
+    int64_t value = ((SyncCounter *) pTrigger->pSync)->value;
+    int64_t ahead = 1 + random() % 1000;
+
+    fired++;
+    SyncDeleteTriggerFromSyncObject(pTrigger);
+    if (pTrigger->test_type == XSyncPositiveTransition ||
+        pTrigger->test_type == XSyncPositiveComparison)
+        pTrigger->test_value = value + ahead;
+    else
+        pTrigger->test_value = value - ahead;
+    SyncAddTriggerToSyncObject(pTrigger);
+}
+
+static void
+bench_query(void *counter, int64_t *value)
+{
+}
+
+static void
+bench_brackets(void *counter, int64_t *pless, int64_t *pgreater)
+{
+    bracket_less = pless ? *pless : LLONG_MIN;
+    bracket_greater = pgreater ? *pgreater : LLONG_MAX;
+}
+
+/* what the triggers list walk used to compute */
+static void
+bench_reference_brackets(SyncTrigger *triggers, int n, int64_t value,
+                         int64_t *less, int64_t *greater)
+{
+    *less = LLONG_MIN;
+    *greater = LLONG_MAX;
+    for (int i = 0; i < n; i++) {
+        int64_t test = triggers[i].test_value;
+        Bool below = triggers[i].test_type == XSyncNegativeTransition ?
+            test <= value : test < value;
+        Bool above = triggers[i].test_type == XSyncPositiveTransition ?
+            test >= value : test > value;
+
+        if (above && test < *greater)
+            *greater = test;
+        else if (below && test > *less)
+            *less = test;
+    }
+}
+
+/* counts up to 2 * UPDATES, and back down */
+static int64_t
+bench_value(int i)
+{
+    return i < UPDATES ? 2 * i : 4 * UPDATES - 2 * i;
+}
+
+static void
+bench_counter(int n, Bool system)
+{
+    SyncCounter counter = { 0 };
+    SysCounterInfo info = { 0 };
+    SyncTrigger *triggers = calloc(n, sizeof(SyncTrigger));
+    ClientRec client = { 0 };
+    unsigned long expected = 0;
+    char label[64];
+    uint64_t start;
+
+    if (!triggers)
+        abort();
+    counter.sync.type = SYNC_COUNTER;
+    counter.sync.initialized = TRUE;
+    if (system) {
+        info.pCounter = &counter;
+        info.counterType = XSyncCounterUnrestricted;
+        info.QueryValue = bench_query;
+        info.BracketValues = bench_brackets;
+        counter.pSysCounterInfo = &info;
+    }
+    else
+        counter.sync.client = &client;
+
+    /* thresholds spread over the range the counter runs through */
+    srandom(n);
+    for (int i = 0; i < n; i++) {
+        triggers[i].pSync = &counter.sync;
+        triggers[i].test_type = i % 4;
+        triggers[i].test_value = random() % (2 * UPDATES);
+        triggers[i].CheckTrigger = bench_check;
+        triggers[i].TriggerFired = bench_fired;
+        SyncAddTriggerToSyncObject(&triggers[i]);
+    }
+
+    /* count up, then back down, checking every step */
+    fired = 0;
+    for (int i = 0; i < 2 * UPDATES; i += 7) {
+        for (int t = 0; t < n; t++)
+            expected += bench_fires(&triggers[t], counter.value, bench_value(i));
+        SyncChangeCounter(&counter, bench_value(i));
+        if (system) {
+            int64_t less, greater;
+
+            bench_reference_brackets(triggers, n, counter.value,
+                                     &less, &greater);
+            if (less != bracket_less || greater != bracket_greater) {
+                fprintf(stderr, "brackets of %lld: %lld..%lld, not %lld..%lld\n",
+                        (long long) counter.value,
+                        (long long) bracket_less, (long long) bracket_greater,
+                        (long long) less, (long long) greater);
+                abort();
+            }
+        }
+    }
+    if (fired != expected) {
+        fprintf(stderr, "%lu triggers fired instead of %lu\n", fired, expected);
+        abort();
+    }
+
+    counter.value = 0;
+    start = bench_now_ns();
+    for (int i = 0; i < 2 * UPDATES; i++)
+        SyncChangeCounter(&counter, bench_value(i));
+    snprintf(label, sizeof(label), "%s counter, %d triggers",
+             system ? "system" : "client", n);
+    bench_report(label, 2 * UPDATES, bench_now_ns() - start);
+
+    for (int i = 0; i < n; i++)
+        SyncDeleteTriggerFromSyncObject(&triggers[i]);
+    free(triggers);
+}
+
+int
+main(void)
+{
+    for (int n = 10; n <= 10000; n *= 10) {
+        bench_counter(n, FALSE);
+        bench_counter(n, TRUE);
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for window moves on a 10k window tree, with full and
+ * incremental clip recomputation in miValidateTree().  The check mode
+ * run fails if the incremental results differ from the full ones.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix/window_priv.h"
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+#include "regionstr.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#include "bench.h"
+
+#define WIDTH       1920
+#define HEIGHT      1080
+#define FRAMES      100
+#define WIDGETS     98          /* per frame, 100 windows each with frame
+                                   and client */
+#define FRAME_W     320
+#define FRAME_H     200
+#define MOVES       200
+
+static ScreenRec screen = { .width = WIDTH, .height = HEIGHT };
+
+static void
+bench_window_exposures(WindowPtr pWin, RegionPtr prgn)
+{
+}
+
+static void
+bench_paint_window(WindowPtr pWin, RegionPtr prgn, int what)
+{
+}
+
+static void
+bench_copy_window(WindowPtr pWin, DDXPointRec oldOrigin, RegionPtr prgnSrc)
+{
+}
+
+static WindowPtr
+bench_window(WindowPtr pParent, int x, int y, int w, int h, int bw)
+{
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+
+    if (!pWin)
+        abort();
+    pWin->drawable.type = DRAWABLE_WINDOW;
+    pWin->drawable.class = InputOutput;
+    pWin->drawable.pScreen = &screen;
+    pWin->drawable.width = w;
+    pWin->drawable.height = h;
+    pWin->borderWidth = bw;
+    pWin->borderIsPixel = TRUE;
+    pWin->winGravity = NorthWestGravity;
+    pWin->mapped = pWin->realized = pWin->viewable = TRUE;
+    RegionNull(&pWin->winSize);
+    RegionNull(&pWin->borderSize);
+    RegionNull(&pWin->clipList);
+    RegionNull(&pWin->borderClip);
+
+    if (!pParent) {
+        BoxRec box = { 0, 0, w, h };
+
+        RegionReset(&pWin->winSize, &box);
+        RegionReset(&pWin->borderSize, &box);
+        RegionReset(&pWin->clipList, &box);
+        RegionReset(&pWin->borderClip, &box);
+        pWin->visibility = VisibilityUnobscured;
+        screen.root = pWin;
+        return pWin;
+    }
+
+    /* at the bottom of its siblings */
+    pWin->parent = pParent;
+    pWin->prevSib = pParent->lastChild;
+    if (pParent->lastChild)
+        pParent->lastChild->nextSib = pWin;
+    else
+        pParent->firstChild = pWin;
+    pParent->lastChild = pWin;
+
+    pWin->origin.x = x + bw;
+    pWin->origin.y = y + bw;
+    pWin->drawable.x = pParent->drawable.x + x + bw;
+    pWin->drawable.y = pParent->drawable.y + y + bw;
+    pWin->visibility = VisibilityNotViewable;
+    SetWinSize(pWin);
+    SetBorderSize(pWin);
+    return pWin;
+}
+
+static void
+bench_free_tree(WindowPtr pWin)
+{
+    WindowPtr pChild = pWin->firstChild;
+
+    while (pChild) {
+        WindowPtr pNext = pChild->nextSib;
+
+        bench_free_tree(pChild);
+        pChild = pNext;
+    }
+    RegionUninit(&pWin->winSize);
+    RegionUninit(&pWin->borderSize);
+    RegionUninit(&pWin->clipList);
+    RegionUninit(&pWin->borderClip);
+    dixFreeObjectWithPrivates(pWin, PRIVATE_WINDOW);
+}
+
+/* a screen full of overlapping frames with lots of widgets in them */
+static WindowPtr
+bench_tree(void)
+{
+    WindowPtr pRoot = bench_window(NULL, 0, 0, WIDTH, HEIGHT, 0);
+
+    srandom(1);
+    for (int f = 0; f < FRAMES; f++) {
+        WindowPtr pFrame = bench_window(pRoot,
+                                        random() % (WIDTH - FRAME_W),
+                                        random() % (HEIGHT - FRAME_H),
+                                        FRAME_W, FRAME_H, 1);
+        WindowPtr pClient = bench_window(pFrame, 2, 20, FRAME_W - 4,
+                                         FRAME_H - 22, 0);
+
+        for (int w = 0; w < WIDGETS; w++)
+            bench_window(pClient, 2 + (w % 14) * 22, 2 + (w / 14) * 24,
+                         20, 20, w & 1);
+    }
+
+    /* validate everything once */
+    for (WindowPtr pWin = pRoot->firstChild; pWin; pWin = pWin->nextSib)
+        miMarkOverlappedWindows(pWin, pWin, NULL);
+    miMarkWindow(pRoot);
+    miValidateTree(pRoot, NullWindow, VTMap);
+    miHandleValidateExposures(pRoot);
+    return pRoot;
+}
+
+static void
+bench_moves(const char *name, int mode)
+{
+    WindowPtr pRoot;
+    WindowPtr pWin;
+    char label[64];
+    uint64_t start;
+
+    miValidateMode = mode;
+    memset(&miValidateStats, 0, sizeof(miValidateStats));
+    pRoot = bench_tree();
+
+    /* drag the frame in the middle of the stack around */
+    pWin = pRoot->firstChild;
+    for (int i = 0; i < FRAMES / 2; i++)
+        pWin = pWin->nextSib;
+
+    start = bench_now_ns();
+    for (int i = 0; i < MOVES; i++) {
+        int x = (i * 7) % (WIDTH - FRAME_W);
+        int y = (i * 5) % (HEIGHT - FRAME_H);
+
+        miMoveWindow(pWin, x, y, pWin->nextSib, VTMove);
+    }
+    snprintf(label, sizeof(label), "move, %s", name);
+    bench_report(label, MOVES, bench_now_ns() - start);
+    printf("%-40s %10lu computed %10lu skipped %5lu mismatches\n", "",
+           miValidateStats.computed, miValidateStats.skipped,
+           miValidateStats.mismatches);
+
+    bench_free_tree(pRoot);
+    screen.root = NULL;
+}
+
+int
+main(void)
+{
+    screen.MarkWindow = miMarkWindow;
+    screen.MarkOverlappedWindows = miMarkOverlappedWindows;
+    screen.ValidateTree = miValidateTree;
+    screen.HandleExposures = miHandleValidateExposures;
+    screen.WindowExposures = bench_window_exposures;
+    screen.PaintWindow = bench_paint_window;
+    screen.CopyWindow = bench_copy_window;
+    screen.MoveWindow = miMoveWindow;
+
+    /* window.c keeps the window index up to date */
+    if (!WindowIndexInit() ||
+        !dixAllocatePrivates(&screen.devPrivates, PRIVATE_SCREEN))
+        return 1;
+
+    bench_moves("full", MI_VALIDATE_FULL);
+    bench_moves("incremental", MI_VALIDATE_INCREMENTAL);
+    bench_moves("check", MI_VALIDATE_CHECK);
+    return miValidateStats.mismatches ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/*
+ * Microbenchmark for pointer picking with many top-level windows, walking
+ * the children of the root vs. the window index.  test/windowindex.c
+ * checks that both find the same windows.
+ */
+
+#include <dix-config.h>
+
+#include <stdlib.h>
+#include <X11/X.h>
+
+#include "dix/window_priv.h"
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+#include "inputstr.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#include "bench.h"
+
+#define WIDTH     3840
+#define HEIGHT    2160
+#define LOOKUPS   100000
+#define RAISES    10000
+
+static ScreenRec screen = { .width = WIDTH, .height = HEIGHT };
+
+static WindowPtr
+bench_window(WindowPtr pParent, int x, int y, int w, int h)
+{
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+
+    if (!pWin)
+        abort();
+    pWin->drawable.pScreen = &screen;
+    pWin->drawable.x = x;
+    pWin->drawable.y = y;
+    pWin->drawable.width = w;
+    pWin->drawable.height = h;
+    pWin->parent = pParent;
+    if (pParent) {
+        /* on top of its siblings, like a new window */
+        pWin->nextSib = pParent->firstChild;
+        if (pParent->firstChild)
+            pParent->firstChild->prevSib = pWin;
+        else
+            pParent->lastChild = pWin;
+        pParent->firstChild = pWin;
+    }
+    pWin->mapped = TRUE;
+    return pWin;
+}
+
+static void
+bench_random_geometry(WindowPtr pWin)
+{
+    pWin->drawable.width = 20 + random() % 400;
+    pWin->drawable.height = 30 + random() % 300;
+    pWin->drawable.x = random() % (WIDTH + 200) - 100;
+    pWin->drawable.y = random() % (HEIGHT + 200) - 100;
+    pWin->borderWidth = random() % 3;
+}
+
+static WindowPtr
+bench_lookup(SpritePtr pSprite, int x, int y, Bool indexed)
+{
+    WindowIndexEnabled = indexed;
+    return miXYToWindow(&screen, pSprite, x, y);
+}
+
+static void
+bench_picking(int nwindows)
+{
+    WindowPtr pRoot = bench_window(NULL, 0, 0, WIDTH, HEIGHT);
+    WindowPtr *windows = calloc(nwindows, sizeof(WindowPtr));
+    SpriteRec sprite = { 0 };
+    char label[64];
+    uint64_t start;
+
+    sprite.spriteTraceSize = 10;
+    sprite.spriteTrace = calloc(sprite.spriteTraceSize, sizeof(WindowPtr));
+    sprite.spriteTrace[0] = pRoot;
+    if (!windows || !sprite.spriteTrace)
+        abort();
+
+    srandom(nwindows);
+    for (int i = 0; i < nwindows; i++) {
+        windows[i] = bench_window(pRoot, 0, 0, 1, 1);
+        bench_random_geometry(windows[i]);
+        /* hidden frames, tooltips etc */
+        windows[i]->mapped = random() % 4 != 0;
+        /* a frame with a client window in it */
+        bench_window(windows[i], windows[i]->drawable.x + 4,
+                     windows[i]->drawable.y + 20,
+                     windows[i]->drawable.width - 8,
+                     windows[i]->drawable.height - 24);
+    }
+
+    snprintf(label, sizeof(label), "walk %d windows", nwindows);
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++)
+        bench_lookup(&sprite, (i * 7919u) % WIDTH, (i * 104729u) % HEIGHT,
+                     FALSE);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    snprintf(label, sizeof(label), "index %d windows", nwindows);
+    start = bench_now_ns();
+    for (int i = 0; i < LOOKUPS; i++)
+        bench_lookup(&sprite, (i * 7919u) % WIDTH, (i * 104729u) % HEIGHT,
+                     TRUE);
+    bench_report(label, LOOKUPS, bench_now_ns() - start);
+
+    /* clicking through windows, raising each one */
+    snprintf(label, sizeof(label), "raise and index %d windows", nwindows);
+    start = bench_now_ns();
+    for (int i = 0; i < RAISES; i++) {
+        WindowPtr pWin = windows[(i * 7919u) % nwindows];
+
+        if (pWin != pRoot->firstChild) {
+            pWin->prevSib->nextSib = pWin->nextSib;
+            if (pWin->nextSib)
+                pWin->nextSib->prevSib = pWin->prevSib;
+            else
+                pRoot->lastChild = pWin->prevSib;
+            pWin->prevSib = NULL;
+            pWin->nextSib = pRoot->firstChild;
+            pRoot->firstChild->prevSib = pWin;
+            pRoot->firstChild = pWin;
+            WindowIndexRestacked(pWin);
+        }
+        bench_lookup(&sprite, (i * 104729u) % WIDTH, (i * 7919u) % HEIGHT,
+                     TRUE);
+    }
+    bench_report(label, RAISES, bench_now_ns() - start);
+
+    /* the index goes with the root */
+    for (int i = 0; i < nwindows; i++) {
+        WindowIndexRemove(windows[i]->firstChild);
+        dixFreeObjectWithPrivates(windows[i]->firstChild, PRIVATE_WINDOW);
+        WindowIndexRemove(windows[i]);
+        dixFreeObjectWithPrivates(windows[i], PRIVATE_WINDOW);
+    }
+    WindowIndexRemove(pRoot);
+    dixFreeObjectWithPrivates(pRoot, PRIVATE_WINDOW);
+    free(sprite.spriteTrace);
+    free(windows);
+}
+
+int
+main(void)
+{
+    if (!WindowIndexInit() ||
+        !dixAllocatePrivates(&screen.devPrivates, PRIVATE_SCREEN))
+        return 1;
+
+    bench_picking(100);
+    bench_picking(1000);
+    bench_picking(5000);
+    return 0;
+}
@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "composite/compint.h"
+
+#include "mi.h"
+#include "misc.h"
+#include "pixmapstr.h"
+#include "scrnintstr.h"
+
+#include "tests-common.h"
+
+static ScreenRec screen;
+static int created, destroyed;
+
+static PixmapPtr
+test_create_pixmap(ScreenPtr pScreen, int w, int h, int depth,
+                   unsigned usage_hint)
+{
+    PixmapPtr pPixmap = calloc(1, sizeof(PixmapRec));
+
+    assert(pPixmap);
+    pPixmap->drawable.type = DRAWABLE_PIXMAP;
+    pPixmap->drawable.pScreen = pScreen;
+    pPixmap->drawable.width = w;
+    pPixmap->drawable.height = h;
+    pPixmap->drawable.depth = depth;
+    pPixmap->drawable.bitsPerPixel = 32;
+    pPixmap->devKind = w * 4;
+    pPixmap->refcnt = 1;
+    pPixmap->usage_hint = usage_hint;
+    created++;
+    return pPixmap;
+}
+
+static Bool
+test_destroy_pixmap(PixmapPtr pPixmap)
+{
+    if (--pPixmap->refcnt == 0) {
+        free(pPixmap);
+        destroyed++;
+    }
+    return TRUE;
+}
+
+static void
+test_init(CompPixmapPoolPtr pool, size_t maxBytes)
+{
+    screen.CreatePixmap = test_create_pixmap;
+    screen.DestroyPixmap = test_destroy_pixmap;
+    screen.ModifyPixmapHeader = miModifyPixmapHeader;
+    compPixmapPoolInit(pool);
+    pool->maxBytes = maxBytes;
+    created = destroyed = 0;
+}
+
+static void
+comp_pool_disabled(void)
+{
+    CompPixmapPoolRec pool;
+    PixmapPtr pPixmap;
+
+    test_init(&pool, 0);
+    pPixmap = compPixmapPoolGet(&pool, &screen, 100, 70, 24);
+    assert(pPixmap->drawable.width == 100);
+    assert(pPixmap->devKind == 400);
+    compPixmapPoolPut(&pool, pPixmap);
+    assert(created == 1 && destroyed == 1);
+    assert(pool.num == 0 && pool.hits == 0 && pool.misses == 0);
+    compPixmapPoolFini(&pool, &screen);
+}
+
+static void
+comp_pool_resize(void)
+{
+    CompPixmapPoolRec pool;
+    PixmapPtr pOld, pNew;
+
+    test_init(&pool, 64 * 1024 * 1024);
+
+    /* allocated in the size class, shrunk to the size asked for */
+    pOld = compPixmapPoolGet(&pool, &screen, 1000, 700, 24);
+    assert(pOld->drawable.width == 1000 && pOld->drawable.height == 700);
+    assert(pOld->devKind == 1024 * 4);
+    assert(pool.misses == 1);
+
+    /* an interactive resize ping-pongs between two pixmaps */
+    for (int i = 1; i <= 20; i++) {
+        pNew = compPixmapPoolGet(&pool, &screen, 1000 + i, 700 + i, 24);
+        assert(pNew != pOld);
+        assert(pNew->drawable.width == 1000 + i);
+        assert(pNew->drawable.height == 700 + i);
+        compPixmapPoolPut(&pool, pOld);
+        pOld = pNew;
+    }
+    assert(created == 2 && destroyed == 0);
+    assert(pool.hits == 19 && pool.misses == 2);
+
+    /* other depths and size classes don't match */
+    pNew = compPixmapPoolGet(&pool, &screen, 1010, 710, 32);
+    compPixmapPoolPut(&pool, pNew);
+    pNew = compPixmapPoolGet(&pool, &screen, 1500, 710, 24);
+    compPixmapPoolPut(&pool, pNew);
+    assert(pool.misses == 4);
+
+    /* pixmaps somebody else holds aren't pooled */
+    pool.misses = 0;
+    pNew = compPixmapPoolGet(&pool, &screen, 1010, 710, 32);
+    pNew->refcnt++;
+    compPixmapPoolPut(&pool, pNew);
+    assert(pNew->refcnt == 1 && pool.num == 2);
+    compPixmapPoolForget(&pool, pNew);
+    compPixmapPoolPut(&pool, pNew);
+    assert(pool.num == 2 && destroyed == 1);
+
+    compPixmapPoolPut(&pool, pOld);
+    compPixmapPoolFini(&pool, &screen);
+    assert(created == destroyed && pool.num == 0 && pool.bytes == 0);
+}
+
+static void
+comp_pool_limit(void)
+{
+    CompPixmapPoolRec pool;
+    PixmapPtr pixmaps[COMP_PIXMAP_POOL_SIZE + 1];
+
+    /* room for three 256x256 pixmaps */
+    test_init(&pool, 3 * 256 * 256 * 4);
+    for (int i = 0; i < 4; i++)
+        pixmaps[i] = compPixmapPoolGet(&pool, &screen, 250, 250, 24);
+    for (int i = 0; i < 4; i++)
+        compPixmapPoolPut(&pool, pixmaps[i]);
+    assert(pool.num == 3 && pool.evictions == 1 && destroyed == 1);
+    assert(pool.pixmaps[0] == pixmaps[1]);
+
+    /* too big for the pool at all */
+    pixmaps[0] = compPixmapPoolGet(&pool, &screen, 1000, 1000, 24);
+    compPixmapPoolPut(&pool, pixmaps[0]);
+    assert(pool.num == 3 && destroyed == 2);
+    compPixmapPoolFini(&pool, &screen);
+
+    /* lots of small ones */
+    test_init(&pool, 64 * 1024 * 1024);
+    for (size_t i = 0; i < ARRAY_SIZE(pixmaps); i++)
+        pixmaps[i] = compPixmapPoolGet(&pool, &screen, 10, 10, 24);
+    for (size_t i = 0; i < ARRAY_SIZE(pixmaps); i++)
+        compPixmapPoolPut(&pool, pixmaps[i]);
+    assert(pool.num == COMP_PIXMAP_POOL_SIZE && destroyed == 1);
+    compPixmapPoolFini(&pool, &screen);
+    assert(created == destroyed);
+}
+
+const testfunc_t*
+comppool_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        comp_pool_disabled,
+        comp_pool_resize,
+        comp_pool_limit,
+        NULL,
+    };
+    return testfuncs;
+}
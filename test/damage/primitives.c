@@ -29,6 +29,9 @@
  * rendering call that draws some pixels.  Afterwards, the core checks
  * what pixels were modified and makes sure the damage report contains
  * them.
+ *
+ * With --bench, it times lots of small primitives instead, without a
+ * damage object on the pixmap and with one of each report level.
  */
 
 /* Test relies on assert() */
@@ -40,6 +43,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 #include <xcb/damage.h>
 
 struct test_setup {
@@ -335,6 +339,132 @@ test_poly_segment(struct test_setup *setup)
                      ARRAY_SIZE(segs), segs);
 }
 
+#define BENCH_SIZE      256
+#define BENCH_REQUESTS  2000
+#define BENCH_PRIMS     64
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Waits for the server to catch up, dropping the damage events. */
+static void
+bench_sync(struct test_setup *setup)
+{
+    xcb_generic_event_t *ge;
+
+    free(xcb_get_input_focus_reply(setup->c,
+                                   xcb_get_input_focus(setup->c), NULL));
+    while ((ge = xcb_poll_for_event(setup->c))) {
+        if (ge->response_type == 0) {
+            fprintf(stderr, "X error %d\n",
+                    ((xcb_generic_error_t *)ge)->error_code);
+            exit(1);
+        }
+        free(ge);
+    }
+}
+
+/*
+ * Primitives all over a small area of the pixmap, over and over again,
+ * like a terminal or a line drawing application.
+ */
+static void
+bench_points(struct test_setup *setup, int i)
+{
+    xcb_point_t points[BENCH_PRIMS];
+
+    for (int j = 0; j < BENCH_PRIMS; j++) {
+        points[j].x = (i * 7 + j * 13) % 64;
+        points[j].y = (i * 3 + j * 5) % 64;
+    }
+    xcb_poly_point(setup->c, XCB_COORD_MODE_ORIGIN, setup->d, setup->gc,
+                   BENCH_PRIMS, points);
+}
+
+static void
+bench_segments(struct test_setup *setup, int i)
+{
+    xcb_segment_t segs[BENCH_PRIMS];
+
+    for (int j = 0; j < BENCH_PRIMS; j++) {
+        segs[j].x1 = (i + j * 13) % 64;
+        segs[j].y1 = (i * 3 + j) % 64;
+        segs[j].x2 = segs[j].x1 + 8;
+        segs[j].y2 = segs[j].y1 + j % 5;
+    }
+    xcb_poly_segment(setup->c, setup->d, setup->gc, BENCH_PRIMS, segs);
+}
+
+static void
+bench_fill_rectangles(struct test_setup *setup, int i)
+{
+    xcb_rectangle_t rects[BENCH_PRIMS];
+
+    for (int j = 0; j < BENCH_PRIMS; j++) {
+        rects[j].x = (i * 5 + j * 11) % 64;
+        rects[j].y = (i + j * 7) % 64;
+        rects[j].width = 1 + j % 4;
+        rects[j].height = 1 + j % 3;
+    }
+    xcb_poly_fill_rectangle(setup->c, setup->d, setup->gc,
+                            BENCH_PRIMS, rects);
+}
+
+static void
+damage_bench(struct test_setup *setup,
+             void (*draw)(struct test_setup *setup, int i),
+             const char *name)
+{
+    static const struct {
+        int level;
+        const char *name;
+    } levels[] = {
+        { -1, "no damage" },
+        { XCB_DAMAGE_REPORT_LEVEL_RAW_RECTANGLES, "raw" },
+        { XCB_DAMAGE_REPORT_LEVEL_DELTA_RECTANGLES, "delta" },
+        { XCB_DAMAGE_REPORT_LEVEL_BOUNDING_BOX, "bounding box" },
+        { XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY, "non-empty" },
+    };
+
+    setup->d = xcb_generate_id(setup->c);
+    xcb_create_pixmap(setup->c, setup->screen->root_depth,
+                      setup->d, setup->screen->root,
+                      BENCH_SIZE, BENCH_SIZE);
+    setup->gc = xcb_generate_id(setup->c);
+    uint32_t values[]  = { setup->screen->black_pixel };
+    xcb_create_gc(setup->c, setup->gc, setup->screen->root,
+                  XCB_GC_FOREGROUND, values);
+
+    for (int l = 0; l < ARRAY_SIZE(levels); l++) {
+        xcb_damage_damage_t damage = xcb_generate_id(setup->c);
+        double start;
+
+        if (levels[l].level >= 0)
+            xcb_damage_create(setup->c, damage, setup->d, levels[l].level);
+        bench_sync(setup);
+
+        start = bench_now();
+        for (int i = 0; i < BENCH_REQUESTS; i++)
+            draw(setup, i);
+        bench_sync(setup);
+
+        printf("%-16s %-14s %12.0f primitives/s\n", name, levels[l].name,
+               BENCH_REQUESTS * BENCH_PRIMS / (bench_now() - start));
+        if (levels[l].level >= 0)
+            xcb_damage_destroy(setup->c, damage);
+    }
+
+    xcb_free_gc(setup->c, setup->gc);
+    xcb_free_pixmap(setup->c, setup->d);
+    bench_sync(setup);
+}
+
 int main(int argc, char **argv)
 {
     int screen;
@@ -360,6 +490,14 @@ int main(int argc, char **argv)
 
     xcb_damage_query_version(c, 1, 1);
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        damage_bench(&setup, bench_points, "points");
+        damage_bench(&setup, bench_segments, "segments");
+        damage_bench(&setup, bench_fill_rectangles, "fill rectangles");
+        xcb_disconnect(c);
+        exit(0);
+    }
+
     create_start_pixmap(&setup);
 
     bool pass = true;
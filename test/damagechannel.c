@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "Xext/damage/damage_priv.h"
+#include "Xext/damage/damagechannel.h"
+
+#include "misc.h"
+#include "regionstr.h"
+
+#include "tests-common.h"
+
+#define BUFFER_BOXES 64
+
+static union {
+    xDamageChannelHeader header;
+    unsigned char bytes[sz_xDamageChannelHeader +
+                        BUFFER_BOXES * sz_xDamageChannelBox];
+} buffer;
+
+static xDamageChannelBox *const boxes =
+    (xDamageChannelBox *) (buffer.bytes + sz_xDamageChannelHeader);
+
+static void
+add_box(DamageChannelPtr channel, int x1, int y1, int x2, int y2)
+{
+    BoxRec box = { x1, y1, x2, y2 };
+    RegionRec region;
+
+    RegionInit(&region, &box, 1);
+    DamageChannelAdd(channel, &region);
+    RegionUninit(&region);
+}
+
+/* the published boxes as a region */
+static void
+read_region(RegionPtr pRegion)
+{
+    RegionNull(pRegion);
+    for (int i = 0; i < buffer.header.nBoxes; i++) {
+        BoxRec box = { boxes[i].x1, boxes[i].y1, boxes[i].x2, boxes[i].y2 };
+        RegionRec r;
+
+        RegionInit(&r, &box, 1);
+        RegionUnion(pRegion, pRegion, &r);
+        RegionUninit(&r);
+    }
+}
+
+static void
+damage_channel_coalesce(void)
+{
+    DamageChannelPtr channel;
+    RegionRec region;
+    CARD32 serial = 0;
+
+    /* too small for a box */
+    assert(!DamageChannelCreate(&buffer, sz_xDamageChannelHeader, 0));
+
+    channel = DamageChannelCreate(&buffer, sizeof(buffer), 0);
+    assert(channel);
+    assert(buffer.header.magic == DAMAGE_CHANNEL_MAGIC);
+    assert(buffer.header.maxBoxes == BUFFER_BOXES);
+
+    /* nothing to publish */
+    assert(!DamageChannelPublish(channel, &serial));
+    assert(buffer.header.serial == 0);
+
+    /* lots of damage, one update */
+    for (int i = 0; i < 10; i++)
+        add_box(channel, i * 20, 0, i * 20 + 10, 10);
+    assert(DamageChannelPublish(channel, &serial));
+    assert(serial == 2 && buffer.header.serial == 2);
+    assert(buffer.header.nBoxes == 10 && !buffer.header.capped);
+    assert(buffer.header.x1 == 0 && buffer.header.x2 == 190);
+
+    /* the client hasn't read it: merged, without another notify */
+    add_box(channel, 0, 100, 10, 110);
+    assert(!DamageChannelPublish(channel, &serial));
+    assert(serial == 4 && buffer.header.nBoxes == 11);
+    assert(buffer.header.y2 == 110);
+
+    /* once it has, the next update starts over and notifies */
+    buffer.header.ack = buffer.header.serial;
+    add_box(channel, 50, 50, 60, 60);
+    assert(DamageChannelPublish(channel, &serial));
+    assert(buffer.header.nBoxes == 1);
+    read_region(&region);
+    assert(RegionNumRects(&region) == 1);
+    assert(RegionExtents(&region)->x1 == 50);
+    RegionUninit(&region);
+
+    DamageChannelDestroy(channel);
+}
+
+static void
+damage_channel_cap(void)
+{
+    DamageChannelPtr channel;
+    RegionRec damage, published, missed;
+    CARD32 serial;
+
+    channel = DamageChannelCreate(&buffer, sizeof(buffer), 8);
+    assert(channel);
+    assert(buffer.header.maxBoxes == 8);
+
+    /* a checkerboard of 100 boxes, in 8 bounding boxes covering it */
+    RegionNull(&damage);
+    for (int y = 0; y < 10; y++) {
+        for (int x = 0; x < 10; x++) {
+            BoxRec box = { x * 20 + (y & 1) * 10, y * 10,
+                           x * 20 + (y & 1) * 10 + 10, y * 10 + 10 };
+            RegionRec r;
+
+            RegionInit(&r, &box, 1);
+            RegionUnion(&damage, &damage, &r);
+            RegionUninit(&r);
+        }
+    }
+    assert(RegionNumRects(&damage) == 100);
+    DamageChannelAdd(channel, &damage);
+    assert(DamageChannelPublish(channel, &serial));
+    assert(buffer.header.nBoxes <= 8 && buffer.header.capped);
+
+    read_region(&published);
+    RegionNull(&missed);
+    RegionSubtract(&missed, &damage, &published);
+    assert(!RegionNotEmpty(&missed));
+
+    RegionUninit(&missed);
+    RegionUninit(&published);
+    RegionUninit(&damage);
+    DamageChannelDestroy(channel);
+}
+
+const testfunc_t*
+damagechannel_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        damage_channel_coalesce,
+        damage_channel_cap,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -0,0 +1,156 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <X11/X.h>
+
+#include "misc.h"
+#include "pixmapstr.h"
+#include "privates.h"
+#include "regionstr.h"
+#include "scrnintstr.h"
+#include "damagestr.h"
+
+#include "tests-common.h"
+
+#define SIZE    256
+
+static ScreenRec screen;
+
+static PixmapPtr
+create_pixmap(void)
+{
+    PixmapPtr pPixmap = dixAllocateScreenObjectWithPrivates(&screen, PixmapRec,
+                                                            PRIVATE_PIXMAP);
+
+    assert(pPixmap);
+    pPixmap->drawable.type = DRAWABLE_PIXMAP;
+    pPixmap->drawable.pScreen = &screen;
+    pPixmap->drawable.width = SIZE;
+    pPixmap->drawable.height = SIZE;
+    pPixmap->drawable.depth = 32;
+    pPixmap->drawable.bitsPerPixel = 32;
+    return pPixmap;
+}
+
+/* damages the pixmap like drawing would, and adds it to expected */
+static void
+damage(PixmapPtr pPixmap, RegionPtr expected, int nbox, const BoxRec *boxes)
+{
+    RegionRec region;
+
+    RegionInitBoxes(&region, (BoxPtr) boxes, nbox);
+    RegionUnion(expected, expected, &region);
+    DamageDamageRegion(&pPixmap->drawable, &region);
+    RegionUninit(&region);
+}
+
+/* small overlapping boxes, some of them inside what's damaged already */
+static void
+damage_random(PixmapPtr pPixmap, RegionPtr expected, int count)
+{
+    for (int i = 0; i < count; i++) {
+        int x = random() % (SIZE - 32), y = random() % (SIZE - 32);
+        BoxRec boxes[] = {
+            { x, y, x + 1 + random() % 32, y + 1 + random() % 32 },
+            { x, y + 32, x + 16, y + 32 },
+        };
+
+        /* now and then a region of a few boxes */
+        if (i % 5 == 0) {
+            boxes[1].y1 = boxes[0].y2 + 1 + random() % 8;
+            damage(pPixmap, expected, 2, boxes);
+        }
+        else {
+            damage(pPixmap, expected, 1, boxes);
+        }
+    }
+}
+
+static void
+damage_deferred(void)
+{
+    PixmapPtr pPixmap = create_pixmap();
+    DamagePtr pDamage = DamageCreate(NULL, NULL, DamageReportNone, FALSE,
+                                     &screen, NULL);
+    BoxRec box = { 32, 32, 128, 128 }, corner = { 40, 40, 60, 60 };
+    RegionRec expected, subtract;
+
+    assert(pDamage);
+    DamageRegister(&pPixmap->drawable, pDamage);
+    RegionNull(&expected);
+    srandom(1);
+
+    /* nothing is buffered before anything is drawn */
+    assert(!pDamage->deferred);
+    assert(!RegionNotEmpty(DamageRegion(pDamage)));
+
+    /* well past what fits in the buffer */
+    damage_random(pPixmap, &expected, DAMAGE_DEFERRED_BOXES * 3 + 5);
+    assert(pDamage->numDeferred > 0);
+    assert(RegionEqual(DamageRegion(pDamage), &expected));
+    assert(pDamage->numDeferred == 0);
+
+    /* a bit less than fits, then covered and partly covered boxes */
+    damage_random(pPixmap, &expected, DAMAGE_DEFERRED_BOXES - 7);
+    damage(pPixmap, &expected, 1, &box);
+    for (int i = 0; i < 20; i++) {
+        BoxRec inside = { 40 + i, 40 + i, 60 + 2 * i, 60 + 2 * i };
+        BoxRec across = { 100 + i, 100, 140 + i, 110 };
+
+        damage(pPixmap, &expected, 1, &inside);
+        damage(pPixmap, &expected, 1, &across);
+    }
+    assert(RegionEqual(DamageRegion(pDamage), &expected));
+
+    /* subtracting sees the buffered boxes too */
+    RegionInit(&subtract, &box, 1);
+    DamageSubtract(pDamage, &subtract);
+    RegionSubtract(&expected, &expected, &subtract);
+    damage_random(pPixmap, &expected, 10);
+    damage(pPixmap, &expected, 1, &corner);
+    assert(pDamage->numDeferred > 0);
+    RegionSubtract(&expected, &expected, &subtract);
+    assert(DamageSubtract(pDamage, &subtract) ==
+           RegionNotEmpty(&expected));
+    assert(RegionEqual(DamageRegion(pDamage), &expected));
+    RegionUninit(&subtract);
+
+    /* and emptying drops them */
+    damage_random(pPixmap, &expected, 10);
+    DamageEmpty(pDamage);
+    RegionEmpty(&expected);
+    assert(!RegionNotEmpty(DamageRegion(pDamage)));
+
+    /* the box covered before emptying is damage again */
+    damage(pPixmap, &expected, 1, &box);
+    damage_random(pPixmap, &expected, 10);
+    assert(RegionEqual(DamageRegion(pDamage), &expected));
+
+    RegionUninit(&expected);
+    DamageDestroy(pDamage);
+    dixFreeObjectWithPrivates(pPixmap, PRIVATE_PIXMAP);
+}
+
+const testfunc_t*
+damageregion_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        damage_deferred,
+        NULL,
+    };
+
+    /* so the screen gets its damage private when the key is registered */
+    assert(dixAllocatePrivates(&screen.devPrivates, PRIVATE_SCREEN));
+    screenInfo.screens[0] = &screen;
+    screenInfo.numScreens = 1;
+    assert(DamageSetup(&screen));
+    screenInfo.screens[0] = NULL;
+    screenInfo.numScreens = 0;
+    return testfuncs;
+}
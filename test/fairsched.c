@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include <X11/X.h>
+
+#include "dix/dixstruct_priv.h"
+#include "dix/fairsched_priv.h"
+#include "os/threadpool_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+
+#include "tests-common.h"
+
+#define MS 1000000ULL
+
+static ClientRec test_clients[3];
+
+static void
+setup(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(test_clients); i++) {
+        memset(&test_clients[i], 0, sizeof(test_clients[i]));
+        test_clients[i].index = i + 1;
+        clients[i + 1] = &test_clients[i];
+        FairSchedInitClient(&test_clients[i]);
+    }
+}
+
+static void
+teardown(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(test_clients); i++)
+        clients[i + 1] = NULL;
+}
+
+static void
+fairsched_accounting(void)
+{
+    ClientPtr a = &test_clients[0], b = &test_clients[1];
+    CARD64 total;
+
+    setup();
+    total = FairSchedTotalCpuTime();
+
+    FairSchedPicked(a);
+    FairSchedCharge(a->index, 10 * MS);
+    FairSchedPicked(b);
+    FairSchedCharge(b->index, 3 * MS);
+    FairSchedPicked(b);
+    FairSchedCharge(b->index, 3 * MS);
+
+    assert(FairSchedGetClient(a)->cpuNs == 10 * MS);
+    assert(FairSchedGetClient(a)->turns == 1);
+    assert(FairSchedGetClient(b)->cpuNs == 6 * MS);
+    assert(FairSchedGetClient(b)->turns == 2);
+    assert(FairSchedTotalCpuTime() - total == 16 * MS);
+
+    /* the client went away during its turn: only the total counts it */
+    b->clientGone = TRUE;
+    FairSchedCharge(b->index, 5 * MS);
+    assert(FairSchedGetClient(b)->cpuNs == 6 * MS);
+    assert(FairSchedTotalCpuTime() - total == 21 * MS);
+
+    teardown();
+}
+
+static void
+fairsched_weights(void)
+{
+    ClientPtr a = &test_clients[0], b = &test_clients[1];
+
+    setup();
+
+    /* the cheaper client goes first */
+    FairSchedCharge(a->index, 10 * MS);
+    FairSchedCharge(b->index, 6 * MS);
+    assert(FairSchedBefore(b, a));
+    assert(!FairSchedBefore(a, b));
+
+    /* a step up in priority halves what a client is charged */
+    setup();
+    a->priority = 1;
+    FairSchedCharge(a->index, 10 * MS);
+    FairSchedCharge(b->index, 6 * MS);
+    assert(FairSchedBefore(a, b));
+
+    /* and a step down doubles it */
+    setup();
+    a->priority = -1;
+    FairSchedCharge(a->index, 4 * MS);
+    FairSchedCharge(b->index, 6 * MS);
+    assert(FairSchedBefore(b, a));
+
+    teardown();
+}
+
+static void
+fairsched_catch_up(void)
+{
+    ClientPtr busy = &test_clients[0], idle = &test_clients[1];
+    ClientPtr late = &test_clients[2];
+
+    setup();
+
+    /* one client keeps the server busy while another one idles */
+    for (int i = 0; i < 100; i++) {
+        FairSchedPicked(busy);
+        FairSchedCharge(busy->index, 10 * MS);
+    }
+    FairSchedPicked(busy);
+
+    /* when it wakes up, it gets a slice ahead, not a second of CPU time */
+    FairSchedWake(idle);
+    assert(FairSchedBefore(idle, busy));
+    FairSchedCharge(idle->index, (SmartScheduleMaxSlice + 1) * MS);
+    assert(FairSchedBefore(busy, idle));
+
+    /* new clients start where the running ones are */
+    FairSchedInitClient(late);
+    assert(!FairSchedBefore(late, busy));
+    assert(FairSchedGetClient(late)->cpuNs == 0);
+
+    teardown();
+}
+
+/* burns 5ms of the CPU time of whichever thread runs it */
+static void
+spin_task(void *data, int task)
+{
+    struct timespec ts;
+    CARD64 start, now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    start = (CARD64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    do {
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        now = (CARD64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+    } while (now - start < 5 * MS);
+}
+
+static void
+fairsched_worker_time(void)
+{
+    ThreadPoolPtr pool = ThreadPoolCreate(4, "test");
+    CARD64 start;
+
+    /* without worker threads, it's all on this one anyway */
+    if (!pool)
+        return;
+
+    /* what a request costs counts the workers, not just this thread */
+    start = FairSchedCpuTime();
+    ThreadPoolRun(pool, spin_task, NULL, 16);
+    assert(FairSchedCpuTime() - start >= 16 * 5 * MS);
+
+    ThreadPoolDestroy(pool);
+}
+
+const testfunc_t*
+fairsched_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        fairsched_accounting,
+        fairsched_weights,
+        fairsched_catch_up,
+        fairsched_worker_time,
+        NULL,
+    };
+    return testfuncs;
+}
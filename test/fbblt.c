@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "fb/fb_priv.h"
+
+#include "tests-common.h"
+
+#define WIDTH   320             /* pixels, a whole number of words at 1bpp */
+#define HEIGHT  12
+#define WORDS   (WIDTH * 32 / FB_UNIT * HEIGHT)
+
+#ifdef FB_BLT_SIMD
+
+typedef struct {
+    FbBits src[WORDS];
+    FbBits dst[WORDS];
+} BltBuffersRec;
+
+static BltBuffersRec initial, simd, plain;
+
+/* one blit into (or within) buf->dst, the way CopyArea would do it */
+static void
+blt(BltBuffersRec *buf, Bool overlap, int bpp, int alu,
+    int sx, int sy, int dx, int dy, int w, int h)
+{
+    FbStride stride = WIDTH * bpp / FB_UNIT;
+    FbBits *from = overlap ? buf->dst : buf->src;
+    Bool reverse = overlap && dy == sy && dx > sx;
+    Bool upsidedown = overlap && dy > sy;
+
+    fbBlt(from + sy * stride, stride, sx * bpp, buf->dst + dy * stride,
+          stride, dx * bpp, w * bpp, h, alu, FB_ALLONES, bpp, reverse,
+          upsidedown);
+}
+
+static void
+check_blt(Bool overlap, int bpp, int alu, int sx, int sy, int dx, int dy)
+{
+    int w = WIDTH - 2 * (sx > dx ? sx : dx), h = HEIGHT - 4;
+
+    simd = initial;
+    assert(fbInitBltSimd(TRUE));
+    blt(&simd, overlap, bpp, alu, sx, sy, dx, dy, w, h);
+
+    plain = initial;
+    fbInitBltSimd(FALSE);
+    blt(&plain, overlap, bpp, alu, sx, sy, dx, dy, w, h);
+
+    assert(memcmp(simd.dst, plain.dst, sizeof(plain.dst)) == 0);
+}
+
+#endif /* FB_BLT_SIMD */
+
+/*
+ * The vector kernels must leave exactly the bits the C loops do, for
+ * every rop, depth, alignment and overlap direction test/bench/blt.c
+ * loops over, and then some.
+ */
+static void
+fb_blt_simd(void)
+{
+#ifdef FB_BLT_SIMD
+    static const int bpps[] = { 1, 8, 16, 24, 32 };
+    const FbBltFuncsRec *saved = fbBltFuncs;
+    static const struct {
+        int sx, sy, dx, dy;
+    } offsets[] = {
+        { 32, 2, 32, 2 },       /* aligned */
+        { 33, 2, 40, 2 },       /* needs shifting */
+        { 3, 1, 1, 3 },
+        { 0, 0, 17, 0 },
+    }, overlaps[] = {
+        { 40, 2, 32, 2 },       /* left */
+        { 32, 2, 37, 2 },       /* right */
+        { 32, 2, 64, 2 },       /* right, aligned */
+        { 32, 3, 32, 1 },       /* up */
+        { 32, 1, 33, 3 },       /* down */
+    };
+
+    if (!fbInitBltSimd(TRUE))
+        return;                 /* nothing to compare against */
+
+    srand(1);
+    for (size_t i = 0; i < ARRAY_SIZE(initial.src); i++) {
+        initial.src[i] = (FbBits) rand() << 16 ^ rand();
+        initial.dst[i] = (FbBits) rand() << 16 ^ rand();
+    }
+
+    for (size_t b = 0; b < ARRAY_SIZE(bpps); b++)
+        for (int alu = GXclear; alu <= GXset; alu++) {
+            for (size_t i = 0; i < ARRAY_SIZE(offsets); i++)
+                check_blt(FALSE, bpps[b], alu, offsets[i].sx, offsets[i].sy,
+                          offsets[i].dx, offsets[i].dy);
+            for (size_t i = 0; i < ARRAY_SIZE(overlaps); i++)
+                check_blt(TRUE, bpps[b], alu, overlaps[i].sx, overlaps[i].sy,
+                          overlaps[i].dx, overlaps[i].dy);
+        }
+
+    fbBltFuncs = saved;
+#endif
+}
+
+const testfunc_t*
+fbblt_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        fb_blt_simd,
+        NULL,
+    };
+    return testfuncs;
+}
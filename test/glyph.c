@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "render/glyphstr_priv.h"
+
+#include "misc.h"
+#include "picturestr.h"
+#include "scrnintstr.h"
+
+#include "tests-common.h"
+
+#define WIDTH   4               /* a multiple of the scanline pad at depth 8 */
+#define HEIGHT  3
+#define SIZE    (WIDTH * HEIGHT)
+
+static ScreenRec screen;
+static PictFormatRec format = { .depth = 8 };
+static xGlyphInfo info = { .width = WIDTH, .height = HEIGHT };
+
+/* matching a glyph mustn't read it back from the GPU */
+static void
+test_get_image(DrawablePtr pDrawable, int x, int y, int w, int h,
+               unsigned int format, unsigned long planeMask, char *pdstLine)
+{
+    assert(!"GetImage called to match a glyph");
+}
+
+/* a glyph as ProcRenderAddGlyphs() makes it, but with the digest given */
+static GlyphPtr
+make_glyph(CARD8 *bits, const unsigned char sha1[20])
+{
+    GlyphPtr glyph = AllocateGlyph(&info, GlyphFormat8, bits, SIZE);
+
+    assert(glyph);
+    memcpy(glyph->sha1, sha1, sizeof(glyph->sha1));
+    return glyph;
+}
+
+static void
+glyph_collisions(void)
+{
+    ScreenInfo saved = screenInfo;
+    GlyphSetPtr glyphSet;
+    GlyphPtr a, b, c;
+    CARD8 bits_a[SIZE], bits_b[SIZE], bits_c[SIZE];
+    unsigned char sha1[20];
+
+    screen.myNum = 0;
+    screen.GetImage = test_get_image;
+    screenInfo.numScreens = 1;
+    screenInfo.screens[0] = &screen;
+
+    memset(bits_a, 0x11, SIZE);
+    memset(bits_b, 0x22, SIZE);
+    memset(bits_c, 0x33, SIZE);
+    assert(HashGlyph(&info, bits_a, SIZE, sha1) == Success);
+
+    glyphSet = AllocateGlyphSet(GlyphFormat8, &format);
+    assert(glyphSet);
+    assert(ResizeGlyphSet(glyphSet, 3));
+
+    /* a made up glyph with a's digest doesn't get a's bits */
+    a = make_glyph(bits_a, sha1);
+    b = make_glyph(bits_b, sha1);
+    AddGlyph(glyphSet, a, 1);
+    AddGlyph(glyphSet, b, 2);
+    FreeGlyph(a, GlyphFormat8);
+    FreeGlyph(b, GlyphFormat8);
+    assert(FindGlyph(glyphSet, 1) == a);
+    assert(FindGlyph(glyphSet, 2) == b);
+
+    assert(FindGlyphByHash(sha1, GlyphFormat8, &info, bits_a) == a);
+    assert(FindGlyphByHash(sha1, GlyphFormat8, &info, bits_b) == b);
+    assert(!FindGlyphByHash(sha1, GlyphFormat8, &info, bits_c));
+
+    /* the same bits still share a glyph */
+    c = make_glyph(bits_a, sha1);
+    AddGlyph(glyphSet, c, 3);
+    FreeGlyph(c, GlyphFormat8);
+    assert(FindGlyph(glyphSet, 3) == a);
+    assert(a->refcnt == 2);
+
+    /* and the colliding ones come out again one at a time */
+    assert(DeleteGlyph(glyphSet, 1));
+    assert(FindGlyphByHash(sha1, GlyphFormat8, &info, bits_a) == a);
+    assert(DeleteGlyph(glyphSet, 3));
+    assert(!FindGlyphByHash(sha1, GlyphFormat8, &info, bits_a));
+    assert(FindGlyphByHash(sha1, GlyphFormat8, &info, bits_b) == b);
+
+    FreeGlyphSet(glyphSet, 0);
+    screenInfo = saved;
+}
+
+const testfunc_t*
+glyph_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        glyph_collisions,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -32,6 +32,7 @@
 #include <X11/extensions/XI2proto.h>
 #include <X11/Xatom.h>
 
+#include "dix/atom_priv.h"
 #include "dix/dix_priv.h"
 #include "dix/dixgrabs_priv.h"
 #include "dix/eventconvert.h"
@@ -39,10 +40,13 @@
 #include "dix/input_priv.h"
 #include "dix/inpututils_priv.h"
 #include "mi/mi_priv.h"
+#include "mi/mipointer_priv.h"
 #include "os/fmt.h"
+#include "Xi/xibarriers.h"
 
 #include "misc.h"
 #include "resource.h"
+#include "scrnintstr.h"
 #include "windowstr.h"
 #include "inputstr.h"
 #include "exglobals.h"
@@ -1781,10 +1785,277 @@ dix_double_fp_conversion(void)
     }
 }
 
+/* QueuePointerMotionEvents() must queue what GetPointerEvents() returns for
+ * each of the masks, for a mouse and for a tablet.
+ */
+#define MOTION_MAX_EVENTS 64
+#define MOTION_TABLET_MAX 32767
+
+static ScreenRec motion_screen;
+static WindowRec motion_root;
+static WindowOptRec motion_root_optional;
+static InternalEvent motion_queued[MOTION_MAX_EVENTS];
+static int motion_nqueued;
+
+static Bool
+motion_sprite_init(DeviceIntPtr pDev, ScreenPtr pScreen)
+{
+    return TRUE;
+}
+
+static void
+motion_sprite_cleanup(DeviceIntPtr pDev, ScreenPtr pScreen)
+{
+}
+
+static Bool
+motion_realize_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor)
+{
+    return TRUE;
+}
+
+static void
+motion_set_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, CursorPtr pCursor,
+                  int x, int y)
+{
+}
+
+static void
+motion_move_cursor(DeviceIntPtr pDev, ScreenPtr pScreen, int x, int y)
+{
+}
+
+static Bool
+motion_cursor_off_screen(ScreenPtr *ppScreen, int *x, int *y)
+{
+    return FALSE;
+}
+
+static miPointerSpriteFuncRec motion_sprite_funcs = {
+    .RealizeCursor = motion_realize_cursor,
+    .UnrealizeCursor = motion_realize_cursor,
+    .SetCursor = motion_set_cursor,
+    .MoveCursor = motion_move_cursor,
+    .DeviceCursorInitialize = motion_sprite_init,
+    .DeviceCursorCleanup = motion_sprite_cleanup,
+};
+
+static miPointerScreenFuncRec motion_screen_funcs = {
+    .CursorOffScreen = motion_cursor_off_screen,
+    .WarpCursor = miPointerWarpCursor,
+};
+
+static int
+motion_device_proc(DeviceIntPtr dev, int what, int mode)
+{
+    CARD8 map[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    Atom btn_labels[7] = { 0 };
+    Atom axes_labels[4] = { 0 };
+
+    if (what != DEVICE_INIT)
+        return Success;
+
+    if (!InitPointerDeviceStruct((DevicePtr) dev, map, 7, btn_labels,
+                                 (PtrCtrlProcPtr) NoopDDA,
+                                 GetMotionHistorySize(), 4, axes_labels))
+        return BadAlloc;
+    SetScrollValuator(dev, 2, SCROLL_TYPE_VERTICAL, 15, SCROLL_FLAG_PREFERRED);
+    SetScrollValuator(dev, 3, SCROLL_TYPE_HORIZONTAL, 15, SCROLL_FLAG_NONE);
+    if (mode == Absolute) {
+        InitValuatorAxisStruct(dev, 0, axes_labels[0], 0, MOTION_TABLET_MAX,
+                               1, 0, 1, Absolute);
+        InitValuatorAxisStruct(dev, 1, axes_labels[1], 0, MOTION_TABLET_MAX,
+                               1, 0, 1, Absolute);
+    }
+    return Success;
+}
+
+static int
+motion_mouse_proc(DeviceIntPtr dev, int what)
+{
+    return motion_device_proc(dev, what, Relative);
+}
+
+static int
+motion_tablet_proc(DeviceIntPtr dev, int what)
+{
+    return motion_device_proc(dev, what, Absolute);
+}
+
+/* a floating slave, as ActivateDevice() and EnableDevice() would leave it */
+static DeviceIntPtr
+motion_device(DeviceProc proc)
+{
+    DeviceIntPtr dev = AddInputDevice(NULL, proc, TRUE);
+
+    assert(dev);
+    dev->type = SLAVE;
+    dev->coreEvents = FALSE;
+    assert(proc(dev, DEVICE_INIT) == Success);
+    assert(motion_screen.DeviceCursorInitialize(dev, &motion_screen));
+    dev->inited = TRUE;
+
+    dev->spriteInfo->sprite = calloc(1, sizeof(SpriteRec));
+    assert(dev->spriteInfo->sprite);
+    InitializeSprite(dev, &motion_root);
+    dev->spriteInfo->spriteOwner = FALSE;
+    dev->spriteInfo->paired = dev;
+    dev->enabled = TRUE;
+    return dev;
+}
+
+static void
+motion_event_handler(int screenNum, InternalEvent *ev, DeviceIntPtr dev)
+{
+    assert(motion_nqueued < MOTION_MAX_EVENTS);
+    memcpy(&motion_queued[motion_nqueued++], ev, ev->any.length);
+}
+
+/* everything but the time and the device it came from */
+static void
+motion_check_event(InternalEvent *queued, InternalEvent *expected)
+{
+    assert(queued->any.type == expected->any.type);
+    assert(queued->any.length == expected->any.length);
+
+    switch (queued->any.type) {
+    case ET_RawMotion:
+    case ET_RawButtonPress:
+    case ET_RawButtonRelease:
+        queued->raw_event.time = expected->raw_event.time;
+        queued->raw_event.deviceid = expected->raw_event.deviceid;
+        queued->raw_event.sourceid = expected->raw_event.sourceid;
+        break;
+    default:
+        queued->device_event.time = expected->device_event.time;
+        queued->device_event.deviceid = expected->device_event.deviceid;
+        queued->device_event.sourceid = expected->device_event.sourceid;
+        break;
+    }
+    assert(memcmp(queued, expected, queued->any.length) == 0);
+}
+
+static int
+motion_count_buttons(int button)
+{
+    int count = 0;
+
+    for (int i = 0; i < motion_nqueued; i++)
+        if (motion_queued[i].any.type == ET_ButtonPress &&
+            motion_queued[i].device_event.detail.button == button)
+            count++;
+    return count;
+}
+
+/* the same masks through both, on twin devices */
+static void
+motion_check_masks(DeviceProc proc, int flags, const ValuatorMask *masks,
+                   int nmasks)
+{
+    DeviceIntPtr batched = motion_device(proc);
+    DeviceIntPtr single = motion_device(proc);
+    InternalEvent *events = InitEventList(GetMaximumEventsNum());
+    int nexpected = 0;
+
+    assert(events);
+    motion_nqueued = 0;
+    QueuePointerMotionEvents(batched, flags, masks, nmasks);
+    mieqProcessInputEvents();
+
+    for (int i = 0; i < nmasks; i++) {
+        /* as xf86PostMotionEventM() does */
+        int nevents = GetPointerEvents(events, single, MotionNotify, 0,
+                                       valuator_mask_num_valuators(&masks[i]) ?
+                                       flags : 0, &masks[i]);
+
+        for (int j = 0; j < nevents; j++) {
+            assert(nexpected < motion_nqueued);
+            motion_check_event(&motion_queued[nexpected++], &events[j]);
+        }
+    }
+    assert(nexpected == motion_nqueued);
+    FreeEventList(events, GetMaximumEventsNum());
+}
+
+static void
+dix_queue_pointer_motion_events(void)
+{
+    ValuatorMask masks[9];
+
+    motion_screen.width = 1920;
+    motion_screen.height = 1080;
+    motion_screen.root = &motion_root;
+    motion_root.drawable.pScreen = &motion_screen;
+    motion_root.drawable.width = motion_screen.width;
+    motion_root.drawable.height = motion_screen.height;
+    motion_root.optional = &motion_root_optional;
+    screenInfo.numScreens = 1;
+    screenInfo.screens[0] = &motion_screen;
+    screenInfo.width = motion_screen.width;
+    screenInfo.height = motion_screen.height;
+
+    dixResetPrivates();
+    InitAtoms();
+    assert(miPointerInitialize(&motion_screen, &motion_sprite_funcs,
+                               &motion_screen_funcs, TRUE));
+    assert(XIBarrierInit());
+    InitEvents();
+    mieqInit();
+    mieqSetHandler(ET_Motion, motion_event_handler);
+    mieqSetHandler(ET_RawMotion, motion_event_handler);
+    mieqSetHandler(ET_ButtonPress, motion_event_handler);
+    mieqSetHandler(ET_ButtonRelease, motion_event_handler);
+    mieqSetHandler(ET_RawButtonPress, motion_event_handler);
+    mieqSetHandler(ET_RawButtonRelease, motion_event_handler);
+
+    for (int i = 0; i < ARRAY_SIZE(masks); i++)
+        valuator_mask_zero(&masks[i]);
+
+    /* mouse motion, nothing at all, and wheels in between */
+    valuator_mask_set(&masks[0], 0, 3);
+    valuator_mask_set(&masks[0], 1, -2);
+    valuator_mask_set(&masks[2], 0, 1);
+    valuator_mask_set(&masks[2], 2, 15);
+    valuator_mask_set(&masks[3], 3, -30);
+    valuator_mask_set(&masks[4], 1, 5);
+    valuator_mask_set_double(&masks[5], 2, 7.5);
+    valuator_mask_set_double(&masks[6], 2, 7.5);
+    valuator_mask_set(&masks[7], 0, -4);
+    valuator_mask_set(&masks[8], 1, 0);
+    motion_check_masks(motion_mouse_proc, POINTER_RELATIVE, masks,
+                       ARRAY_SIZE(masks));
+
+    /* only motion on the wheels scrolls */
+    assert(motion_count_buttons(5) == 2);
+    assert(motion_count_buttons(6) == 2);
+    assert(motion_count_buttons(4) == 0 && motion_count_buttons(7) == 0);
+
+    /* a tablet, which has its coordinates scaled */
+    for (int i = 0; i < ARRAY_SIZE(masks); i++)
+        valuator_mask_zero(&masks[i]);
+    valuator_mask_set(&masks[0], 0, 1000);
+    valuator_mask_set(&masks[0], 1, 31000);
+    valuator_mask_set(&masks[2], 0, 12345);
+    valuator_mask_set(&masks[3], 1, 777);
+    valuator_mask_set(&masks[3], 2, 30);
+    valuator_mask_set(&masks[5], 0, MOTION_TABLET_MAX);
+    valuator_mask_set(&masks[5], 1, 0);
+    valuator_mask_set(&masks[6], 3, 20);
+    valuator_mask_set(&masks[7], 0, 4567);
+    valuator_mask_set(&masks[7], 1, 8901);
+    motion_check_masks(motion_tablet_proc, POINTER_ABSOLUTE, masks,
+                       ARRAY_SIZE(masks));
+    assert(motion_count_buttons(5) == 2);
+    assert(motion_count_buttons(7) == 1);
+
+    mieqFini();
+}
+
 /* The mieq test verifies that events added to the queue come out in the same
  * order that they went in.
  */
 static uint32_t mieq_test_event_last_processed;
+static uint32_t mieq_test_events_processed;
 
 static void
 mieq_test_event_handler(int screenNum, InternalEvent *ie, DeviceIntPtr dev)
@@ -1794,6 +2065,7 @@ mieq_test_event_handler(int screenNum, InternalEvent *ie, DeviceIntPtr dev)
     assert(e->type == ET_RawMotion);
     assert(e->flags > mieq_test_event_last_processed);
     mieq_test_event_last_processed = e->flags;
+    mieq_test_events_processed++;
 }
 
 static void
@@ -1834,6 +2106,7 @@ mieq_test(void)
     uint32_t next = 1;
 
     mieq_test_event_last_processed = 0;
+    mieq_test_events_processed = 0;
     mieqInit();
     mieqSetHandler(ET_RawMotion, mieq_test_event_handler);
 
@@ -1857,10 +2130,23 @@ mieq_test(void)
     mieq_test_generate_events(1950);
     mieqProcessInputEvents();
 
+    /* growing the queue lost none of them */
+    assert(mieq_test_events_processed == next - 1);
+    assert(mieqDroppedEvents() == 0);
+
     /* Now overflow one last time with the maximal queue and reach the verbosity limit */
     mieq_test_generate_events(10000);
     mieqProcessInputEvents();
 
+    /* all but what fits are dropped, and counted */
+    assert(mieq_test_events_processed == next - 1 - mieqDroppedEvents());
+    assert(mieqDroppedEvents() == 10000 - 4095);
+
+    /* so is a second overflow, the log only hears of it later */
+    mieq_test_generate_events(10000);
+    mieqProcessInputEvents();
+    assert(mieqDroppedEvents() == 2 * (10000 - 4095));
+
     mieqFini();
 }
 
@@ -1949,6 +2235,7 @@ input_test(void)
         xi_unregister_handlers,
         dix_valuator_alloc,
         dix_get_master,
+        dix_queue_pointer_motion_events,
         input_option_test,
         mieq_test,
         NULL,
@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix/window_priv.h"
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+#include "privates.h"
+#include "regionstr.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#include "tests-common.h"
+
+static ScreenRec screen = { .width = 640, .height = 480 };
+
+static void
+test_window_exposures(WindowPtr pWin, RegionPtr prgn)
+{
+}
+
+static void
+test_paint_window(WindowPtr pWin, RegionPtr prgn, int what)
+{
+}
+
+static void
+test_copy_window(WindowPtr pWin, DDXPointRec oldOrigin, RegionPtr prgnSrc)
+{
+}
+
+static WindowPtr
+test_window(WindowPtr pParent, int x, int y, int w, int h, int bw)
+{
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+
+    assert(pWin);
+    pWin->drawable.type = DRAWABLE_WINDOW;
+    pWin->drawable.class = InputOutput;
+    pWin->drawable.pScreen = &screen;
+    pWin->drawable.width = w;
+    pWin->drawable.height = h;
+    pWin->borderWidth = bw;
+    pWin->borderIsPixel = TRUE;
+    pWin->winGravity = NorthWestGravity;
+    pWin->mapped = pWin->realized = pWin->viewable = TRUE;
+    RegionNull(&pWin->winSize);
+    RegionNull(&pWin->borderSize);
+    RegionNull(&pWin->clipList);
+    RegionNull(&pWin->borderClip);
+
+    if (!pParent) {
+        BoxRec box = { 0, 0, w, h };
+
+        RegionReset(&pWin->winSize, &box);
+        RegionReset(&pWin->borderSize, &box);
+        RegionReset(&pWin->clipList, &box);
+        RegionReset(&pWin->borderClip, &box);
+        pWin->visibility = VisibilityUnobscured;
+        screen.root = pWin;
+        return pWin;
+    }
+
+    /* at the bottom of its siblings */
+    pWin->parent = pParent;
+    pWin->prevSib = pParent->lastChild;
+    if (pParent->lastChild)
+        pParent->lastChild->nextSib = pWin;
+    else
+        pParent->firstChild = pWin;
+    pParent->lastChild = pWin;
+
+    pWin->origin.x = x + bw;
+    pWin->origin.y = y + bw;
+    pWin->drawable.x = pParent->drawable.x + x + bw;
+    pWin->drawable.y = pParent->drawable.y + y + bw;
+    pWin->visibility = VisibilityNotViewable;
+    SetWinSize(pWin);
+    SetBorderSize(pWin);
+    return pWin;
+}
+
+static void
+free_tree(WindowPtr pWin)
+{
+    WindowPtr pChild = pWin->firstChild;
+
+    while (pChild) {
+        WindowPtr pNext = pChild->nextSib;
+
+        free_tree(pChild);
+        pChild = pNext;
+    }
+    RegionUninit(&pWin->winSize);
+    RegionUninit(&pWin->borderSize);
+    RegionUninit(&pWin->clipList);
+    RegionUninit(&pWin->borderClip);
+    dixFreeObjectWithPrivates(pWin, PRIVATE_WINDOW);
+}
+
+/* validates pFrame and its client window, which haven't changed */
+static void
+revalidate(WindowPtr pRoot, WindowPtr pFrame)
+{
+    miMarkWindow(pRoot);
+    miMarkWindow(pFrame);
+    miMarkWindow(pFrame->firstChild);
+    miValidateTree(pRoot, pFrame, VTOther);
+    miHandleValidateExposures(pRoot);
+}
+
+/*
+ * A window that isn't viewable is never validated, so its clipDirty
+ * mustn't keep its parent from ever being skipped again.
+ */
+static void
+valtree_unmapped_sibling(void)
+{
+    WindowPtr pRoot, pFrame, pClient, pHidden;
+    miValidateStatsRec stats;
+
+    memset(&miValidateStats, 0, sizeof(miValidateStats));
+    miValidateMode = MI_VALIDATE_INCREMENTAL;
+
+    pRoot = test_window(NULL, 0, 0, screen.width, screen.height, 0);
+    pFrame = test_window(pRoot, 100, 100, 300, 200, 1);
+    pClient = test_window(pFrame, 2, 20, 296, 178, 0);
+    pHidden = test_window(pFrame, 10, 2, 100, 15, 0);
+    pHidden->mapped = pHidden->realized = pHidden->viewable = FALSE;
+
+    miMarkOverlappedWindows(pFrame, pFrame, NULL);
+    miMarkWindow(pRoot);
+    miValidateTree(pRoot, NullWindow, VTMap);
+    miHandleValidateExposures(pRoot);
+    assert(!pFrame->clipDirty && !pClient->clipDirty);
+    assert(!pFrame->dirtyDescendants && !pRoot->dirtyDescendants);
+    assert(pHidden->clipDirty);
+
+    /* the unmapped window changes size, then the frame moves */
+    pHidden->drawable.width = 50;
+    SetWinSize(pHidden);
+    SetBorderSize(pHidden);
+    assert(pFrame->dirtyDescendants && pRoot->dirtyDescendants);
+    miMoveWindow(pFrame, 150, 120, pFrame->nextSib, VTMove);
+    assert(!pFrame->dirtyDescendants && !pRoot->dirtyDescendants);
+
+    /* so the frame can be skipped again */
+    stats = miValidateStats;
+    revalidate(pRoot, pFrame);
+    assert(miValidateStats.skipped == stats.skipped + 1);
+    assert(miValidateStats.computed == stats.computed);
+
+    /* and skipping it leaves the clips a full validation computes */
+    miValidateMode = MI_VALIDATE_CHECK;
+    revalidate(pRoot, pFrame);
+    assert(miValidateStats.mismatches == 0);
+    miValidateMode = MI_VALIDATE_INCREMENTAL;
+
+    /* the unmapped window still gets its clips once it's mapped */
+    pHidden->mapped = pHidden->realized = pHidden->viewable = TRUE;
+    miMarkOverlappedWindows(pHidden, pHidden, NULL);
+    miValidateTree(pFrame, pHidden, VTMap);
+    miHandleValidateExposures(pFrame);
+    assert(!pHidden->clipDirty);
+    assert(RegionEqual(&pHidden->clipList, &pHidden->winSize));
+
+    free_tree(pRoot);
+    screen.root = NULL;
+}
+
+const testfunc_t*
+mivaltree_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        valtree_unmapped_sibling,
+        NULL,
+    };
+
+    screen.MarkWindow = miMarkWindow;
+    screen.MarkOverlappedWindows = miMarkOverlappedWindows;
+    screen.ValidateTree = miValidateTree;
+    screen.HandleExposures = miHandleValidateExposures;
+    screen.WindowExposures = test_window_exposures;
+    screen.PaintWindow = test_paint_window;
+    screen.CopyWindow = test_copy_window;
+    screen.MoveWindow = miMoveWindow;
+
+    /* window.c keeps the window index up to date */
+    assert(WindowIndexInit());
+    assert(dixAllocatePrivates(&screen.devPrivates, PRIVATE_SCREEN));
+    return testfuncs;
+}
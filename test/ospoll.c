@@ -0,0 +1,337 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <X11/X.h>
+
+#include "include/fd_notify.h"
+#include "os/ospoll.h"
+
+#include "os.h"
+
+#include "tests-common.h"
+
+/* one end of a socket pair in the ospoll, with what it got */
+typedef struct {
+    int fd;
+    int peer;
+    int calls;
+    int xevents;
+} TestFdRec;
+
+static struct ospoll *ospoll;
+static TestFdRec *remove_on_call[3];
+
+static void
+test_ready(int fd, int xevents, void *data)
+{
+    TestFdRec *t = data;
+
+    assert(fd == t->fd);
+    t->calls++;
+    t->xevents = xevents;
+}
+
+/* removes what's listed, itself included */
+static void
+test_ready_remove(int fd, int xevents, void *data)
+{
+    test_ready(fd, xevents, data);
+    for (size_t i = 0; i < ARRAY_SIZE(remove_on_call); i++)
+        if (remove_on_call[i])
+            ospoll_remove(ospoll, remove_on_call[i]->fd);
+}
+
+static void
+test_add(TestFdRec *t, enum ospoll_trigger trigger,
+         void (*callback)(int fd, int xevents, void *data))
+{
+    int sv[2];
+
+    assert(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0);
+    t->fd = sv[0];
+    t->peer = sv[1];
+    t->calls = t->xevents = 0;
+    assert(ospoll_add(ospoll, t->fd, trigger, callback, t));
+}
+
+static void
+test_close(TestFdRec *t)
+{
+    ospoll_remove(ospoll, t->fd);
+    close(t->fd);
+    close(t->peer);
+}
+
+static void
+test_send(TestFdRec *t)
+{
+    assert(write(t->peer, "x", 1) == 1);
+}
+
+static void
+test_drain(TestFdRec *t)
+{
+    char buf[16];
+
+    while (read(t->fd, buf, sizeof(buf)) > 0)
+        ;
+}
+
+/* waits, and checks how often the callback ran since the last time */
+static void
+test_wait(TestFdRec *t, int timeout, int calls, int xevents)
+{
+    t->calls = t->xevents = 0;
+    ospoll_wait(ospoll, timeout);
+    assert(t->calls == calls);
+    assert(t->xevents == xevents);
+}
+
+static void
+check_level(void)
+{
+    TestFdRec t;
+
+    test_add(&t, ospoll_trigger_level, test_ready);
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ);
+    test_wait(&t, 0, 0, 0);
+
+    /* for as long as there's something to read */
+    test_send(&t);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    test_drain(&t);
+    test_wait(&t, 0, 0, 0);
+
+    test_send(&t);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    test_drain(&t);
+    test_close(&t);
+}
+
+static void
+check_edge(void)
+{
+    TestFdRec t;
+
+    test_add(&t, ospoll_trigger_edge, test_ready);
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ);
+    test_wait(&t, 0, 0, 0);
+
+    /* once, however much there is to read */
+    test_send(&t);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    test_wait(&t, 0, 0, 0);
+
+    /* until it's read and reset as io.c does it */
+    test_drain(&t);
+    ospoll_reset_events(ospoll, t.fd);
+    test_wait(&t, 0, 0, 0);
+    test_send(&t);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    test_wait(&t, 0, 0, 0);
+    test_drain(&t);
+    test_close(&t);
+}
+
+static void
+check_mute_listen(enum ospoll_trigger trigger)
+{
+    TestFdRec t;
+    char buf[4096] = { 0 };
+
+    test_add(&t, trigger, test_ready);
+
+    /* nothing before listening */
+    test_send(&t);
+    test_wait(&t, 0, 0, 0);
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+
+    /* nor after muting, with the data still there */
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_READ);
+    test_send(&t);
+    test_wait(&t, 0, 0, 0);
+
+    /* writing, as a client whose output has backed up */
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_WRITE);
+    test_wait(&t, 1000, 1, X_NOTIFY_WRITE);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_WRITE);
+    test_wait(&t, 0, 0, 0);
+
+    /* both at once */
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ | X_NOTIFY_WRITE);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ | X_NOTIFY_WRITE);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_READ | X_NOTIFY_WRITE);
+    test_wait(&t, 0, 0, 0);
+
+    /* one of them muted while waiting for both */
+    test_drain(&t);
+    while (write(t.fd, buf, sizeof(buf)) > 0)
+        ;
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ | X_NOTIFY_WRITE);
+    test_wait(&t, 0, 0, 0);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_WRITE);
+    while (read(t.peer, buf, sizeof(buf)) > 0)
+        ;
+    test_send(&t);
+    test_wait(&t, 1000, 1, X_NOTIFY_READ);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_READ);
+
+    /* and muted in between waits without any */
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_READ);
+    test_wait(&t, 0, 0, 0);
+    test_drain(&t);
+    test_close(&t);
+}
+
+static void
+check_mute_listen_level(void)
+{
+    check_mute_listen(ospoll_trigger_level);
+}
+
+static void
+check_mute_listen_edge(void)
+{
+    check_mute_listen(ospoll_trigger_edge);
+}
+
+static void
+check_remove_in_callback(void)
+{
+    TestFdRec t[3];
+
+    /* whichever goes first removes all of them, so it's the only one */
+    for (size_t i = 0; i < ARRAY_SIZE(t); i++) {
+        test_add(&t[i], ospoll_trigger_level, test_ready_remove);
+        ospoll_listen(ospoll, t[i].fd, X_NOTIFY_READ);
+        test_send(&t[i]);
+        remove_on_call[i] = &t[i];
+    }
+    ospoll_wait(ospoll, 1000);
+    assert(t[0].calls + t[1].calls + t[2].calls == 1);
+    for (size_t i = 0; i < ARRAY_SIZE(t); i++) {
+        remove_on_call[i] = NULL;
+        assert(!ospoll_data(ospoll, t[i].fd));
+    }
+
+    /* nor do they come back later */
+    t[0].calls = t[1].calls = t[2].calls = 0;
+    ospoll_wait(ospoll, 0);
+    assert(t[0].calls + t[1].calls + t[2].calls == 0);
+
+    /* the fds can be added again, like a new client's would be */
+    for (size_t i = 0; i < ARRAY_SIZE(t); i++) {
+        assert(ospoll_add(ospoll, t[i].fd, ospoll_trigger_level, test_ready,
+                          &t[i]));
+        ospoll_listen(ospoll, t[i].fd, X_NOTIFY_READ);
+        test_wait(&t[i], 1000, 1, X_NOTIFY_READ);
+        test_drain(&t[i]);
+        test_close(&t[i]);
+    }
+}
+
+static void
+check_timeout(void)
+{
+    TestFdRec t;
+    char buf[4096] = { 0 };
+    CARD32 start, waited;
+    pid_t pid;
+
+    /* waiting to write, which is muted before it can */
+    test_add(&t, ospoll_trigger_level, test_ready);
+    while (write(t.fd, buf, sizeof(buf)) > 0)
+        ;
+    ospoll_listen(ospoll, t.fd, X_NOTIFY_READ | X_NOTIFY_WRITE);
+    test_wait(&t, 0, 0, 0);
+    ospoll_mute(ospoll, t.fd, X_NOTIFY_WRITE);
+
+    /* it gets to while waiting, which still times out in time */
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        usleep(150 * 1000);
+        while (read(t.peer, buf, sizeof(buf)) > 0)
+            ;
+        _exit(0);
+    }
+    start = GetTimeInMillis();
+    assert(ospoll_wait(ospoll, 200) == 0);
+    waited = GetTimeInMillis() - start;
+    assert(waitpid(pid, NULL, 0) == pid);
+    assert(t.calls == 0);
+    assert(waited >= 190 && waited < 300);
+    test_close(&t);
+}
+
+/* each check with epoll, and with io_uring where the server has it */
+static void
+run_backends(void (*check)(void))
+{
+    for (int uring = 0; uring <= 1; uring++) {
+        ospoll_use_uring = uring;
+        ospoll = ospoll_create();
+        assert(ospoll);
+        check();
+        ospoll_destroy(ospoll);
+    }
+    ospoll_use_uring = true;
+}
+
+static void
+poll_level(void)
+{
+    run_backends(check_level);
+}
+
+static void
+poll_edge(void)
+{
+    run_backends(check_edge);
+}
+
+static void
+poll_mute_listen(void)
+{
+    run_backends(check_mute_listen_level);
+    run_backends(check_mute_listen_edge);
+}
+
+static void
+poll_remove_in_callback(void)
+{
+    run_backends(check_remove_in_callback);
+}
+
+static void
+poll_timeout(void)
+{
+    run_backends(check_timeout);
+}
+
+const testfunc_t*
+ospoll_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        poll_level,
+        poll_edge,
+        poll_mute_listen,
+        poll_remove_in_callback,
+        poll_timeout,
+        NULL,
+    };
+
+    return testfuncs;
+}
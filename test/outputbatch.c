@@ -0,0 +1,246 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+
+#include "dix/dixstruct_priv.h"
+#include "dix/input_priv.h"
+#include "os/client_priv.h"
+#include "os/osdep.h"
+#include "os/Xtransint.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "inputstr.h"
+
+#include "tests-common.h"
+
+#define WINDOW  0x200001
+
+typedef struct {
+    ClientRec client;
+    OsCommRec oc;
+    struct _XtransConnInfo conn;
+} TestClientRec;
+
+/* every writev() that made it to a client, in order */
+static struct {
+    int client;
+    int count;
+    xEvent events[4];
+} writes[8];
+static int nwrites;
+
+/* no XKB state for XkbFilterEvents() to rewrite */
+static DeviceIntRec keyboard = { .type = MASTER_KEYBOARD };
+static TestClientRec test_clients[3];
+
+static ssize_t
+test_writev(XtransConnInfo ciptr, struct iovec *iov, int iovcnt)
+{
+    ssize_t len = 0;
+
+    assert(nwrites < (int) ARRAY_SIZE(writes));
+    writes[nwrites].client = ciptr->index;
+    for (int i = 0; i < iovcnt; i++) {
+        assert(len + iov[i].iov_len <= sizeof(writes[nwrites].events));
+        memcpy((char *) writes[nwrites].events + len, iov[i].iov_base,
+               iov[i].iov_len);
+        len += iov[i].iov_len;
+    }
+    writes[nwrites++].count = len / sizeof(xEvent);
+    return len;
+}
+
+static Xtransport transport = {
+    .TransName = "test",
+    .Writev = test_writev,
+};
+
+static ClientPtr
+test_client(int i, Bool local)
+{
+    TestClientRec *t = &test_clients[i];
+
+    memset(t, 0, sizeof(*t));
+    t->conn.transptr = &transport;
+    t->conn.index = i;
+    t->oc.fd = -1;
+    t->oc.trans_conn = &t->conn;
+    t->client.index = i + 1;
+    t->client.local = local;
+    t->client.osPrivate = &t->oc;
+    t->client.clientPtr = &keyboard;
+    xorg_list_init(&t->client.ready);
+    xorg_list_init(&t->client.output_pending);
+    return &t->client;
+}
+
+static void
+send_event(ClientPtr client, int type, int x, int state)
+{
+    xEvent ev = {
+        .u.keyButtonPointer.root = WINDOW,
+        .u.keyButtonPointer.event = WINDOW,
+        .u.keyButtonPointer.rootX = x,
+        .u.keyButtonPointer.eventX = x,
+        .u.keyButtonPointer.state = state,
+        .u.keyButtonPointer.sameScreen = xTrue,
+    };
+
+    ev.u.u.type = type;
+    WriteEventsToClient(client, 1, &ev);
+}
+
+static void
+check_write(int n, int client, int count)
+{
+    assert(n < nwrites);
+    assert(writes[n].client == client);
+    assert(writes[n].count == count);
+}
+
+static int
+written_x(int n, int event)
+{
+    return writes[n].events[event].u.keyButtonPointer.rootX;
+}
+
+static void
+output_batch_flush(void)
+{
+    ClientPtr a = test_client(0, TRUE);
+    ClientPtr b = test_client(1, TRUE);
+    ClientPtr remote = test_client(2, FALSE);
+
+    CoalesceMotionEvents = FALSE;
+    nwrites = 0;
+
+    /* local clients get their output right away outside a batch */
+    send_event(a, MotionNotify, 1, 0);
+    send_event(a, MotionNotify, 2, 0);
+    assert(nwrites == 2);
+    check_write(0, 0, 1);
+    check_write(1, 0, 1);
+
+    /* and once for everything at the end of one */
+    nwrites = 0;
+    OutputBatchBegin();
+    send_event(b, MotionNotify, 1, 0);
+    send_event(a, MotionNotify, 2, 0);
+    send_event(remote, MotionNotify, 3, 0);
+    send_event(b, ButtonPress, 4, 0);
+    send_event(a, MotionNotify, 5, 0);
+    OutputBatchBegin();
+    send_event(a, ButtonPress, 6, 0);
+    OutputBatchEnd();
+    assert(nwrites == 0);
+    OutputBatchEnd();
+
+    /* in the order they got output first, the remote one is left alone */
+    assert(nwrites == 2);
+    check_write(0, 1, 2);
+    assert(written_x(0, 0) == 1 && written_x(0, 1) == 4);
+    check_write(1, 0, 3);
+    assert(written_x(1, 0) == 2 && written_x(1, 1) == 5 &&
+           written_x(1, 2) == 6);
+
+    FlushAllOutput();
+    assert(nwrites == 3);
+    check_write(2, 2, 1);
+    assert(written_x(2, 0) == 3);
+}
+
+static void
+output_batch_coalesce(void)
+{
+    ClientPtr a = test_client(0, TRUE);
+    ClientPtr b = test_client(1, TRUE);
+    ClientPtr remote = test_client(2, FALSE);
+
+    CoalesceMotionEvents = TRUE;
+    nwrites = 0;
+
+    /* only the last of a run of motion events is left */
+    OutputBatchBegin();
+    for (int x = 1; x <= 5; x++)
+        send_event(a, MotionNotify, x, 0);
+    OutputBatchEnd();
+    assert(nwrites == 1);
+    check_write(0, 0, 1);
+    assert(written_x(0, 0) == 5);
+    assert(writes[0].events[0].u.u.type == MotionNotify);
+
+    /* anything else in between ends the run, so does another state */
+    nwrites = 0;
+    OutputBatchBegin();
+    send_event(a, MotionNotify, 1, 0);
+    send_event(a, MotionNotify, 2, 0);
+    send_event(a, ButtonPress, 3, 0);
+    send_event(a, MotionNotify, 4, Button1Mask);
+    send_event(a, MotionNotify, 5, Button1Mask);
+    send_event(a, MotionNotify, 6, 0);
+    OutputBatchEnd();
+    assert(nwrites == 1);
+    check_write(0, 0, 4);
+    assert(writes[0].events[1].u.u.type == ButtonPress);
+    assert(written_x(0, 0) == 2 && written_x(0, 1) == 3 &&
+           written_x(0, 2) == 5 && written_x(0, 3) == 6);
+
+    /* other clients' output doesn't, they get theirs coalesced too */
+    nwrites = 0;
+    OutputBatchBegin();
+    send_event(a, MotionNotify, 1, 0);
+    send_event(b, MotionNotify, 2, 0);
+    send_event(a, MotionNotify, 3, 0);
+    send_event(b, MotionNotify, 4, 0);
+    OutputBatchEnd();
+    assert(nwrites == 2);
+    check_write(0, 0, 1);
+    assert(written_x(0, 0) == 3);
+    check_write(1, 1, 1);
+    assert(written_x(1, 0) == 4);
+
+    /* nor across batches, the first one is gone already */
+    nwrites = 0;
+    OutputBatchBegin();
+    send_event(a, MotionNotify, 1, 0);
+    OutputBatchEnd();
+    OutputBatchBegin();
+    send_event(a, MotionNotify, 2, 0);
+    OutputBatchEnd();
+    assert(nwrites == 2);
+    assert(written_x(0, 0) == 1 && written_x(1, 0) == 2);
+
+    /* and never outside a batch, even if it's still in the buffer */
+    nwrites = 0;
+    send_event(remote, MotionNotify, 1, 0);
+    send_event(remote, MotionNotify, 2, 0);
+    assert(nwrites == 0);
+    FlushAllOutput();
+    assert(nwrites == 1);
+    check_write(0, 2, 2);
+
+    CoalesceMotionEvents = FALSE;
+}
+
+const testfunc_t*
+outputbatch_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        output_batch_flush,
+        output_batch_coalesce,
+        NULL,
+    };
+
+    /* as Dispatch() would */
+    xorg_list_init(&output_pending_clients);
+    return testfuncs;
+}
@@ -0,0 +1,298 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+#include <X11/Xatom.h>
+
+#include "dix/atom_priv.h"
+#include "dix/property_priv.h"
+#include "Xext/xace.h"
+#include "Xext/xacestr.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "privates.h"
+#include "propertyst.h"
+#include "windowstr.h"
+
+#include "tests-common.h"
+
+/* enough properties for the window to get an index, and to grow it */
+#define COUNT   100
+#define NAME(i) (XA_LAST_PREDEFINED + 1 + (i))
+
+static ClientRec client;
+static WindowOptRec optional;
+static Bool polyinstantiate;
+
+static WindowPtr
+create_window(void)
+{
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+
+    assert(pWin);
+    pWin->optional = &optional;
+    return pWin;
+}
+
+static void
+destroy_window(WindowPtr pWin)
+{
+    DeleteAllWindowProperties(pWin);
+    dixFreeObjectWithPrivates(pWin, PRIVATE_WINDOW);
+}
+
+static void
+set_property(WindowPtr pWin, Atom name, CARD32 value)
+{
+    assert(dixChangeWindowProperty(&client, pWin, name, XA_CARDINAL, 32,
+                                   PropModeReplace, 1, &value,
+                                   FALSE) == Success);
+}
+
+static PropertyPtr
+find_property(WindowPtr pWin, Atom name)
+{
+    PropertyPtr pProp;
+
+    if (dixLookupProperty(&pProp, pWin, name, &client,
+                          DixReadAccess) != Success)
+        return NULL;
+    return pProp;
+}
+
+static CARD32
+property_value(WindowPtr pWin, Atom name)
+{
+    PropertyPtr pProp = find_property(pWin, name);
+
+    assert(pProp);
+    return *(CARD32 *) pProp->data;
+}
+
+static int
+list_length(WindowPtr pWin)
+{
+    int n = 0;
+
+    for (PropertyPtr pProp = pWin->properties; pProp; pProp = pProp->next) {
+        assert(pProp->next == NULL || pProp->next->prev == pProp);
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Polyinstantiation the way XSELinux does it: each client only sees the
+ * instance of a property it created, here the one whose type is the
+ * client's index.
+ */
+static void
+poly_property_access(CallbackListPtr *pcbl, void *unused, void *calldata)
+{
+    XacePropertyAccessRec *rec = calldata;
+    PropertyPtr pProp = *rec->ppProp;
+    Atom name = pProp->propertyName;
+
+    if (!polyinstantiate)
+        return;
+    if (rec->access_mode & DixCreateAccess) {
+        pProp->type = rec->client->index;
+        return;
+    }
+    while (pProp && (pProp->propertyName != name ||
+                     pProp->type != rec->client->index))
+        pProp = pProp->next;
+    if (pProp)
+        *rec->ppProp = pProp;
+    else
+        rec->status = BadMatch;
+}
+
+static void
+property_index(void)
+{
+    WindowPtr pWin = create_window();
+
+    for (int i = 0; i < COUNT; i++)
+        set_property(pWin, NAME(i), i);
+    assert(list_length(pWin) == COUNT);
+
+    for (int i = 0; i < COUNT; i++)
+        assert(property_value(pWin, NAME(i)) == i);
+    assert(!find_property(pWin, NAME(COUNT)));
+
+    /* replacing doesn't add another property */
+    set_property(pWin, NAME(7), 1000);
+    assert(property_value(pWin, NAME(7)) == 1000);
+    assert(list_length(pWin) == COUNT);
+
+    /* every other one, then the rest, down to no index at all */
+    for (int i = 0; i < COUNT; i += 2)
+        assert(DeleteProperty(&client, pWin, NAME(i)) == Success);
+    for (int i = 0; i < COUNT; i++)
+        assert(!find_property(pWin, NAME(i)) == !(i % 2));
+    for (int i = 1; i < COUNT; i += 2)
+        assert(DeleteProperty(&client, pWin, NAME(i)) == Success);
+    assert(pWin->properties == NULL);
+    for (int i = 0; i < COUNT; i++)
+        assert(!find_property(pWin, NAME(i)));
+
+    /* and up again */
+    for (int i = 0; i < COUNT; i++)
+        set_property(pWin, NAME(i), i + 1);
+    for (int i = 0; i < COUNT; i++)
+        assert(property_value(pWin, NAME(i)) == i + 1);
+
+    destroy_window(pWin);
+}
+
+static void
+property_delete_iterating(void)
+{
+    WindowPtr pWin = create_window();
+    PropertyPtr pProp, next;
+    int n = 0, deleted = 0;
+
+    for (int i = 0; i < COUNT; i++)
+        set_property(pWin, NAME(i), i);
+
+    /* deleting the current property keeps the rest of the walk intact */
+    for (pProp = pWin->properties; pProp; pProp = next) {
+        next = pProp->next;
+        if (pProp->propertyName % 3 == 0) {
+            assert(DeleteProperty(&client, pWin,
+                                  pProp->propertyName) == Success);
+            deleted++;
+        }
+        n++;
+    }
+    assert(n == COUNT);
+
+    for (int i = 0; i < COUNT; i++) {
+        if (NAME(i) % 3 == 0)
+            assert(!find_property(pWin, NAME(i)));
+        else
+            assert(property_value(pWin, NAME(i)) == i);
+    }
+    assert(deleted >= COUNT / 3);
+    assert(list_length(pWin) == COUNT - deleted);
+
+    destroy_window(pWin);
+}
+
+static void
+property_duplicates(void)
+{
+    WindowPtr pWin = create_window();
+    ClientRec other = { .index = 2 };
+
+    client.index = 1;
+    polyinstantiate = TRUE;
+    assert(XaceRegisterCallback(XACE_PROPERTY_ACCESS, poly_property_access,
+                                NULL));
+
+    /* both clients get their own instance of every property */
+    for (int i = 0; i < COUNT; i++) {
+        CARD32 value = 1000 + i;
+
+        set_property(pWin, NAME(i), i);
+        assert(dixChangeWindowProperty(&other, pWin, NAME(i), XA_CARDINAL,
+                                       32, PropModeReplace, 1, &value,
+                                       FALSE) == Success);
+    }
+    assert(list_length(pWin) == 2 * COUNT);
+
+    for (int i = 0; i < COUNT; i++) {
+        PropertyPtr pProp;
+
+        assert(property_value(pWin, NAME(i)) == i);
+        assert(dixLookupProperty(&pProp, pWin, NAME(i), &other,
+                                 DixReadAccess) == Success);
+        assert(*(CARD32 *) pProp->data == 1000 + i);
+    }
+
+    /* deleting either instance leaves the other one reachable */
+    for (int i = 0; i < COUNT; i++)
+        assert(DeleteProperty(i % 2 ? &client : &other, pWin,
+                              NAME(i)) == Success);
+    for (int i = 0; i < COUNT; i++) {
+        PropertyPtr pProp;
+        int rc = dixLookupProperty(&pProp, pWin, NAME(i), &other,
+                                   DixReadAccess);
+
+        assert(!find_property(pWin, NAME(i)) == !!(i % 2));
+        assert((rc == Success) == !!(i % 2));
+    }
+    assert(list_length(pWin) == COUNT);
+
+    XaceDeleteCallback(XACE_PROPERTY_ACCESS, poly_property_access, NULL);
+    polyinstantiate = FALSE;
+    client.index = 0;
+    destroy_window(pWin);
+}
+
+static void
+property_rotate(void)
+{
+    WindowPtr pWin = create_window();
+    Atom atoms[COUNT / 2];
+
+    for (int i = 0; i < COUNT; i++)
+        set_property(pWin, NAME(i), i);
+    for (size_t i = 0; i < ARRAY_SIZE(atoms); i++)
+        atoms[i] = NAME(2 * i);
+
+    assert(dixRotateWindowProperties(&client, pWin, atoms, ARRAY_SIZE(atoms),
+                                     3) == Success);
+    for (size_t i = 0; i < ARRAY_SIZE(atoms); i++)
+        assert(property_value(pWin, atoms[(i + 3) % ARRAY_SIZE(atoms)]) ==
+               2 * i);
+    for (int i = 1; i < COUNT; i += 2)
+        assert(property_value(pWin, NAME(i)) == i);
+
+    /* and back */
+    assert(dixRotateWindowProperties(&client, pWin, atoms, ARRAY_SIZE(atoms),
+                                     -3) == Success);
+    for (int i = 0; i < COUNT; i++)
+        assert(property_value(pWin, NAME(i)) == i);
+
+    /* duplicate and missing names */
+    atoms[1] = atoms[0];
+    assert(dixRotateWindowProperties(&client, pWin, atoms, ARRAY_SIZE(atoms),
+                                     1) == BadMatch);
+    atoms[1] = NAME(COUNT);
+    assert(dixRotateWindowProperties(&client, pWin, atoms, ARRAY_SIZE(atoms),
+                                     1) == BadMatch);
+
+    destroy_window(pWin);
+}
+
+const testfunc_t*
+property_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        property_index,
+        property_delete_iterating,
+        property_duplicates,
+        property_rotate,
+        NULL,
+    };
+
+    InitAtoms();
+    for (int i = 0; i <= COUNT; i++) {
+        char name[16];
+        int len = snprintf(name, sizeof(name), "PROPERTY_%d", i);
+
+        assert(MakeAtom(name, len, TRUE) == NAME(i));
+    }
+    assert(PropertyIndexInit());
+    return testfuncs;
+}
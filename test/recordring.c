@@ -0,0 +1,184 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include <X11/extensions/recordproto.h>
+
+#include "record/record_priv.h"
+#include "record/ring.h"
+
+#include "misc.h"
+
+#include "tests-common.h"
+
+/* RecordRingCreate() needs sealable memfds */
+#if defined(HAVE_MEMFD_CREATE) && defined(F_SEAL_SHRINK)
+
+/* the recording client's view of the ring */
+typedef struct {
+    volatile xRecordRingHeader *header;
+    unsigned char *data;
+    size_t mapSize;
+} RingClient;
+
+static void
+ring_map(RingClient *rc, RecordRingPtr ring, int fd)
+{
+    rc->mapSize = RecordRingDataOffset(ring) + RecordRingSize(ring);
+    rc->header = mmap(NULL, rc->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    assert(rc->header != MAP_FAILED);
+    rc->data = (unsigned char *) rc->header + rc->header->dataOffset;
+    assert(rc->header->magic == RECORD_RING_MAGIC);
+    assert(rc->header->size == RecordRingSize(ring));
+    close(fd);
+}
+
+/* a reply of recorded data, byte i of the data being seed + i */
+static int
+ring_reply(unsigned char *buf, int datalen, int seed, Bool swapped)
+{
+    xRecordEnableContextReply *rep = (xRecordEnableContextReply *) buf;
+
+    memset(rep, 0, sizeof(*rep));
+    rep->type = X_Reply;
+    rep->category = XRecordFromClient;
+    rep->length = bytes_to_int32(datalen);
+    if (swapped)
+        swapl(&rep->length);
+    for (int i = 0; i < datalen; i++)
+        buf[sz_xRecordEnableContextReply + i] = seed + i;
+    return sz_xRecordEnableContextReply + datalen;
+}
+
+/* checks that the reply at the tail is the one in buf and consumes it */
+static void
+ring_consume(RingClient *rc, const unsigned char *buf, int len)
+{
+    CARD32 mask = rc->header->size - 1;
+    CARD64 tail = rc->header->tail;
+
+    assert(rc->header->head - tail >= len);
+    for (int i = 0; i < len; i++)
+        assert(rc->data[(tail + i) & mask] == buf[i]);
+    rc->header->tail = tail + len;
+}
+
+#endif
+
+static void
+record_ring_stream(void)
+{
+#if defined(HAVE_MEMFD_CREATE) && defined(F_SEAL_SHRINK)
+    static unsigned char buf[8192];
+    RingClient rc;
+    RecordRingPtr ring;
+    CARD64 head = 0;
+    int fd, len;
+
+    ring = RecordRingCreate(1, &fd);
+    assert(ring);
+    assert((RecordRingSize(ring) & (RecordRingSize(ring) - 1)) == 0);
+    ring_map(&rc, ring, fd);
+
+    /* a reply in one piece, no wakeup asked for */
+    len = ring_reply(buf, 64, 1, FALSE);
+    assert(!RecordRingWrite(ring, buf, len, FALSE, &head));
+    assert(head == len && rc.header->head == len);
+    ring_consume(&rc, buf, len);
+
+    /* a swapped reply in pieces, the last one padded like WriteToClient
+     * does; it only becomes visible and notifies once it's complete */
+    rc.header->wakeup = 1;
+    len = ring_reply(buf, 40, 7, TRUE);
+    assert(!RecordRingWrite(ring, buf, sz_xRecordEnableContextReply, TRUE,
+                            &head));
+    assert(!RecordRingWrite(ring, buf + sz_xRecordEnableContextReply, 12,
+                            TRUE, &head));
+    assert(rc.header->head == rc.header->tail);
+    assert(RecordRingWrite(ring, buf + sz_xRecordEnableContextReply + 12,
+                           26, TRUE, &head));
+    assert(rc.header->wakeup == 0);
+    assert(rc.header->head == head);
+    buf[len - 2] = buf[len - 1] = 0;
+    ring_consume(&rc, buf, len);
+
+    /* no more notifies until the client asks again */
+    len = ring_reply(buf, 4, 0, FALSE);
+    assert(!RecordRingWrite(ring, buf, len, FALSE, &head));
+    ring_consume(&rc, buf, len);
+
+    /* wrap around the end of the ring lots of times */
+    for (int i = 0; i < 1000; i++) {
+        len = ring_reply(buf, 4 * (1 + i % 1000), i, FALSE);
+        RecordRingWrite(ring, buf, len, FALSE, &head);
+        ring_consume(&rc, buf, len);
+    }
+    assert(rc.header->dropped == 0);
+
+    RecordRingDestroy(ring);
+    munmap((void *) rc.header, rc.mapSize);
+#endif
+}
+
+static void
+record_ring_overflow(void)
+{
+#if defined(HAVE_MEMFD_CREATE) && defined(F_SEAL_SHRINK)
+    static unsigned char buf[4096];
+    RingClient rc;
+    RecordRingPtr ring;
+    CARD64 head = 0;
+    int fd, len, written;
+
+    ring = RecordRingCreate(0, &fd);
+    assert(ring);
+    ring_map(&rc, ring, fd);
+
+    /* nobody consumes: replies which don't fit are dropped whole */
+    len = ring_reply(buf, sizeof(buf) - sz_xRecordEnableContextReply, 3,
+                     FALSE);
+    for (CARD32 i = 0; i < RecordRingSize(ring) / len + 5; i++) {
+        RecordRingWrite(ring, buf, len - 100, FALSE, &head);
+        RecordRingWrite(ring, buf + len - 100, 100, FALSE, &head);
+    }
+    written = RecordRingSize(ring) / len;
+    assert(rc.header->head == (CARD64) written * len);
+    assert(rc.header->dropped == 5);
+
+    /* once there's room again, replies get through */
+    ring_consume(&rc, buf, len);
+    RecordRingWrite(ring, buf, len, FALSE, &head);
+    assert(rc.header->head == (CARD64) (written + 1) * len);
+    assert(rc.header->dropped == 5);
+
+    /* a client writing garbage into the tail only loses data */
+    rc.header->tail = rc.header->head + 12345;
+    RecordRingWrite(ring, buf, len, FALSE, &head);
+    assert(rc.header->dropped == 6);
+
+    RecordRingDestroy(ring);
+    munmap((void *) rc.header, rc.mapSize);
+#endif
+}
+
+const testfunc_t*
+recordring_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        record_ring_stream,
+        record_ring_overflow,
+        NULL,
+    };
+    return testfuncs;
+}
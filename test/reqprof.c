@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix/reqprof_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+
+#include "tests-common.h"
+
+static ClientRec test_client;
+
+static ReqProfStatsRec found[1024];
+static int nfound;
+
+static void
+collect(const ReqProfStatsRec *stats, void *data)
+{
+    assert(nfound < ARRAY_SIZE(found));
+    found[nfound++] = *stats;
+}
+
+static const ReqProfStatsRec *
+lookup(CARD8 major, CARD16 minor)
+{
+    for (int i = 0; i < nfound; i++)
+        if (found[i].major == major && found[i].minor == minor)
+            return &found[i];
+    return NULL;
+}
+
+static void
+reqprof_histogram(void)
+{
+    const ReqProfStatsRec *stats;
+
+    memset(&test_client, 0, sizeof(test_client));
+    test_client.index = 1;
+
+    ReqProfAccount(&test_client, 1, 0, 0);      /* < 1us */
+    ReqProfAccount(&test_client, 1, 0, 1);      /* [1, 2) */
+    ReqProfAccount(&test_client, 1, 0, 3);      /* [2, 4) */
+    ReqProfAccount(&test_client, 1, 0, 1000);   /* [512, 1024) */
+    ReqProfAccount(&test_client, 1, 0, 1ULL << 40);
+
+    nfound = 0;
+    ReqProfForEach(&test_client, collect, NULL);
+    assert(nfound == 1);
+    stats = lookup(1, 0);
+    assert(stats);
+    assert(stats->count == 5);
+    assert(stats->totalUs == 1004 + (1ULL << 40));
+    assert(stats->maxUs == UINT32_MAX);
+    assert(stats->buckets[0] == 1);
+    assert(stats->buckets[1] == 1);
+    assert(stats->buckets[2] == 1);
+    assert(stats->buckets[10] == 1);
+    assert(stats->buckets[REQPROF_BUCKETS - 1] == 1);
+
+    ReqProfClientGone(&test_client);
+    nfound = 0;
+    ReqProfForEach(&test_client, collect, NULL);
+    assert(nfound == 0);
+}
+
+static void
+reqprof_opcodes(void)
+{
+    memset(&test_client, 0, sizeof(test_client));
+    test_client.index = 2;
+
+    /* enough distinct opcodes to grow the table a couple of times */
+    for (int major = 1; major < 128; major++)
+        ReqProfAccount(&test_client, major, 0, major);
+    for (int minor = 0; minor < 256; minor++) {
+        ReqProfAccount(&test_client, 130, minor, 1);
+        ReqProfAccount(&test_client, 131, minor, 2);
+    }
+
+    nfound = 0;
+    ReqProfForEach(&test_client, collect, NULL);
+    assert(nfound == 127 + 2 * 256);
+    for (int major = 1; major < 128; major++)
+        assert(lookup(major, 0)->totalUs == major);
+    assert(lookup(130, 255)->count == 1 && lookup(130, 255)->maxUs == 1);
+    assert(lookup(131, 0)->count == 1 && lookup(131, 0)->maxUs == 2);
+
+    /* gone clients don't get new entries */
+    ReqProfClientGone(&test_client);
+    test_client.clientGone = TRUE;
+    ReqProfAccount(&test_client, 1, 0, 1);
+    nfound = 0;
+    ReqProfForEach(&test_client, collect, NULL);
+    assert(nfound == 0);
+}
+
+const testfunc_t*
+reqprof_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        reqprof_histogram,
+        reqprof_opcodes,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -0,0 +1,270 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "dix/resource_priv.h"
+
+#include "misc.h"
+#include "dixstruct.h"
+#include "resource.h"
+
+#include "tests-common.h"
+
+static ClientRec server_client;
+static ClientRec test_client;
+
+static int deleted;
+
+static int
+delete_count(void *value, XID id)
+{
+    deleted++;
+    return Success;
+}
+
+/* frees the resource whose id is stored as value, like nested objects do */
+static int
+delete_chained(void *value, XID id)
+{
+    deleted++;
+    FreeResource((XID) (uintptr_t) value, X11_RESTYPE_NONE);
+    return Success;
+}
+
+static void
+setup(void)
+{
+    memset(&server_client, 0, sizeof(server_client));
+    memset(&test_client, 0, sizeof(test_client));
+    serverClient = &server_client;
+    assert(InitClientResources(serverClient));
+
+    test_client.index = 1;
+    test_client.clientAsMask = (Mask) 1 << CLIENTOFFSET;
+    assert(InitClientResources(&test_client));
+
+    deleted = 0;
+}
+
+static void
+teardown(void)
+{
+    FreeClientResources(&test_client);
+    FreeClientResources(serverClient);
+}
+
+static void
+resource_add_lookup(void)
+{
+    const int count = 100000;
+    RESTYPE type, other;
+    void *value;
+
+    setup();
+    type = CreateNewResourceType(delete_count, "TEST");
+    other = CreateNewResourceType(delete_count, "TEST_OTHER");
+    assert(type && other);
+
+    /* enough to go through several (incremental) table resizes */
+    for (int i = 1; i <= count; i++)
+        assert(AddResource(test_client.clientAsMask | i, type,
+                           (void *) (uintptr_t) i));
+
+    for (int i = 1; i <= count; i++) {
+        XID id = test_client.clientAsMask | i;
+
+        assert(dixLookupResourceByType(&value, id, type, NULL,
+                                       DixReadAccess) == Success);
+        assert(value == (void *) (uintptr_t) i);
+        assert(dixLookupResourceByType(&value, id, other, NULL,
+                                       DixReadAccess) != Success);
+        assert(dixLookupResourceByClass(&value, id, RC_ANY, NULL,
+                                        DixReadAccess) == Success);
+    }
+    assert(dixLookupResourceByClass(&value, test_client.clientAsMask | (count + 1),
+                                    RC_ANY, NULL, DixReadAccess) == BadValue);
+    assert(LegalNewID(test_client.clientAsMask | (count + 1), &test_client));
+    assert(!LegalNewID(test_client.clientAsMask | count, &test_client));
+
+    for (int i = 1; i <= count; i += 2)
+        FreeResource(test_client.clientAsMask | i, X11_RESTYPE_NONE);
+    assert(deleted == count / 2);
+
+    for (int i = 1; i <= count; i++) {
+        int rc = dixLookupResourceByType(&value, test_client.clientAsMask | i,
+                                         type, NULL, DixReadAccess);
+        assert((rc == Success) == !(i & 1));
+    }
+
+    assert(ChangeResourceValue(test_client.clientAsMask | 2, type, NULL));
+    assert(!ChangeResourceValue(test_client.clientAsMask | 1, type, NULL));
+    assert(dixLookupResourceByType(&value, test_client.clientAsMask | 2, type,
+                                   NULL, DixReadAccess) == Success);
+    assert(value == NULL);
+
+    teardown();
+    assert(deleted == count);
+}
+
+static void
+resource_same_id(void)
+{
+    XID id;
+    RESTYPE a, b;
+    void *value;
+
+    setup();
+    id = test_client.clientAsMask | 42;
+    a = CreateNewResourceType(delete_count, "TEST_A");
+    b = CreateNewResourceType(delete_count, "TEST_B");
+
+    assert(AddResource(id, a, &a));
+    assert(AddResource(id, b, &b));
+    assert(dixLookupResourceByType(&value, id, a, NULL, DixReadAccess) == Success);
+    assert(value == &a);
+    assert(dixLookupResourceByType(&value, id, b, NULL, DixReadAccess) == Success);
+    assert(value == &b);
+
+    FreeResourceByType(id, b, FALSE);
+    assert(deleted == 1);
+    assert(dixLookupResourceByType(&value, id, b, NULL, DixReadAccess) != Success);
+    assert(dixLookupResourceByType(&value, id, a, NULL, DixReadAccess) == Success);
+
+    /* skipped delete functions still free the resource itself */
+    assert(AddResource(id, b, &b));
+    FreeResource(id, a);
+    assert(deleted == 2);
+    assert(dixLookupResourceByClass(&value, id, RC_ANY, NULL,
+                                    DixReadAccess) == BadValue);
+
+    teardown();
+}
+
+static int visited;
+
+static void
+count_visit(void *value, XID id, void *cdata)
+{
+    visited++;
+}
+
+static void
+free_next_visit(void *value, XID id, void *cdata)
+{
+    visited++;
+    /* frees a resource the walk hasn't reached yet */
+    FreeResource(id - 1, X11_RESTYPE_NONE);
+}
+
+static void
+resource_by_type(void)
+{
+    RESTYPE a, b;
+
+    setup();
+    a = CreateNewResourceType(delete_count, "TEST_A");
+    b = CreateNewResourceType(delete_count, "TEST_B");
+
+    for (int i = 1; i <= 1000; i++)
+        assert(AddResource(test_client.clientAsMask | i,
+                           (i % 10) ? a : b, NULL));
+
+    visited = 0;
+    FindClientResourcesByType(&test_client, b, count_visit, NULL);
+    assert(visited == 100);
+
+    visited = 0;
+    FindClientResourcesByType(&test_client, 0, count_visit, NULL);
+    assert(visited == 1000);
+
+    /* walks newest first, so every visit frees the following resource */
+    visited = 0;
+    FindClientResourcesByType(&test_client, a, free_next_visit, NULL);
+    assert(visited == 500);
+    assert(deleted == 499);
+
+    teardown();
+}
+
+static void
+resource_free_client(void)
+{
+    const int count = 1000;
+    RESTYPE type;
+
+    setup();
+    type = CreateNewResourceType(delete_chained, "TEST_CHAINED");
+
+    /* every resource frees its predecessor */
+    for (int i = 1; i <= count; i++)
+        assert(AddResource(test_client.clientAsMask | i, type,
+                           (void *) (uintptr_t) (test_client.clientAsMask | (i - 1))));
+
+    FreeClientResources(&test_client);
+    assert(deleted == count);
+
+    FreeClientResources(serverClient);
+}
+
+/* the server client never goes away, its records have to be reused */
+static void
+resource_churn(void)
+{
+    const int count = 20000;
+    RESTYPE type;
+    XID ids[count];
+    void *value;
+
+    setup();
+    type = CreateNewResourceType(delete_count, "TEST_CHURN");
+
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < count; i++) {
+            ids[i] = FakeClientID(serverClient->index);
+            assert(AddResource(ids[i], type, (void *) (uintptr_t) i));
+        }
+        /* scattered over all of the chunks */
+        for (int i = 0; i < count; i++) {
+            int n = (i * 7919) % count;
+
+            assert(dixLookupResourceByType(&value, ids[n], type, NULL,
+                                           DixReadAccess) == Success);
+            assert(value == (void *) (uintptr_t) n);
+            FreeResource(ids[n], X11_RESTYPE_NONE);
+        }
+        assert(deleted == (round + 1) * count);
+
+        /* a client hovering around a chunk boundary */
+        for (int i = 0; i < 1000; i++) {
+            XID id = FakeClientID(serverClient->index);
+
+            assert(AddResource(id, type, NULL));
+            FreeResource(id, X11_RESTYPE_NONE);
+        }
+        deleted -= 1000;
+    }
+
+    teardown();
+}
+
+const testfunc_t*
+resource_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        resource_add_lookup,
+        resource_same_id,
+        resource_by_type,
+        resource_free_client,
+        resource_churn,
+        NULL,
+    };
+    return testfuncs;
+}
@@ -0,0 +1,209 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/X.h>
+
+#include "mi/mi_priv.h"
+
+#include "gcstruct.h"
+#include "misc.h"
+#include "pixmapstr.h"
+
+#include "tests-common.h"
+
+/* every span drawn, in order */
+static struct {
+    DDXPointRec pt;
+    int width;
+} *spans;
+static int nspans, sizeSpans;
+
+static PixmapRec pixmap;
+static GCRec gc;
+static GCOps ops;
+
+static void
+test_fill_spans(DrawablePtr pDrawable, GCPtr pGC, int n, DDXPointPtr ppt,
+                int *pwidth, int fSorted)
+{
+    if (nspans + n > sizeSpans) {
+        sizeSpans = (nspans + n) * 2;
+        spans = reallocarray(spans, sizeSpans, sizeof(*spans));
+        assert(spans);
+    }
+    for (int i = 0; i < n; i++) {
+        spans[nspans].pt = ppt[i];
+        spans[nspans].width = pwidth[i];
+        nspans++;
+    }
+}
+
+/* what toolkits draw: radio buttons, rounded corners, gauges */
+static void
+draw_arcs(void)
+{
+    xArc arcs[3 * 16];
+
+    for (int i = 0; i < 16; i++) {
+        arcs[i] = (xArc) {
+            .x = i * 20, .y = 0, .width = 13, .height = 13,
+            .angle1 = 0, .angle2 = 360 * 64
+        };
+        arcs[16 + i] = (xArc) {
+            .x = i * 40, .y = 40, .width = 16 + i % 3, .height = 16,
+            .angle1 = i % 4 * 90 * 64, .angle2 = 90 * 64
+        };
+        arcs[32 + i] = (xArc) {
+            .x = i * 64, .y = 80, .width = 60, .height = 30 + i % 2 * 10,
+            .angle1 = -45 * 64, .angle2 = 270 * 64
+        };
+    }
+    for (int lw = 1; lw <= 6; lw++) {
+        gc.lineWidth = lw;
+        for (int i = 0; i < 3; i++)
+            miPolyArc(&pixmap.drawable, &gc, 16, &arcs[i * 16]);
+    }
+}
+
+static void
+draw_round_lines(void)
+{
+    DDXPointRec points[16];
+
+    gc.capStyle = CapRound;
+    gc.joinStyle = JoinRound;
+    for (int i = 0; i < 16; i++) {
+        points[i].x = i * 60;
+        points[i].y = 200 + i % 2 * 15;
+    }
+    for (int lw = 3; lw <= 11; lw += 2) {
+        gc.lineWidth = lw;
+        miWideLine(&pixmap.drawable, &gc, CoordModeOrigin, 16, points);
+    }
+    gc.capStyle = CapButt;
+    gc.joinStyle = JoinMiter;
+}
+
+static void
+draw(void)
+{
+    draw_arcs();
+    draw_round_lines();
+}
+
+/* the same spans with the cache at size as without it, twice over */
+static void
+check_cached(size_t size)
+{
+    int uncached;
+
+    miSpanCacheSetSize(0);
+    nspans = 0;
+    draw();
+    uncached = nspans;
+    assert(uncached > 0);
+
+    miSpanCacheSetSize(size);
+    for (int round = 1; round <= 2; round++) {
+        draw();
+        assert(nspans == uncached * (round + 1));
+        assert(memcmp(&spans[uncached * round], spans,
+                      uncached * sizeof(*spans)) == 0);
+    }
+}
+
+static void
+span_cache_same_spans(void)
+{
+    check_cached(MI_SPAN_CACHE_BYTES);
+    assert(miSpanCacheStats.hits > 0 && miSpanCacheStats.evictions == 0);
+
+    /* and with entries evicted while drawing */
+    check_cached(4 * 1024);
+    assert(miSpanCacheStats.evictions > 0);
+
+    miSpanCacheSetSize(MI_SPAN_CACHE_BYTES);
+    free(spans);
+    spans = NULL;
+    nspans = sizeSpans = 0;
+}
+
+static void
+span_cache_evict_referenced(void)
+{
+    unsigned char *held, *data;
+
+    miSpanCacheSetSize(16 * 1024);
+
+    /* computed and cached by one arc, which is still drawing */
+    held = miSpanCacheAlloc(MI_SPAN_CACHE_ARC, 3, 100, 50, 512);
+    assert(held);
+    memset(held, 0x5a, 512);
+    miSpanCacheAdd(held);
+
+    /* another one finds it */
+    data = miSpanCacheFind(MI_SPAN_CACHE_ARC, 3, 100, 50);
+    assert(data == held);
+    miSpanCacheRelease(data);
+
+    /* other sizes push it out meanwhile */
+    for (int i = 0; i < 64; i++) {
+        data = miSpanCacheAlloc(MI_SPAN_CACHE_ARC, 3, i, i, 512);
+        assert(data);
+        memset(data, i, 512);
+        miSpanCacheAdd(data);
+        miSpanCacheRelease(data);
+    }
+    assert(miSpanCacheStats.evictions > 0);
+    assert(!miSpanCacheFind(MI_SPAN_CACHE_ARC, 3, 100, 50));
+
+    /* the first arc still has its spans */
+    for (int i = 0; i < 512; i++)
+        assert(held[i] == 0x5a);
+    miSpanCacheRelease(held);
+
+    /* same when the cache is flushed, as on reset */
+    held = miSpanCacheAlloc(MI_SPAN_CACHE_LINE_ARC, 7, 0, 0, 256);
+    assert(held);
+    memset(held, 0xa5, 256);
+    miSpanCacheAdd(held);
+    miSpanCacheFlush();
+    assert(!miSpanCacheFind(MI_SPAN_CACHE_LINE_ARC, 7, 0, 0));
+    for (int i = 0; i < 256; i++)
+        assert(held[i] == 0xa5);
+    miSpanCacheRelease(held);
+
+    miSpanCacheSetSize(MI_SPAN_CACHE_BYTES);
+}
+
+const testfunc_t*
+spancache_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        span_cache_same_spans,
+        span_cache_evict_referenced,
+        NULL,
+    };
+
+    pixmap.drawable.type = DRAWABLE_PIXMAP;
+    pixmap.drawable.width = 2048;
+    pixmap.drawable.height = 2048;
+    pixmap.drawable.depth = 24;
+
+    ops.FillSpans = test_fill_spans;
+    gc.ops = &ops;
+    gc.alu = GXcopy;
+    gc.fillStyle = FillSolid;
+    gc.lineStyle = LineSolid;
+    gc.capStyle = CapButt;
+    gc.joinStyle = JoinMiter;
+    gc.miTranslate = 1;
+    return testfuncs;
+}
@@ -11,11 +11,27 @@ main(int argc, char **argv)
     run_test(string_test);
 
 #ifdef XORG_TESTS
+    run_test(atom_test);
+    run_test(comppool_test);
+    run_test(damagechannel_test);
+    run_test(damageregion_test);
+    run_test(fairsched_test);
+    run_test(fbblt_test);
     run_test(fixes_test);
+    run_test(glyph_test);
     run_test(input_test);
     run_test(misc_test);
+    run_test(mivaltree_test);
+    run_test(ospoll_test);
+    run_test(outputbatch_test);
+    run_test(property_test);
+    run_test(recordring_test);
+    run_test(reqprof_test);
+    run_test(resource_test);
     run_test(signal_logging_test);
+    run_test(spancache_test);
     run_test(touch_test);
+    run_test(windowindex_test);
     run_test(xfree86_test);
     run_test(xkb_test);
     run_test(xtest_test);
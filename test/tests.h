@@ -23,14 +23,30 @@ extern int verbose;
 
 typedef void (*testfunc_t)(void);
 
+const testfunc_t* atom_test(void);
+const testfunc_t* comppool_test(void);
+const testfunc_t* damagechannel_test(void);
+const testfunc_t* damageregion_test(void);
+const testfunc_t* fairsched_test(void);
+const testfunc_t* fbblt_test(void);
 const testfunc_t* fixes_test(void);
+const testfunc_t* glyph_test(void);
 const testfunc_t* hashtabletest_test(void);
 const testfunc_t* input_test(void);
 const testfunc_t* list_test(void);
 const testfunc_t* misc_test(void);
+const testfunc_t* mivaltree_test(void);
+const testfunc_t* ospoll_test(void);
+const testfunc_t* outputbatch_test(void);
+const testfunc_t* property_test(void);
+const testfunc_t* recordring_test(void);
+const testfunc_t* reqprof_test(void);
+const testfunc_t* resource_test(void);
 const testfunc_t* signal_logging_test(void);
+const testfunc_t* spancache_test(void);
 const testfunc_t* string_test(void);
 const testfunc_t* touch_test(void);
+const testfunc_t* windowindex_test(void);
 const testfunc_t* xfree86_test(void);
 const testfunc_t* xkb_test(void);
 const testfunc_t* xtest_test(void);
@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: MIT OR X11 */
+
+/* Test relies on assert() */
+#undef NDEBUG
+
+#include <dix-config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <X11/X.h>
+
+#include "dix/window_priv.h"
+#include "mi/mi_priv.h"
+
+#include "misc.h"
+#include "inputstr.h"
+#include "privates.h"
+#include "scrnintstr.h"
+#include "windowstr.h"
+
+#include "tests-common.h"
+
+#define WIDTH     1920
+#define HEIGHT    1080
+#define WINDOWS   300
+#define CHANGES   3000
+
+static ScreenRec screen = { .width = WIDTH, .height = HEIGHT };
+static WindowPtr pRoot;
+static WindowPtr windows[WINDOWS];
+static SpriteRec sprite;
+
+static WindowPtr
+create_window(WindowPtr pParent, int x, int y, int w, int h)
+{
+    WindowPtr pWin = dixAllocateScreenObjectWithPrivates(NULL, WindowRec,
+                                                         PRIVATE_WINDOW);
+
+    assert(pWin);
+    pWin->drawable.pScreen = &screen;
+    pWin->drawable.x = x;
+    pWin->drawable.y = y;
+    pWin->drawable.width = w;
+    pWin->drawable.height = h;
+    pWin->parent = pParent;
+    if (pParent) {
+        /* on top of its siblings, like a new window */
+        pWin->nextSib = pParent->firstChild;
+        if (pParent->firstChild)
+            pParent->firstChild->prevSib = pWin;
+        else
+            pParent->lastChild = pWin;
+        pParent->firstChild = pWin;
+    }
+    pWin->mapped = TRUE;
+    return pWin;
+}
+
+static void
+random_geometry(WindowPtr pWin)
+{
+    pWin->drawable.width = 20 + random() % 400;
+    pWin->drawable.height = 30 + random() % 300;
+    pWin->drawable.x = random() % (WIDTH + 200) - 100;
+    pWin->drawable.y = random() % (HEIGHT + 200) - 100;
+    pWin->borderWidth = random() % 3;
+}
+
+/* put pWin right above pSib, or at the bottom if pSib is NULL */
+static void
+restack(WindowPtr pWin, WindowPtr pSib)
+{
+    if (pWin == pSib || pWin->nextSib == pSib)
+        return;
+
+    if (pWin->prevSib)
+        pWin->prevSib->nextSib = pWin->nextSib;
+    else
+        pRoot->firstChild = pWin->nextSib;
+    if (pWin->nextSib)
+        pWin->nextSib->prevSib = pWin->prevSib;
+    else
+        pRoot->lastChild = pWin->prevSib;
+
+    pWin->nextSib = pSib;
+    pWin->prevSib = pSib ? pSib->prevSib : pRoot->lastChild;
+    if (pWin->prevSib)
+        pWin->prevSib->nextSib = pWin;
+    else
+        pRoot->firstChild = pWin;
+    if (pSib)
+        pSib->prevSib = pWin;
+    else
+        pRoot->lastChild = pWin;
+
+    WindowIndexRestacked(pWin);
+}
+
+static WindowPtr
+lookup(int x, int y, Bool indexed)
+{
+    WindowIndexEnabled = indexed;
+    return miXYToWindow(&screen, &sprite, x, y);
+}
+
+static Bool
+hit(WindowPtr pWin, int x, int y)
+{
+    return pWin->mapped &&
+        x >= pWin->drawable.x && x < pWin->drawable.x + pWin->drawable.width &&
+        y >= pWin->drawable.y && y < pWin->drawable.y + pWin->drawable.height;
+}
+
+static WindowPtr
+top_level_at(int x, int y)
+{
+    WindowPtr pWin;
+
+    WindowIndexEnabled = TRUE;
+    assert(WindowIndexLookup(pRoot, x, y, hit, &pWin));
+    return pWin;
+}
+
+/* the index has to find what walking the tree finds */
+static void
+check(int points)
+{
+    for (int i = 0; i < points; i++) {
+        int x = random() % WIDTH, y = random() % HEIGHT;
+
+        assert(lookup(x, y, TRUE) == lookup(x, y, FALSE));
+    }
+}
+
+static void
+setup(void)
+{
+    pRoot = create_window(NULL, 0, 0, WIDTH, HEIGHT);
+    sprite.spriteTraceSize = 10;
+    sprite.spriteTrace = calloc(sprite.spriteTraceSize, sizeof(WindowPtr));
+    assert(sprite.spriteTrace);
+    sprite.spriteTrace[0] = pRoot;
+
+    srandom(WINDOWS);
+    for (int i = 0; i < WINDOWS; i++) {
+        windows[i] = create_window(pRoot, 0, 0, 1, 1);
+        random_geometry(windows[i]);
+        /* hidden frames, tooltips etc */
+        windows[i]->mapped = random() % 4 != 0;
+        /* a frame with a client window in it */
+        create_window(windows[i], windows[i]->drawable.x + 4,
+                      windows[i]->drawable.y + 20,
+                      windows[i]->drawable.width - 8,
+                      windows[i]->drawable.height - 24);
+    }
+}
+
+static void
+teardown(void)
+{
+    /* the index goes with the root */
+    for (int i = 0; i < WINDOWS; i++) {
+        WindowIndexRemove(windows[i]->firstChild);
+        dixFreeObjectWithPrivates(windows[i]->firstChild, PRIVATE_WINDOW);
+        WindowIndexRemove(windows[i]);
+        dixFreeObjectWithPrivates(windows[i], PRIVATE_WINDOW);
+    }
+    WindowIndexRemove(pRoot);
+    dixFreeObjectWithPrivates(pRoot, PRIVATE_WINDOW);
+    free(sprite.spriteTrace);
+}
+
+static void
+window_index_changes(void)
+{
+    setup();
+    check(1000);
+
+    for (int i = 0; i < CHANGES; i++) {
+        WindowPtr pWin = windows[random() % WINDOWS];
+
+        switch (random() % 5) {
+        case 0:
+            random_geometry(pWin);
+            WindowIndexUpdate(pWin);
+            break;
+        case 1:
+            pWin->mapped = !pWin->mapped;
+            WindowIndexUpdate(pWin);
+            break;
+        case 2:
+            restack(pWin, pRoot->firstChild);
+            break;
+        case 3:
+            restack(pWin, NULL);
+            break;
+        case 4:
+            restack(pWin, windows[random() % WINDOWS]);
+            break;
+        }
+        check(5);
+    }
+
+    teardown();
+}
+
+static void
+window_index_renumber(void)
+{
+    WindowPtr pTop, a, b;
+
+    setup();
+    for (int i = 0; i < WINDOWS; i++) {
+        windows[i]->drawable.x = windows[i]->drawable.y = 100;
+        windows[i]->borderWidth = 0;
+        windows[i]->mapped = TRUE;
+        WindowIndexUpdate(windows[i]);
+    }
+    check(100);
+
+    /* keep squeezing two windows in right below the top one */
+    pTop = pRoot->firstChild;
+    a = pTop->nextSib;
+    b = a->nextSib;
+    for (int i = 0; i < 200; i++) {
+        restack(i % 2 ? a : b, pTop->nextSib);
+        assert(top_level_at(110, 110) == pTop);
+        pTop->mapped = FALSE;
+        WindowIndexUpdate(pTop);
+        assert(top_level_at(110, 110) == pTop->nextSib);
+        pTop->mapped = TRUE;
+        WindowIndexUpdate(pTop);
+    }
+    check(100);
+
+    /* and the top ones right above the bottom one */
+    for (int i = 0; i < 200; i++) {
+        restack(pRoot->firstChild, pRoot->lastChild);
+        assert(top_level_at(110, 110) == pRoot->firstChild);
+        check(5);
+    }
+
+    teardown();
+}
+
+const testfunc_t*
+windowindex_test(void)
+{
+    static const testfunc_t testfuncs[] = {
+        window_index_changes,
+        window_index_renumber,
+        NULL,
+    };
+
+    assert(WindowIndexInit());
+    assert(dixAllocatePrivates(&screen.devPrivates, PRIVATE_SCREEN));
+    return testfuncs;
+}